@@ -8,7 +8,7 @@
 // Copyright  2021 DigiPen, All rights reserved.
 //---------------------------------------------------------
 #pragma once
-#include "cprocessing.h"
+#include "pch.h"
 #include "SyncRatio.h"
 
 
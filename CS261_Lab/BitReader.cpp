@@ -0,0 +1,125 @@
+//---------------------------------------------------------
+// file:	BitReader.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Unpacks values written into a packet by a BitWriter.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "BitReader.h"
+#include "PacketSerializer.h"
+#include "LabMath.h"
+
+
+BitReader::BitReader(Packet& packet)
+	: packet_(packet),
+	scratch_(0),
+	scratch_bits_(0),
+	bits_read_(0)
+{ }
+
+
+/// <summary>
+/// Read bit_count bits out of the packet.
+/// </summary>
+/// <returns>If true, the bits were successfully read out of the packet.</returns>
+bool BitReader::ReadBits(uint32_t& value, const unsigned int bit_count)
+{
+	if ((bit_count == 0) || (bit_count > 32))
+	{
+		return false;
+	}
+
+	// pull in as many bytes as we need to satisfy the request
+	while (scratch_bits_ < bit_count)
+	{
+		uint8_t next_byte;
+		if (!PacketSerializer::ReadValue<uint8_t>(packet_, next_byte))
+		{
+			return false;
+		}
+		scratch_ |= static_cast<uint64_t>(next_byte) << scratch_bits_;
+		scratch_bits_ += 8;
+	}
+
+	const auto mask = (bit_count < 32) ? (1ull << bit_count) - 1ull : 0xFFFFFFFFull;
+	value = static_cast<uint32_t>(scratch_ & mask);
+	scratch_ >>= bit_count;
+	scratch_bits_ -= bit_count;
+	bits_read_ += bit_count;
+
+	return true;
+}
+
+
+/// <summary>
+/// Read a single-bit bool out of the packet.
+/// </summary>
+/// <returns>If true, the bit was successfully read out of the packet.</returns>
+bool BitReader::ReadBool(bool& value)
+{
+	uint32_t bit;
+	if (!ReadBits(bit, 1))
+	{
+		return false;
+	}
+	value = (bit != 0);
+	return true;
+}
+
+
+/// <summary>
+/// Read an integer that was written with the same [min, max] range.
+/// </summary>
+/// <returns>If true, the value was successfully read out of the packet, and was within range.</returns>
+bool BitReader::ReadRangedInt(int32_t& value, const int32_t min, const int32_t max)
+{
+	if (min >= max)
+	{
+		return false;
+	}
+
+	const auto range = static_cast<uint32_t>(static_cast<int64_t>(max) - min);
+	uint32_t offset;
+	if (!ReadBits(offset, LabMath::BitsRequired(range)) || (offset > range))
+	{
+		return false;
+	}
+
+	value = static_cast<int32_t>(static_cast<int64_t>(min) + offset);
+	return true;
+}
+
+
+/// <summary>
+/// Read a full-precision float out of the packet.
+/// </summary>
+/// <returns>If true, the value was successfully read out of the packet.</returns>
+bool BitReader::ReadFloat(float& value)
+{
+	uint32_t bits;
+	if (!ReadBits(bits, 32))
+	{
+		return false;
+	}
+	memcpy(&value, &bits, sizeof(value));
+	return true;
+}
+
+
+/// <summary>
+/// Read a value that was quantized with the same range and number of bits.
+/// </summary>
+/// <returns>If true, the value was successfully read out of the packet.</returns>
+bool BitReader::ReadQuantized(float& value, const float min, const float max, const unsigned int bits)
+{
+	uint32_t quantized;
+	if (!ReadBits(quantized, bits))
+	{
+		return false;
+	}
+	value = PacketSerializer::Dequantize(quantized, min, max, bits);
+	return true;
+}
@@ -0,0 +1,38 @@
+//---------------------------------------------------------
+// file:	BitReader.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Unpacks values written into a packet by a BitWriter.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include "Packet.h"
+
+
+/// <summary>
+/// Unpacks values written into a packet by a BitWriter.
+/// </summary>
+/// <remarks>Values must be read in the same order, and with the same bit counts, as they were written.</remarks>
+class BitReader
+{
+public:
+	BitReader(Packet& packet);
+
+	bool ReadBits(uint32_t& value, unsigned int bit_count);
+	bool ReadBool(bool& value);
+	bool ReadRangedInt(int32_t& value, int32_t min, int32_t max);
+	bool ReadFloat(float& value);
+	bool ReadQuantized(float& value, float min, float max, unsigned int bits);
+
+	unsigned int GetBitsRead() const { return bits_read_; }
+
+private:
+	Packet& packet_;
+
+	uint64_t scratch_;
+	unsigned int scratch_bits_;
+	unsigned int bits_read_;
+};
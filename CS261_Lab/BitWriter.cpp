@@ -0,0 +1,127 @@
+//---------------------------------------------------------
+// file:	BitWriter.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Packs values into a packet using only as many bits as each value needs.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "BitWriter.h"
+#include "PacketSerializer.h"
+#include "LabMath.h"
+
+
+BitWriter::BitWriter(Packet& packet)
+	: packet_(packet),
+	scratch_(0),
+	scratch_bits_(0),
+	bits_written_(0)
+{ }
+
+
+/// <summary>
+/// Write the lowest bit_count bits of the value into the packet.
+/// </summary>
+/// <returns>If true, the bits were successfully written into the packet.</returns>
+bool BitWriter::WriteBits(uint32_t value, const unsigned int bit_count)
+{
+	if ((bit_count == 0) || (bit_count > 32))
+	{
+		return false;
+	}
+
+	// mask off anything above the requested bits, then append them to the scratch
+	if (bit_count < 32)
+	{
+		value &= (1u << bit_count) - 1u;
+	}
+	scratch_ |= static_cast<uint64_t>(value) << scratch_bits_;
+	scratch_bits_ += bit_count;
+	bits_written_ += bit_count;
+
+	// move every completed byte into the packet
+	while (scratch_bits_ >= 8)
+	{
+		if (!PacketSerializer::WriteValue<uint8_t>(packet_, static_cast<uint8_t>(scratch_ & 0xFF)))
+		{
+			return false;
+		}
+		scratch_ >>= 8;
+		scratch_bits_ -= 8;
+	}
+
+	return true;
+}
+
+
+/// <summary>
+/// Write a bool into the packet as a single bit.
+/// </summary>
+/// <returns>If true, the bit was successfully written into the packet.</returns>
+bool BitWriter::WriteBool(const bool value)
+{
+	return WriteBits(value ? 1u : 0u, 1);
+}
+
+
+/// <summary>
+/// Write an integer known to be within [min, max], using only the bits required for that range.
+/// </summary>
+/// <returns>If true, the value was successfully written into the packet.</returns>
+bool BitWriter::WriteRangedInt(const int32_t value, const int32_t min, const int32_t max)
+{
+	if ((min >= max) || (value < min) || (value > max))
+	{
+		return false;
+	}
+
+	const auto range = static_cast<uint32_t>(static_cast<int64_t>(max) - min);
+	const auto offset = static_cast<uint32_t>(static_cast<int64_t>(value) - min);
+	return WriteBits(offset, LabMath::BitsRequired(range));
+}
+
+
+/// <summary>
+/// Write a float into the packet, at full precision.
+/// </summary>
+/// <returns>If true, the value was successfully written into the packet.</returns>
+bool BitWriter::WriteFloat(const float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return WriteBits(bits, 32);
+}
+
+
+/// <summary>
+/// Write a value known to be within [min, max], quantized to exactly the given number of bits.
+/// </summary>
+/// <returns>If true, the value was successfully written into the packet.</returns>
+bool BitWriter::WriteQuantized(const float value, const float min, const float max, const unsigned int bits)
+{
+	return WriteBits(PacketSerializer::Quantize(value, min, max, bits), bits);
+}
+
+
+/// <summary>
+/// Write any remaining partial byte into the packet, padded with zeroes.
+/// </summary>
+/// <returns>If true, the remaining bits were successfully written into the packet.</returns>
+bool BitWriter::Flush()
+{
+	if (scratch_bits_ == 0)
+	{
+		return true;
+	}
+
+	if (!PacketSerializer::WriteValue<uint8_t>(packet_, static_cast<uint8_t>(scratch_ & 0xFF)))
+	{
+		return false;
+	}
+	scratch_ = 0;
+	scratch_bits_ = 0;
+
+	return true;
+}
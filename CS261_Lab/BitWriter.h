@@ -0,0 +1,39 @@
+//---------------------------------------------------------
+// file:	BitWriter.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Packs values into a packet using only as many bits as each value needs.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include "Packet.h"
+
+
+/// <summary>
+/// Packs values into a packet using only as many bits as each value needs.
+/// </summary>
+/// <remarks>Bits are packed least-significant first.  Call Flush when finished, to write any partial byte.</remarks>
+class BitWriter
+{
+public:
+	BitWriter(Packet& packet);
+
+	bool WriteBits(uint32_t value, unsigned int bit_count);
+	bool WriteBool(bool value);
+	bool WriteRangedInt(int32_t value, int32_t min, int32_t max);
+	bool WriteFloat(float value);
+	bool WriteQuantized(float value, float min, float max, unsigned int bits);
+	bool Flush();
+
+	unsigned int GetBitsWritten() const { return bits_written_; }
+
+private:
+	Packet& packet_;
+
+	uint64_t scratch_;
+	unsigned int scratch_bits_;
+	unsigned int bits_written_;
+};
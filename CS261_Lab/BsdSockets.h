@@ -0,0 +1,48 @@
+//---------------------------------------------------------
+// file:	BsdSockets.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Maps the WinSock names used throughout the lab onto BSD sockets, for builds outside of Windows.
+//
+// remarks: Only what the lab actually uses is mapped.  WSAGetLastError reads errno, so error codes
+//          compare against the WSAE* names below, exactly as they do on Windows.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+typedef int SOCKET;
+typedef sockaddr SOCKADDR;
+typedef sockaddr_in SOCKADDR_IN;
+typedef struct WSAData { int unused; } WSADATA;
+
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define WSAEWOULDBLOCK EWOULDBLOCK
+#define WSAECONNRESET ECONNRESET
+#define WSAECONNREFUSED ECONNREFUSED
+#define WSAEINTR EINTR
+#define MAKEWORD(low, high) ((low) | ((high) << 8))
+
+
+inline int closesocket(const SOCKET socket) { return close(socket); }
+inline int WSAGetLastError() { return errno; }
+inline int WSAStartup(int, WSADATA*) { return 0; }
+inline int WSACleanup() { return 0; }
+
+inline int ioctlsocket(const SOCKET socket, const long command, u_long* argument)
+{
+	// FIONBIO takes an int outside of Windows
+	int value = static_cast<int>(*argument);
+	return ioctl(socket, command, &value);
+}
\ No newline at end of file
@@ -0,0 +1,205 @@
+//---------------------------------------------------------
+// file:	ClockSync.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Estimates the round-trip time to the peer, and the offset from our clock to theirs.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "ClockSync.h"
+#include <cstdlib>
+#include "PacketSerializer.h"
+
+const float kRttSmoothing = 0.125f; // the weight of each new sample in the smoothed round trip, as TCP uses
+const uint32_t kMaxHold_Usecs = 0xFFFFFFFE; // the hold is written plus one, so zero can mean "nothing to echo"
+const float kJitterSmoothing = 1.0f / 16.0f; // the weight of each new transit difference, as RFC 3550 uses
+
+
+ClockSync::ClockSync(MessageDispatcher& dispatcher)
+	: epoch_(Clock::now()),
+	arrival_time_(epoch_),
+	has_received_(false),
+	newest_remote_time_usecs_(0),
+	newest_arrival_usecs_(0),
+	datagram_remote_time_usecs_(0),
+	jitter_usecs_(0.0f),
+	remote_jitter_usecs_(0),
+	last_remote_time_usecs_(0),
+	last_arrival_usecs_(0),
+	samples_(),
+	sample_count_(0),
+	next_sample_(0),
+	smoothed_rtt_secs_(0.0f)
+{
+	dispatcher.Register(kTimeMessageType, [this](Packet& payload) { return ReceiveTime(payload); });
+}
+
+
+/// <summary>
+/// Set when the datagram about to be dispatched came off the socket, so the time message in it can be timed.
+/// </summary>
+void ClockSync::SetArrivalTime(const Clock::time_point arrival_time)
+{
+	arrival_time_ = arrival_time;
+}
+
+
+/// <summary>
+/// Append the time message: our clock now, the jitter we see, and the newest peer datagram echoed back with how long we held it.
+/// </summary>
+/// <remarks>Write it first, so it is dispatched before any message that wants the datagram's send time.</remarks>
+/// <returns>If true, the message was successfully written.</returns>
+bool ClockSync::Write(MessageWriter& writer)
+{
+	const auto now_usecs = GetLocalUsecs(Clock::now());
+	return writer.Write(kTimeMessageType, [&](Packet& payload)
+		{
+			if (!PacketSerializer::WriteValue<uint32_t>(payload, static_cast<uint32_t>(now_usecs)) ||
+				!PacketSerializer::WriteVarUInt(payload, static_cast<uint32_t>(jitter_usecs_)))
+			{
+				return false;
+			}
+			if (!has_received_)
+			{
+				return PacketSerializer::WriteVarUInt(payload, 0);
+			}
+			const auto hold_usecs = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(now_usecs - newest_arrival_usecs_, 0), kMaxHold_Usecs));
+			return PacketSerializer::WriteVarUInt(payload, hold_usecs + 1) &&
+				PacketSerializer::WriteValue<uint32_t>(payload, static_cast<uint32_t>(newest_remote_time_usecs_));
+		});
+}
+
+
+/// <summary>
+/// The smallest round trip among the recent samples, which is the one least delayed by queues.
+/// </summary>
+float ClockSync::GetMinRttSecs() const
+{
+	return HasEstimate() ? GetBestSample().rtt_usecs / 1000000.0f : 0.0f;
+}
+
+
+/// <summary>
+/// How far the peer's clock is ahead of ours, from the sample with the smallest round trip.
+/// </summary>
+float ClockSync::GetOffsetSecs() const
+{
+	return HasEstimate() ? GetBestSample().offset_usecs / 1000000.0f : 0.0f;
+}
+
+
+/// <summary>
+/// Our clock now, which started when this was constructed.
+/// </summary>
+double ClockSync::GetLocalTimeSecs() const
+{
+	return GetLocalUsecs(Clock::now()) / 1000000.0;
+}
+
+
+/// <summary>
+/// The peer's clock now, as estimated from ours.  On the client, this is "server time".
+/// </summary>
+double ClockSync::GetRemoteTimeSecs() const
+{
+	return (GetLocalUsecs(Clock::now()) + (HasEstimate() ? GetBestSample().offset_usecs : 0)) / 1000000.0;
+}
+
+
+/// <summary>
+/// How long ago, on the peer's clock, the given peer time was: the true age of data the peer sent then.
+/// </summary>
+/// <remarks>Zero until there is an estimate, since the two clocks start at unrelated times.</remarks>
+float ClockSync::GetAgeSecs(const double remote_time_secs) const
+{
+	if (!HasEstimate())
+	{
+		return 0.0f;
+	}
+	return std::max(static_cast<float>(GetRemoteTimeSecs() - remote_time_secs), 0.0f);
+}
+
+
+bool ClockSync::ReceiveTime(Packet& payload)
+{
+	uint32_t send_time, remote_jitter, hold_plus_one;
+	if (!PacketSerializer::ReadValue<uint32_t>(payload, send_time) ||
+		!PacketSerializer::ReadVarUInt(payload, remote_jitter) ||
+		!PacketSerializer::ReadVarUInt(payload, hold_plus_one))
+	{
+		return false;
+	}
+	uint32_t echo_time = 0;
+	if ((hold_plus_one > 0) && !PacketSerializer::ReadValue<uint32_t>(payload, echo_time))
+	{
+		return false;
+	}
+
+	// t1: we sent the echoed datagram, t2: the peer received it, t3: the peer sent this one, t4: it arrived here
+	const auto t4 = GetLocalUsecs(arrival_time_);
+	const auto t3 = has_received_ ? Unwrap(send_time, newest_remote_time_usecs_) : static_cast<int64_t>(send_time);
+	datagram_remote_time_usecs_ = t3;
+	remote_jitter_usecs_ = remote_jitter;
+
+	// the change in transit time from the previous datagram, which the clock offset cancels out of
+	if (has_received_)
+	{
+		const auto transit_change_usecs = std::abs((t4 - last_arrival_usecs_) - (t3 - last_remote_time_usecs_));
+		jitter_usecs_ += kJitterSmoothing * (static_cast<float>(transit_change_usecs) - jitter_usecs_);
+	}
+	last_remote_time_usecs_ = t3;
+	last_arrival_usecs_ = t4;
+
+	if (!has_received_ || (t3 > newest_remote_time_usecs_))
+	{
+		has_received_ = true;
+		newest_remote_time_usecs_ = t3;
+		newest_arrival_usecs_ = t4;
+	}
+
+	if (hold_plus_one == 0)
+	{
+		return true;
+	}
+	const int64_t hold_usecs = hold_plus_one - 1;
+	const auto t1 = Unwrap(echo_time, t4);
+	const auto t2 = t3 - hold_usecs;
+	if (t4 < t1)
+	{
+		return false;
+	}
+
+	Sample& sample = samples_[next_sample_];
+	next_sample_ = (next_sample_ + 1) % kSampleCount;
+	sample.rtt_usecs = std::max<int64_t>((t4 - t1) - hold_usecs, 0);
+	sample.offset_usecs = ((t2 - t1) + (t3 - t4)) / 2;
+
+	const auto rtt_secs = sample.rtt_usecs / 1000000.0f;
+	smoothed_rtt_secs_ = (sample_count_ == 0) ? rtt_secs : smoothed_rtt_secs_ + kRttSmoothing * (rtt_secs - smoothed_rtt_secs_);
+	sample_count_ = std::min(sample_count_ + 1, kSampleCount);
+	return true;
+}
+
+
+int64_t ClockSync::GetLocalUsecs(const Clock::time_point time) const
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(time - epoch_).count();
+}
+
+
+/// <summary>
+/// Restore the high bits of a 32-bit microsecond time, taking the nearest value to a known full time.
+/// </summary>
+int64_t ClockSync::Unwrap(const uint32_t time, const int64_t near_time)
+{
+	return near_time + static_cast<int32_t>(time - static_cast<uint32_t>(near_time));
+}
+
+
+const ClockSync::Sample& ClockSync::GetBestSample() const
+{
+	return *std::min_element(samples_.begin(), samples_.begin() + sample_count_,
+		[](const Sample& a, const Sample& b) { return a.rtt_usecs < b.rtt_usecs; });
+}
\ No newline at end of file
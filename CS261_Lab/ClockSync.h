@@ -0,0 +1,91 @@
+//---------------------------------------------------------
+// file:	ClockSync.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Estimates the round-trip time to the peer, and the offset from our clock to theirs.
+//
+// remarks: Every datagram carries a time message: when it was sent, and the send time of the newest datagram
+//          received from the peer, with how long it was held here before this reply.  That gives the four
+//          timestamps of an NTP exchange on every datagram that echoes one of ours.  The offset is taken from
+//          the sample with the lowest round trip in a small window, since that one was least delayed by queues.
+//          Each side also measures the jitter of the peer's datagrams as RFC 3550 does, and reports it back.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <array>
+#include "DatagramTransport.h"
+#include "MessageWriter.h"
+#include "MessageDispatcher.h"
+
+
+/// <summary>
+/// Estimates the round-trip time to the peer, and the offset from our clock to theirs.
+/// </summary>
+class ClockSync
+{
+public:
+	using Clock = DatagramTransport::Clock;
+
+	// the time message type, which must not be used by any other message
+	static const MessageTypeId kTimeMessageType = 254;
+	// the most recent samples the offset is chosen from
+	static constexpr unsigned int kSampleCount = 8;
+
+	ClockSync(MessageDispatcher& dispatcher);
+
+	ClockSync(const ClockSync&) = delete;
+	ClockSync& operator=(const ClockSync&) = delete;
+
+	void SetArrivalTime(Clock::time_point arrival_time);
+	bool Write(MessageWriter& writer);
+
+	bool HasEstimate() const { return sample_count_ > 0; }
+	float GetRttSecs() const { return smoothed_rtt_secs_; }
+	float GetMinRttSecs() const;
+	float GetOffsetSecs() const;
+	float GetJitterSecs() const { return jitter_usecs_ / 1000000.0f; }
+	float GetRemoteJitterSecs() const { return remote_jitter_usecs_ / 1000000.0f; }
+
+	double GetLocalTimeSecs() const;
+	double GetRemoteTimeSecs() const;
+	double GetDatagramRemoteTimeSecs() const { return datagram_remote_time_usecs_ / 1000000.0; }
+	float GetAgeSecs(double remote_time_secs) const;
+
+private:
+	/// <summary>
+	/// One completed exchange: the round trip, less the peer's hold time, and the clock offset it implies.
+	/// </summary>
+	struct Sample
+	{
+		int64_t rtt_usecs;
+		int64_t offset_usecs;
+	};
+
+	bool ReceiveTime(Packet& payload);
+	int64_t GetLocalUsecs(Clock::time_point time) const;
+	static int64_t Unwrap(uint32_t time, int64_t near_time);
+	const Sample& GetBestSample() const;
+
+	Clock::time_point epoch_;
+	Clock::time_point arrival_time_; // of the datagram being dispatched
+
+	// the newest datagram from the peer, to echo back
+	bool has_received_;
+	int64_t newest_remote_time_usecs_;
+	int64_t newest_arrival_usecs_;
+	int64_t datagram_remote_time_usecs_; // the send time of the datagram being dispatched, on the peer's clock
+
+	// the variation in transit time of the peer's datagrams, as measured here and as the peer reports ours
+	float jitter_usecs_;
+	uint32_t remote_jitter_usecs_;
+	int64_t last_remote_time_usecs_;
+	int64_t last_arrival_usecs_;
+
+	std::array<Sample, kSampleCount> samples_;
+	unsigned int sample_count_;
+	unsigned int next_sample_;
+	float smoothed_rtt_secs_;
+};
\ No newline at end of file
@@ -0,0 +1,167 @@
+//---------------------------------------------------------
+// file:	ConnectionCookie.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A token the host hands a connecting client, which proves the client can receive at its address.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "ConnectionCookie.h"
+#include <random>
+#include "LabClock.h"
+#include "PacketSerializer.h"
+
+static_assert(PacketSerializer::kWireSize<uint32_t> + PacketSerializer::kWireSize<unsigned long long> == ConnectionCookie::kWireSize, "kWireSize must match what Write writes");
+static_assert(1 + std::char_traits<char>::length(ConnectionCookie::kChallengeResponse) + ConnectionCookie::kWireSize == ConnectionCookie::kChallengeSize, "kChallengeSize must match what WriteChallenge writes");
+
+
+namespace
+{
+	uint64_t RotateLeft(const uint64_t value, const int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	void SipRound(uint64_t (&v)[4])
+	{
+		v[0] += v[1]; v[1] = RotateLeft(v[1], 13); v[1] ^= v[0]; v[0] = RotateLeft(v[0], 32);
+		v[2] += v[3]; v[3] = RotateLeft(v[3], 16); v[3] ^= v[2];
+		v[0] += v[3]; v[3] = RotateLeft(v[3], 21); v[3] ^= v[0];
+		v[2] += v[1]; v[1] = RotateLeft(v[1], 17); v[1] ^= v[2]; v[2] = RotateLeft(v[2], 32);
+	}
+
+	/// <summary>
+	/// SipHash-2-4 of a 16-byte message, given as two little-endian words: a keyed hash that is fast on short inputs,
+	/// and cannot be forged without the key.
+	/// </summary>
+	uint64_t SipHash(const unsigned long long (&key)[2], const uint64_t first, const uint64_t second)
+	{
+		uint64_t v[4] = {
+			key[0] ^ 0x736f6d6570736575ull,
+			key[1] ^ 0x646f72616e646f6dull,
+			key[0] ^ 0x6c7967656e657261ull,
+			key[1] ^ 0x7465646279746573ull };
+		for (const auto word : { first, second, uint64_t(16) << 56 })
+		{
+			v[3] ^= word;
+			SipRound(v);
+			SipRound(v);
+			v[0] ^= word;
+		}
+		v[2] ^= 0xff;
+		for (int i = 0; i < 4; ++i)
+		{
+			SipRound(v);
+		}
+		return v[0] ^ v[1] ^ v[2] ^ v[3];
+	}
+
+	uint32_t GetCurrentPeriod()
+	{
+		const auto now = std::chrono::duration_cast<std::chrono::seconds>(LabClock::now().time_since_epoch());
+		return static_cast<uint32_t>(now.count() / ConnectionCookie::kLifetime_Secs);
+	}
+}
+
+
+/// <summary>
+/// Start issuing cookies under a new random key, which no other host knows.
+/// </summary>
+ConnectionCookie::Issuer::Issuer()
+{
+	std::random_device random;
+	for (auto& key : key_)
+	{
+		key = (static_cast<unsigned long long>(random()) << 32) | random();
+	}
+}
+
+
+/// <summary>
+/// Issue a cookie for the given address, for the current period.
+/// </summary>
+ConnectionCookie ConnectionCookie::Issuer::Issue(const SOCKADDR_IN& address) const
+{
+	const auto period = GetCurrentPeriod();
+	return { period, Sign(period, address) };
+}
+
+
+/// <summary>
+/// Was the cookie issued by this host, to the given address, in this period or the last?
+/// </summary>
+bool ConnectionCookie::Issuer::IsValid(const ConnectionCookie& cookie, const SOCKADDR_IN& address) const
+{
+	const auto period = GetCurrentPeriod();
+	if ((cookie.period != period) && (cookie.period + 1 != period))
+	{
+		return false;
+	}
+	return cookie.signature == Sign(cookie.period, address);
+}
+
+
+/// <summary>
+/// Write kChallengeResponse and a new cookie for the address, unless the challenge would be larger than the request.
+/// </summary>
+/// <returns>If false, nothing was written, and there is nothing to send.</returns>
+bool ConnectionCookie::Issuer::WriteChallenge(Packet& response, const SOCKADDR_IN& address, const unsigned int request_size) const
+{
+	if ((request_size < kChallengeSize) || (response.GetRemainingSpace() < kChallengeSize))
+	{
+		return false;
+	}
+	return PacketSerializer::WriteString(response, kChallengeResponse) && Issue(address).Write(response);
+}
+
+
+unsigned long long ConnectionCookie::Issuer::Sign(const uint32_t period, const SOCKADDR_IN& address) const
+{
+	// the address and port are hashed as they are on the wire, so the byte order does not matter
+	const auto peer = (static_cast<uint64_t>(address.sin_addr.s_addr) << 16) | address.sin_port;
+	return SipHash(key_, peer, period);
+}
+
+
+/// <summary>
+/// Read a cookie from the provided packet.
+/// </summary>
+/// <returns>If true, the cookie was successfully read out of the packet.</returns>
+bool ConnectionCookie::Read(Packet& packet)
+{
+	return PacketSerializer::ReadValue(packet, period) && PacketSerializer::ReadValue(packet, signature);
+}
+
+
+/// <summary>
+/// Write the cookie into the provided packet.
+/// </summary>
+/// <returns>If true, the cookie was successfully written into the packet.</returns>
+bool ConnectionCookie::Write(Packet& packet) const
+{
+	return PacketSerializer::WriteValue(packet, period) && PacketSerializer::WriteValue(packet, signature);
+}
+
+
+/// <summary>
+/// Pad a connection request with zeros up to kChallengeSize, so the host may answer it with a challenge.
+/// </summary>
+/// <remarks>The padding reads as an empty shared memory name, which the host ignores.</remarks>
+/// <returns>If true, the request is at least kChallengeSize bytes.</returns>
+bool ConnectionCookie::PadRequest(Packet& request)
+{
+	const auto used_space = request.GetUsedSpace();
+	if (used_space >= kChallengeSize)
+	{
+		return true;
+	}
+	auto* padding = request.GetTarget();
+	if (!request.Advance(kChallengeSize - used_space))
+	{
+		return false;
+	}
+	memset(padding, 0, kChallengeSize - used_space);
+	return true;
+}
\ No newline at end of file
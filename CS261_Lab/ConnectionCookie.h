@@ -0,0 +1,65 @@
+//---------------------------------------------------------
+// file:	ConnectionCookie.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A token the host hands a connecting client, which proves the client can receive at its address.
+//
+// remarks: A connection request carries the game type, then a cookie, then anything else (such as a shared
+//          memory offer).  A client's first request carries an empty cookie.  The host answers any request
+//          without a valid cookie with kChallengeResponse and a cookie for the address it came from, and keeps
+//          nothing about it, so a flood of requests from spoofed addresses costs the host no memory.
+//          The cookie is a keyed hash of the address and the time, so only the host that issued it can
+//          check it, and it expires after one to two kLifetime_Secs.
+//          A challenge is never larger than the request it answers, so the host cannot be used to amplify a flood;
+//          clients pad their requests to kChallengeSize (see PadRequest), as QUIC pads its Initial packets.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include "Packet.h"
+
+
+/// <summary>
+/// A token the host hands a connecting client, which proves the client can receive at its address.
+/// </summary>
+struct ConnectionCookie
+{
+	// the host's answer to a request without a valid cookie, followed by the cookie to send back
+	static constexpr const char* kChallengeResponse = "Cookie";
+	// a cookie is valid in the period it was issued, and the next
+	static const unsigned int kLifetime_Secs = 2;
+	// the bytes a cookie takes in a packet
+	static const unsigned int kWireSize = 12;
+	// the bytes a challenge takes: kChallengeResponse, then a cookie
+	static const unsigned int kChallengeSize = 19;
+
+	/// <summary>
+	/// Issues and checks cookies with a key of its own, so it alone can check the cookies it issues.
+	/// </summary>
+	class Issuer
+	{
+	public:
+		Issuer();
+
+		ConnectionCookie Issue(const SOCKADDR_IN& address) const;
+		bool IsValid(const ConnectionCookie& cookie, const SOCKADDR_IN& address) const;
+		bool WriteChallenge(Packet& response, const SOCKADDR_IN& address, unsigned int request_size) const;
+
+	private:
+		unsigned long long Sign(uint32_t period, const SOCKADDR_IN& address) const;
+
+		unsigned long long key_[2];
+	};
+
+	bool Read(Packet& packet);
+	bool Write(Packet& packet) const;
+
+	static bool PadRequest(Packet& request);
+
+	bool IsEmpty() const { return (period == 0) && (signature == 0); }
+
+	uint32_t period; // the lifetime period it was issued in
+	unsigned long long signature; // the keyed hash of the period and the address
+};
\ No newline at end of file
@@ -0,0 +1,140 @@
+//---------------------------------------------------------
+// file:	DatagramBatch.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A set of datagram buffers that are received or sent together, in one system call where the platform allows.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "DatagramBatch.h"
+
+
+DatagramBatch::DatagramBatch()
+	: count_(0)
+{
+#if defined(__linux__)
+	// the buffers never move, so the message headers only need their per-call fields filled in
+	memset(headers_, 0, sizeof(headers_));
+	for (unsigned int i = 0; i < kMaxDatagrams; ++i)
+	{
+		iovecs_[i].iov_base = buffers_[i];
+		iovecs_[i].iov_len = kMaxDatagramSize;
+		headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+		headers_[i].msg_hdr.msg_iovlen = 1;
+	}
+#endif
+}
+
+
+/// <summary>
+/// Replace the contents of the batch with as many datagrams as are waiting on the socket, up to kMaxDatagrams.
+/// </summary>
+/// <returns>The number of datagrams received, which is zero if none were waiting, or SOCKET_ERROR.</returns>
+int DatagramBatch::Receive(const SOCKET socket)
+{
+	count_ = 0;
+
+#if defined(__linux__)
+	for (unsigned int i = 0; i < kMaxDatagrams; ++i)
+	{
+		iovecs_[i].iov_len = kMaxDatagramSize;
+		headers_[i].msg_hdr.msg_name = &addresses_[i];
+		headers_[i].msg_hdr.msg_namelen = sizeof(addresses_[i]);
+	}
+	const auto res = recvmmsg(socket, headers_, kMaxDatagrams, MSG_DONTWAIT, nullptr);
+	if (res < 0)
+	{
+		return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : SOCKET_ERROR;
+	}
+	for (int i = 0; i < res; ++i)
+	{
+		sizes_[i] = headers_[i].msg_len;
+		has_address_[i] = true;
+	}
+	count_ = static_cast<unsigned int>(res);
+#else
+	while (count_ < kMaxDatagrams)
+	{
+		socklen_t address_size = sizeof(addresses_[count_]);
+		const auto res = recvfrom(socket, buffers_[count_], kMaxDatagramSize, 0, reinterpret_cast<SOCKADDR*>(&addresses_[count_]), &address_size);
+		if (res == SOCKET_ERROR)
+		{
+			// report errors on the next call if some datagrams were already received
+			if ((count_ > 0) || (WSAGetLastError() == WSAEWOULDBLOCK))
+			{
+				break;
+			}
+			return SOCKET_ERROR;
+		}
+		sizes_[count_] = res;
+		has_address_[count_] = true;
+		++count_;
+	}
+#endif
+
+	return static_cast<int>(count_);
+}
+
+
+/// <summary>
+/// Add the datagram written into GetNextBuffer() to the batch, to be sent to the given address,
+/// or to the socket's connected address if it is null.
+/// </summary>
+void DatagramBatch::Push(const unsigned int size, const SOCKADDR_IN* address)
+{
+	sizes_[count_] = size;
+	has_address_[count_] = (address != nullptr);
+	if (address != nullptr)
+	{
+		addresses_[count_] = *address;
+	}
+	++count_;
+}
+
+
+/// <summary>
+/// Send every datagram in the batch, in order, then clear it.
+/// </summary>
+/// <remarks>Datagrams after a send failure are dropped, as UDP would drop them anyway.</remarks>
+/// <returns>The number of datagrams sent, or SOCKET_ERROR if the first could not be sent.</returns>
+int DatagramBatch::Send(const SOCKET socket)
+{
+	int sent = 0;
+
+#if defined(__linux__)
+	for (unsigned int i = 0; i < count_; ++i)
+	{
+		iovecs_[i].iov_len = sizes_[i];
+		headers_[i].msg_hdr.msg_name = has_address_[i] ? &addresses_[i] : nullptr;
+		headers_[i].msg_hdr.msg_namelen = has_address_[i] ? sizeof(addresses_[i]) : 0;
+	}
+	// sendmmsg may stop short of the whole batch, so keep going from where it stopped
+	while (static_cast<unsigned int>(sent) < count_)
+	{
+		const auto res = sendmmsg(socket, headers_ + sent, count_ - sent, 0);
+		if (res <= 0)
+		{
+			break;
+		}
+		sent += res;
+	}
+#else
+	for (unsigned int i = 0; i < count_; ++i)
+	{
+		const auto res = has_address_[i] ?
+			sendto(socket, buffers_[i], sizes_[i], 0, reinterpret_cast<const SOCKADDR*>(&addresses_[i]), sizeof(addresses_[i])) :
+			send(socket, buffers_[i], sizes_[i], 0);
+		if (res == SOCKET_ERROR)
+		{
+			break;
+		}
+		++sent;
+	}
+#endif
+
+	const bool is_failed = (sent == 0) && (count_ > 0);
+	count_ = 0;
+	return is_failed ? SOCKET_ERROR : sent;
+}
\ No newline at end of file
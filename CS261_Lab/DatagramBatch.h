@@ -0,0 +1,61 @@
+//---------------------------------------------------------
+// file:	DatagramBatch.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A set of datagram buffers that are received or sent together, in one system call where the platform allows.
+//
+// remarks: On Linux, Receive and Send use recvmmsg and sendmmsg, so a batch costs one system call.
+//          Elsewhere, they fall back to one recvfrom or sendto per datagram, with the same results.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include "Packet.h"
+#if defined(__linux__)
+#include <sys/socket.h>
+#endif
+
+
+/// <summary>
+/// A set of datagram buffers that are received or sent together, in one system call where the platform allows.
+/// </summary>
+class DatagramBatch
+{
+public:
+	static const unsigned int kMaxDatagrams = 32;
+
+	DatagramBatch();
+
+	DatagramBatch(const DatagramBatch&) = delete;
+	DatagramBatch& operator=(const DatagramBatch&) = delete;
+
+	int Receive(SOCKET socket);
+	int Send(SOCKET socket);
+
+	/// <summary>
+	/// The buffer for the next datagram to send; write into it, then Push the datagram.
+	/// </summary>
+	char* GetNextBuffer() { return buffers_[count_]; }
+	void Push(unsigned int size, const SOCKADDR_IN* address = nullptr);
+
+	Packet GetDatagram(const unsigned int index) { return Packet(buffers_[index], sizes_[index]); }
+	const SOCKADDR_IN& GetAddress(const unsigned int index) const { return addresses_[index]; }
+
+	unsigned int GetCount() const { return count_; }
+	bool IsFull() const { return count_ == kMaxDatagrams; }
+	void Clear() { count_ = 0; }
+
+private:
+	char buffers_[kMaxDatagrams][kMaxDatagramSize];
+	unsigned int sizes_[kMaxDatagrams];
+	SOCKADDR_IN addresses_[kMaxDatagrams];
+	bool has_address_[kMaxDatagrams];
+	unsigned int count_;
+
+#if defined(__linux__)
+	mmsghdr headers_[kMaxDatagrams];
+	iovec iovecs_[kMaxDatagrams];
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,571 @@
+//---------------------------------------------------------
+// file:	DatagramReceiver.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Waits for datagrams on a socket, and receives them in batches, by the best means the platform offers.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "DatagramReceiver.h"
+#if defined(__linux__)
+#include <csignal>
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/syscall.h>
+#endif
+
+
+#if defined(__linux__)
+const unsigned int kUringEntries = 4; // the only submissions are the receive, re-arming it, and cancelling it
+const unsigned int kUringCompletionEntries = 2 * DatagramReceiver::kRegisteredBufferCount; // room for every registered buffer to complete
+const unsigned short kBufferGroup = 0;
+const unsigned int kRegisteredBufferSize = sizeof(io_uring_recvmsg_out) + sizeof(SOCKADDR_IN) + kMaxDatagramSize; // the header the kernel writes, the address, then the datagram
+const __u64 kReceiveUserData = 1;
+const __u64 kCancelUserData = 2;
+const long kCancelTimeout_Nsecs = 100000000; // how long closing waits for the kernel to let go of the socket
+
+static_assert((DatagramReceiver::kRegisteredBufferCount & (DatagramReceiver::kRegisteredBufferCount - 1)) == 0, "the registered buffer count must be a power of two");
+
+
+/// <summary>
+/// The io_uring, its rings as mapped from the kernel, and the buffers registered with it.
+/// </summary>
+/// <remarks>The kernel writes the completion tail and reads the submission and buffer tails, so those are accessed atomically.</remarks>
+struct DatagramReceiver::Uring
+{
+	Uring(const SOCKET socket)
+		: socket(socket),
+		fd(-1),
+		ring(MAP_FAILED),
+		ring_size(0),
+		submissions(static_cast<io_uring_sqe*>(MAP_FAILED)),
+		submissions_size(0),
+		buffer_ring(static_cast<io_uring_buf*>(MAP_FAILED)),
+		buffer_ring_tail(nullptr),
+		buffer_ring_size(0),
+		buffer_tail(0),
+		receive_header(),
+		is_armed(false),
+		has_received(false),
+		pending_submissions(0),
+		held_count(0),
+		count(0)
+	{ }
+
+	~Uring()
+	{
+		// closing the ring cancels the receive too, but later, on a kernel thread, and the socket stays bound until then
+		if (fd >= 0)
+		{
+			Cancel();
+			close(fd);
+		}
+		if (buffer_ring != MAP_FAILED)
+		{
+			munmap(buffer_ring, buffer_ring_size);
+		}
+		if (submissions != MAP_FAILED)
+		{
+			munmap(submissions, submissions_size);
+		}
+		if (ring != MAP_FAILED)
+		{
+			munmap(ring, ring_size);
+		}
+	}
+
+	/// <summary>
+	/// Set up the ring and register the buffers.
+	/// </summary>
+	/// <returns>If false, this kernel does not offer what the backend needs, and errno says why.</returns>
+	bool Start()
+	{
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		params.flags = IORING_SETUP_CQSIZE;
+		params.cq_entries = kUringCompletionEntries;
+		fd = static_cast<int>(syscall(__NR_io_uring_setup, kUringEntries, &params));
+		// a timed wait needs the extended enter arguments (5.11), and the single mapping keeps things simple (5.4)
+		if ((fd < 0) || !(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_SINGLE_MMAP))
+		{
+			errno = (fd < 0) ? errno : ENOSYS;
+			return false;
+		}
+
+		// the submission and completion rings share one mapping, and the submissions themselves have another
+		ring_size = std::max(params.sq_off.array + params.sq_entries * sizeof(__u32), params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+		ring = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		submissions_size = params.sq_entries * sizeof(io_uring_sqe);
+		submissions = static_cast<io_uring_sqe*>(mmap(nullptr, submissions_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+		if ((ring == MAP_FAILED) || (submissions == MAP_FAILED))
+		{
+			return false;
+		}
+		auto* const ring_bytes = static_cast<char*>(ring);
+		submission_tail = reinterpret_cast<__u32*>(ring_bytes + params.sq_off.tail);
+		submission_mask = *reinterpret_cast<__u32*>(ring_bytes + params.sq_off.ring_mask);
+		submission_array = reinterpret_cast<__u32*>(ring_bytes + params.sq_off.array);
+		completion_head = reinterpret_cast<__u32*>(ring_bytes + params.cq_off.head);
+		completion_tail = reinterpret_cast<__u32*>(ring_bytes + params.cq_off.tail);
+		completion_mask = *reinterpret_cast<__u32*>(ring_bytes + params.cq_off.ring_mask);
+		completions = reinterpret_cast<io_uring_cqe*>(ring_bytes + params.cq_off.cqes);
+
+		// the buffer ring is ours to allocate, page-aligned, and the kernel picks a buffer from it for each datagram (5.19)
+		buffer_ring_size = kRegisteredBufferCount * sizeof(io_uring_buf);
+		buffer_ring = static_cast<io_uring_buf*>(mmap(nullptr, buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (buffer_ring == MAP_FAILED)
+		{
+			return false;
+		}
+		// the tail overlays the first entry's reserved field; io_uring_buf_ring says so, but its flexible array is offset in C++
+		buffer_ring_tail = &buffer_ring[0].resv;
+		io_uring_buf_reg registration;
+		memset(&registration, 0, sizeof(registration));
+		registration.ring_addr = reinterpret_cast<__u64>(buffer_ring);
+		registration.ring_entries = kRegisteredBufferCount;
+		registration.bgid = kBufferGroup;
+		if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0)
+		{
+			return false;
+		}
+		buffers.reset(new char[kRegisteredBufferCount * kRegisteredBufferSize]);
+		for (unsigned short id = 0; id < kRegisteredBufferCount; ++id)
+		{
+			ProvideBuffer(id);
+		}
+		__atomic_store_n(buffer_ring_tail, buffer_tail, __ATOMIC_RELEASE);
+
+		// only the address is wanted alongside each datagram, with no control data
+		receive_header.msg_namelen = sizeof(SOCKADDR_IN);
+		return true;
+	}
+
+	/// <summary>
+	/// Hand back the buffers of the previous batch, then wait for the next batch.
+	/// </summary>
+	/// <returns>The datagrams received, zero if the timeout passed first, or SOCKET_ERROR.</returns>
+	int Receive(const long timeout_usecs)
+	{
+		for (unsigned int i = 0; i < held_count; ++i)
+		{
+			ProvideBuffer(held_ids[i]);
+		}
+		if (held_count > 0)
+		{
+			__atomic_store_n(buffer_ring_tail, buffer_tail, __ATOMIC_RELEASE);
+			held_count = 0;
+		}
+
+		// a receive that ran out of buffers leaves the rest in the socket, so it is re-armed to take them now
+		const auto res = WaitAndReap(timeout_usecs);
+		return ((res == 0) && !is_armed) ? WaitAndReap(timeout_usecs) : res;
+	}
+
+	/// <summary>
+	/// Re-arm the receive if it has ended, wait for completions, and take a batch of datagrams from them.
+	/// </summary>
+	int WaitAndReap(const long timeout_usecs)
+	{
+		count = 0;
+		if (!is_armed)
+		{
+			Arm();
+		}
+
+		const auto is_empty = (*completion_head == __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE));
+		if ((pending_submissions > 0) || (is_empty && (timeout_usecs > 0)))
+		{
+			__kernel_timespec timeout;
+			timeout.tv_sec = timeout_usecs / 1000000;
+			timeout.tv_nsec = (timeout_usecs % 1000000) * 1000;
+			io_uring_getevents_arg wait;
+			memset(&wait, 0, sizeof(wait));
+			wait.sigmask_sz = _NSIG / 8;
+			wait.ts = reinterpret_cast<__u64>(&timeout);
+			const auto is_waiting = is_empty && (timeout_usecs > 0);
+			const auto res = syscall(__NR_io_uring_enter, fd, pending_submissions, is_waiting ? 1 : 0,
+				(is_waiting ? IORING_ENTER_GETEVENTS : 0) | IORING_ENTER_EXT_ARG, &wait, sizeof(wait));
+			if ((res < 0) && (errno != ETIME) && (errno != EINTR) && (errno != EBUSY))
+			{
+				return SOCKET_ERROR;
+			}
+			if (res >= 0)
+			{
+				pending_submissions -= std::min<unsigned int>(static_cast<unsigned int>(res), pending_submissions);
+			}
+		}
+
+		auto head = *completion_head;
+		const auto tail = __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE);
+		for (; (head != tail) && (held_count < kMaxDatagrams); ++head)
+		{
+			const auto& completion = completions[head & completion_mask];
+			if (completion.user_data != kReceiveUserData)
+			{
+				continue;
+			}
+			if (!(completion.flags & IORING_CQE_F_MORE))
+			{
+				is_armed = false;
+			}
+			if (completion.res < 0)
+			{
+				// multishot recvmsg is refused outright by kernels before 6.0, so the caller falls back
+				if ((completion.res != -ENOBUFS) && !has_received)
+				{
+					__atomic_store_n(completion_head, head + 1, __ATOMIC_RELEASE);
+					errno = -completion.res;
+					return SOCKET_ERROR;
+				}
+				continue;
+			}
+			if (!(completion.flags & IORING_CQE_F_BUFFER))
+			{
+				continue;
+			}
+			has_received = true;
+			const auto id = static_cast<unsigned short>(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+			held_ids[held_count++] = id;
+
+			// the kernel lays out its header, then the address, then the datagram, within the buffer
+			char* const buffer = buffers.get() + id * kRegisteredBufferSize;
+			const auto* out = reinterpret_cast<const io_uring_recvmsg_out*>(buffer);
+			const auto header_size = sizeof(io_uring_recvmsg_out) + receive_header.msg_namelen + receive_header.msg_controllen;
+			if ((static_cast<size_t>(completion.res) < header_size) || (out->namelen < sizeof(SOCKADDR_IN)))
+			{
+				continue;
+			}
+			memcpy(&addresses[count], buffer + sizeof(io_uring_recvmsg_out), sizeof(SOCKADDR_IN));
+			data[count] = buffer + header_size;
+			sizes[count] = std::min<unsigned int>(out->payloadlen, static_cast<unsigned int>(completion.res - header_size));
+			++count;
+		}
+		__atomic_store_n(completion_head, head, __ATOMIC_RELEASE);
+		return static_cast<int>(count);
+	}
+
+	/// <summary>
+	/// Cancel the receive, and wait until it has ended, so it no longer holds the socket.
+	/// </summary>
+	void Cancel()
+	{
+		if (!is_armed)
+		{
+			return;
+		}
+		const auto tail = *submission_tail;
+		const auto index = tail & submission_mask;
+		auto& submission = submissions[index];
+		memset(&submission, 0, sizeof(submission));
+		submission.opcode = IORING_OP_ASYNC_CANCEL;
+		submission.fd = -1;
+		submission.addr = kReceiveUserData;
+		submission.user_data = kCancelUserData;
+		submission_array[index] = index;
+		__atomic_store_n(submission_tail, tail + 1, __ATOMIC_RELEASE);
+		++pending_submissions;
+
+		__kernel_timespec timeout = { 0, kCancelTimeout_Nsecs };
+		io_uring_getevents_arg wait;
+		memset(&wait, 0, sizeof(wait));
+		wait.sigmask_sz = _NSIG / 8;
+		wait.ts = reinterpret_cast<__u64>(&timeout);
+		while (is_armed)
+		{
+			const auto res = syscall(__NR_io_uring_enter, fd, pending_submissions, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &wait, sizeof(wait));
+			if ((res < 0) && (errno != EINTR))
+			{
+				return;
+			}
+			pending_submissions = 0;
+			auto head = *completion_head;
+			const auto completion_end = __atomic_load_n(completion_tail, __ATOMIC_ACQUIRE);
+			for (; head != completion_end; ++head)
+			{
+				const auto& completion = completions[head & completion_mask];
+				if ((completion.user_data == kReceiveUserData) && !(completion.flags & IORING_CQE_F_MORE))
+				{
+					is_armed = false;
+				}
+			}
+			__atomic_store_n(completion_head, head, __ATOMIC_RELEASE);
+		}
+	}
+
+	/// <summary>
+	/// Queue the multishot receive, which stays armed until it runs out of buffers, to be submitted by the next wait.
+	/// </summary>
+	void Arm()
+	{
+		const auto tail = *submission_tail;
+		const auto index = tail & submission_mask;
+		auto& submission = submissions[index];
+		memset(&submission, 0, sizeof(submission));
+		submission.opcode = IORING_OP_RECVMSG;
+		submission.fd = socket;
+		submission.addr = reinterpret_cast<__u64>(&receive_header);
+		submission.len = 1;
+		submission.ioprio = IORING_RECV_MULTISHOT;
+		submission.flags = IOSQE_BUFFER_SELECT;
+		submission.buf_group = kBufferGroup;
+		submission.user_data = kReceiveUserData;
+		submission_array[index] = index;
+		__atomic_store_n(submission_tail, tail + 1, __ATOMIC_RELEASE);
+		++pending_submissions;
+		is_armed = true;
+	}
+
+	/// <summary>
+	/// Add a buffer to the ring the kernel picks from.  The tail is published separately, once per batch.
+	/// </summary>
+	void ProvideBuffer(const unsigned short id)
+	{
+		auto& entry = buffer_ring[buffer_tail & (kRegisteredBufferCount - 1)];
+		entry.addr = reinterpret_cast<__u64>(buffers.get() + id * kRegisteredBufferSize);
+		entry.len = kRegisteredBufferSize;
+		entry.bid = id;
+		++buffer_tail;
+	}
+
+	SOCKET socket;
+	int fd;
+
+	void* ring;
+	size_t ring_size;
+	io_uring_sqe* submissions;
+	size_t submissions_size;
+	__u32* submission_tail;
+	__u32 submission_mask;
+	__u32* submission_array;
+	__u32* completion_head;
+	__u32* completion_tail;
+	__u32 completion_mask;
+	io_uring_cqe* completions;
+
+	io_uring_buf* buffer_ring;
+	__u16* buffer_ring_tail;
+	size_t buffer_ring_size;
+	__u16 buffer_tail;
+	std::unique_ptr<char[]> buffers;
+
+	msghdr receive_header; // read by the kernel for as long as the receive is armed
+	bool is_armed;
+	bool has_received; // once a datagram has arrived, an error is a passing one, not a missing feature
+	unsigned int pending_submissions;
+
+	// the batch handed out by the last Receive, whose buffers go back to the kernel on the next
+	unsigned short held_ids[kMaxDatagrams];
+	unsigned int held_count;
+	char* data[kMaxDatagrams];
+	unsigned int sizes[kMaxDatagrams];
+	SOCKADDR_IN addresses[kMaxDatagrams];
+	unsigned int count;
+};
+#endif
+
+
+/// <summary>
+/// Start receiving on the socket with the given backend, or the next one the kernel allows.
+/// </summary>
+/// <remarks>The socket must be non-blocking, and stays owned by the caller.</remarks>
+DatagramReceiver::DatagramReceiver(const SOCKET socket, const Backend backend)
+	: socket_(socket), backend_(backend)
+#if defined(__linux__)
+	, epoll_fd_(-1)
+#endif
+{
+#if defined(__linux__)
+	if (backend_ == Backend::Uring)
+	{
+		uring_ = std::make_unique<Uring>(socket);
+		if (!uring_->Start())
+		{
+			std::cerr << "io_uring is not available (" << strerror(errno) << "), so receiving with epoll" << std::endl;
+			uring_.reset();
+			backend_ = Backend::Epoll;
+		}
+	}
+	if ((backend_ == Backend::Epoll) && !StartEpoll())
+	{
+		std::cerr << "epoll is not available (" << strerror(errno) << "), so receiving with select" << std::endl;
+		backend_ = Backend::Select;
+	}
+#else
+	backend_ = Backend::Select;
+#endif
+}
+
+
+DatagramReceiver::~DatagramReceiver()
+{
+	Stop();
+}
+
+
+/// <summary>
+/// Wait up to the timeout for datagrams, then receive a batch of them.  The previous batch is no longer valid.
+/// </summary>
+/// <remarks>A full batch may mean more are waiting, so call again with no timeout to take them.</remarks>
+/// <returns>The datagrams received, zero if the timeout passed first, or SOCKET_ERROR.</returns>
+int DatagramReceiver::Receive(const long timeout_usecs)
+{
+#if defined(__linux__)
+	if (backend_ == Backend::Uring)
+	{
+		const auto res = uring_->Receive(timeout_usecs);
+		if ((res != SOCKET_ERROR) || uring_->has_received || !StartEpoll())
+		{
+			return res;
+		}
+		std::cerr << "io_uring cannot receive here (" << strerror(errno) << "), so receiving with epoll" << std::endl;
+		uring_.reset();
+		backend_ = Backend::Epoll;
+	}
+#endif
+	return WaitAndReceiveBatch(timeout_usecs);
+}
+
+
+/// <summary>
+/// Let go of the socket, so closing it frees the port at once.  The receiver must not be used again.
+/// </summary>
+/// <remarks>An armed io_uring receive holds the socket open, until the ring is gone.</remarks>
+void DatagramReceiver::Stop()
+{
+#if defined(__linux__)
+	uring_.reset();
+	if (epoll_fd_ >= 0)
+	{
+		close(epoll_fd_);
+		epoll_fd_ = -1;
+	}
+#endif
+	backend_ = Backend::Select;
+}
+
+
+Packet DatagramReceiver::GetDatagram(const unsigned int index)
+{
+#if defined(__linux__)
+	if (backend_ == Backend::Uring)
+	{
+		return Packet(uring_->data[index], uring_->sizes[index]);
+	}
+#endif
+	return batch_.GetDatagram(index);
+}
+
+
+const SOCKADDR_IN& DatagramReceiver::GetAddress(const unsigned int index) const
+{
+#if defined(__linux__)
+	if (backend_ == Backend::Uring)
+	{
+		return uring_->addresses[index];
+	}
+#endif
+	return batch_.GetAddress(index);
+}
+
+
+const char* DatagramReceiver::GetBackendName(const Backend backend)
+{
+	switch (backend)
+	{
+	case Backend::Uring:
+		return "uring";
+	case Backend::Epoll:
+		return "epoll";
+	case Backend::Select:
+		return "select";
+	}
+	return "unknown";
+}
+
+
+/// <summary>
+/// The backend named by a kArgumentPrefix argument, or the best one, which falls back as far as it must.
+/// </summary>
+DatagramReceiver::Backend DatagramReceiver::FromArguments(int argc, char** argv)
+{
+	const auto prefix_length = strlen(kArgumentPrefix);
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strncmp(argv[i], kArgumentPrefix, prefix_length) != 0)
+		{
+			continue;
+		}
+		for (const auto backend : { Backend::Uring, Backend::Epoll, Backend::Select })
+		{
+			if (strcmp(argv[i] + prefix_length, GetBackendName(backend)) == 0)
+			{
+				return backend;
+			}
+		}
+		std::cerr << "Unknown receive backend '" << (argv[i] + prefix_length) << "', expected uring, epoll, or select" << std::endl;
+	}
+	return Backend::Uring;
+}
+
+
+bool DatagramReceiver::StartEpoll()
+{
+#if defined(__linux__)
+	epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd_ < 0)
+	{
+		return false;
+	}
+	epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = static_cast<int>(socket_);
+	if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, static_cast<int>(socket_), &event) < 0)
+	{
+		close(epoll_fd_);
+		epoll_fd_ = -1;
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+/// <summary>
+/// Wait for the socket to be readable with epoll or select, then receive a batch with DatagramBatch.
+/// </summary>
+int DatagramReceiver::WaitAndReceiveBatch(const long timeout_usecs)
+{
+	batch_.Clear();
+	if (timeout_usecs > 0)
+	{
+		int res;
+#if defined(__linux__)
+		if (backend_ == Backend::Epoll)
+		{
+			// epoll only waits in whole milliseconds, so round up rather than spin
+			epoll_event event;
+			res = epoll_wait(epoll_fd_, &event, 1, static_cast<int>((timeout_usecs + 999) / 1000));
+		}
+		else
+#endif
+		{
+			fd_set read_set;
+			FD_ZERO(&read_set);
+			FD_SET(socket_, &read_set);
+			timeval timeout = { timeout_usecs / 1000000, timeout_usecs % 1000000 };
+			res = select(static_cast<int>(socket_) + 1, &read_set, nullptr, nullptr, &timeout);
+		}
+		if (res <= 0)
+		{
+			return ((res == 0) || (errno == EINTR)) ? 0 : SOCKET_ERROR;
+		}
+	}
+	return batch_.Receive(socket_);
+}
\ No newline at end of file
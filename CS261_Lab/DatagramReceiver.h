@@ -0,0 +1,75 @@
+//---------------------------------------------------------
+// file:	DatagramReceiver.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Waits for datagrams on a socket, and receives them in batches, by the best means the platform offers.
+//
+// remarks: There are three backends, each falling back to the next if the kernel refuses it:
+//          Uring:  one io_uring multishot recvmsg stays armed on the socket, and the kernel writes each datagram
+//                  into a ring of buffers registered with it, so a wait and a whole batch cost one system call,
+//                  and nothing is called to find the socket empty.  Linux 6.0 or later.
+//          Epoll:  epoll_wait, then recvmmsg.  Linux.
+//          Select: select, then DatagramBatch::Receive, as on every platform.
+//          The datagrams of a batch are valid until the next Receive.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <memory>
+#include "Packet.h"
+#include "DatagramBatch.h"
+
+
+/// <summary>
+/// Waits for datagrams on a socket, and receives them in batches, by the best means the platform offers.
+/// </summary>
+class DatagramReceiver
+{
+public:
+	enum class Backend
+	{
+		Uring,
+		Epoll,
+		Select,
+	};
+
+	// the most datagrams in one batch
+	static const unsigned int kMaxDatagrams = DatagramBatch::kMaxDatagrams;
+	// the buffers registered with the kernel by the uring backend, which bounds the datagrams it holds for us
+	static const unsigned int kRegisteredBufferCount = 256;
+	// picks the backend on the command line, as --recv=uring, --recv=epoll, or --recv=select
+	static constexpr const char* kArgumentPrefix = "--recv=";
+
+	DatagramReceiver(SOCKET socket, Backend backend);
+	~DatagramReceiver();
+
+	DatagramReceiver(const DatagramReceiver&) = delete;
+	DatagramReceiver& operator=(const DatagramReceiver&) = delete;
+
+	int Receive(long timeout_usecs);
+	void Stop();
+
+	Packet GetDatagram(unsigned int index);
+	const SOCKADDR_IN& GetAddress(unsigned int index) const;
+
+	Backend GetBackend() const { return backend_; }
+
+	static const char* GetBackendName(Backend backend);
+	static Backend FromArguments(int argc, char** argv);
+
+private:
+	struct Uring;
+
+	bool StartEpoll();
+	int WaitAndReceiveBatch(long timeout_usecs);
+
+	SOCKET socket_;
+	Backend backend_;
+	DatagramBatch batch_; // for the epoll and select backends
+#if defined(__linux__)
+	std::unique_ptr<Uring> uring_;
+	int epoll_fd_;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,68 @@
+//---------------------------------------------------------
+// file:	DatagramTransport.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	The interface a networked scenario uses to exchange datagrams with its one peer.
+//
+// remarks: NetworkThread implements it over a connected socket of its own, and SessionHost implements it
+//          for each of many peers sharing one bound socket.  All calls come from the simulation thread.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <chrono>
+#include "LabClock.h"
+#include "Packet.h"
+#include "PacketBufferPool.h"
+
+
+/// <summary>
+/// The interface a networked scenario uses to exchange datagrams with its one peer.
+/// </summary>
+class DatagramTransport
+{
+public:
+	// the steady clock, unless a run that drives the scenarios itself has set the time by hand
+	using Clock = LabClock;
+
+	/// <summary>
+	/// A datagram received from the peer, with the time it came off the socket.
+	/// </summary>
+	struct ReceivedDatagram
+	{
+		PacketBuffer buffer;
+		Clock::time_point arrival_time;
+	};
+
+	virtual ~DatagramTransport() = default;
+
+	/// <summary>
+	/// Queue a copy of the packet's used space to be sent to the peer.
+	/// </summary>
+	/// <returns>If false, the datagram was dropped.</returns>
+	virtual bool Send(const Packet& packet) = 0;
+
+	/// <summary>
+	/// Take the oldest datagram received from the peer.
+	/// </summary>
+	/// <returns>If false, there were no datagrams waiting.</returns>
+	virtual bool Receive(ReceivedDatagram& datagram) = 0;
+
+	/// <summary>
+	/// Stop exchanging datagrams with the peer.  Anything still queued is dropped.
+	/// </summary>
+	virtual void Stop() = 0;
+
+	/// <summary>
+	/// The number of received datagrams dropped because the simulation was not keeping up.
+	/// </summary>
+	virtual unsigned int GetOverflowCount() const = 0;
+
+	/// <summary>
+	/// Has the link to the peer failed for good, such as by the peer's port refusing datagrams?
+	/// </summary>
+	/// <remarks>Transports that cannot fail that way need not override this.</remarks>
+	virtual bool HasFailed() const { return false; }
+};
\ No newline at end of file
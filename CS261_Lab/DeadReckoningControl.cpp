@@ -13,19 +13,20 @@
 
 
 void DeadReckoningControl::SetLastKnown(const float position_x, const float position_y, 
-	const float velocity_x, const float velocity_y, const float time_since_last_update_secs, const u_long remote_frame)
+	const float velocity_x, const float velocity_y, const float time_since_last_update_secs, const float data_age_secs, const u_long remote_frame)
 {
 	remote_frame_ = remote_frame;
 	
-	last_known_position_x_ = position_x;
-	last_known_position_y_ = position_y;
+	// every state is already data_age_secs old, so it is known from where it has moved to since
+	last_known_position_x_ = position_x + velocity_x * data_age_secs;
+	last_known_position_y_ = position_y + velocity_y * data_age_secs;
 	last_known_velocity_x_ = velocity_x;
 	last_known_velocity_y_ = velocity_y;
 
 	if (is_initialized_ == false)
 	{
-		current_x_ = position_x;
-		current_y_ = position_y;
+		current_x_ = last_known_position_x_;
+		current_y_ = last_known_position_y_;
 		current_velocity_x_ = velocity_x;
 		current_velocity_y_ = velocity_y;
 		current_acceleration_x_ = 0.0f;
@@ -34,13 +35,18 @@ void DeadReckoningControl::SetLastKnown(const float position_x, const float posi
 		return;
 	}
 
+	if (time_since_last_update_secs <= 0.0f)
+	{
+		return;
+	}
+
 	current_acceleration_x_ = (velocity_x - current_velocity_x_) / time_since_last_update_secs;
 	current_acceleration_y_ = (velocity_y - current_velocity_y_) / time_since_last_update_secs;
 
-	//if (LabMath::IsWithinDistance(position_x, position_y, current_x_, current_y_, 100.0f) == false)
+	//if (LabMath::IsWithinDistance(last_known_position_x_, last_known_position_y_, current_x_, current_y_, 100.0f) == false)
 	//{
-	//	current_x_ = position_x;
-	//	current_y_ = position_y;
+	//	current_x_ = last_known_position_x_;
+	//	current_y_ = last_known_position_y_;
 	//}
 }
 
@@ -20,7 +20,7 @@ class DeadReckoningControl final
 {
 public:
 	void SetLastKnown(float position_x, float position_y, 
-		float velocity_x, float velocity_y, float time_since_last_update_secs, u_long remote_frame);
+		float velocity_x, float velocity_y, float time_since_last_update_secs, float data_age_secs, u_long remote_frame);
 
 	void Update(float dt) override;
 	void Draw() override;
@@ -32,7 +32,7 @@ private:
 	float current_acceleration_x_ = 0.0f, current_acceleration_y_ = 0.0f;
 	bool is_initialized_ = false;
 
-	// retaining the last known position and velocity for visualization
+	// retaining the last known position, projected by the state's age, and velocity for visualization
 	float last_known_position_x_ = 0.0f, last_known_position_y_ = 0.0f;
 	float last_known_velocity_x_ = 0.0f, last_known_velocity_y_ = 0.0f;
 
@@ -9,21 +9,54 @@
 //---------------------------------------------------------
 #include "pch.h"
 #include "DumbClientScenarioState.h"
-#include "PacketSerializer.h"
+#include "MessageSchema.h"
 
-const int kNetworkBufferSize = 1024;
 const float kDeterministicDt = 1.0f / 30.0f;
 
 
-DumbClientScenarioState::DumbClientScenarioState(const SOCKET socket, const bool is_host)
-	: NetworkedScenarioState(socket, is_host),
+namespace
+{
+	/// <summary>
+	/// Sent from the host to the client: the authoritative positions of both players.
+	/// </summary>
+	/// <remarks>CONVENTION: host values come before non-host values.  The frame is written ahead of the schema.</remarks>
+	struct PositionsMessage
+	{
+		u_long frame = 0;
+		float host_x = 0.0f, host_y = 0.0f;
+		float non_host_x = 0.0f, non_host_y = 0.0f;
+	};
+
+	/// <summary>
+	/// Sent from the client to the host: the client's control state.
+	/// </summary>
+	/// <remarks>The frame is written ahead of the schema.</remarks>
+	struct ControlMessage
+	{
+		u_long frame = 0;
+		bool is_paused = false;
+	};
+
+	using PositionsSchema = MessageSchema::Schema<PositionsMessage,
+		MessageSchema::Value<&PositionsMessage::host_x>,
+		MessageSchema::Value<&PositionsMessage::host_y>,
+		MessageSchema::Value<&PositionsMessage::non_host_x>,
+		MessageSchema::Value<&PositionsMessage::non_host_y>>;
+	static_assert(PositionsSchema::kMaxBytes <= kMaxDatagramSize, "PositionsMessage must fit in the network buffer");
+
+	using ControlSchema = MessageSchema::Schema<ControlMessage,
+		MessageSchema::Value<&ControlMessage::is_paused>>;
+	static_assert(ControlSchema::kMaxBytes <= kMaxDatagramSize, "ControlMessage must fit in the network buffer");
+}
+
+DumbClientScenarioState::DumbClientScenarioState(std::unique_ptr<DatagramTransport> transport, const bool is_host)
+	: NetworkedScenarioState(std::move(transport), is_host),
 	host_control_(200.0f, 250.0f, 100.0f, 1.0f),
 	non_host_control_(200.0f, 150.0f, 100.0f, 2.0f),
 	is_remote_paused_(false),
 	local_frame_(0),
 	remote_frame_(0),
-	is_frame_waiting_(true),
-	packet_(kNetworkBufferSize)
+	is_frame_waiting_(true)
 {
 	local_player_.color = CP_Color_Create(255, 0, 0, 255);
 	remote_player_.color = CP_Color_Create(0, 0, 255, 255);
@@ -48,7 +81,7 @@ void DumbClientScenarioState::Update()
 	// if the frames are up to date (or we are not waiting):
 	// 1) Update the simulation IF we are the host
 	// 2) Send the current state
-	if (!is_frame_waiting_ || (local_frame_ <= remote_frame_))
+	if (!is_frame_waiting_ || !PacketSerializer::IsFrameNewer(local_frame_, remote_frame_))
 	{
 		const bool is_local_paused = CP_Input_KeyDown(KEY_SPACE);
 		if (is_host_)
@@ -64,52 +97,65 @@ void DumbClientScenarioState::Update()
 		}
 
 		packet_.Reset();
-		PacketSerializer::WriteValue<u_long>(packet_, ++local_frame_);
-		// the client only sends control updates, while the host sends all positions
+		// neither side acknowledges frames, so the frame is written with the unacked window
+		// -- the client only sends control updates, while the host sends all positions
 		if (is_host_)
 		{
-			PacketSerializer::WriteValue<float>(packet_, host_control_.GetCurrentX());
-			PacketSerializer::WriteValue<float>(packet_, host_control_.GetCurrentY());
-			PacketSerializer::WriteValue<float>(packet_, non_host_control_.GetCurrentX());
-			PacketSerializer::WriteValue<float>(packet_, non_host_control_.GetCurrentY());
+			PositionsMessage message;
+			message.frame = ++local_frame_;
+			message.host_x = host_control_.GetCurrentX();
+			message.host_y = host_control_.GetCurrentY();
+			message.non_host_x = non_host_control_.GetCurrentX();
+			message.non_host_y = non_host_control_.GetCurrentY();
+			PacketSerializer::WriteFrame(packet_, message.frame);
+			PositionsSchema::Write(packet_, message);
 		}
 		else
 		{
-			PacketSerializer::WriteValue<bool>(packet_, is_local_paused);
+			ControlMessage message;
+			message.frame = ++local_frame_;
+			message.is_paused = is_local_paused;
+			PacketSerializer::WriteFrame(packet_, message.frame);
+			ControlSchema::Write(packet_, message);
 		}
 
-		send(socket_, packet_.GetRoot(), packet_.GetUsedSpace(), 0);
+		SendDatagram(packet_);
 	}
 	
 	// if we are ahead of the remote, look for network data
-	if (!is_frame_waiting_ || (remote_frame_ < local_frame_))
+	if (!is_frame_waiting_ || PacketSerializer::IsFrameNewer(local_frame_, remote_frame_))
 	{
-		packet_.Reset();		
-		const auto res = recv(socket_, packet_.GetRoot(), packet_.GetRemainingSpace(), 0);
-		if (res > 0)
-		{
-			u_long received_frame;
-			PacketSerializer::ReadValue<u_long>(packet_, received_frame);
-			if (received_frame > remote_frame_)
+		// only the newest message matters, as each carries the complete state
+		DrainReceivedDatagrams([this](Packet& datagram)
 			{
-				remote_frame_ = received_frame;
 				// the host only receives control updates, while the client receives all positions
 				if (is_host_)
 				{
-					PacketSerializer::ReadValue<bool>(packet_, is_remote_paused_);
+					ControlMessage message;
+					if (!PacketSerializer::ReadFrame(datagram, message.frame, remote_frame_) ||
+						!ControlSchema::Read(datagram, message) ||
+						!PacketSerializer::IsFrameNewer(message.frame, remote_frame_))
+					{
+						return false;
+					}
+					remote_frame_ = message.frame;
+					is_remote_paused_ = message.is_paused;
 				}
 				else
 				{
-					float host_x, host_y, non_host_x, non_host_y;
-					PacketSerializer::ReadValue<float>(packet_, host_x);
-					PacketSerializer::ReadValue<float>(packet_, host_y);
-					PacketSerializer::ReadValue<float>(packet_, non_host_x);
-					PacketSerializer::ReadValue<float>(packet_, non_host_y);
-					remote_player_.SetPosition(host_x, host_y);
-					local_player_.SetPosition(non_host_x, non_host_y);
+					PositionsMessage message;
+					if (!PacketSerializer::ReadFrame(datagram, message.frame, remote_frame_) ||
+						!PositionsSchema::Read(datagram, message) ||
+						!PacketSerializer::IsFrameNewer(message.frame, remote_frame_))
+					{
+						return false;
+					}
+					remote_frame_ = message.frame;
+					remote_player_.SetPosition(message.host_x, message.host_y);
+					local_player_.SetPosition(message.non_host_x, message.non_host_y);
 				}
-			}
-		}
+				return true;
+			});
 	}
 
 	if (is_host_)
@@ -122,7 +168,7 @@ void DumbClientScenarioState::Update()
 
 void DumbClientScenarioState::Draw()
 {
-	ScenarioState::Draw();
+	NetworkedScenarioState::Draw();
 
 	local_player_.Draw();
 	remote_player_.Draw();
@@ -148,23 +194,7 @@ std::string DumbClientScenarioState::GetInstructions() const
 }
 
 
-bool DumbClientScenarioState::HandleSocketError(const char* error_text)
+NetworkedScenarioState::View DumbClientScenarioState::GetView() const
 {
-	const auto wsa_error = WSAGetLastError();
-
-	// ignore WSAEWOULDBLOCK
-	if (wsa_error == WSAEWOULDBLOCK)
-	{
-		return false;
-	}
-
-	// log unexpected errors and return to the default game mode
-	std::cerr << "DumbClient WinSock Error: " << error_text << wsa_error << std::endl;
-
-	// close the socket and clear it
-	// -- this should trigger a GameStateManager reset in the next Update
-	closesocket(socket_);
-	socket_ = INVALID_SOCKET;
-
-	return true;
+	return { local_frame_, remote_frame_, local_player_.GetX(), local_player_.GetY(), remote_player_.GetX(), remote_player_.GetY() };
 }
\ No newline at end of file
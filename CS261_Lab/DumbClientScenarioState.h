@@ -21,7 +21,7 @@ class DumbClientScenarioState final
 	: public NetworkedScenarioState
 {
 public:
-    DumbClientScenarioState(const SOCKET socket, const bool is_host);
+    DumbClientScenarioState(std::unique_ptr<DatagramTransport> transport, const bool is_host);
     ~DumbClientScenarioState() override;
 
     DumbClientScenarioState(const DumbClientScenarioState&) = delete;
@@ -34,10 +34,9 @@ public:
 
     std::string GetDescription() const override;
     std::string GetInstructions() const override;
+    View GetView() const override;
 
 private:
-    bool HandleSocketError(const char* error_text);
-
     DoubleOrbitControl host_control_;
     DoubleOrbitControl non_host_control_;
 
@@ -50,5 +49,5 @@ private:
     u_long remote_frame_;
     bool is_frame_waiting_;
 
-    Packet packet_;
+    FixedPacket<kMaxDatagramSize> packet_;
 };
\ No newline at end of file
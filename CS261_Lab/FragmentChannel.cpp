@@ -0,0 +1,220 @@
+//---------------------------------------------------------
+// file:	FragmentChannel.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Splits messages too large for one datagram into fragments, and reassembles them on the other side.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "FragmentChannel.h"
+#include "PacketSerializer.h"
+
+const float kReassemblyTimeout_Secs = 1.0f; // how long a partly received message waits for the rest of its fragments
+const unsigned int kMaxFragmentHeaderSize = 5; // the message id (a varint of up to 3 bytes), the index, and the count
+const unsigned int kOtherMessagesRoom = 48; // kept free in a fragment's datagram, for the reliable header and a time message
+
+static_assert(FragmentChannel::kMaxFragmentCount <= 32, "Reassembly::received_bits must hold a bit for every fragment");
+static_assert(FragmentChannel::kMaxFragmentCount <= 255, "the fragment index and count are written as one byte each");
+static_assert(FragmentChannel::kFragmentSize + MessageWriter::kMaxHeaderSize + kMaxFragmentHeaderSize + kOtherMessagesRoom <= kMaxDatagramSize, "a fragment must fit in a datagram alongside the per-datagram messages");
+static_assert(FragmentChannel::kMaxMessageSize <= MessageWriter::kMaxPayloadSize, "a whole message must fit in a fragment-wrapped payload's length");
+
+
+FragmentChannel::FragmentChannel(MessageDispatcher& dispatcher)
+	: dispatcher_(dispatcher),
+	time_secs_(0.0f),
+	next_message_id_(0),
+	outgoing_id_(0),
+	outgoing_size_(0),
+	outgoing_fragment_count_(0),
+	next_outgoing_fragment_(0),
+	outgoing_data_(),
+	reassemblies_(),
+	completed_ids_(),
+	completed_count_(0),
+	next_completed_(0),
+	is_dispatching_(false),
+	stats_()
+{
+	dispatcher_.Register(kFragmentMessageType, [this](Packet& payload) { return ReceiveFragment(payload); });
+}
+
+
+/// <summary>
+/// Advance the clock, and drop any message that has waited too long for the rest of its fragments.
+/// </summary>
+void FragmentChannel::Update(const float dt)
+{
+	time_secs_ += dt;
+	for (auto& reassembly : reassemblies_)
+	{
+		if (reassembly.is_active && (time_secs_ - reassembly.start_secs > kReassemblyTimeout_Secs))
+		{
+			reassembly.is_active = false;
+			++stats_.messages_timed_out;
+		}
+	}
+}
+
+
+/// <summary>
+/// Write the next fragment of the queued message into the datagram.
+/// </summary>
+/// <remarks>A fragment nearly fills a datagram, so write it into one that carries little else.</remarks>
+/// <returns>If false, there was nothing to write, or the fragment did not fit and is left for the next datagram.</returns>
+bool FragmentChannel::WriteFragment(MessageWriter& writer)
+{
+	if (!HasPendingFragments())
+	{
+		return false;
+	}
+
+	const auto offset = next_outgoing_fragment_ * kFragmentSize;
+	const auto size = std::min(outgoing_size_ - offset, kFragmentSize);
+	const bool is_written = writer.Write(kFragmentMessageType, [&](Packet& payload)
+		{
+			return PacketSerializer::WriteVarUInt(payload, outgoing_id_) &&
+				PacketSerializer::WriteValue<uint8_t>(payload, static_cast<uint8_t>(next_outgoing_fragment_)) &&
+				PacketSerializer::WriteValue<uint8_t>(payload, static_cast<uint8_t>(outgoing_fragment_count_)) &&
+				PacketSerializer::WriteBytes(payload, outgoing_data_.data() + offset, size);
+		});
+	if (!is_written)
+	{
+		return false;
+	}
+
+	++next_outgoing_fragment_;
+	++stats_.fragments_sent;
+	return true;
+}
+
+
+bool FragmentChannel::ReceiveFragment(Packet& payload)
+{
+	// a reassembled message is framed by the peer, and must not carry fragments of its own
+	if (is_dispatching_)
+	{
+		return false;
+	}
+
+	uint32_t id;
+	uint8_t index, fragment_count;
+	if (!PacketSerializer::ReadVarUInt(payload, id) || (id > 0xFFFF) ||
+		!PacketSerializer::ReadValue<uint8_t>(payload, index) ||
+		!PacketSerializer::ReadValue<uint8_t>(payload, fragment_count) ||
+		(fragment_count == 0) || (fragment_count > kMaxFragmentCount) || (index >= fragment_count))
+	{
+		return false;
+	}
+
+	// every fragment but the last is full, so the offset follows from the index
+	const auto size = payload.GetRemainingSpace();
+	const bool is_last = (index == fragment_count - 1);
+	if ((size == 0) || (size > kFragmentSize) || (!is_last && (size != kFragmentSize)))
+	{
+		return false;
+	}
+
+	if (IsCompleted(static_cast<uint16_t>(id)))
+	{
+		++stats_.fragments_duplicate;
+		return true;
+	}
+	Reassembly* reassembly = FindReassembly(static_cast<uint16_t>(id), fragment_count);
+	if (reassembly == nullptr)
+	{
+		++stats_.fragments_stale;
+		return true;
+	}
+	if (reassembly->fragment_count != fragment_count)
+	{
+		return false;
+	}
+	const auto bit = 1u << index;
+	if ((reassembly->received_bits & bit) != 0)
+	{
+		++stats_.fragments_duplicate;
+		return true;
+	}
+	++stats_.fragments_received;
+
+	memcpy(reassembly->data.data() + index * kFragmentSize, payload.GetTarget(), size);
+	reassembly->received_bits |= bit;
+	++reassembly->received_count;
+	if (is_last)
+	{
+		reassembly->size = index * kFragmentSize + size;
+	}
+	if (reassembly->received_count < reassembly->fragment_count)
+	{
+		return true;
+	}
+
+	// complete, so hand the message to its handler, framed as MessageWriter wrote it
+	completed_ids_[next_completed_] = reassembly->id;
+	next_completed_ = (next_completed_ + 1) % kCompletedHistorySize;
+	completed_count_ = std::min(completed_count_ + 1, kCompletedHistorySize);
+	++stats_.messages_received;
+	Packet message(reassembly->data.data(), reassembly->size);
+	is_dispatching_ = true;
+	dispatcher_.Dispatch(message);
+	is_dispatching_ = false;
+	reassembly->is_active = false;
+	return true;
+}
+
+
+bool FragmentChannel::IsCompleted(const uint16_t id) const
+{
+	return std::find(completed_ids_.begin(), completed_ids_.begin() + completed_count_, id) != completed_ids_.begin() + completed_count_;
+}
+
+
+/// <summary>
+/// Is id newer than than_id, allowing for the 16-bit counter wrapping around?
+/// </summary>
+bool FragmentChannel::IsIdNewer(const uint16_t id, const uint16_t than_id)
+{
+	return static_cast<int16_t>(static_cast<uint16_t>(id - than_id)) > 0;
+}
+
+
+/// <summary>
+/// Find the reassembly for a message, or start one, pushing out the oldest message if every slot is in use.
+/// </summary>
+/// <remarks>The caller checks that the fragment count agrees with earlier fragments of the message.</remarks>
+/// <returns>The reassembly, or nullptr if every slot holds a newer message, so this one is stale.</returns>
+FragmentChannel::Reassembly* FragmentChannel::FindReassembly(const uint16_t id, const unsigned int fragment_count)
+{
+	Reassembly* target = nullptr;
+	for (auto& reassembly : reassemblies_)
+	{
+		if (reassembly.is_active && (reassembly.id == id))
+		{
+			return &reassembly;
+		}
+		if ((target == nullptr) || (target->is_active && (!reassembly.is_active || IsIdNewer(target->id, reassembly.id))))
+		{
+			target = &reassembly;
+		}
+	}
+
+	if (target->is_active)
+	{
+		// a message pushed out may still have fragments on the way, which must not push out newer ones in turn
+		if (!IsIdNewer(id, target->id))
+		{
+			return nullptr;
+		}
+		++stats_.messages_displaced;
+	}
+	target->is_active = true;
+	target->id = id;
+	target->fragment_count = fragment_count;
+	target->received_bits = 0;
+	target->received_count = 0;
+	target->size = 0;
+	target->start_secs = time_secs_;
+	return target;
+}
\ No newline at end of file
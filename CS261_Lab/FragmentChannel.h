@@ -0,0 +1,139 @@
+//---------------------------------------------------------
+// file:	FragmentChannel.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Splits messages too large for one datagram into fragments, and reassembles them on the other side.
+//
+// remarks: Each fragment rides in a wrapper message with the message's id, its own index, and the fragment count.
+//          Every fragment but the last carries exactly kFragmentSize bytes, so its offset follows from its index.
+//          Fragments are sent unreliably: a message is dispatched once all of its fragments arrive, in any order,
+//          and a message still missing fragments after a timeout, or pushed out by newer ones, is dropped.
+//          Message ids only increase, so a fragment older than every message in progress is dropped too.
+//          All buffers are allocated up front, so a flood of fragments cannot grow memory.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <array>
+#include "Packet.h"
+#include "MessageWriter.h"
+#include "MessageDispatcher.h"
+
+
+/// <summary>
+/// Splits messages too large for one datagram into fragments, and reassembles them on the other side.
+/// </summary>
+class FragmentChannel
+{
+public:
+	/// <summary>
+	/// Counters for the fragmented messages sent and received.
+	/// </summary>
+	struct Stats
+	{
+		unsigned int messages_sent; // messages queued and split into fragments
+		unsigned int fragments_sent;
+		unsigned int fragments_received; // fragments added to a message in progress
+		unsigned int fragments_duplicate; // fragments received more than once, or after their message was complete
+		unsigned int fragments_stale; // fragments of a message older than every one in progress, after it was pushed out
+		unsigned int messages_received; // messages reassembled and dispatched
+		unsigned int messages_timed_out; // incomplete messages dropped after waiting too long for the rest
+		unsigned int messages_displaced; // incomplete messages dropped to make room for a newer one
+	};
+
+	// the wrapper type around fragments, which must not be used by any other message
+	static const MessageTypeId kFragmentMessageType = 253;
+	// the bytes of the message carried by every fragment but the last, leaving room in the datagram for the
+	// reliable channel's header, a time message, and the fragment's own header
+	static constexpr unsigned int kFragmentSize = 960;
+	// the most fragments in one message, and so the largest message, including its own header
+	static const unsigned int kMaxFragmentCount = 8;
+	static const unsigned int kMaxMessageSize = kFragmentSize * kMaxFragmentCount;
+	// the most messages that may be partly received at once
+	static const unsigned int kMaxReassemblies = 4;
+	// the most recently completed messages remembered, so late duplicates of their fragments are dropped
+	static constexpr unsigned int kCompletedHistorySize = 8;
+
+	FragmentChannel(MessageDispatcher& dispatcher);
+
+	FragmentChannel(const FragmentChannel&) = delete;
+	FragmentChannel& operator=(const FragmentChannel&) = delete;
+
+	void Update(float dt);
+
+	/// <summary>
+	/// Queue a message to be split into fragments, as written by write_message(MessageWriter&).
+	/// </summary>
+	/// <remarks>Write the fragments with WriteFragment, one per datagram, until HasPendingFragments is false.</remarks>
+	/// <returns>If false, the message was too large, or the previous one has not been written out yet, and it was dropped.</returns>
+	template <typename WriteMessage>
+	bool Queue(WriteMessage&& write_message)
+	{
+		if (HasPendingFragments())
+		{
+			return false;
+		}
+
+		Packet packet(outgoing_data_.data(), kMaxMessageSize);
+		MessageWriter writer(packet);
+		if (!write_message(writer) || (writer.GetMessageCount() == 0))
+		{
+			return false;
+		}
+		outgoing_size_ = packet.GetUsedSpace();
+		outgoing_fragment_count_ = (outgoing_size_ + kFragmentSize - 1) / kFragmentSize;
+		next_outgoing_fragment_ = 0;
+		outgoing_id_ = next_message_id_++;
+		++stats_.messages_sent;
+		return true;
+	}
+
+	bool WriteFragment(MessageWriter& writer);
+	bool HasPendingFragments() const { return next_outgoing_fragment_ < outgoing_fragment_count_; }
+
+	const Stats& GetStats() const { return stats_; }
+
+private:
+	/// <summary>
+	/// A message partly received, with the fragments that have arrived so far.
+	/// </summary>
+	struct Reassembly
+	{
+		bool is_active;
+		uint16_t id;
+		unsigned int fragment_count;
+		uint32_t received_bits; // one bit per fragment index
+		unsigned int received_count;
+		unsigned int size; // known once the last fragment arrives
+		float start_secs;
+		std::array<char, kMaxMessageSize> data;
+	};
+
+	static bool IsIdNewer(uint16_t id, uint16_t than_id);
+
+	bool ReceiveFragment(Packet& payload);
+	bool IsCompleted(uint16_t id) const;
+	Reassembly* FindReassembly(uint16_t id, unsigned int fragment_count);
+
+	MessageDispatcher& dispatcher_;
+	float time_secs_;
+
+	// sending, one message at a time
+	uint16_t next_message_id_;
+	uint16_t outgoing_id_;
+	unsigned int outgoing_size_;
+	unsigned int outgoing_fragment_count_;
+	unsigned int next_outgoing_fragment_;
+	std::array<char, kMaxMessageSize> outgoing_data_;
+
+	// receiving
+	std::array<Reassembly, kMaxReassemblies> reassemblies_;
+	std::array<uint16_t, kCompletedHistorySize> completed_ids_;
+	unsigned int completed_count_;
+	unsigned int next_completed_;
+	bool is_dispatching_; // a reassembled message is being handled
+
+	Stats stats_;
+};
\ No newline at end of file
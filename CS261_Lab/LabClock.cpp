@@ -0,0 +1,37 @@
+//---------------------------------------------------------
+// file:	LabClock.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	The clock the networking code times datagrams with: the steady clock, unless a run has taken manual control.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "LabClock.h"
+
+std::atomic<bool> LabClock::is_manual_(false);
+std::atomic<LabClock::rep> LabClock::manual_ticks_(0);
+
+
+/// <summary>
+/// Take manual control of the clock, which then stands still until advanced, or hand it back to the steady clock.
+/// </summary>
+/// <remarks>Manual time starts from the steady clock's time now, so time points already taken stay in the past.</remarks>
+void LabClock::SetManual(const bool is_manual)
+{
+	if (is_manual && !IsManual())
+	{
+		manual_ticks_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+	}
+	is_manual_.store(is_manual, std::memory_order_relaxed);
+}
+
+
+/// <summary>
+/// Move manual time forward.  Does nothing unless the clock is manual.
+/// </summary>
+void LabClock::Advance(const duration elapsed)
+{
+	manual_ticks_.fetch_add(std::max(elapsed, duration::zero()).count(), std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+//---------------------------------------------------------
+// file:	LabClock.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	The clock the networking code times datagrams with: the steady clock, unless a run has taken manual control.
+//
+// remarks: A run that drives the scenarios itself, such as the headless loopback check, switches the clock to manual,
+//          then advances it one tick at a time, so every timestamp, round trip, and simulated delay is repeatable.
+//          The time points are the steady clock's, so the two may be mixed freely.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <chrono>
+
+
+/// <summary>
+/// The clock the networking code times datagrams with: the steady clock, unless a run has taken manual control.
+/// </summary>
+class LabClock
+{
+public:
+	using rep = std::chrono::steady_clock::rep;
+	using period = std::chrono::steady_clock::period;
+	using duration = std::chrono::steady_clock::duration;
+	using time_point = std::chrono::steady_clock::time_point;
+	static constexpr bool is_steady = true;
+
+	/// <summary>
+	/// The manual time, if it has been set, or the steady clock's.
+	/// </summary>
+	static time_point now()
+	{
+		return is_manual_.load(std::memory_order_relaxed) ?
+			time_point(duration(manual_ticks_.load(std::memory_order_relaxed))) :
+			std::chrono::steady_clock::now();
+	}
+
+	static void SetManual(bool is_manual);
+	static void Advance(duration elapsed);
+	static bool IsManual() { return is_manual_.load(std::memory_order_relaxed); }
+
+private:
+	// the networking threads read the clock too, so the state is atomic, though only one thread should set it
+	static std::atomic<bool> is_manual_;
+	static std::atomic<rep> manual_ticks_;
+};
\ No newline at end of file
@@ -15,4 +15,18 @@ namespace LabMath
 	const float kTwoPi = static_cast<float>(M_PI) * 2.0f;
 
 	bool IsWithinDistance(const float a_x, const float a_y, const float b_x, const float b_y, const float distance);
+
+	/// <summary>
+	/// The number of bits needed to represent every value from 0 to range, inclusive.
+	/// </summary>
+	constexpr unsigned int BitsRequired(uint32_t range)
+	{
+		unsigned int bits = 0;
+		while (range > 0)
+		{
+			++bits;
+			range >>= 1;
+		}
+		return (bits > 0) ? bits : 1;
+	}
 };
\ No newline at end of file
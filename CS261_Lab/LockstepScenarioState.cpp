@@ -9,20 +9,37 @@
 //---------------------------------------------------------
 #include "pch.h"
 #include "LockstepScenarioState.h"
-#include "PacketSerializer.h"
+#include "MessageSchema.h"
 
-const int kNetworkBufferSize = 1024;
 const float kDeterministicDt = 1.0f / 30.0f;
 
 
-LockstepScenarioState::LockstepScenarioState(const SOCKET socket, const bool is_host)
-	: NetworkedScenarioState(socket, is_host),
+namespace
+{
+	/// <summary>
+	/// Sent by both the host and the client: the sender's frame and control state.
+	/// </summary>
+	/// <remarks>The frame is written ahead of the schema, relative to the frames the peer has received.</remarks>
+	struct LockstepMessage
+	{
+		u_long frame = 0;
+		bool is_paused = false;
+	};
+
+	using LockstepSchema = MessageSchema::Schema<LockstepMessage,
+		MessageSchema::Value<&LockstepMessage::is_paused>>;
+	static_assert(LockstepSchema::kMaxBytes <= kMaxDatagramSize, "LockstepMessage must fit in the network buffer");
+}
+
+
+LockstepScenarioState::LockstepScenarioState(std::unique_ptr<DatagramTransport> transport, const bool is_host)
+	: NetworkedScenarioState(std::move(transport), is_host),
 	  host_control_(200.0f, 250.0f, 100.0f, 1.0f),
 	  non_host_control_(200.0f, 150.0f, 100.0f, 2.0f),
-	  isRemotePaused_(false),
+	  isLocalPaused_(false),
+	  isRemotePaused_{ false, false },
 	  local_frame_(0),
-	  remote_frame_(0),
-	  packet_(kNetworkBufferSize)
+	  remote_frame_(0)
 {
 	local_player_.color = CP_Color_Create(255, 0, 0, 255);
 	remote_player_.color = CP_Color_Create(0, 0, 255, 255);
@@ -40,42 +57,50 @@ void LockstepScenarioState::Update()
 	auto* remote_control = is_host_ ? &non_host_control_ : &host_control_;
 
 	// if we are behind the remote, update until we catch up
-	if (local_frame_ <= remote_frame_)
+	if (!PacketSerializer::IsFrameNewer(local_frame_, remote_frame_))
 	{
 		const float dt = 1.0f / 30.0f;
-		const bool is_local_paused = CP_Input_KeyDown(KEY_SPACE);
-		// both the host and client update the simulation
-		if (!is_local_paused)
+		// both the host and client update the simulation, with the pauses both sent with the current frame
+		// -- the remote may have sent the next frame already, so its pause for this one is kept by parity
+		if (!isLocalPaused_)
 		{
 			local_control->Update(kDeterministicDt);
 		}
-		if (!isRemotePaused_)
+		if (!isRemotePaused_[local_frame_ & 1])
 		{
 			remote_control->Update(kDeterministicDt);
 		}
 
+		// the pause pressed now is sent with the next frame, and applied by both sides from there
+		isLocalPaused_ = CP_Input_KeyDown(KEY_SPACE);
+		LockstepMessage message;
+		message.frame = ++local_frame_;
+		message.is_paused = isLocalPaused_;
 		packet_.Reset();
-		PacketSerializer::WriteValue<u_long>(packet_, ++local_frame_);
-		PacketSerializer::WriteValue<bool>(packet_, is_local_paused);
+		// the remote only reached remote_frame_ after receiving our previous frame, so that frame is implicitly acked
+		PacketSerializer::WriteFrame(packet_, message.frame, remote_frame_ - 1);
+		LockstepSchema::Write(packet_, message);
 
-		send(socket_, packet_.GetRoot(), packet_.GetUsedSpace(), 0);
+		SendDatagram(packet_);
 	}
 
 	// if the remote is behind us, look for updates on the network
-	if (remote_frame_ <= local_frame_)
+	// -- the remote never runs more than a frame ahead, so any older frames waiting are duplicates
+	if (!PacketSerializer::IsFrameNewer(remote_frame_, local_frame_))
 	{
-		packet_.Reset();
-		const auto res = recv(socket_, packet_.GetRoot(), packet_.GetRemainingSpace(), 0);
-		if (res > 0)
-		{
-			u_long received_frame;
-			PacketSerializer::ReadValue<u_long>(packet_, received_frame);
-			if (received_frame > remote_frame_)
+		DrainReceivedDatagrams([this](Packet& datagram)
 			{
-				remote_frame_ = received_frame;
-				PacketSerializer::ReadValue<bool>(packet_, isRemotePaused_);
-			}
-		}
+				LockstepMessage message;
+				if (!PacketSerializer::ReadFrame(datagram, message.frame, remote_frame_) ||
+					!LockstepSchema::Read(datagram, message) ||
+					!PacketSerializer::IsFrameNewer(message.frame, remote_frame_))
+				{
+					return false;
+				}
+				remote_frame_ = message.frame;
+				isRemotePaused_[remote_frame_ & 1] = message.is_paused;
+				return true;
+			});
 	}
 
 	// apply whatever information we have
@@ -86,7 +111,7 @@ void LockstepScenarioState::Update()
 
 void LockstepScenarioState::Draw()
 {
-    ScenarioState::Draw();
+    NetworkedScenarioState::Draw();
 
 	local_player_.Draw();
 	remote_player_.Draw();
@@ -111,23 +136,7 @@ std::string LockstepScenarioState::GetInstructions() const
 }
 
 
-bool LockstepScenarioState::HandleSocketError(const char* error_text)
+NetworkedScenarioState::View LockstepScenarioState::GetView() const
 {
-	const auto wsa_error = WSAGetLastError();
-
-	// ignore WSAEWOULDBLOCK
-	if (wsa_error == WSAEWOULDBLOCK)
-	{
-		return false;
-	}
-
-	// log unexpected errors and return to the default game mode
-	std::cerr << "Lockstep WinSock Error: " << error_text << wsa_error << std::endl;
-
-	// close the socket and clear it
-	// -- this should trigger a GameStateManager reset in the next Update
-	closesocket(socket_);
-	socket_ = INVALID_SOCKET;
-
-	return true;
+	return { local_frame_, remote_frame_, local_player_.GetX(), local_player_.GetY(), remote_player_.GetX(), remote_player_.GetY() };
 }
\ No newline at end of file
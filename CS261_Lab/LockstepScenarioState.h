@@ -21,7 +21,7 @@ class LockstepScenarioState final:
     public NetworkedScenarioState
 {
 public:
-    LockstepScenarioState(const SOCKET socket, const bool is_host);
+    LockstepScenarioState(std::unique_ptr<DatagramTransport> transport, const bool is_host);
     ~LockstepScenarioState() override;
 
     LockstepScenarioState(const LockstepScenarioState&) = delete;
@@ -34,20 +34,21 @@ public:
 
     std::string GetDescription() const override;
     std::string GetInstructions() const override;
+    View GetView() const override;
 	
 private:
-    bool HandleSocketError(const char* error_text);
-
     DoubleOrbitControl host_control_;
     DoubleOrbitControl non_host_control_;
 
     Player local_player_;
     Player remote_player_;
 
-    bool isRemotePaused_;
+    // each side's pause is sent with a frame, and applied by both sides when simulating on from that frame
+    bool isLocalPaused_; // as sent with our newest frame
+    bool isRemotePaused_[2]; // as sent with the remote's two newest frames, by the frame's parity
 
     u_long local_frame_;
     u_long remote_frame_;
 
-    Packet packet_;
+    FixedPacket<kMaxDatagramSize> packet_;
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+//---------------------------------------------------------
+// file:	LoopbackTransport.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Connects two scenarios in one process, handing datagrams from one to the other in memory.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "LoopbackTransport.h"
+#include <array>
+#include "PacketBufferPool.h"
+#include "SpscQueue.h"
+
+// received datagrams may be held a while (as NetworkConditionTransport does), so the pool outlasts a full queue
+const unsigned int kPoolSize = 2 * LoopbackTransport::kQueueCapacity;
+
+
+/// <summary>
+/// The datagrams waiting in each direction, and whether each end is still exchanging them.
+/// </summary>
+struct LoopbackTransport::Link
+{
+	struct Direction
+	{
+		Direction() : pool(kPoolSize), overflow_count(0), is_stopped(false) { }
+
+		PacketBufferPool pool;
+		SpscQueue<ReceivedDatagram, kQueueCapacity> queue; // only ever used from one thread, but never allocates
+		unsigned int overflow_count; // datagrams dropped because the receiving end was not keeping up
+		bool is_stopped; // the receiving end has stopped, or gone
+	};
+
+	std::array<Direction, 2> directions;
+};
+
+
+/// <summary>
+/// Create two connected ends, one for each scenario.
+/// </summary>
+std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>> LoopbackTransport::CreatePair()
+{
+	const auto link = std::make_shared<Link>();
+	return { std::unique_ptr<LoopbackTransport>(new LoopbackTransport(link, 0)), std::unique_ptr<LoopbackTransport>(new LoopbackTransport(link, 1)) };
+}
+
+
+LoopbackTransport::LoopbackTransport(std::shared_ptr<Link> link, const unsigned int side)
+	: link_(std::move(link)), side_(side)
+{ }
+
+
+LoopbackTransport::~LoopbackTransport()
+{
+	Stop();
+}
+
+
+/// <summary>
+/// Copy the packet's used space into a datagram waiting for the other end.
+/// </summary>
+/// <returns>If false, either end has stopped, or the other end has fallen too far behind, and the datagram was dropped.</returns>
+bool LoopbackTransport::Send(const Packet& packet)
+{
+	auto& direction = link_->directions[1 - side_];
+	if (direction.is_stopped || link_->directions[side_].is_stopped)
+	{
+		return false;
+	}
+
+	auto buffer = (direction.queue.GetSize() < kQueueCapacity) ? direction.pool.Acquire() : PacketBuffer();
+	if (!buffer.IsValid())
+	{
+		++direction.overflow_count;
+		return false;
+	}
+	memcpy(buffer.GetData(), packet.GetRoot(), packet.GetUsedSpace());
+	buffer.SetSize(packet.GetUsedSpace());
+	return direction.queue.Push({ std::move(buffer), Clock::now() });
+}
+
+
+/// <summary>
+/// Take the oldest datagram the other end has sent.
+/// </summary>
+/// <returns>If false, there were no datagrams waiting.</returns>
+bool LoopbackTransport::Receive(ReceivedDatagram& datagram)
+{
+	auto& direction = link_->directions[side_];
+	return !direction.is_stopped && direction.queue.Pop(datagram);
+}
+
+
+/// <summary>
+/// Stop exchanging datagrams.  Anything waiting for this end is dropped, and the other end's sends are refused.
+/// </summary>
+void LoopbackTransport::Stop()
+{
+	auto& direction = link_->directions[side_];
+	direction.is_stopped = true;
+	ReceivedDatagram dropped;
+	while (direction.queue.Pop(dropped))
+	{
+		dropped.buffer.Reset();
+	}
+}
+
+
+/// <summary>
+/// The datagrams the other end dropped because this end was not keeping up.
+/// </summary>
+unsigned int LoopbackTransport::GetOverflowCount() const
+{
+	return link_->directions[side_].overflow_count;
+}
\ No newline at end of file
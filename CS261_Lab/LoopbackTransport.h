@@ -0,0 +1,54 @@
+//---------------------------------------------------------
+// file:	LoopbackTransport.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Connects two scenarios in one process, handing datagrams from one to the other in memory.
+//
+// remarks: Made in pairs, one for each scenario.  A datagram sent by one is ready for the other at once, stamped
+//          with LabClock's time, so a run on a manual clock is the same every time.  Neither end is thread-safe:
+//          both scenarios must be updated from one thread, as the headless loopback check does.
+//          Wrap either end in a NetworkConditionTransport to put a simulated link between them.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <memory>
+#include <utility>
+#include "Packet.h"
+#include "DatagramTransport.h"
+
+
+/// <summary>
+/// Connects two scenarios in one process, handing datagrams from one to the other in memory.
+/// </summary>
+class LoopbackTransport :
+	public DatagramTransport
+{
+public:
+	// the datagrams that may be waiting in each direction, beyond which sends are dropped
+	static const unsigned int kQueueCapacity = 256;
+
+	static std::pair<std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>> CreatePair();
+
+	~LoopbackTransport() override;
+
+	LoopbackTransport(const LoopbackTransport&) = delete;
+	LoopbackTransport& operator=(const LoopbackTransport&) = delete;
+
+	// Inherited via DatagramTransport
+	bool Send(const Packet& packet) override;
+	bool Receive(ReceivedDatagram& datagram) override;
+	void Stop() override;
+	unsigned int GetOverflowCount() const override;
+
+private:
+	struct Link;
+
+	LoopbackTransport(std::shared_ptr<Link> link, unsigned int side);
+
+	// shared by both ends, so either may be destroyed first
+	std::shared_ptr<Link> link_;
+	unsigned int side_; // the direction this end receives from; it sends into the other
+};
\ No newline at end of file
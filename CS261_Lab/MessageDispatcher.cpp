@@ -0,0 +1,75 @@
+//---------------------------------------------------------
+// file:	MessageDispatcher.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Routes each message in a datagram, as written by MessageWriter, to the handler for its type.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "MessageDispatcher.h"
+#include "PacketSerializer.h"
+
+
+MessageDispatcher::MessageDispatcher()
+	: handlers_(), stats_(), is_failure_logged_(false)
+{
+}
+
+
+/// <summary>
+/// Set the handler for messages of the given type, replacing any previous handler.
+/// </summary>
+void MessageDispatcher::Register(const MessageTypeId type, Handler handler)
+{
+	handlers_[type] = std::move(handler);
+}
+
+
+/// <summary>
+/// Pass every message in the datagram to its handler, in the order they were written.
+/// </summary>
+/// <remarks>A message that its handler cannot read is counted and skipped; the rest of the datagram is still dispatched.</remarks>
+/// <returns>If false, the framing itself was malformed, and the rest of the datagram was dropped.</returns>
+bool MessageDispatcher::Dispatch(Packet& datagram)
+{
+	while (datagram.GetRemainingSpace() > 0)
+	{
+		MessageTypeId type;
+		uint32_t payload_size;
+		if (!PacketSerializer::ReadValue<MessageTypeId>(datagram, type) ||
+			!PacketSerializer::ReadVarUInt(datagram, payload_size) ||
+			(payload_size > datagram.GetRemainingSpace()))
+		{
+			++stats_.datagrams_malformed;
+			LogFirstFailure("Malformed message header, dropping the rest of the datagram");
+			return false;
+		}
+
+		Packet payload(datagram.GetTarget(), payload_size);
+		const auto& handler = handlers_[type];
+		if (handler && !handler(payload))
+		{
+			++stats_.messages_unreadable;
+			LogFirstFailure("A message could not be read, skipping it");
+		}
+		datagram.AdvanceUnchecked(payload_size);
+	}
+
+	return true;
+}
+
+
+
+/// <summary>
+/// Log the first failure only, since a peer sending garbage would otherwise flood the console every frame.
+/// </summary>
+void MessageDispatcher::LogFirstFailure(const char* failure)
+{
+	if (!is_failure_logged_)
+	{
+		std::cout << failure << "; further failures are only counted" << std::endl;
+		is_failure_logged_ = true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+//---------------------------------------------------------
+// file:	MessageDispatcher.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Routes each message in a datagram, as written by MessageWriter, to the handler for its type.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <array>
+#include <functional>
+#include "Packet.h"
+#include "MessageWriter.h"
+
+
+/// <summary>
+/// Routes each message in a datagram, as written by MessageWriter, to the handler for its type.
+/// </summary>
+/// <remarks>Messages with no handler are skipped, using their length, so new types do not break older peers.</remarks>
+class MessageDispatcher
+{
+public:
+	/// <summary>
+	/// Counters for what could not be dispatched, which a peer (or an attacker) can cause as often as it likes.
+	/// </summary>
+	struct Stats
+	{
+		unsigned int datagrams_malformed; // datagrams whose message framing was broken, and were dropped from there
+		unsigned int messages_unreadable; // messages whose handler could not read them, and were skipped
+	};
+
+	/// <summary>
+	/// Handles one message, given a packet over just its payload.  Returns false if the payload could not be read.
+	/// </summary>
+	using Handler = std::function<bool(Packet& payload)>;
+
+	MessageDispatcher();
+
+	void Register(MessageTypeId type, Handler handler);
+	bool Dispatch(Packet& datagram);
+
+	const Stats& GetStats() const { return stats_; }
+
+private:
+	void LogFirstFailure(const char* failure);
+
+	std::array<Handler, 256> handlers_;
+	Stats stats_;
+	bool is_failure_logged_;
+};
@@ -0,0 +1,484 @@
+//---------------------------------------------------------
+// file:	MessageSchema.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Declares the fields of a message once, and generates its serialization in either packet format.
+//
+// remarks: A schema is a list of field descriptors, each naming a member of the message struct:
+//          - Value<&Message::member> writes the member whole (or as one bit, for bools in the Bits format)
+//          - Quantized<&Message::member, kField> quantizes a float member to the range/precision of kField
+//          - Nested<&Message::member, Schema<...>> writes a struct member with its own schema
+//          - Optional<&Message::flag, Fields...> writes the bool flag, and then the fields only if it is set
+//          Schemas are themselves field descriptors, so a schema can be included in another schema.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <type_traits>
+#include "Packet.h"
+#include "PacketSerializer.h"
+#include "PacketCursor.h"
+#include "BitWriter.h"
+#include "BitReader.h"
+
+
+namespace MessageSchema
+{
+	// a changed quantized value whose delta from the baseline fits in this many (zig-zag encoded) bits is sent as a delta
+	const unsigned int kDeltaBits = 11;
+
+
+	template <typename T>
+	struct MemberTraits;
+
+	template <typename Message, typename T>
+	struct MemberTraits<T Message::*>
+	{
+		using Type = T;
+	};
+
+
+	/// <summary>
+	/// A member written whole, in the Bytes format, or in its natural bit count (one bit for bools) in the Bits format.
+	/// </summary>
+	template <auto Member>
+	struct Value
+	{
+		using Type = typename MemberTraits<decltype(Member)>::Type;
+		using Wire = typename PacketSerializer::WireType<Type>::Type;
+		static_assert(std::is_integral_v<Type> || std::is_same_v<Type, float>, "Value fields must be integral or float");
+
+		static constexpr unsigned int kMinBytes = PacketSerializer::kWireSize<Type>;
+		static constexpr unsigned int kMaxBytes = PacketSerializer::kWireSize<Type>;
+		static constexpr unsigned int kMaxBits = std::is_same_v<Type, bool> ? 1 : PacketSerializer::kWireSize<Type> * 8;
+		static constexpr unsigned int kMaxDeltaBits = kMaxBits;
+
+		template <typename Message>
+		static void Write(PacketWriteCursor& writer, const Message& message)
+		{
+			writer.Write<Type>(message.*Member);
+		}
+
+		template <typename Message>
+		static bool Read(PacketReadCursor& reader, Message& message)
+		{
+			reader.Read<Type>(message.*Member);
+			return true;
+		}
+
+		template <typename Message>
+		static bool Write(BitWriter& writer, const Message& message)
+		{
+			if constexpr (std::is_same_v<Type, bool>)
+			{
+				return writer.WriteBool(message.*Member);
+			}
+			else if constexpr (std::is_same_v<Type, float>)
+			{
+				return writer.WriteFloat(message.*Member);
+			}
+			else if constexpr (sizeof(Wire) > sizeof(uint32_t))
+			{
+				const auto value = static_cast<uint64_t>(message.*Member);
+				return writer.WriteBits(static_cast<uint32_t>(value), 32) &&
+					writer.WriteBits(static_cast<uint32_t>(value >> 32), 32);
+			}
+			else
+			{
+				return writer.WriteBits(static_cast<uint32_t>(message.*Member), kMaxBits);
+			}
+		}
+
+		template <typename Message>
+		static bool Read(BitReader& reader, Message& message)
+		{
+			if constexpr (std::is_same_v<Type, bool>)
+			{
+				return reader.ReadBool(message.*Member);
+			}
+			else if constexpr (std::is_same_v<Type, float>)
+			{
+				return reader.ReadFloat(message.*Member);
+			}
+			else if constexpr (sizeof(Wire) > sizeof(uint32_t))
+			{
+				uint32_t low, high;
+				if (!reader.ReadBits(low, 32) || !reader.ReadBits(high, 32))
+				{
+					return false;
+				}
+				message.*Member = static_cast<Type>((static_cast<uint64_t>(high) << 32) | low);
+				return true;
+			}
+			else
+			{
+				uint32_t value;
+				if (!reader.ReadBits(value, kMaxBits))
+				{
+					return false;
+				}
+				message.*Member = static_cast<Type>(static_cast<Wire>(value));
+				return true;
+			}
+		}
+
+		template <typename Message>
+		static bool WriteDelta(BitWriter& writer, const Message& message, const Message&)
+		{
+			return Write(writer, message);
+		}
+
+		template <typename Message>
+		static bool ReadDelta(BitReader& reader, Message& message, const Message&)
+		{
+			return Read(reader, message);
+		}
+	};
+
+
+	/// <summary>
+	/// A float member quantized to the range and precision of Field.
+	/// </summary>
+	/// <remarks>In the Bits format, this can be delta-compressed against a baseline message.</remarks>
+	template <auto Member, const PacketSerializer::QuantizedField& Field>
+	struct Quantized
+	{
+		static constexpr unsigned int kMinBytes = PacketSerializer::GetQuantizedSize(Field.bits);
+		static constexpr unsigned int kMaxBytes = PacketSerializer::GetQuantizedSize(Field.bits);
+		static constexpr unsigned int kMaxBits = Field.bits;
+		static constexpr unsigned int kMaxDeltaBits = 2 + ((Field.bits > kDeltaBits) ? Field.bits : kDeltaBits);
+		// the Bytes format reads a whole byte, short, or int, and a delta may step outside the range, so both are checked against this
+		static constexpr uint32_t kMaxQuantized = PacketSerializer::GetMaxQuantized(Field.bits);
+
+		template <typename Message>
+		static void Write(PacketWriteCursor& writer, const Message& message)
+		{
+			const auto quantized = PacketSerializer::Quantize(message.*Member, Field.min, Field.max, Field.bits);
+			if constexpr (kMaxBytes == sizeof(uint8_t))
+			{
+				writer.Write<uint8_t>(static_cast<uint8_t>(quantized));
+			}
+			else if constexpr (kMaxBytes == sizeof(uint16_t))
+			{
+				writer.Write<uint16_t>(static_cast<uint16_t>(quantized));
+			}
+			else
+			{
+				writer.Write<uint32_t>(quantized);
+			}
+		}
+
+		template <typename Message>
+		static bool Read(PacketReadCursor& reader, Message& message)
+		{
+			uint32_t quantized;
+			if constexpr (kMaxBytes == sizeof(uint8_t))
+			{
+				uint8_t small_value;
+				reader.Read<uint8_t>(small_value);
+				quantized = small_value;
+			}
+			else if constexpr (kMaxBytes == sizeof(uint16_t))
+			{
+				uint16_t medium_value;
+				reader.Read<uint16_t>(medium_value);
+				quantized = medium_value;
+			}
+			else
+			{
+				reader.Read<uint32_t>(quantized);
+			}
+			if (quantized > kMaxQuantized)
+			{
+				return false;
+			}
+			message.*Member = PacketSerializer::Dequantize(quantized, Field.min, Field.max, Field.bits);
+			return true;
+		}
+
+		template <typename Message>
+		static bool Write(BitWriter& writer, const Message& message)
+		{
+			return writer.WriteQuantized(message.*Member, Field.min, Field.max, Field.bits);
+		}
+
+		template <typename Message>
+		static bool Read(BitReader& reader, Message& message)
+		{
+			return reader.ReadQuantized(message.*Member, Field.min, Field.max, Field.bits);
+		}
+
+		/// <summary>
+		/// Write the value as "unchanged", a small delta, or in full, relative to the baseline.
+		/// </summary>
+		template <typename Message>
+		static bool WriteDelta(BitWriter& writer, const Message& message, const Message& baseline)
+		{
+			const auto current = PacketSerializer::Quantize(message.*Member, Field.min, Field.max, Field.bits);
+			const auto previous = PacketSerializer::Quantize(baseline.*Member, Field.min, Field.max, Field.bits);
+			if (!writer.WriteBool(current != previous))
+			{
+				return false;
+			}
+			if (current == previous)
+			{
+				return true;
+			}
+
+			// zig-zag the signed delta, so small negative deltas are also small unsigned values
+			const auto encoded_delta = PacketSerializer::ZigZagEncode(static_cast<int32_t>(current - previous));
+			const auto is_small = encoded_delta < (1u << kDeltaBits);
+			if (!writer.WriteBool(is_small))
+			{
+				return false;
+			}
+			return is_small ? writer.WriteBits(encoded_delta, kDeltaBits) : writer.WriteBits(current, Field.bits);
+		}
+
+		/// <summary>
+		/// Read a value written by WriteDelta, rebuilding it from the baseline.
+		/// </summary>
+		template <typename Message>
+		static bool ReadDelta(BitReader& reader, Message& message, const Message& baseline)
+		{
+			bool is_changed;
+			if (!reader.ReadBool(is_changed))
+			{
+				return false;
+			}
+			if (!is_changed)
+			{
+				message.*Member = baseline.*Member;
+				return true;
+			}
+
+			bool is_small;
+			uint32_t quantized;
+			if (!reader.ReadBool(is_small))
+			{
+				return false;
+			}
+			if (is_small)
+			{
+				uint32_t encoded_delta;
+				if (!reader.ReadBits(encoded_delta, kDeltaBits))
+				{
+					return false;
+				}
+				// a delta below zero wraps around, so it is caught as too large
+				const auto delta = PacketSerializer::ZigZagDecode(encoded_delta);
+				quantized = PacketSerializer::Quantize(baseline.*Member, Field.min, Field.max, Field.bits) + static_cast<uint32_t>(delta);
+				if (quantized > kMaxQuantized)
+				{
+					return false;
+				}
+			}
+			else if (!reader.ReadBits(quantized, Field.bits))
+			{
+				return false;
+			}
+
+			message.*Member = PacketSerializer::Dequantize(quantized, Field.min, Field.max, Field.bits);
+			return true;
+		}
+	};
+
+
+	/// <summary>
+	/// A set of fields, written in order.  Use as a top-level message schema, or as a field of another schema.
+	/// </summary>
+	template <typename Message, typename... Fields>
+	struct Schema
+	{
+		static constexpr unsigned int kMinBytes = (0 + ... + Fields::kMinBytes);
+		static constexpr unsigned int kMaxBytes = (0 + ... + Fields::kMaxBytes);
+		static constexpr unsigned int kMaxBits = (0 + ... + Fields::kMaxBits);
+		static constexpr unsigned int kMaxDeltaBits = (0 + ... + Fields::kMaxDeltaBits);
+
+		static void Write(PacketWriteCursor& writer, const Message& message)
+		{
+			(Fields::Write(writer, message), ...);
+		}
+
+		static bool Read(PacketReadCursor& reader, Message& message)
+		{
+			return (true && ... && Fields::Read(reader, message));
+		}
+
+		static bool Write(BitWriter& writer, const Message& message)
+		{
+			return (true && ... && Fields::Write(writer, message));
+		}
+
+		static bool Read(BitReader& reader, Message& message)
+		{
+			return (true && ... && Fields::Read(reader, message));
+		}
+
+		static bool WriteDelta(BitWriter& writer, const Message& message, const Message& baseline)
+		{
+			return (true && ... && Fields::WriteDelta(writer, message, baseline));
+		}
+
+		static bool ReadDelta(BitReader& reader, Message& message, const Message& baseline)
+		{
+			return (true && ... && Fields::ReadDelta(reader, message, baseline));
+		}
+
+		/// <summary>
+		/// Write the message into the packet in the Bytes format.
+		/// </summary>
+		/// <remarks>The space for the largest possible message is checked once, and the fields are then written unchecked.</remarks>
+		/// <returns>If true, the message was successfully written into the packet.</returns>
+		static bool Write(Packet& packet, const Message& message)
+		{
+			PacketWriteCursor writer(packet, kMaxBytes);
+			if (!writer.IsValid())
+			{
+				return false;
+			}
+
+			Write(writer, message);
+			return writer.Commit();
+		}
+
+		/// <summary>
+		/// Read the message out of the packet in the Bytes format.
+		/// </summary>
+		/// <remarks>The length of the fixed fields is checked once, and each optional section is checked once.</remarks>
+		/// <returns>If true, the message was successfully read out of the packet.</returns>
+		static bool Read(Packet& packet, Message& message)
+		{
+			PacketReadCursor reader(packet, kMinBytes);
+			if (!reader.IsValid() || !Read(reader, message))
+			{
+				return false;
+			}
+
+			reader.Commit();
+			return true;
+		}
+	};
+
+
+	/// <summary>
+	/// A struct member, written with its own schema.
+	/// </summary>
+	template <auto Member, typename MemberSchema>
+	struct Nested
+	{
+		static constexpr unsigned int kMinBytes = MemberSchema::kMinBytes;
+		static constexpr unsigned int kMaxBytes = MemberSchema::kMaxBytes;
+		static constexpr unsigned int kMaxBits = MemberSchema::kMaxBits;
+		static constexpr unsigned int kMaxDeltaBits = MemberSchema::kMaxDeltaBits;
+
+		template <typename Message>
+		static void Write(PacketWriteCursor& writer, const Message& message)
+		{
+			MemberSchema::Write(writer, message.*Member);
+		}
+
+		template <typename Message>
+		static bool Read(PacketReadCursor& reader, Message& message)
+		{
+			return MemberSchema::Read(reader, message.*Member);
+		}
+
+		template <typename Message>
+		static bool Write(BitWriter& writer, const Message& message)
+		{
+			return MemberSchema::Write(writer, message.*Member);
+		}
+
+		template <typename Message>
+		static bool Read(BitReader& reader, Message& message)
+		{
+			return MemberSchema::Read(reader, message.*Member);
+		}
+
+		template <typename Message>
+		static bool WriteDelta(BitWriter& writer, const Message& message, const Message& baseline)
+		{
+			return MemberSchema::WriteDelta(writer, message.*Member, baseline.*Member);
+		}
+
+		template <typename Message>
+		static bool ReadDelta(BitReader& reader, Message& message, const Message& baseline)
+		{
+			return MemberSchema::ReadDelta(reader, message.*Member, baseline.*Member);
+		}
+	};
+
+
+	/// <summary>
+	/// A bool flag member, followed by the fields only if the flag is set.
+	/// </summary>
+	/// <remarks>Optional fields are never delta-compressed, as they describe one-off events.</remarks>
+	template <auto FlagMember, typename... Fields>
+	struct Optional
+	{
+		static constexpr unsigned int kMinBytes = PacketSerializer::kWireSize<bool>;
+		static constexpr unsigned int kMaxBytes = PacketSerializer::kWireSize<bool> + (0 + ... + Fields::kMaxBytes);
+		static constexpr unsigned int kMaxBits = 1 + (0 + ... + Fields::kMaxBits);
+		static constexpr unsigned int kMaxDeltaBits = kMaxBits;
+
+		template <typename Message>
+		static void Write(PacketWriteCursor& writer, const Message& message)
+		{
+			writer.Write<bool>(message.*FlagMember);
+			if (message.*FlagMember)
+			{
+				(Fields::Write(writer, message), ...);
+			}
+		}
+
+		template <typename Message>
+		static bool Read(PacketReadCursor& reader, Message& message)
+		{
+			reader.Read<bool>(message.*FlagMember);
+			if (!(message.*FlagMember))
+			{
+				return true;
+			}
+			if (!reader.Require((0 + ... + Fields::kMinBytes)))
+			{
+				return false;
+			}
+			return (true && ... && Fields::Read(reader, message));
+		}
+
+		template <typename Message>
+		static bool Write(BitWriter& writer, const Message& message)
+		{
+			if (!writer.WriteBool(message.*FlagMember))
+			{
+				return false;
+			}
+			return !(message.*FlagMember) || (true && ... && Fields::Write(writer, message));
+		}
+
+		template <typename Message>
+		static bool Read(BitReader& reader, Message& message)
+		{
+			if (!reader.ReadBool(message.*FlagMember))
+			{
+				return false;
+			}
+			return !(message.*FlagMember) || (true && ... && Fields::Read(reader, message));
+		}
+
+		template <typename Message>
+		static bool WriteDelta(BitWriter& writer, const Message& message, const Message&)
+		{
+			return Write(writer, message);
+		}
+
+		template <typename Message>
+		static bool ReadDelta(BitReader& reader, Message& message, const Message&)
+		{
+			return Read(reader, message);
+		}
+	};
+};
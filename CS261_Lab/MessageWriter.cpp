@@ -0,0 +1,42 @@
+//---------------------------------------------------------
+// file:	MessageWriter.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Appends typed, length-prefixed messages to a packet, so that one datagram can carry many messages.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "MessageWriter.h"
+#include "PacketSerializer.h"
+
+
+MessageWriter::MessageWriter(Packet& packet)
+	: packet_(packet),
+	message_count_(0)
+{ }
+
+
+/// <summary>
+/// Write the header for a payload that was written kMaxHeaderSize bytes past the packet's target.
+/// </summary>
+/// <returns>If true, the header and payload are now part of the packet.</returns>
+bool MessageWriter::Commit(const MessageTypeId type, const unsigned int payload_size)
+{
+	if (payload_size > kMaxPayloadSize)
+	{
+		return false;
+	}
+
+	char* payload_start = packet_.GetTarget() + kMaxHeaderSize;
+	PacketSerializer::WriteValue<MessageTypeId>(packet_, type);
+	PacketSerializer::WriteVarUInt(packet_, payload_size);
+
+	// the header is usually shorter than the space left for it
+	memmove(packet_.GetTarget(), payload_start, payload_size);
+	packet_.AdvanceUnchecked(payload_size);
+	++message_count_;
+
+	return true;
+}
@@ -0,0 +1,62 @@
+//---------------------------------------------------------
+// file:	MessageWriter.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Appends typed, length-prefixed messages to a packet, so that one datagram can carry many messages.
+//
+// remarks: Each message is written as its type (1 byte), its payload length (a varint), and then its payload.
+//          Read them back out with MessageDispatcher.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include "Packet.h"
+
+
+using MessageTypeId = uint8_t;
+
+
+/// <summary>
+/// Appends typed, length-prefixed messages to a packet, so that one datagram can carry many messages.
+/// </summary>
+class MessageWriter
+{
+public:
+	// the type, plus a length of up to 2 varint bytes (16383), which covers any datagram we send
+	static const unsigned int kMaxHeaderSize = sizeof(MessageTypeId) + 2;
+	static const unsigned int kMaxPayloadSize = (1u << 14) - 1;
+
+	MessageWriter(Packet& packet);
+
+	/// <summary>
+	/// Append a message, whose payload is written by write_payload(Packet&), which returns false on failure.
+	/// </summary>
+	/// <returns>If true, the message was successfully written.  If false, the packet is unchanged.</returns>
+	template <typename WritePayload>
+	bool Write(const MessageTypeId type, WritePayload&& write_payload)
+	{
+		const auto remaining_space = packet_.GetRemainingSpace();
+		if (remaining_space <= kMaxHeaderSize)
+		{
+			return false;
+		}
+
+		// write the payload past the largest header, then slide it back once its length is known
+		Packet payload(packet_.GetTarget() + kMaxHeaderSize, remaining_space - kMaxHeaderSize);
+		if (!write_payload(payload))
+		{
+			return false;
+		}
+		return Commit(type, payload.GetUsedSpace());
+	}
+
+	unsigned int GetMessageCount() const { return message_count_; }
+
+private:
+	bool Commit(MessageTypeId type, unsigned int payload_size);
+
+	Packet& packet_;
+	unsigned int message_count_;
+};
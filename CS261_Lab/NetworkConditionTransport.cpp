@@ -0,0 +1,288 @@
+//---------------------------------------------------------
+// file:	NetworkConditionTransport.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Wraps another transport, and delays, drops, reorders, and duplicates the datagrams going each way.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "NetworkConditionTransport.h"
+
+const unsigned int kPoolSize = 2 * NetworkConditionTransport::kMaxHeldDatagrams; // enough for both links to fill
+const unsigned int kOutgoingStream = 0; // mixed into the seed, so the two directions make different decisions
+const unsigned int kIncomingStream = 1;
+
+
+namespace
+{
+	/// <summary>
+	/// The min-heap order for held datagrams: earliest release first, then the order they were offered in.
+	/// </summary>
+	template <typename HeldDatagram>
+	bool IsReleasedLater(const HeldDatagram& a, const HeldDatagram& b)
+	{
+		return (a.release_time != b.release_time) ? (a.release_time > b.release_time) : (a.order > b.order);
+	}
+
+
+	bool RollChance(std::mt19937& random, const float chance)
+	{
+		return (chance > 0.0f) && (std::uniform_real_distribution<float>(0.0f, 1.0f)(random) < chance);
+	}
+}
+
+
+NetworkConditionTransport::Link::Link(const NetworkConditions& conditions, const unsigned int stream)
+	: conditions(conditions),
+	random(),
+	is_bursting(false),
+	next_order(0),
+	held(),
+	stats()
+{
+	std::seed_seq seed = { conditions.seed, stream };
+	random.seed(seed);
+	held.reserve(kMaxHeldDatagrams);
+}
+
+
+NetworkConditionTransport::NetworkConditionTransport(std::unique_ptr<DatagramTransport> transport, const NetworkConditions& conditions)
+	: transport_(std::move(transport)),
+	pool_(kPoolSize),
+	outgoing_(conditions, kOutgoingStream),
+	incoming_(conditions, kIncomingStream)
+{ }
+
+
+NetworkConditionTransport::~NetworkConditionTransport()
+{
+	const auto log_link = [](const char* direction, const Stats& stats)
+	{
+		std::cout << "  " << direction << ": " << stats.datagram_count << " datagrams, " <<
+			stats.lost_count << " lost (" << stats.burst_lost_count << " in bursts), " <<
+			stats.reordered_count << " reordered, " << stats.duplicated_count << " duplicated, " <<
+			stats.overflow_count << " overflowed" << std::endl;
+	};
+	std::cout << "Simulated network conditions, seed " << outgoing_.conditions.seed << ":" << std::endl;
+	log_link("Sent", outgoing_.stats);
+	log_link("Received", incoming_.stats);
+}
+
+
+/// <summary>
+/// Wrap the transport in the given conditions, unless there is nothing to simulate.
+/// </summary>
+std::unique_ptr<DatagramTransport> NetworkConditionTransport::Wrap(std::unique_ptr<DatagramTransport> transport, const NetworkConditions& conditions)
+{
+	if ((transport == nullptr) || conditions.IsPerfect())
+	{
+		return transport;
+	}
+	return std::make_unique<NetworkConditionTransport>(std::move(transport), conditions);
+}
+
+
+/// <summary>
+/// Offer a copy of the packet's used space to the outgoing link, and send whatever it has released.
+/// </summary>
+/// <returns>If false, too many datagrams were already held, and it was dropped.  A simulated loss still returns true.</returns>
+bool NetworkConditionTransport::Send(const Packet& packet)
+{
+	const auto now = Clock::now();
+
+	auto buffer = pool_.Acquire();
+	if (!buffer.IsValid())
+	{
+		++outgoing_.stats.overflow_count;
+		return false;
+	}
+	memcpy(buffer.GetData(), packet.GetRoot(), packet.GetUsedSpace());
+	buffer.SetSize(packet.GetUsedSpace());
+	Offer(outgoing_, std::move(buffer), now);
+
+	SendDue(now);
+	return true;
+}
+
+
+/// <summary>
+/// Take the next datagram the incoming link has released, after offering it everything the wrapped transport received.
+/// </summary>
+/// <returns>If false, no datagram is due yet.</returns>
+bool NetworkConditionTransport::Receive(ReceivedDatagram& datagram)
+{
+	const auto now = Clock::now();
+
+	// the outgoing link is serviced here too, since a scenario may go several frames without sending
+	SendDue(now);
+
+	// copy each datagram out, so held datagrams never starve the wrapped transport's pool
+	ReceivedDatagram received;
+	while (transport_->Receive(received))
+	{
+		auto buffer = pool_.Acquire();
+		if (!buffer.IsValid())
+		{
+			++incoming_.stats.overflow_count;
+		}
+		else
+		{
+			memcpy(buffer.GetData(), received.buffer.GetData(), received.buffer.GetSize());
+			buffer.SetSize(received.buffer.GetSize());
+			Offer(incoming_, std::move(buffer), received.arrival_time);
+		}
+		received.buffer.Reset();
+	}
+
+	HeldDatagram released;
+	if (!Release(incoming_, now, released))
+	{
+		return false;
+	}
+	datagram.buffer = std::move(released.buffer);
+	datagram.arrival_time = released.release_time;
+	return true;
+}
+
+
+/// <summary>
+/// Drop everything held on both links, and stop the wrapped transport.
+/// </summary>
+void NetworkConditionTransport::Stop()
+{
+	outgoing_.held.clear();
+	incoming_.held.clear();
+	transport_->Stop();
+}
+
+
+/// <summary>
+/// Decide the fate of a datagram entering the link: lose it, or hold it until it is due, perhaps twice.
+/// </summary>
+void NetworkConditionTransport::Offer(Link& link, PacketBuffer&& buffer, const Clock::time_point now)
+{
+	++link.stats.datagram_count;
+	if (IsLost(link))
+	{
+		return;
+	}
+
+	auto delay_secs = SampleDelaySecs(link);
+	if (RollChance(link.random, link.conditions.reorder_chance))
+	{
+		++link.stats.reordered_count;
+		delay_secs += link.conditions.reorder_delay_secs;
+	}
+	const auto to_duration = [](const float secs) { return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(secs)); };
+	Hold(link, buffer, now + to_duration(delay_secs));
+
+	// the copy shares the buffer, which nothing writes to again, and takes its own path across the link
+	if (RollChance(link.random, link.conditions.duplicate_chance))
+	{
+		++link.stats.duplicated_count;
+		Hold(link, buffer, now + to_duration(SampleDelaySecs(link)));
+	}
+}
+
+
+/// <summary>
+/// Step the Gilbert-Elliott model, then roll for loss with the chance of the state it is in.
+/// </summary>
+bool NetworkConditionTransport::IsLost(Link& link)
+{
+	if (link.is_bursting)
+	{
+		link.is_bursting = !RollChance(link.random, link.conditions.burst_end_chance);
+	}
+	else
+	{
+		link.is_bursting = RollChance(link.random, link.conditions.burst_start_chance);
+	}
+
+	const auto loss_chance = link.is_bursting ? link.conditions.burst_loss_chance : link.conditions.loss_chance;
+	if (!RollChance(link.random, loss_chance))
+	{
+		return false;
+	}
+
+	++link.stats.lost_count;
+	if (link.is_bursting)
+	{
+		++link.stats.burst_lost_count;
+	}
+	return true;
+}
+
+
+/// <summary>
+/// The latency plus a sample of the jitter, never less than zero.
+/// </summary>
+float NetworkConditionTransport::SampleDelaySecs(Link& link)
+{
+	const auto& conditions = link.conditions;
+	if (conditions.jitter_secs <= 0.0f)
+	{
+		return conditions.latency_secs;
+	}
+
+	float jitter_secs = 0.0f;
+	switch (conditions.jitter_distribution)
+	{
+	case NetworkConditions::JitterDistribution::Uniform:
+		jitter_secs = std::uniform_real_distribution<float>(-conditions.jitter_secs, conditions.jitter_secs)(link.random);
+		break;
+	case NetworkConditions::JitterDistribution::Normal:
+		jitter_secs = std::normal_distribution<float>(0.0f, conditions.jitter_secs)(link.random);
+		break;
+	case NetworkConditions::JitterDistribution::Exponential:
+		jitter_secs = std::exponential_distribution<float>(1.0f / conditions.jitter_secs)(link.random);
+		break;
+	}
+	return std::max(conditions.latency_secs + jitter_secs, 0.0f);
+}
+
+
+void NetworkConditionTransport::Hold(Link& link, const PacketBuffer& buffer, const Clock::time_point release_time)
+{
+	if (link.held.size() >= kMaxHeldDatagrams)
+	{
+		++link.stats.overflow_count;
+		return;
+	}
+
+	link.held.push_back({ release_time, link.next_order++, buffer });
+	std::push_heap(link.held.begin(), link.held.end(), IsReleasedLater<HeldDatagram>);
+}
+
+
+/// <summary>
+/// Take the earliest datagram the link has held, if it is due.
+/// </summary>
+/// <returns>If false, nothing was due.</returns>
+bool NetworkConditionTransport::Release(Link& link, const Clock::time_point now, HeldDatagram& datagram)
+{
+	if (link.held.empty() || (link.held.front().release_time > now))
+	{
+		return false;
+	}
+
+	std::pop_heap(link.held.begin(), link.held.end(), IsReleasedLater<HeldDatagram>);
+	datagram = std::move(link.held.back());
+	link.held.pop_back();
+	return true;
+}
+
+
+void NetworkConditionTransport::SendDue(const Clock::time_point now)
+{
+	HeldDatagram due;
+	while (Release(outgoing_, now, due))
+	{
+		Packet packet(due.buffer.GetData(), due.buffer.GetSize());
+		packet.AdvanceUnchecked(due.buffer.GetSize());
+		transport_->Send(packet);
+		due.buffer.Reset();
+	}
+}
\ No newline at end of file
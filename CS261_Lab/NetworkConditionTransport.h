@@ -0,0 +1,103 @@
+//---------------------------------------------------------
+// file:	NetworkConditionTransport.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Wraps another transport, and delays, drops, reorders, and duplicates the datagrams going each way.
+//
+// remarks: Each direction has its own random state, seeded from the conditions, so a run with the same seed makes
+//          the same decision for every datagram.  Held datagrams are only released when the scenario calls Send or
+//          Receive, which it does every frame, so delays are rounded up to the next frame.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <memory>
+#include <random>
+#include <vector>
+#include "DatagramTransport.h"
+#include "NetworkConditions.h"
+#include "PacketBufferPool.h"
+
+
+/// <summary>
+/// Wraps another transport, and delays, drops, reorders, and duplicates the datagrams going each way.
+/// </summary>
+class NetworkConditionTransport :
+	public DatagramTransport
+{
+public:
+	/// <summary>
+	/// What the simulation has done to the datagrams going one way.
+	/// </summary>
+	struct Stats
+	{
+		unsigned int datagram_count; // offered to the link
+		unsigned int lost_count;
+		unsigned int burst_lost_count; // lost while the link was in the bad state
+		unsigned int reordered_count;
+		unsigned int duplicated_count;
+		unsigned int overflow_count; // dropped because too many were already held
+	};
+
+	// the most datagrams held back at once, in each direction
+	static const unsigned int kMaxHeldDatagrams = 512;
+
+	NetworkConditionTransport(std::unique_ptr<DatagramTransport> transport, const NetworkConditions& conditions);
+	~NetworkConditionTransport() override;
+
+	NetworkConditionTransport(const NetworkConditionTransport&) = delete;
+	NetworkConditionTransport& operator=(const NetworkConditionTransport&) = delete;
+
+	static std::unique_ptr<DatagramTransport> Wrap(std::unique_ptr<DatagramTransport> transport, const NetworkConditions& conditions);
+
+	// Inherited via DatagramTransport
+	bool Send(const Packet& packet) override;
+	bool Receive(ReceivedDatagram& datagram) override;
+	void Stop() override;
+	unsigned int GetOverflowCount() const override { return transport_->GetOverflowCount(); }
+	bool HasFailed() const override { return transport_->HasFailed(); }
+
+	const Stats& GetOutgoingStats() const { return outgoing_.stats; }
+	const Stats& GetIncomingStats() const { return incoming_.stats; }
+
+private:
+	/// <summary>
+	/// A datagram held back until the simulated link delivers it.
+	/// </summary>
+	struct HeldDatagram
+	{
+		Clock::time_point release_time;
+		unsigned int order; // breaks ties, so datagrams released together keep the order they were offered in
+		PacketBuffer buffer;
+	};
+
+	/// <summary>
+	/// One direction of the simulated link.
+	/// </summary>
+	struct Link
+	{
+		Link(const NetworkConditions& conditions, unsigned int stream);
+
+		NetworkConditions conditions;
+		std::mt19937 random;
+		bool is_bursting; // in the Gilbert-Elliott bad state
+		unsigned int next_order;
+		std::vector<HeldDatagram> held; // a min-heap on release time
+		Stats stats;
+	};
+
+	static void Offer(Link& link, PacketBuffer&& buffer, Clock::time_point now);
+	static bool IsLost(Link& link);
+	static float SampleDelaySecs(Link& link);
+	static void Hold(Link& link, const PacketBuffer& buffer, Clock::time_point release_time);
+	static bool Release(Link& link, Clock::time_point now, HeldDatagram& datagram);
+
+	void SendDue(Clock::time_point now);
+
+	std::unique_ptr<DatagramTransport> transport_;
+	PacketBufferPool pool_;
+	Link outgoing_;
+	Link incoming_;
+};
\ No newline at end of file
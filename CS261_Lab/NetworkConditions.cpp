@@ -0,0 +1,152 @@
+//---------------------------------------------------------
+// file:	NetworkConditions.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	The latency, jitter, loss, reordering, and duplication to simulate on each direction of a link.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "NetworkConditions.h"
+#include <cstdlib>
+
+const char* kArgumentPrefix = "--net=";
+
+
+namespace
+{
+	/// <summary>
+	/// A numeric setting, and the scale from how it is written to how it is stored.
+	/// </summary>
+	struct Setting
+	{
+		const char* name;
+		float NetworkConditions::* member;
+		float scale;
+	};
+
+	const Setting kSettings[] = {
+		{ "latency", &NetworkConditions::latency_secs, 0.001f }, // milliseconds
+		{ "jitter", &NetworkConditions::jitter_secs, 0.001f },
+		{ "loss", &NetworkConditions::loss_chance, 1.0f },
+		{ "burst_start", &NetworkConditions::burst_start_chance, 1.0f },
+		{ "burst_end", &NetworkConditions::burst_end_chance, 1.0f },
+		{ "burst_loss", &NetworkConditions::burst_loss_chance, 1.0f },
+		{ "reorder", &NetworkConditions::reorder_chance, 1.0f },
+		{ "reorder_delay", &NetworkConditions::reorder_delay_secs, 0.001f },
+		{ "duplicate", &NetworkConditions::duplicate_chance, 1.0f },
+	};
+
+
+	bool ParseJitterDistribution(const std::string& value, NetworkConditions::JitterDistribution& distribution)
+	{
+		if (value == "uniform")
+		{
+			distribution = NetworkConditions::JitterDistribution::Uniform;
+		}
+		else if (value == "normal")
+		{
+			distribution = NetworkConditions::JitterDistribution::Normal;
+		}
+		else if (value == "exponential")
+		{
+			distribution = NetworkConditions::JitterDistribution::Exponential;
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+}
+
+
+/// <summary>
+/// Does this leave every datagram alone, so there is nothing to simulate?
+/// </summary>
+bool NetworkConditions::IsPerfect() const
+{
+	return (latency_secs <= 0.0f) && (jitter_secs <= 0.0f) && (loss_chance <= 0.0f) && (burst_start_chance <= 0.0f) &&
+		(reorder_chance <= 0.0f) && (duplicate_chance <= 0.0f);
+}
+
+
+/// <summary>
+/// Read comma-separated name=value pairs over the given conditions, with times in milliseconds and chances from 0 to 1.
+/// </summary>
+/// <remarks>For example: latency=80,jitter=20,jitter_dist=normal,loss=0.01,burst_start=0.02,burst_end=0.25,reorder=0.01,duplicate=0.01,seed=7</remarks>
+/// <returns>If false, a pair was not understood, and the conditions may have been partly read.</returns>
+bool NetworkConditions::Parse(const char* text, NetworkConditions& conditions)
+{
+	const std::string spec(text);
+	size_t start = 0;
+	while (start < spec.size())
+	{
+		auto end = spec.find(',', start);
+		if (end == std::string::npos)
+		{
+			end = spec.size();
+		}
+		const auto pair = spec.substr(start, end - start);
+		start = end + 1;
+
+		const auto equals = pair.find('=');
+		if (equals == std::string::npos)
+		{
+			std::cerr << "Network conditions: expected name=value, found '" << pair << "'" << std::endl;
+			return false;
+		}
+		const auto name = pair.substr(0, equals);
+		const auto value = pair.substr(equals + 1);
+
+		if (name == "jitter_dist")
+		{
+			if (!ParseJitterDistribution(value, conditions.jitter_distribution))
+			{
+				std::cerr << "Network conditions: unknown jitter distribution '" << value << "'" << std::endl;
+				return false;
+			}
+			continue;
+		}
+		if (name == "seed")
+		{
+			conditions.seed = static_cast<unsigned int>(strtoul(value.c_str(), nullptr, 10));
+			continue;
+		}
+
+		const auto setting = std::find_if(std::begin(kSettings), std::end(kSettings),
+			[&](const Setting& candidate) { return name == candidate.name; });
+		if (setting == std::end(kSettings))
+		{
+			std::cerr << "Network conditions: unknown setting '" << name << "'" << std::endl;
+			return false;
+		}
+		conditions.*(setting->member) = static_cast<float>(atof(value.c_str())) * setting->scale;
+	}
+	return true;
+}
+
+
+/// <summary>
+/// Find a --net= argument on the command line, and read the conditions from it.
+/// </summary>
+/// <returns>The conditions given, or perfect conditions if there were none, or they could not be read.</returns>
+NetworkConditions NetworkConditions::FromArguments(int argc, char** argv)
+{
+	const auto prefix_length = strlen(kArgumentPrefix);
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strncmp(argv[i], kArgumentPrefix, prefix_length) == 0)
+		{
+			NetworkConditions conditions;
+			if (!Parse(argv[i] + prefix_length, conditions))
+			{
+				std::cerr << "Ignoring the network conditions, and running without any" << std::endl;
+				return NetworkConditions();
+			}
+			return conditions;
+		}
+	}
+	return NetworkConditions();
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+//---------------------------------------------------------
+// file:	NetworkConditions.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	The latency, jitter, loss, reordering, and duplication to simulate on each direction of a link.
+//
+// remarks: Loss follows a Gilbert-Elliott model: the link moves between a good and a bad state once per datagram,
+//          and each state has its own loss chance, so losses come in bursts as they do on real networks.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+
+
+/// <summary>
+/// The latency, jitter, loss, reordering, and duplication to simulate on each direction of a link.
+/// </summary>
+struct NetworkConditions
+{
+	/// <summary>
+	/// How the jitter added to each datagram's latency is distributed.
+	/// </summary>
+	enum class JitterDistribution
+	{
+		Uniform, // anywhere within jitter of the latency
+		Normal, // jitter is the standard deviation
+		Exponential, // only ever later, with jitter as the mean
+	};
+
+	float latency_secs = 0.0f; // one-way
+	float jitter_secs = 0.0f;
+	JitterDistribution jitter_distribution = JitterDistribution::Uniform;
+	float loss_chance = 0.0f; // in the good state
+	float burst_start_chance = 0.0f; // of moving from the good state to the bad state, per datagram
+	float burst_end_chance = 1.0f; // of moving from the bad state back to the good state, per datagram
+	float burst_loss_chance = 1.0f; // in the bad state
+	float reorder_chance = 0.0f;
+	float reorder_delay_secs = 0.05f; // how long a reordered datagram is held back, so later ones overtake it
+	float duplicate_chance = 0.0f;
+	unsigned int seed = 1;
+
+	bool IsPerfect() const;
+
+	static bool Parse(const char* text, NetworkConditions& conditions);
+	static NetworkConditions FromArguments(int argc, char** argv);
+};
\ No newline at end of file
@@ -0,0 +1,209 @@
+//---------------------------------------------------------
+// file:	NetworkThread.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A thread that owns a session's socket, handing received datagrams to the simulation through a lock-free queue.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "NetworkThread.h"
+#if defined(__linux__)
+#include <sys/select.h>
+#endif
+
+const long kStopCheck_Usecs = 100000; // how often the thread checks for Stop, only if it has no wake socket
+const auto kSelectRetryDelay = std::chrono::milliseconds(10); // how long the thread backs off after select itself fails
+const unsigned int kPoolSize = NetworkThread::kQueueCapacity + DatagramBatch::kMaxDatagrams; // enough for the queue to fill
+
+
+namespace
+{
+	/// <summary>
+	/// A loopback UDP socket connected to itself, so a datagram sent on it wakes a select waiting on it.
+	/// </summary>
+	/// <remarks>select only waits on sockets on Windows, so this stands in for an eventfd or a pipe.</remarks>
+	/// <returns>The socket, or INVALID_SOCKET if it could not be set up.</returns>
+	SOCKET CreateWakeSocket()
+	{
+		auto wake_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		SOCKADDR_IN address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t address_size = sizeof(address);
+		u_long nonblocking = 1;
+		if ((wake_socket != INVALID_SOCKET) &&
+			((bind(wake_socket, reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) != 0) ||
+			(getsockname(wake_socket, reinterpret_cast<SOCKADDR*>(&address), &address_size) != 0) ||
+			(connect(wake_socket, reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) != 0) ||
+			(ioctlsocket(wake_socket, FIONBIO, &nonblocking) != 0)))
+		{
+			closesocket(wake_socket);
+			wake_socket = INVALID_SOCKET;
+		}
+		return wake_socket;
+	}
+}
+
+
+NetworkThread::NetworkThread(const SOCKET socket)
+	: socket_(socket),
+	wake_socket_(CreateWakeSocket()),
+	pool_(kPoolSize),
+	overflow_count_(0),
+	socket_error_(0),
+	is_running_(true),
+	thread_(&NetworkThread::Run, this) // last, so everything the thread touches is constructed
+{ }
+
+
+NetworkThread::~NetworkThread()
+{
+	Stop();
+}
+
+
+/// <summary>
+/// Send the packet's used space at once, alongside the thread's receives.  Simulation thread only.
+/// </summary>
+/// <returns>If false, the datagram was dropped.</returns>
+bool NetworkThread::Send(const Packet& packet)
+{
+	if ((socket_ == INVALID_SOCKET) || HasFailed())
+	{
+		return false;
+	}
+
+	// UDP may drop any datagram, so a failed send is treated the same way
+	// -- unless the peer's port has refused an earlier one, which the socket reports on whichever call comes next
+	if (send(socket_, packet.GetRoot(), packet.GetUsedSpace(), 0) == SOCKET_ERROR)
+	{
+		const auto wsa_error = WSAGetLastError();
+		if ((wsa_error == WSAECONNRESET) || (wsa_error == WSAECONNREFUSED))
+		{
+			Fail("send failed: ", wsa_error);
+		}
+		return false;
+	}
+	return true;
+}
+
+
+/// <summary>
+/// Take the oldest datagram the thread has received.  Simulation thread only.
+/// </summary>
+/// <returns>If false, there were no datagrams waiting.</returns>
+bool NetworkThread::Receive(ReceivedDatagram& datagram)
+{
+	return received_.Pop(datagram);
+}
+
+
+/// <summary>
+/// Stop the thread and close the socket.  Anything received and not yet taken is dropped.
+/// </summary>
+void NetworkThread::Stop()
+{
+	is_running_.store(false, std::memory_order_release);
+	if (wake_socket_ != INVALID_SOCKET)
+	{
+		const char wake = 0;
+		send(wake_socket_, &wake, sizeof(wake), 0);
+	}
+	if (thread_.joinable())
+	{
+		thread_.join();
+	}
+
+	if (socket_ != INVALID_SOCKET)
+	{
+		closesocket(socket_);
+		socket_ = INVALID_SOCKET;
+	}
+	if (wake_socket_ != INVALID_SOCKET)
+	{
+		closesocket(wake_socket_);
+		wake_socket_ = INVALID_SOCKET;
+	}
+}
+
+
+void NetworkThread::Run()
+{
+	while (is_running_.load(std::memory_order_acquire) && !HasFailed())
+	{
+		// sleep until a datagram arrives, or Stop wakes us
+		// -- without a wake socket, Stop can only be noticed by checking now and then
+		fd_set read_set;
+		FD_ZERO(&read_set);
+		FD_SET(socket_, &read_set);
+		if (wake_socket_ != INVALID_SOCKET)
+		{
+			FD_SET(wake_socket_, &read_set);
+		}
+		timeval stop_check = { 0, kStopCheck_Usecs };
+		const auto highest_socket = (wake_socket_ != INVALID_SOCKET) ? std::max(socket_, wake_socket_) : socket_;
+		const auto res = select(static_cast<int>(highest_socket) + 1, &read_set, nullptr, nullptr,
+			(wake_socket_ != INVALID_SOCKET) ? nullptr : &stop_check);
+		if ((res > 0) && FD_ISSET(socket_, &read_set))
+		{
+			ReceiveWaiting();
+		}
+		else if ((res == SOCKET_ERROR) && (WSAGetLastError() != WSAEINTR))
+		{
+			// whatever is wrong will likely still be wrong at once, so don't spin on it
+			std::this_thread::sleep_for(kSelectRetryDelay);
+		}
+	}
+}
+
+
+void NetworkThread::ReceiveWaiting()
+{
+	int received;
+	while ((received = receive_batch_.Receive(socket_)) > 0)
+	{
+		const auto arrival_time = Clock::now();
+		for (int i = 0; i < received; ++i)
+		{
+			const auto datagram = receive_batch_.GetDatagram(i);
+			ReceivedDatagram received_datagram = { pool_.Acquire(), arrival_time };
+			if (!received_datagram.buffer.IsValid())
+			{
+				overflow_count_.fetch_add(1, std::memory_order_relaxed);
+				continue;
+			}
+
+			memcpy(received_datagram.buffer.GetData(), datagram.GetRoot(), datagram.GetRemainingSpace());
+			received_datagram.buffer.SetSize(datagram.GetRemainingSpace());
+			if (!received_.Push(std::move(received_datagram)))
+			{
+				// the simulation is not keeping up, so drop the newest rather than block the socket
+				overflow_count_.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// a partial batch means the socket is already empty
+		if (received < static_cast<int>(DatagramBatch::kMaxDatagrams))
+		{
+			return;
+		}
+	}
+
+	// DatagramBatch reports WSAEWOULDBLOCK as no datagrams, so anything else is a real error
+	if (received == SOCKET_ERROR)
+	{
+		Fail("recv failed: ", WSAGetLastError());
+	}
+}
+
+
+/// <summary>
+/// Stop exchanging datagrams after an unexpected socket error, leaving the simulation to notice through HasFailed.
+/// </summary>
+void NetworkThread::Fail(const char* error_text, const int wsa_error)
+{
+	std::cerr << "Network Thread Winsock Error: " << error_text << wsa_error << std::endl;
+	socket_error_.store(wsa_error, std::memory_order_release);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+//---------------------------------------------------------
+// file:	NetworkThread.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A thread that owns a session's socket, handing received datagrams to the simulation through a lock-free queue.
+//
+// remarks: Datagrams are received as soon as they arrive, even while a slow frame holds up the simulation,
+//          and each is stamped with its arrival time.  Sends go straight out on the simulation's thread, as a UDP
+//          send never waits on the peer, so they add no latency.  The thread sleeps until a datagram arrives,
+//          or until Stop wakes it through a loopback socket connected to itself.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <thread>
+#include "Packet.h"
+#include "PacketBufferPool.h"
+#include "DatagramBatch.h"
+#include "DatagramTransport.h"
+#include "SpscQueue.h"
+
+
+/// <summary>
+/// A thread that owns a session's socket, handing received datagrams to the simulation through a lock-free queue.
+/// </summary>
+class NetworkThread :
+	public DatagramTransport
+{
+public:
+	static const unsigned int kQueueCapacity = 256;
+
+	NetworkThread(SOCKET socket);
+	~NetworkThread() override;
+
+	NetworkThread(const NetworkThread&) = delete;
+	NetworkThread& operator=(const NetworkThread&) = delete;
+
+	// Inherited via DatagramTransport
+	bool Send(const Packet& packet) override;
+	bool Receive(ReceivedDatagram& datagram) override;
+	void Stop() override;
+	unsigned int GetOverflowCount() const override { return overflow_count_.load(std::memory_order_relaxed); }
+	bool HasFailed() const override { return socket_error_.load(std::memory_order_acquire) != 0; }
+
+	bool IsRunning() const { return is_running_.load(std::memory_order_acquire); }
+
+private:
+	void Run();
+	void ReceiveWaiting();
+	void Fail(const char* error_text, int wsa_error);
+
+	SOCKET socket_;
+	SOCKET wake_socket_; // written to by Stop, to wake the thread from select
+	PacketBufferPool pool_;
+	SpscQueue<ReceivedDatagram, kQueueCapacity> received_;
+	DatagramBatch receive_batch_;
+	std::atomic<unsigned int> overflow_count_;
+	std::atomic<int> socket_error_; // the error that stopped the thread, or 0 while it runs
+	std::atomic<bool> is_running_;
+	std::thread thread_;
+};
\ No newline at end of file
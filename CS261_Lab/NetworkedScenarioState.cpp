@@ -11,9 +11,12 @@
 #include "NetworkedScenarioState.h"
 #include "GameStateManager.h"
 
+const float kReceiveStatsTextSize = 20.0f; // The size of the receive counters text.
+const CP_Color kReceiveStatsTextColor = CP_Color_Create(180, 180, 180, 255); // The color of the receive counters text.
 
-NetworkedScenarioState::NetworkedScenarioState(const SOCKET socket, const bool is_host)
-	: socket_(socket), is_host_(is_host)
+
+NetworkedScenarioState::NetworkedScenarioState(std::unique_ptr<DatagramTransport> transport, const bool is_host)
+	: is_host_(is_host), receive_stats_(), transport_(std::move(transport)), arrival_time_()
 { }
 
 
@@ -24,12 +27,44 @@ void NetworkedScenarioState::Update()
 {
 	if (CP_Input_KeyTriggered(KEY_ESCAPE))
 	{
-		if (socket_ != INVALID_SOCKET)
-		{
-			closesocket(socket_);
-			socket_ = INVALID_SOCKET;
-		}
+		transport_->Stop();
+		GameStateManager::ReturnToBaseState();
+		return;
+	}
+
+	// such as the peer's port refusing our datagrams, when it has gone away
+	if (transport_->HasFailed())
+	{
+		transport_->Stop();
 		GameStateManager::ReturnToBaseState();
 		return;
 	}
+}
+
+
+void NetworkedScenarioState::Draw()
+{
+	ScenarioState::Draw();
+
+	std::string receive_text("Received: ");
+	receive_text += std::to_string(receive_stats_.datagrams_drained);
+	receive_text += ", Stale: ";
+	receive_text += std::to_string(receive_stats_.datagrams_stale);
+	receive_text += ", Queue Depth: ";
+	receive_text += std::to_string(receive_stats_.queue_depth);
+	receive_text += " (Max ";
+	receive_text += std::to_string(receive_stats_.max_queue_depth);
+	receive_text += "), Overflowed: ";
+	receive_text += std::to_string(receive_stats_.datagrams_overflowed);
+	receive_text += ", Malformed: ";
+	receive_text += std::to_string(receive_stats_.datagrams_malformed);
+	receive_text += ", Unreadable: ";
+	receive_text += std::to_string(receive_stats_.messages_unreadable);
+	receive_text += ", Queue Delay: ";
+	receive_text += std::to_string(static_cast<int>(receive_stats_.queue_delay_secs * 1000));
+	receive_text += "ms";
+	CP_Settings_TextSize(kReceiveStatsTextSize);
+	CP_Settings_TextAlignment(CP_TEXT_ALIGN_H_LEFT, CP_TEXT_ALIGN_V_TOP);
+	CP_Settings_Fill(kReceiveStatsTextColor);
+	CP_Font_DrawText(receive_text.c_str(), 0.0f, 25.0f);
 }
\ No newline at end of file
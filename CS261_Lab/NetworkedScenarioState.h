@@ -8,7 +8,10 @@
 // Copyright  2021 DigiPen, All rights reserved.
 //---------------------------------------------------------
 #pragma once
+#include <memory>
 #include "ScenarioState.h"
+#include "Packet.h"
+#include "DatagramTransport.h"
 
 
 /// <summary>
@@ -18,15 +21,94 @@ class NetworkedScenarioState :
     public ScenarioState
 {
 public:
-    NetworkedScenarioState(const SOCKET socket, const bool is_host);
+    /// <summary>
+    /// Counters for the receive stage, which drains every datagram the transport has received each Update.
+    /// </summary>
+    struct ReceiveStats
+    {
+        unsigned int datagrams_drained; // all datagrams received
+        unsigned int datagrams_stale; // datagrams dropped because nothing in them was newer than what we had
+        unsigned int datagrams_overflowed; // datagrams the transport dropped because the queue was full
+        unsigned int datagrams_malformed; // datagrams whose message framing was broken, for scenarios that use a MessageDispatcher
+        unsigned int messages_unreadable; // messages that could not be read, for scenarios that use a MessageDispatcher
+        unsigned int queue_depth; // datagrams that were waiting on the most recent drain
+        unsigned int max_queue_depth; // the deepest the backlog has been on any drain
+        float queue_delay_secs; // how long the oldest datagram on the most recent drain waited after arriving
+    };
+
+    /// <summary>
+    /// What the scenario is showing: its frame counters, and where it draws each player.
+    /// </summary>
+    /// <remarks>For runs that drive the scenario without a window, such as the headless loopback check.</remarks>
+    struct View
+    {
+        u_long local_frame;
+        u_long remote_frame;
+        float local_x, local_y;
+        float remote_x, remote_y;
+    };
+
+    // the most datagrams drained in one Update, so a flood cannot stall the frame
+    static const unsigned int kMaxDatagramsPerDrain = 256;
+
+    NetworkedScenarioState(std::unique_ptr<DatagramTransport> transport, const bool is_host);
     ~NetworkedScenarioState() override;
 
     // Inherited via GameState
     virtual void Update() override;
+    virtual void Draw() override;
+
+    const ReceiveStats& GetReceiveStats() const { return receive_stats_; }
+    virtual View GetView() const = 0;
 
-    typedef NetworkedScenarioState* (*NetworkedScenarioStateCreator)(const SOCKET, const bool);
+    typedef NetworkedScenarioState* (*NetworkedScenarioStateCreator)(std::unique_ptr<DatagramTransport>, const bool);
 
 protected:
-    SOCKET socket_;
+    /// <summary>
+    /// Pass every datagram the transport has received, oldest first, to handle_datagram(Packet&).
+    /// </summary>
+    /// <remarks>handle_datagram returns false if the datagram was stale, and was dropped.</remarks>
+    template <typename HandleDatagram>
+    void DrainReceivedDatagrams(HandleDatagram&& handle_datagram)
+    {
+        const auto now = DatagramTransport::Clock::now();
+        receive_stats_.queue_depth = 0;
+        DatagramTransport::ReceivedDatagram received;
+        while ((receive_stats_.queue_depth < kMaxDatagramsPerDrain) && transport_->Receive(received))
+        {
+            if (receive_stats_.queue_depth == 0)
+            {
+                receive_stats_.queue_delay_secs = std::chrono::duration<float>(now - received.arrival_time).count();
+            }
+            ++receive_stats_.queue_depth;
+            ++receive_stats_.datagrams_drained;
+            arrival_time_ = received.arrival_time;
+            Packet datagram(received.buffer.GetData(), received.buffer.GetSize());
+            if (!handle_datagram(datagram))
+            {
+                ++receive_stats_.datagrams_stale;
+            }
+            received.buffer.Reset();
+        }
+        receive_stats_.max_queue_depth = std::max(receive_stats_.max_queue_depth, receive_stats_.queue_depth);
+        receive_stats_.datagrams_overflowed = transport_->GetOverflowCount();
+    }
+
+    /// <summary>
+    /// Queue the used space of the packet to be sent to the peer.
+    /// </summary>
+    void SendDatagram(const Packet& packet)
+    {
+        transport_->Send(packet);
+    }
+
+    /// <summary>
+    /// When the datagram being handled came off the socket, for handlers that time the round trip.
+    /// </summary>
+    DatagramTransport::Clock::time_point GetArrivalTime() const { return arrival_time_; }
+
     bool is_host_;
+    ReceiveStats receive_stats_;
+    std::unique_ptr<DatagramTransport> transport_;
+    DatagramTransport::Clock::time_point arrival_time_;
 };
\ No newline at end of file
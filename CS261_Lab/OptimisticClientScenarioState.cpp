@@ -10,8 +10,8 @@
 #include "pch.h"
 #include "OptimisticClientScenarioState.h"
 #include "PacketSerializer.h"
+#include "OptimisticMessages.h"
 
-const int kNetworkBufferSize = 1024; // maximum size of our packet
 const float kTimeBetweenClientSend_Secs = 0.1f; // acceptable latency on client control updates: 100ms (plus wire, etc.)
 const float kDrawRemoteHit_Secs = 2.0f; // number of seconds to draw the remote player as hit
 const float kAttackTextSize = 30.0f; // The size of the attack text.
@@ -19,17 +19,20 @@ const CP_Color kAttackAgreeTextColor = CP_Color_Create(255, 255, 255, 255); // T
 const CP_Color kAttackDisagreeTextColor = CP_Color_Create(255, 0, 255, 255); // The color of the attack text when local and remote disagree.
 
 
-OptimisticClientScenarioState::OptimisticClientScenarioState(const SOCKET socket)
-	: NetworkedScenarioState(socket, false),
+OptimisticClientScenarioState::OptimisticClientScenarioState(std::unique_ptr<DatagramTransport> transport)
+	: NetworkedScenarioState(std::move(transport), false),
 	active_control_(OptimisticClientScenarioState::Active_Control::Simple),
 	is_drawing_controls_(false),
-	is_attack_queued_(false),
 	remote_hit_timer_secs_(0.0f),
 	local_frame_(0),
 	remote_frame_(0),
 	send_timer_secs_(0.0f), // always start with a packet
-	time_since_last_recv_(0.0f),
-	packet_(kNetworkBufferSize)
+	last_state_remote_time_secs_(0.0),
+	send_format_(PacketSerializer::Format::Bytes),
+	last_send_size_(0),
+	reliable_(dispatcher_),
+	clock_sync_(dispatcher_),
+	fragments_(dispatcher_)
 {
 	local_player_.color = CP_Color_Create(255, 0, 0, 255);
 	remote_player_.color = CP_Color_Create(0, 0, 255, 255);
@@ -39,6 +42,11 @@ OptimisticClientScenarioState::OptimisticClientScenarioState(const SOCKET socket
 	remote_confirmed_attack_.SetAttackColor(CP_Color_Create(0, 0, 0, 0));
 	remote_confirmed_attack_.SetTargetColor(CP_Color_Create(255, 255, 255, 0));
 	remote_confirmed_attack_.SetTargetSize(25.0f);
+
+	// the host coalesces its state, and any resolved attack, into each datagram
+	using OptimisticMessages::MessageType;
+	OptimisticMessages::Register(dispatcher_, MessageType::State, [this](Packet& payload) { return ReceiveState(payload); });
+	OptimisticMessages::Register(dispatcher_, MessageType::ConfirmedAttack, [this](Packet& payload) { return ReceiveConfirmedAttack(payload); });
 }
 
 
@@ -56,6 +64,11 @@ void OptimisticClientScenarioState::Update()
 		is_drawing_controls_ = !is_drawing_controls_;
 	}
 
+	if (CP_Input_KeyTriggered(CP_KEY::KEY_B))
+	{
+		send_format_ = (send_format_ == PacketSerializer::Format::Bytes) ? PacketSerializer::Format::Bits : PacketSerializer::Format::Bytes;
+	}
+
 	if (CP_Input_KeyTriggered(CP_KEY::KEY_A))
 	{
 		switch (active_control_)
@@ -112,83 +125,109 @@ void OptimisticClientScenarioState::Update()
 
 	if (CP_Input_KeyTriggered(CP_KEY::KEY_F))
 	{
-		is_attack_queued_ = true;
 		local_attack_.Set(local_x, local_y, remote_x, remote_y, current_sync);
+		// the attack is sent with the next datagram, and again until the host acknowledges it
+		OptimisticMessages::AttackMessage attack;
+		attack.attack_x = local_attack_.GetAttackX();
+		attack.attack_y = local_attack_.GetAttackY();
+		attack.attack_sync = local_attack_.GetSyncRatio(); // use the stored sync, not the current one!
+		const auto format = send_format_;
+		reliable_.QueueReliable([&](MessageWriter& writer) { return OptimisticMessages::WriteAttack(writer, format, attack); });
 	}
 
-	time_since_last_recv_ += system_dt;
-	packet_.Reset();
-	const auto res = recv(socket_, packet_.GetRoot(), packet_.GetRemainingSpace(), 0);
-	if (res > 0)
-	{
-		u_long received_frame;
-		PacketSerializer::ReadValue<u_long>(packet_, received_frame);
-		// only use data if it's newer than the last frame we received
-		if (received_frame > remote_frame_)
+	reliable_.Update(system_dt);
+	fragments_.Update(system_dt);
+	// every state is kept as a snapshot and a baseline, and every confirmed attack is shown
+	DrainReceivedDatagrams([this](Packet& datagram)
 		{
-			remote_frame_ = received_frame;
-			float host_x, host_y, host_velocity_x, host_velocity_y;
-			float non_host_x, non_host_y, non_host_velocity_x, non_host_velocity_y;
-			// CONVENTION: host writes its own values first
-			PacketSerializer::ReadValue<float>(packet_, host_x);
-			PacketSerializer::ReadValue<float>(packet_, host_y);
-			PacketSerializer::ReadValue<float>(packet_, host_velocity_x);
-			PacketSerializer::ReadValue<float>(packet_, host_velocity_y);
-			PacketSerializer::ReadValue<float>(packet_, non_host_x);
-			PacketSerializer::ReadValue<float>(packet_, non_host_y);
-			PacketSerializer::ReadValue<float>(packet_, non_host_velocity_x);
-			PacketSerializer::ReadValue<float>(packet_, non_host_velocity_y);
-			// if there is a confirmed client attack, then process it
-			auto is_client_attacking = false;
-			PacketSerializer::ReadValue<bool>(packet_, is_client_attacking);
-			if (is_client_attacking)
+			if (!reliable_.ReadHeader(datagram))
 			{
-				float client_attack_x, client_attack_y;
-				float target_x, target_y;
-				PacketSerializer::ReadValue<float>(packet_, client_attack_x);
-				PacketSerializer::ReadValue<float>(packet_, client_attack_y);
-				PacketSerializer::ReadValue<float>(packet_, target_x);
-				PacketSerializer::ReadValue<float>(packet_, target_y);
-				remote_confirmed_attack_.Set(client_attack_x, client_attack_y, target_x, target_y, SyncRatio());
-				remote_hit_timer_secs_ = remote_confirmed_attack_.IsTargetHit() ? kDrawRemoteHit_Secs : 0.0f;
+				return false;
 			}
-			// store the data in all of the controls
-			simple_local_control_.SetLastKnown(non_host_x, non_host_y, remote_frame_);
-			simple_remote_control_.SetLastKnown(host_x, host_y, remote_frame_);
-			dr_local_control_.SetLastKnown(non_host_x, non_host_y, non_host_velocity_x, non_host_velocity_y, time_since_last_recv_, remote_frame_);
-			dr_remote_control_.SetLastKnown(host_x, host_y, host_velocity_x, host_velocity_y, time_since_last_recv_, remote_frame_);
-			snapshot_local_control_.AddSnapshot({ non_host_x, non_host_y, time_since_last_recv_}, remote_frame_);
-			snapshot_remote_control_.AddSnapshot({ host_x, host_y, time_since_last_recv_}, remote_frame_);
-		}
-		time_since_last_recv_ = 0.0f;
-	}
+			const auto previous_remote_frame = remote_frame_;
+			clock_sync_.SetArrivalTime(GetArrivalTime());
+			dispatcher_.Dispatch(datagram);
+			return remote_frame_ != previous_remote_frame;
+		});
+	receive_stats_.datagrams_malformed = dispatcher_.GetStats().datagrams_malformed;
+	receive_stats_.messages_unreadable = dispatcher_.GetStats().messages_unreadable;
 
 	send_timer_secs_ -= system_dt;
 	if (send_timer_secs_ < 0.0f)
 	{
+		OptimisticMessages::ControlMessage control;
+		control.frame = ++local_frame_;
+		control.is_paused = is_local_paused;
+		OptimisticMessages::AckMessage ack;
+		ack.acked_frame = remote_frame_;
 		packet_.Reset();
-		PacketSerializer::WriteValue<u_long>(packet_, ++local_frame_);
-		PacketSerializer::WriteValue<bool>(packet_, is_local_paused);
-		PacketSerializer::WriteValue<bool>(packet_, is_attack_queued_);
-		if (is_attack_queued_)
-		{
-			const auto attack_sync = local_attack_.GetSyncRatio(); // use the stored sync, not the current one!
-			PacketSerializer::WriteValue<float>(packet_, local_attack_.GetAttackX());
-			PacketSerializer::WriteValue<float>(packet_, local_attack_.GetAttackY());
-			PacketSerializer::WriteValue<u_long>(packet_, attack_sync.base_frame);
-			PacketSerializer::WriteValue<u_long>(packet_, attack_sync.target_frame);
-			PacketSerializer::WriteValue<float>(packet_, attack_sync.t);
-			is_attack_queued_ = false;
-		}
-		send(socket_, packet_.GetRoot(), packet_.GetUsedSpace(), 0);
+		reliable_.WriteHeader(packet_);
+		MessageWriter writer(packet_);
+		clock_sync_.Write(writer);
+		OptimisticMessages::WriteControl(writer, send_format_, control);
+		OptimisticMessages::WriteAck(writer, send_format_, ack);
+		reliable_.WriteReliable(writer);
+		last_send_size_ = packet_.GetUsedSpace();
+		SendDatagram(packet_);
 		send_timer_secs_ = kTimeBetweenClientSend_Secs;
 	}
 }
 
 
+bool OptimisticClientScenarioState::ReceiveState(Packet& payload)
+{
+	OptimisticMessages::StateMessage state;
+	if (!OptimisticMessages::ReadState(payload, state, remote_frame_, received_state_history_))
+	{
+		// a delta against a state we have not received is routine under loss and reordering, so it is only dropped,
+		// and the datagram is counted as stale, since it moved nothing forward
+		return state.baseline_frame != 0;
+	}
+
+	// only use data if it's newer than the last frame we received
+	if (!PacketSerializer::IsFrameNewer(state.frame, remote_frame_))
+	{
+		return true;
+	}
+
+	// the spacing and age come from the host's clock, so neither is skewed by delays on the way here
+	const auto is_first_state = (remote_frame_ == 0);
+	const auto remote_time_secs = clock_sync_.GetDatagramRemoteTimeSecs();
+	const auto time_since_last_state_secs = is_first_state ? 0.0f : static_cast<float>(remote_time_secs - last_state_remote_time_secs_);
+	const auto state_age_secs = clock_sync_.GetAgeSecs(remote_time_secs);
+	last_state_remote_time_secs_ = remote_time_secs;
+
+	remote_frame_ = state.frame;
+	// keep the rebuilt state, as the host may delta-compress against it once we acknowledge it
+	received_state_history_.Push(state);
+	// store the data in all of the controls
+	simple_local_control_.SetLastKnown(state.non_host_x, state.non_host_y, remote_frame_);
+	simple_remote_control_.SetLastKnown(state.host_x, state.host_y, remote_frame_);
+	dr_local_control_.SetLastKnown(state.non_host_x, state.non_host_y, state.non_host_velocity_x, state.non_host_velocity_y, time_since_last_state_secs, state_age_secs, remote_frame_);
+	dr_remote_control_.SetLastKnown(state.host_x, state.host_y, state.host_velocity_x, state.host_velocity_y, time_since_last_state_secs, state_age_secs, remote_frame_);
+	snapshot_local_control_.AddSnapshot({ state.non_host_x, state.non_host_y, time_since_last_state_secs, state_age_secs }, remote_frame_);
+	snapshot_remote_control_.AddSnapshot({ state.host_x, state.host_y, time_since_last_state_secs, state_age_secs }, remote_frame_);
+	return true;
+}
+
+
+bool OptimisticClientScenarioState::ReceiveConfirmedAttack(Packet& payload)
+{
+	OptimisticMessages::ConfirmedAttackMessage confirmed_attack;
+	if (!OptimisticMessages::ReadConfirmedAttack(payload, confirmed_attack))
+	{
+		return false;
+	}
+
+	remote_confirmed_attack_.Set(confirmed_attack.client_attack_x, confirmed_attack.client_attack_y, confirmed_attack.target_x, confirmed_attack.target_y, SyncRatio());
+	remote_hit_timer_secs_ = remote_confirmed_attack_.IsTargetHit() ? kDrawRemoteHit_Secs : 0.0f;
+	return true;
+}
+
+
 void OptimisticClientScenarioState::Draw()
 {
-	ScenarioState::Draw();
+	NetworkedScenarioState::Draw();
 
 	local_attack_.Draw(true, true);
 	remote_confirmed_attack_.Draw(false, true);
@@ -265,33 +304,25 @@ std::string OptimisticClientScenarioState::GetDescription() const
 	{
 		description += ", Drawing";
 	}
+	description += ", Resent: ";
+	description += std::to_string(reliable_.GetStats().reliable_resent);
+	description += ", RTT: ";
+	description += std::to_string(static_cast<int>(clock_sync_.GetRttSecs() * 1000));
+	description += "ms";
+	description += (send_format_ == PacketSerializer::Format::Bits) ? ", Bits: " : ", Bytes: ";
+	description += std::to_string(last_send_size_);
+	description += "B";
 	return description;
 }
 
 
 std::string OptimisticClientScenarioState::GetInstructions() const
 {
-	return "Hold SPACE to halt local (red) player, F to attack, A to toggle control, D to toggle drawing";
+	return "Hold SPACE to halt local (red) player, F to attack, A to toggle control, D to toggle drawing, B to toggle bit-packing";
 }
 
 
-bool OptimisticClientScenarioState::HandleSocketError(const char* error_text)
+NetworkedScenarioState::View OptimisticClientScenarioState::GetView() const
 {
-	const auto wsa_error = WSAGetLastError();
-
-	// ignore WSAEWOULDBLOCK
-	if (wsa_error == WSAEWOULDBLOCK)
-	{
-		return false;
-	}
-
-	// log unexpected errors and return to the default game mode
-	std::cerr << "Optimistic WinSock Error: " << error_text << wsa_error << std::endl;
-
-	// close the socket and clear it
-	// -- this should trigger a GameStateManager reset in the next Update
-	closesocket(socket_);
-	socket_ = INVALID_SOCKET;
-
-	return true;
+	return { local_frame_, remote_frame_, local_player_.GetX(), local_player_.GetY(), remote_player_.GetX(), remote_player_.GetY() };
 }
\ No newline at end of file
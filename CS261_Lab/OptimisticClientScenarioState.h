@@ -14,6 +14,12 @@
 #include "SnapshotControl.h"
 #include "DeadReckoningControl.h"
 #include "Packet.h"
+#include "PacketSerializer.h"
+#include "OptimisticMessages.h"
+#include "MessageDispatcher.h"
+#include "ReliableChannel.h"
+#include "ClockSync.h"
+#include "FragmentChannel.h"
 #include "Attack.h"
 
 
@@ -24,7 +30,7 @@ class OptimisticClientScenarioState final :
     public NetworkedScenarioState
 {
 public:
-    OptimisticClientScenarioState(const SOCKET socket);
+    OptimisticClientScenarioState(std::unique_ptr<DatagramTransport> transport);
     ~OptimisticClientScenarioState() override;
 
     OptimisticClientScenarioState(const OptimisticClientScenarioState&) = delete;
@@ -37,9 +43,15 @@ public:
 
     std::string GetDescription() const override;
     std::string GetInstructions() const override;
+    View GetView() const override;
+
+    const Attack& GetLocalAttack() const { return local_attack_; }
+    const Attack& GetRemoteConfirmedAttack() const { return remote_confirmed_attack_; }
+    const ReliableChannel::Stats& GetReliableStats() const { return reliable_.GetStats(); }
 
 private:
-    bool HandleSocketError(const char* error_text);
+    bool ReceiveState(Packet& payload);
+    bool ReceiveConfirmedAttack(Packet& payload);
 
     enum class Active_Control
     {
@@ -61,13 +73,23 @@ private:
 
     Attack local_attack_;
     Attack remote_confirmed_attack_;
-    bool is_attack_queued_;
     float remote_hit_timer_secs_;
 
     u_long local_frame_;
     u_long remote_frame_;
     float send_timer_secs_;
-    float time_since_last_recv_;
+    double last_state_remote_time_secs_; // when the host sent the newest state, on the host's clock
+    PacketSerializer::Format send_format_;
+    unsigned int last_send_size_;
+
+    FixedPacket<kMaxDatagramSize> packet_;
+    MessageDispatcher dispatcher_;
+    // attacks are sent reliably, and the channel's header leads every datagram
+    ReliableChannel reliable_;
+    // times the data in each datagram, so the controls see its true age rather than the spacing of arrivals
+    ClockSync clock_sync_;
+    // reassembles any state the host had to split across datagrams
+    FragmentChannel fragments_;
 
-    Packet packet_;
+    OptimisticMessages::StateHistory received_state_history_;
 };
\ No newline at end of file
@@ -10,31 +10,45 @@
 #include "pch.h"
 #include "OptimisticHostScenarioState.h"
 #include "PacketSerializer.h"
+#include "OptimisticMessages.h"
 #include "DoubleOrbitControl.h"
 #include "LabMath.h"
 
-const int kNetworkBufferSize = 1024; // maximum size of our packet
 const float kDrawLocalHit_Secs = 2.0f; // number of seconds to draw the local player as hit
 const float kAttackTextSize = 30.0f; // The size of the attack text.
 const CP_Color kAttackTextColor = CP_Color_Create(255, 255, 255, 255); // The color of the attack text.
-const int kLocalStateHistorySize = 100; // the amount of state records to keep
+const float kSendBudget_BytesPerSec = 4096.0f; // the most state the automatic send rate may send each client
 
 
-OptimisticHostScenarioState::OptimisticHostScenarioState(const SOCKET socket)
-	: NetworkedScenarioState(socket, true),
+OptimisticHostScenarioState::OptimisticHostScenarioState(std::unique_ptr<DatagramTransport> transport)
+	: NetworkedScenarioState(std::move(transport), true),
 	local_control_(200.0f, 250.0f, 100.0f, 1.5f),
 	remote_control_(200.0f, 150.0f, 100.0f, 2.0f),
 	is_remote_paused_(false),
-	is_client_attack_queued_(false),
 	local_hit_timer_secs_(0.0f),
 	local_frame_(0),
 	remote_frame_(0),
+	acked_frame_(0),
 	send_timer_secs_(0.0f), // always start with a packet
 	target_time_between_send_(0.0f),
-	packet_(kNetworkBufferSize)
+	is_send_rate_automatic_(true),
+	send_rate_(kSendBudget_BytesPerSec),
+	send_format_(PacketSerializer::Format::Bytes),
+	last_send_size_(0),
+	reliable_(dispatcher_),
+	clock_sync_(dispatcher_),
+	fragments_(dispatcher_)
 {
 	local_player_.color = CP_Color_Create(255, 0, 0, 255);
 	remote_player_.color = CP_Color_Create(0, 0, 255, 255);
+
+	OptimisticMessages::ReportQuantization();
+
+	// the client coalesces its control, ack, and any new attack into each datagram
+	using OptimisticMessages::MessageType;
+	OptimisticMessages::Register(dispatcher_, MessageType::Control, [this](Packet& payload) { return ReceiveControl(payload); });
+	OptimisticMessages::Register(dispatcher_, MessageType::Ack, [this](Packet& payload) { return ReceiveAck(payload); });
+	OptimisticMessages::Register(dispatcher_, MessageType::Attack, [this](Packet& payload) { return ReceiveAttack(payload); });
 }
 
 
@@ -45,19 +59,34 @@ void OptimisticHostScenarioState::Update()
 {
 	NetworkedScenarioState::Update();
 
+	// W cycles from automatic through the manual send targets, and back to automatic
 	if (CP_Input_KeyTriggered(CP_KEY::KEY_W))
 	{
-		target_time_between_send_ += 0.1f;
-		if (target_time_between_send_ > 0.5f)
+		if (is_send_rate_automatic_)
 		{
+			is_send_rate_automatic_ = false;
 			target_time_between_send_ = 0.0f;
 		}
+		else
+		{
+			target_time_between_send_ += 0.1f;
+			if (target_time_between_send_ > 0.5f)
+			{
+				is_send_rate_automatic_ = true;
+				target_time_between_send_ = 0.0f;
+			}
+		}
+	}
+
+	if (!is_send_rate_automatic_ && CP_Input_KeyTriggered(CP_KEY::KEY_B))
+	{
+		send_format_ = (send_format_ == PacketSerializer::Format::Bytes) ? PacketSerializer::Format::Bits : PacketSerializer::Format::Bytes;
 	}
 
 	const auto system_dt = 1.0f / 30.0f; // CP_System_GetDt();
 	const bool is_local_paused = CP_Input_KeyDown(KEY_SPACE);
-	// always send a packet when the server pauses...
-	if (CP_Input_KeyTriggered(KEY_SPACE))
+	// always send a packet when the server pauses or resumes...
+	if (CP_Input_KeyTriggered(KEY_SPACE) || CP_Input_KeyReleased(KEY_SPACE))
 	{
 		send_timer_secs_ = 0.0f; 
 	}
@@ -68,100 +97,179 @@ void OptimisticHostScenarioState::Update()
 	local_player_.SetPosition(local_control_.GetCurrentX(), local_control_.GetCurrentY());
 	remote_player_.SetPosition(remote_control_.GetCurrentX(), remote_control_.GetCurrentY());
 
-	packet_.Reset();
-	const auto res = recv(socket_, packet_.GetRoot(), packet_.GetRemainingSpace(), 0);
-	if (res > 0)
-	{
-		u_long received_frame;
-		PacketSerializer::ReadValue<u_long>(packet_, received_frame);
-		// only use data if it's newer than the last frame we received
-		if (received_frame > remote_frame_)
+	reliable_.Update(system_dt);
+	fragments_.Update(system_dt);
+	// only the newest control and ack are kept, but every attack is resolved
+	DrainReceivedDatagrams([this](Packet& datagram)
 		{
-			remote_frame_ = received_frame;
-			// the host only receives control updates, while the client receives all positions
-			PacketSerializer::ReadValue<bool>(packet_, is_remote_paused_);
-
-			bool is_client_attacking;
-			PacketSerializer::ReadValue<bool>(packet_, is_client_attacking);
-			if (is_client_attacking)
+			if (!reliable_.ReadHeader(datagram))
 			{
-				float attack_x, attack_y;
-				u_long base_attack_frame, target_attack_frame;
-				float attack_t;
-				PacketSerializer::ReadValue<float>(packet_, attack_x);
-				PacketSerializer::ReadValue<float>(packet_, attack_y);
-				PacketSerializer::ReadValue<u_long>(packet_, base_attack_frame);
-				PacketSerializer::ReadValue<u_long>(packet_, target_attack_frame);
-				PacketSerializer::ReadValue<float>(packet_, attack_t);
-				// calculate historical position of the local (target) player, using remote sync information and stored frames
-				const auto base_attack_record_iter = std::find_if(local_state_history_.begin(), local_state_history_.end(), [=](ControlStateRecord record) { return record.frame == base_attack_frame; });
-				const auto target_attack_record_iter = std::find_if(local_state_history_.begin(), local_state_history_.end(), [=](ControlStateRecord record) { return record.frame == target_attack_frame; });
-				if (base_attack_record_iter == local_state_history_.end())
-				{
-					std::cout << "Base attack frame " << base_attack_frame << "not found" << std::endl;
-				}
-				else if (target_attack_record_iter == local_state_history_.end())
-				{
-					std::cout << "Base attack frame " << base_attack_frame << " found, BUT target attack frame " << target_attack_frame << " not found" << std::endl;
-				}
-				else
-				{
-					//GOAL: calculate historical position of the local (target) player, using remote sync information and stored frames
-					float target_x, target_y;
-
-					// just use whatever the host has now
-					//WRONG: current values won't match what the client thought they were hitting!
-					target_x = local_control_.GetCurrentX();
-					target_y = local_control_.GetCurrentY();
-
-					// TODO ADD LAB CODE HERE!
-
-					client_attack_.Set(attack_x, attack_y, target_x, target_y, { base_attack_frame, target_attack_frame, attack_t });
-					is_client_attack_queued_ = true;
-					local_hit_timer_secs_ = client_attack_.IsTargetHit() ? kDrawLocalHit_Secs : 0.0f;
-				}
+				return false;
 			}
-		}
+			const auto previous_remote_frame = remote_frame_;
+			clock_sync_.SetArrivalTime(GetArrivalTime());
+			dispatcher_.Dispatch(datagram);
+			return remote_frame_ != previous_remote_frame;
+		});
+	receive_stats_.datagrams_malformed = dispatcher_.GetStats().datagrams_malformed;
+	receive_stats_.messages_unreadable = dispatcher_.GetStats().messages_unreadable;
+
+	if (is_send_rate_automatic_)
+	{
+		SendRateController::Signals signals;
+		signals.rtt_secs = clock_sync_.GetRttSecs();
+		signals.min_rtt_secs = clock_sync_.GetMinRttSecs();
+		signals.remote_jitter_secs = clock_sync_.GetRemoteJitterSecs();
+		signals.datagrams_acked = reliable_.GetStats().datagrams_acked;
+		signals.datagrams_lost = reliable_.GetStats().datagrams_lost;
+		send_rate_.Update(system_dt, signals);
+		send_format_ = send_rate_.IsBitPacking() ? PacketSerializer::Format::Bits : PacketSerializer::Format::Bytes;
 	}
 
 	send_timer_secs_ -= system_dt;
 	if (send_timer_secs_ < 0.0f)
 	{
+		OptimisticMessages::StateMessage state;
+		state.frame = ++local_frame_;
+		state.host_x = local_control_.GetCurrentX();
+		state.host_y = local_control_.GetCurrentY();
+		state.host_velocity_x = local_control_.GetCurrentVelocityX();
+		state.host_velocity_y = local_control_.GetCurrentVelocityY();
+		state.non_host_x = remote_control_.GetCurrentX();
+		state.non_host_y = remote_control_.GetCurrentY();
+		state.non_host_velocity_x = remote_control_.GetCurrentVelocityX();
+		state.non_host_velocity_y = remote_control_.GetCurrentVelocityY();
+		// delta-compress against the newest state the client has acknowledged, if we still have it
+		const auto* baseline = sent_state_history_.Find([=](const OptimisticMessages::StateMessage& record) { return record.frame == acked_frame_; });
 		packet_.Reset();
-		PacketSerializer::WriteValue<u_long>(packet_, ++local_frame_);
-		// CONVENTION: host writes its own values first
-		PacketSerializer::WriteValue<float>(packet_, local_control_.GetCurrentX());
-		PacketSerializer::WriteValue<float>(packet_, local_control_.GetCurrentY());
-		PacketSerializer::WriteValue<float>(packet_, local_control_.GetCurrentVelocityX());
-		PacketSerializer::WriteValue<float>(packet_, local_control_.GetCurrentVelocityY());
-		PacketSerializer::WriteValue<float>(packet_, remote_control_.GetCurrentX());
-		PacketSerializer::WriteValue<float>(packet_, remote_control_.GetCurrentY());
-		PacketSerializer::WriteValue<float>(packet_, remote_control_.GetCurrentVelocityX());
-		PacketSerializer::WriteValue<float>(packet_, remote_control_.GetCurrentVelocityY());
-		PacketSerializer::WriteValue<bool>(packet_, is_client_attack_queued_);
-		if (is_client_attack_queued_)
+		reliable_.WriteHeader(packet_);
+		MessageWriter writer(packet_);
+		clock_sync_.Write(writer);
+		if (!OptimisticMessages::WriteState(writer, send_format_, state, baseline, acked_frame_))
 		{
-			PacketSerializer::WriteValue<float>(packet_, client_attack_.GetAttackX());
-			PacketSerializer::WriteValue<float>(packet_, client_attack_.GetAttackY());
-			PacketSerializer::WriteValue<float>(packet_, client_attack_.GetTargetX());
-			PacketSerializer::WriteValue<float>(packet_, client_attack_.GetTargetY());
-			is_client_attack_queued_ = false;
+			fragments_.Queue([&](MessageWriter& fragment_writer) { return OptimisticMessages::WriteState(fragment_writer, send_format_, state, baseline, acked_frame_); });
+		}
+		// any resolved client attack rides along in the same datagram, until the client acknowledges it
+		reliable_.WriteReliable(writer);
+		last_send_size_ = packet_.GetUsedSpace();
+
+		sent_state_history_.Push(state);
+		SendDatagram(packet_);
+		// the fragments of a large state follow at once, each numbered and timed like any other datagram
+		while (fragments_.HasPendingFragments())
+		{
+			packet_.Reset();
+			reliable_.WriteHeader(packet_);
+			MessageWriter fragment_writer(packet_);
+			clock_sync_.Write(fragment_writer);
+			if (!fragments_.WriteFragment(fragment_writer))
+			{
+				break;
+			}
+			last_send_size_ += packet_.GetUsedSpace();
+			SendDatagram(packet_);
 		}
-		send(socket_, packet_.GetRoot(), packet_.GetUsedSpace(), 0);
-		send_timer_secs_ = target_time_between_send_;
+		send_rate_.OnSend(last_send_size_);
+		// the automatic interval carries over the part of a tick the timer overshot, so the rate averages out as chosen,
+		// but no more than one interval of it, so a long stall does not turn into a burst of catch-up sends
+		const auto time_between_send = is_send_rate_automatic_ ? send_rate_.GetInterval() : target_time_between_send_;
+		send_timer_secs_ = is_send_rate_automatic_ ? std::max(send_timer_secs_, -time_between_send) + time_between_send : time_between_send;
 
-		local_state_history_.push_back({ local_frame_, local_control_.GetState(), {local_control_.GetCurrentX(), local_control_.GetCurrentY(), target_time_between_send_} });
-		while (local_state_history_.size() > kLocalStateHistorySize)
+		local_state_history_.Push({ local_frame_, local_control_.GetState(), {local_control_.GetCurrentX(), local_control_.GetCurrentY(), time_between_send} });
+	}
+}
+
+
+bool OptimisticHostScenarioState::ReceiveControl(Packet& payload)
+{
+	OptimisticMessages::ControlMessage control;
+	if (!OptimisticMessages::ReadControl(payload, control, remote_frame_))
+	{
+		return false;
+	}
+
+	// only use data if it's newer than the last frame we received
+	if (PacketSerializer::IsFrameNewer(control.frame, remote_frame_))
+	{
+		remote_frame_ = control.frame;
+		// the host only receives control updates, while the client receives all positions
+		// -- a pause or resume is sent on at once, whatever the send rate
+		if (control.is_paused != is_remote_paused_)
 		{
-			local_state_history_.pop_front();
+			send_timer_secs_ = 0.0f;
 		}
+		is_remote_paused_ = control.is_paused;
+	}
+	return true;
+}
+
+
+bool OptimisticHostScenarioState::ReceiveAck(Packet& payload)
+{
+	OptimisticMessages::AckMessage ack;
+	if (!OptimisticMessages::ReadAck(payload, ack))
+	{
+		return false;
+	}
+
+	if (PacketSerializer::IsFrameNewer(ack.acked_frame, acked_frame_))
+	{
+		acked_frame_ = ack.acked_frame;
+	}
+	return true;
+}
+
+
+bool OptimisticHostScenarioState::ReceiveAttack(Packet& payload)
+{
+	OptimisticMessages::AttackMessage attack;
+	if (!OptimisticMessages::ReadAttack(payload, attack))
+	{
+		return false;
+	}
+
+	const auto base_attack_frame = attack.attack_sync.base_frame;
+	const auto target_attack_frame = attack.attack_sync.target_frame;
+	// calculate historical position of the local (target) player, using remote sync information and stored frames
+	const auto* base_attack_record = local_state_history_.Find([=](const ControlStateRecord& record) { return record.frame == base_attack_frame; });
+	const auto* target_attack_record = local_state_history_.Find([=](const ControlStateRecord& record) { return record.frame == target_attack_frame; });
+	if (base_attack_record == nullptr)
+	{
+		std::cout << "Base attack frame " << base_attack_frame << "not found" << std::endl;
+	}
+	else if (target_attack_record == nullptr)
+	{
+		std::cout << "Base attack frame " << base_attack_frame << " found, BUT target attack frame " << target_attack_frame << " not found" << std::endl;
 	}
+	else
+	{
+		//GOAL: calculate historical position of the local (target) player, using remote sync information and stored frames
+		float target_x, target_y;
+
+		// just use whatever the host has now
+		//WRONG: current values won't match what the client thought they were hitting!
+		target_x = local_control_.GetCurrentX();
+		target_y = local_control_.GetCurrentY();
+
+		// TODO ADD LAB CODE HERE!
+
+		client_attack_.Set(attack.attack_x, attack.attack_y, target_x, target_y, attack.attack_sync);
+		OptimisticMessages::ConfirmedAttackMessage confirmed_attack;
+		confirmed_attack.client_attack_x = client_attack_.GetAttackX();
+		confirmed_attack.client_attack_y = client_attack_.GetAttackY();
+		confirmed_attack.target_x = client_attack_.GetTargetX();
+		confirmed_attack.target_y = client_attack_.GetTargetY();
+		const auto format = send_format_;
+		reliable_.QueueReliable([&](MessageWriter& writer) { return OptimisticMessages::WriteConfirmedAttack(writer, format, confirmed_attack); });
+		local_hit_timer_secs_ = client_attack_.IsTargetHit() ? kDrawLocalHit_Secs : 0.0f;
+	}
+	return true;
 }
 
 
 void OptimisticHostScenarioState::Draw()
 {
-	ScenarioState::Draw();
+	NetworkedScenarioState::Draw();
 
 	client_attack_.Draw(true, true);
 
@@ -199,35 +307,40 @@ std::string OptimisticHostScenarioState::GetDescription() const
 	description += ", Remote: ";
 	description += std::to_string(remote_frame_);
 	description += ", Send Target: ";
-	description += std::to_string(static_cast<int>(target_time_between_send_ * 1000));
-	description += "ms";
+	if (is_send_rate_automatic_)
+	{
+		description += "Auto ";
+		description += std::to_string(static_cast<int>(send_rate_.GetInterval() * 1000));
+		description += "ms (";
+		description += SendRateController::GetReasonName(send_rate_.GetReason());
+		description += ", ";
+		description += std::to_string(static_cast<int>(send_rate_.GetMetrics().bytes_per_sec));
+		description += "B/s), ";
+	}
+	else
+	{
+		description += std::to_string(static_cast<int>(target_time_between_send_ * 1000));
+		description += "ms, ";
+	}
+	description += "Resent: ";
+	description += std::to_string(reliable_.GetStats().reliable_resent);
+	description += ", RTT: ";
+	description += std::to_string(static_cast<int>(clock_sync_.GetRttSecs() * 1000));
+	description += "ms, ";
+	description += (send_format_ == PacketSerializer::Format::Bits) ? "Bits: " : "Bytes: ";
+	description += std::to_string(last_send_size_);
+	description += "B";
 	return description;
 }
 
 
 std::string OptimisticHostScenarioState::GetInstructions() const
 {
-	return "Hold SPACE to halt the local (red) player, W to increase Send Target";
+	return "Hold SPACE to halt the local (red) player, W to increase Send Target (or return to Auto), B to toggle bit-packing when not Auto";
 }
 
 
-bool OptimisticHostScenarioState::HandleSocketError(const char* error_text)
+NetworkedScenarioState::View OptimisticHostScenarioState::GetView() const
 {
-	const auto wsa_error = WSAGetLastError();
-
-	// ignore WSAEWOULDBLOCK
-	if (wsa_error == WSAEWOULDBLOCK)
-	{
-		return false;
-	}
-
-	// log unexpected errors and return to the default game mode
-	std::cerr << "Optimistic WinSock Error: " << error_text << wsa_error << std::endl;
-
-	// close the socket and clear it
-	// -- this should trigger a GameStateManager reset in the next Update
-	closesocket(socket_);
-	socket_ = INVALID_SOCKET;
-
-	return true;
+	return { local_frame_, remote_frame_, local_player_.GetX(), local_player_.GetY(), remote_player_.GetX(), remote_player_.GetY() };
 }
\ No newline at end of file
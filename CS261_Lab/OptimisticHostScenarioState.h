@@ -11,6 +11,13 @@
 #include "NetworkedScenarioState.h"
 #include "Player.h"
 #include "Packet.h"
+#include "PacketSerializer.h"
+#include "OptimisticMessages.h"
+#include "MessageDispatcher.h"
+#include "ReliableChannel.h"
+#include "ClockSync.h"
+#include "FragmentChannel.h"
+#include "SendRateController.h"
 #include "DoubleOrbitControl.h"
 #include "SnapshotControl.h"
 #include "Attack.h"
@@ -23,7 +30,7 @@ class OptimisticHostScenarioState final :
     public NetworkedScenarioState
 {
 public:
-    OptimisticHostScenarioState(const SOCKET socket);
+    OptimisticHostScenarioState(std::unique_ptr<DatagramTransport> transport);
     ~OptimisticHostScenarioState() override;
 
     OptimisticHostScenarioState(const OptimisticHostScenarioState&) = delete;
@@ -36,9 +43,15 @@ public:
 
     std::string GetDescription() const override;
     std::string GetInstructions() const override;
+    View GetView() const override;
+
+    const Attack& GetClientAttack() const { return client_attack_; }
+    const ReliableChannel::Stats& GetReliableStats() const { return reliable_.GetStats(); }
 
 private:
-    bool HandleSocketError(const char* error_text);
+    bool ReceiveControl(Packet& payload);
+    bool ReceiveAck(Packet& payload);
+    bool ReceiveAttack(Packet& payload);
 
     DoubleOrbitControl local_control_;
     DoubleOrbitControl remote_control_;
@@ -49,15 +62,27 @@ private:
     bool is_remote_paused_;
 
     Attack client_attack_;
-    bool is_client_attack_queued_;
     float local_hit_timer_secs_;
 
     u_long local_frame_;
     u_long remote_frame_;
+    u_long acked_frame_;
     float send_timer_secs_;
     float target_time_between_send_;
+    // when set, the send interval and format are picked by send_rate_ rather than the W and B keys
+    bool is_send_rate_automatic_;
+    SendRateController send_rate_;
+    PacketSerializer::Format send_format_;
+    unsigned int last_send_size_;
 
-    Packet packet_;
+    FixedPacket<kMaxDatagramSize> packet_;
+    MessageDispatcher dispatcher_;
+    // confirmed attacks are sent reliably, and the channel's header leads every datagram
+    ReliableChannel reliable_;
+    // echoes the client's send times, so the client can estimate the round trip and host time
+    ClockSync clock_sync_;
+    // a state too large to share a datagram follows in fragments, which the client reassembles
+    FragmentChannel fragments_;
 
     struct ControlStateRecord
     {
@@ -65,5 +90,8 @@ private:
         DoubleOrbitControl::State actual_control_state;
         SnapshotControl::State snapshot_state;
     };
-    std::deque<ControlStateRecord> local_state_history_;
+    // the amount of state records to keep
+    static const unsigned int kLocalStateHistorySize = 100;
+    RingBuffer<ControlStateRecord, kLocalStateHistorySize> local_state_history_;
+    OptimisticMessages::StateHistory sent_state_history_;
 };
\ No newline at end of file
@@ -0,0 +1,338 @@
+//---------------------------------------------------------
+// file:	OptimisticMessages.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	The messages exchanged by the optimistic host and client, in either packet format.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "OptimisticMessages.h"
+#include <atomic>
+#include "MessageSchema.h"
+#include "LabMath.h"
+
+using PacketSerializer::Format;
+
+
+namespace
+{
+	using namespace OptimisticMessages;
+	using namespace MessageSchema;
+
+	using SyncRatioSchema = Schema<SyncRatio,
+		Value<&SyncRatio::base_frame>,
+		Value<&SyncRatio::target_frame>,
+		Value<&SyncRatio::t>>;
+
+	// the frame is written ahead of the schema
+	using ControlSchema = Schema<ControlMessage,
+		Value<&ControlMessage::is_paused>>;
+
+	// the acked frame is written whole, since 0 means "none yet" and must not be read as a truncated frame
+	using AckSchema = Schema<AckMessage,
+		Value<&AckMessage::acked_frame>>;
+
+	using AttackSchema = Schema<AttackMessage,
+		Quantized<&AttackMessage::attack_x, kPositionX>,
+		Quantized<&AttackMessage::attack_y, kPositionY>,
+		Nested<&AttackMessage::attack_sync, SyncRatioSchema>>;
+
+	// the frame and baseline reference are written ahead of the schema, and the player values are
+	// delta-compressed against the baseline in the Bits format
+	using StateSchema = Schema<StateMessage,
+		Quantized<&StateMessage::host_x, kPositionX>,
+		Quantized<&StateMessage::host_y, kPositionY>,
+		Quantized<&StateMessage::host_velocity_x, kVelocity>,
+		Quantized<&StateMessage::host_velocity_y, kVelocity>,
+		Quantized<&StateMessage::non_host_x, kPositionX>,
+		Quantized<&StateMessage::non_host_y, kPositionY>,
+		Quantized<&StateMessage::non_host_velocity_x, kVelocity>,
+		Quantized<&StateMessage::non_host_velocity_y, kVelocity>>;
+
+	using ConfirmedAttackSchema = Schema<ConfirmedAttackMessage,
+		Quantized<&ConfirmedAttackMessage::client_attack_x, kPositionX>,
+		Quantized<&ConfirmedAttackMessage::client_attack_y, kPositionY>,
+		Quantized<&ConfirmedAttackMessage::target_x, kPositionX>,
+		Quantized<&ConfirmedAttackMessage::target_y, kPositionY>>;
+
+
+	/// <summary>
+	/// Write the rest of a message with its schema, in the given format.
+	/// </summary>
+	template <typename MessageSchemaType, typename Message>
+	bool WriteBody(Packet& payload, const Format format, const Message& message)
+	{
+		if (format == Format::Bytes)
+		{
+			return MessageSchemaType::Write(payload, message);
+		}
+		BitWriter writer(payload);
+		return MessageSchemaType::Write(writer, message) && writer.Flush();
+	}
+
+
+	/// <summary>
+	/// Read the rest of a message with its schema, in the given format.
+	/// </summary>
+	template <typename MessageSchemaType, typename Message>
+	bool ReadBody(Packet& payload, const Format format, Message& message)
+	{
+		if (format == Format::Bytes)
+		{
+			return MessageSchemaType::Read(payload, message);
+		}
+		BitReader reader(payload);
+		return MessageSchemaType::Read(reader, message);
+	}
+
+
+	/// <summary>
+	/// Write a message that has no frame: the format, then the schema.
+	/// </summary>
+	template <typename MessageSchemaType, typename Message>
+	bool WriteSimple(MessageWriter& writer, const MessageType type, const Format format, const Message& message)
+	{
+		return writer.Write(static_cast<MessageTypeId>(type), [&](Packet& payload)
+		{
+			return PacketSerializer::WriteValue<Format>(payload, format) &&
+				WriteBody<MessageSchemaType>(payload, format, message);
+		});
+	}
+
+
+	/// <summary>
+	/// Read a message written by WriteSimple.
+	/// </summary>
+	template <typename MessageSchemaType, typename Message>
+	bool ReadSimple(Packet& payload, Message& message)
+	{
+		Format format;
+		return PacketSerializer::ReadValue<Format>(payload, format) &&
+			ReadBody<MessageSchemaType>(payload, format, message);
+	}
+
+
+	bool WriteStateBits(Packet& payload, const StateMessage& message, const StateMessage* baseline)
+	{
+		// the baseline reference is written by hand, ahead of the schema
+		BitWriter writer(payload);
+		auto result = writer.WriteBool(baseline != nullptr);
+		if (result && (baseline != nullptr))
+		{
+			result = writer.WriteBits(message.frame - baseline->frame, LabMath::BitsRequired(kMaxBaselineAge)) &&
+				StateSchema::WriteDelta(writer, message, *baseline);
+		}
+		else
+		{
+			result = result && StateSchema::Write(writer, message);
+		}
+		return result && writer.Flush();
+	}
+
+
+	bool ReadStateBits(Packet& payload, StateMessage& message, const StateHistory& baselines)
+	{
+		BitReader reader(payload);
+		bool has_baseline;
+		if (!reader.ReadBool(has_baseline))
+		{
+			return false;
+		}
+		message.baseline_frame = 0;
+		if (!has_baseline)
+		{
+			return StateSchema::Read(reader, message);
+		}
+
+		// find the baseline the host compressed against, which we must have received already
+		uint32_t baseline_age;
+		if (!reader.ReadBits(baseline_age, LabMath::BitsRequired(kMaxBaselineAge)))
+		{
+			return false;
+		}
+		message.baseline_frame = message.frame - baseline_age;
+		// (it may have been lost, or still be on its way, which is routine, so it is left to the caller to count)
+		const auto* baseline = baselines.Find([&](const StateMessage& record) { return record.frame == message.baseline_frame; });
+		if (baseline == nullptr)
+		{
+			return false;
+		}
+		if (!StateSchema::ReadDelta(reader, message, *baseline))
+		{
+			message.baseline_frame = 0;
+			return false;
+		}
+		return true;
+	}
+}
+
+
+/// <summary>
+/// Route messages of the given type to the handler.
+/// </summary>
+void OptimisticMessages::Register(MessageDispatcher& dispatcher, const MessageType type, MessageDispatcher::Handler handler)
+{
+	dispatcher.Register(static_cast<MessageTypeId>(type), std::move(handler));
+}
+
+
+/// <summary>
+/// Append the client's control message: the format, the frame, and then the body.
+/// </summary>
+/// <remarks>The host does not acknowledge control messages, so the frame is written with the unacked window.</remarks>
+/// <returns>If true, the message was successfully written.</returns>
+bool OptimisticMessages::WriteControl(MessageWriter& writer, const Format format, const ControlMessage& message)
+{
+	return writer.Write(static_cast<MessageTypeId>(MessageType::Control), [&](Packet& payload)
+	{
+		return PacketSerializer::WriteValue<Format>(payload, format) &&
+			PacketSerializer::WriteFrame(payload, message.frame) &&
+			WriteBody<ControlSchema>(payload, format, message);
+	});
+}
+
+
+/// <summary>
+/// Read the client's control message out of its payload, in whichever format it was written.
+/// </summary>
+/// <remarks>The frame is rebuilt relative to the newest control frame received.</remarks>
+/// <returns>If true, the message was successfully read.</returns>
+bool OptimisticMessages::ReadControl(Packet& payload, ControlMessage& message, const u_long newest_received_frame)
+{
+	Format format;
+	return PacketSerializer::ReadValue<Format>(payload, format) &&
+		PacketSerializer::ReadFrame(payload, message.frame, newest_received_frame) &&
+		ReadBody<ControlSchema>(payload, format, message);
+}
+
+
+/// <summary>
+/// Append the client's acknowledgment of the newest state it has received.
+/// </summary>
+/// <returns>If true, the message was successfully written.</returns>
+bool OptimisticMessages::WriteAck(MessageWriter& writer, const Format format, const AckMessage& message)
+{
+	return WriteSimple<AckSchema>(writer, MessageType::Ack, format, message);
+}
+
+
+bool OptimisticMessages::ReadAck(Packet& payload, AckMessage& message)
+{
+	return ReadSimple<AckSchema>(payload, message);
+}
+
+
+/// <summary>
+/// Append a new client attack.
+/// </summary>
+/// <returns>If true, the message was successfully written.</returns>
+bool OptimisticMessages::WriteAttack(MessageWriter& writer, const Format format, const AttackMessage& message)
+{
+	return WriteSimple<AttackSchema>(writer, MessageType::Attack, format, message);
+}
+
+
+bool OptimisticMessages::ReadAttack(Packet& payload, AttackMessage& message)
+{
+	return ReadSimple<AttackSchema>(payload, message);
+}
+
+
+/// <summary>
+/// Append the host's state message: the format, the frame, and then the body.
+/// </summary>
+/// <remarks>
+/// The frame is written relative to acked_frame, the newest state frame the client reported receiving.
+/// In the Bits format, the player values are delta-compressed against the baseline, if one is provided.
+/// </remarks>
+/// <returns>If true, the message was successfully written.</returns>
+bool OptimisticMessages::WriteState(MessageWriter& writer, const Format format, const StateMessage& message, const StateMessage* baseline, const u_long acked_frame)
+{
+	// fall back to a full snapshot if the baseline is too old to reference
+	if ((baseline != nullptr) && (message.frame - baseline->frame > kMaxBaselineAge))
+	{
+		baseline = nullptr;
+	}
+
+	return writer.Write(static_cast<MessageTypeId>(MessageType::State), [&](Packet& payload)
+	{
+		if (!PacketSerializer::WriteValue<Format>(payload, format) ||
+			!PacketSerializer::WriteFrame(payload, message.frame, acked_frame))
+		{
+			return false;
+		}
+		return (format == Format::Bits) ? WriteStateBits(payload, message, baseline) : StateSchema::Write(payload, message);
+	});
+}
+
+
+/// <summary>
+/// Read the host's state message out of its payload, in whichever format it was written.
+/// </summary>
+/// <remarks>
+/// The frame is rebuilt relative to the newest state frame received.
+/// Delta-compressed messages are rebuilt from the matching frame in baselines.
+/// </remarks>
+/// <returns>
+/// If true, the message was successfully read.  If false, message.baseline_frame is the frame the message was
+/// compressed against, which was not in baselines, or 0 if the message itself could not be read.
+/// </returns>
+bool OptimisticMessages::ReadState(Packet& payload, StateMessage& message, const u_long newest_received_frame, const StateHistory& baselines)
+{
+	Format format;
+	if (!PacketSerializer::ReadValue<Format>(payload, format) ||
+		!PacketSerializer::ReadFrame(payload, message.frame, newest_received_frame))
+	{
+		return false;
+	}
+	if (format == Format::Bits)
+	{
+		return ReadStateBits(payload, message, baselines);
+	}
+	message.baseline_frame = 0;
+	return StateSchema::Read(payload, message);
+}
+
+
+/// <summary>
+/// Append an attack the host has resolved, for the client to display.
+/// </summary>
+/// <returns>If true, the message was successfully written.</returns>
+bool OptimisticMessages::WriteConfirmedAttack(MessageWriter& writer, const Format format, const ConfirmedAttackMessage& message)
+{
+	return WriteSimple<ConfirmedAttackSchema>(writer, MessageType::ConfirmedAttack, format, message);
+}
+
+
+bool OptimisticMessages::ReadConfirmedAttack(Packet& payload, ConfirmedAttackMessage& message)
+{
+	return ReadSimple<ConfirmedAttackSchema>(payload, message);
+}
+
+
+/// <summary>
+/// Log the reconstruction error of each quantized field, and the bytes it saves in each state message.
+/// </summary>
+/// <remarks>The fields never change, so this only logs once, however many sessions are hosted, on however many threads.</remarks>
+void OptimisticMessages::ReportQuantization()
+{
+	static std::atomic<bool> is_reported(false);
+	if (is_reported.exchange(true))
+	{
+		return;
+	}
+
+	for (const auto& field : { kPositionX, kPositionY, kVelocity })
+	{
+		std::cout << "Quantized " << field.name << ": [" << field.min << ", " << field.max << "] in " << field.bits
+			<< " bits, max error " << PacketSerializer::GetQuantizationError(field.min, field.max, field.bits) << std::endl;
+	}
+
+	const auto raw_size = static_cast<unsigned int>(8 * sizeof(float));
+	const auto byte_size = StateSchema::kMaxBytes;
+	const auto bit_size = (StateSchema::kMaxBits + 7) / 8;
+	std::cout << "Quantized player state: " << raw_size << " bytes as floats, " << byte_size << " bytes in Bytes format (saves "
+		<< raw_size - byte_size << "), " << bit_size << " bytes in Bits format (saves " << raw_size - bit_size << ")" << std::endl;
+}
\ No newline at end of file
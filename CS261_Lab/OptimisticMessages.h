@@ -0,0 +1,116 @@
+//---------------------------------------------------------
+// file:	OptimisticMessages.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	The messages exchanged by the optimistic host and client, in either packet format.
+//
+// remarks: Each message starts with the format it was written in, so the host and client may each pick their own.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include "Packet.h"
+#include "PacketSerializer.h"
+#include "MessageWriter.h"
+#include "MessageDispatcher.h"
+#include "SyncRatio.h"
+#include "RingBuffer.h"
+
+
+namespace OptimisticMessages
+{
+	/// <summary>
+	/// The types of message the optimistic host and client coalesce into each datagram.
+	/// </summary>
+	enum class MessageType : MessageTypeId
+	{
+		Control = 0, // client -> host, every send
+		Ack = 1, // client -> host, every send
+		Attack = 2, // client -> host, once per attack
+		State = 3, // host -> client, every send
+		ConfirmedAttack = 4, // host -> client, once per attack the host has resolved
+	};
+
+	/// <summary>
+	/// Sent from the client to the host: the client's control state.
+	/// </summary>
+	struct ControlMessage
+	{
+		u_long frame = 0;
+		bool is_paused = false;
+	};
+
+	/// <summary>
+	/// Sent from the client to the host: the newest state frame the client has received, or 0 if none yet.
+	/// </summary>
+	struct AckMessage
+	{
+		u_long acked_frame = 0;
+	};
+
+	/// <summary>
+	/// Sent from the client to the host: a new attack, and the frames the client was seeing when it attacked.
+	/// </summary>
+	struct AttackMessage
+	{
+		float attack_x = 0.0f, attack_y = 0.0f;
+		SyncRatio attack_sync{};
+	};
+
+	/// <summary>
+	/// Sent from the host to the client: the authoritative state of both players.
+	/// </summary>
+	/// <remarks>CONVENTION: host values come before non-host values.</remarks>
+	struct StateMessage
+	{
+		u_long frame = 0;
+		u_long baseline_frame = 0; // the frame the player values were delta-compressed against, or 0 if none
+		float host_x = 0.0f, host_y = 0.0f;
+		float host_velocity_x = 0.0f, host_velocity_y = 0.0f;
+		float non_host_x = 0.0f, non_host_y = 0.0f;
+		float non_host_velocity_x = 0.0f, non_host_velocity_y = 0.0f;
+	};
+
+	/// <summary>
+	/// Sent from the host to the client: a client attack, and where the host decided its target was.
+	/// </summary>
+	struct ConfirmedAttackMessage
+	{
+		float client_attack_x = 0.0f, client_attack_y = 0.0f;
+		float target_x = 0.0f, target_y = 0.0f;
+	};
+
+	// players never leave the 1024x768 window
+	inline constexpr PacketSerializer::QuantizedField kPositionX{ "Position X", 0.0f, 1024.0f, 14 };
+	inline constexpr PacketSerializer::QuantizedField kPositionY{ "Position Y", 0.0f, 768.0f, 14 };
+	// DoubleOrbitControl never exceeds 2 * pi * radius / duration (~419 for the fastest orbit)
+	inline constexpr PacketSerializer::QuantizedField kVelocity{ "Velocity", -512.0f, 512.0f, 14 };
+
+	// baselines older than this many frames are not used
+	const u_long kMaxBaselineAge = 255;
+
+	// the states kept as delta-compression baselines: by the host, those it sent, and by the client, those it received
+	const unsigned int kStateHistorySize = 100;
+	using StateHistory = RingBuffer<StateMessage, kStateHistorySize>;
+
+	void ReportQuantization();
+
+	void Register(MessageDispatcher& dispatcher, MessageType type, MessageDispatcher::Handler handler);
+
+	bool WriteControl(MessageWriter& writer, PacketSerializer::Format format, const ControlMessage& message);
+	bool ReadControl(Packet& payload, ControlMessage& message, u_long newest_received_frame);
+
+	bool WriteAck(MessageWriter& writer, PacketSerializer::Format format, const AckMessage& message);
+	bool ReadAck(Packet& payload, AckMessage& message);
+
+	bool WriteAttack(MessageWriter& writer, PacketSerializer::Format format, const AttackMessage& message);
+	bool ReadAttack(Packet& payload, AttackMessage& message);
+
+	bool WriteState(MessageWriter& writer, PacketSerializer::Format format, const StateMessage& message, const StateMessage* baseline, u_long acked_frame);
+	bool ReadState(Packet& payload, StateMessage& message, u_long newest_received_frame, const StateHistory& baselines);
+
+	bool WriteConfirmedAttack(MessageWriter& writer, PacketSerializer::Format format, const ConfirmedAttackMessage& message);
+	bool ReadConfirmedAttack(Packet& payload, ConfirmedAttackMessage& message);
+};
@@ -11,34 +11,14 @@
 #include "Packet.h"
 
 
-Packet::Packet(unsigned int buffer_size)
-	: buffer_size_(buffer_size),
-	remaining_space_(buffer_size),
-	owns_buffer_(true)
-{
-	target_ = buffer_ = new char[buffer_size_];
-}
-
-
 Packet::Packet(char* buffer, unsigned int buffer_size)
 	: buffer_(buffer),
 	buffer_size_(buffer_size),
-	owns_buffer_(false),
 	remaining_space_(buffer_size),
 	target_(buffer)
 { }
 
 
-Packet::~Packet()
-{
-	if (owns_buffer_)
-	{
-		delete[] buffer_;
-		buffer_ = nullptr;
-	}
-}
-
-
 bool Packet::Advance(unsigned int bytes_advanced)
 {
 	if (bytes_advanced > remaining_space_)
@@ -10,29 +10,52 @@
 #pragma once
 
 
+// the largest datagram we send or receive, which with its IP and UDP headers stays under the 1280-byte minimum
+// IPv6 MTU, so it is never fragmented on the path; larger messages are split up by FragmentChannel instead
+const unsigned int kMaxDatagramSize = 1024;
+
+
 /// <summary>
 /// Encapsulates buffer logic for reading or writing multiple items out of a single buffer.
 /// </summary>
+/// <remarks>A packet never owns its buffer; use FixedPacket for a packet with its own storage.</remarks>
 class Packet
 {
 public:
-	Packet(unsigned int buffer_size);
 	Packet(char* buffer, unsigned int buffer_size);
-	~Packet();
 
-	unsigned int GetUsedSpace() inline const { return (buffer_size_ > remaining_space_) ? buffer_size_ - remaining_space_ : 0; }
-	unsigned int GetRemainingSpace() inline const { return remaining_space_; }
-	char* GetTarget() inline const { return target_; }
-	char* GetRoot() inline const { return buffer_; }
+	unsigned int GetUsedSpace() const { return (buffer_size_ > remaining_space_) ? buffer_size_ - remaining_space_ : 0; }
+	unsigned int GetRemainingSpace() const { return remaining_space_; }
+	char* GetTarget() const { return target_; }
+	char* GetRoot() const { return buffer_; }
 
 	bool Advance(unsigned int bytes_advanced);
+	void AdvanceUnchecked(unsigned int bytes_advanced) { remaining_space_ -= bytes_advanced; target_ += bytes_advanced; }
 	void Reset();
 
 private:
 	char* buffer_;
 	unsigned int buffer_size_;
-	bool owns_buffer_;
 
 	unsigned int remaining_space_;
 	char* target_;
+};
+
+
+/// <summary>
+/// A packet with its own fixed-size storage, held inline, so it never touches the heap.
+/// </summary>
+template <unsigned int N>
+class FixedPacket : public Packet
+{
+public:
+	static const unsigned int kCapacity = N;
+
+	// only the address of storage_ is used here, so it may be passed before it is constructed
+	FixedPacket() : Packet(storage_, N) { }
+	FixedPacket(const FixedPacket&) = delete;
+	FixedPacket& operator=(const FixedPacket&) = delete;
+
+private:
+	char storage_[N];
 };
\ No newline at end of file
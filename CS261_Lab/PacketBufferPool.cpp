@@ -0,0 +1,123 @@
+//---------------------------------------------------------
+// file:	PacketBufferPool.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A fixed set of datagram-sized buffers, handed out as reference-counted PacketBuffers.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "PacketBufferPool.h"
+
+
+PacketBufferPool::PacketBufferPool(const unsigned int buffer_count)
+	: entries_(new Entry[buffer_count]),
+	buffer_count_(buffer_count)
+{
+	free_entries_.reserve(buffer_count_);
+	for (unsigned int i = 0; i < buffer_count_; ++i)
+	{
+		entries_[i].pool = this;
+		entries_[i].ref_count.store(0, std::memory_order_relaxed);
+		entries_[i].size = 0;
+		free_entries_.push_back(&entries_[i]);
+	}
+}
+
+
+PacketBufferPool::~PacketBufferPool()
+{
+	const auto free_count = GetFreeCount();
+	if (free_count != buffer_count_)
+	{
+		std::cerr << "PacketBufferPool destroyed with " << (buffer_count_ - free_count) << " buffers still in use" << std::endl;
+	}
+}
+
+
+/// <summary>
+/// Take a buffer from the pool, with a size of zero.
+/// </summary>
+/// <returns>The buffer, or an invalid PacketBuffer if every buffer is in use.</returns>
+PacketBuffer PacketBufferPool::Acquire()
+{
+	Entry* entry;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (free_entries_.empty())
+		{
+			return PacketBuffer();
+		}
+		entry = free_entries_.back();
+		free_entries_.pop_back();
+	}
+
+	entry->ref_count.store(1, std::memory_order_relaxed);
+	entry->size = 0;
+	return PacketBuffer(entry);
+}
+
+
+unsigned int PacketBufferPool::GetFreeCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return static_cast<unsigned int>(free_entries_.size());
+}
+
+
+void PacketBufferPool::Release(Entry* entry)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	// never reallocates, as the list was reserved to hold every entry
+	free_entries_.push_back(entry);
+}
+
+
+PacketBuffer::PacketBuffer(const PacketBuffer& other)
+	: entry_(other.entry_)
+{
+	if (entry_ != nullptr)
+	{
+		entry_->ref_count.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+PacketBuffer::PacketBuffer(PacketBuffer&& other) noexcept
+	: entry_(other.entry_)
+{
+	other.entry_ = nullptr;
+}
+
+
+PacketBuffer& PacketBuffer::operator=(PacketBuffer other) noexcept
+{
+	std::swap(entry_, other.entry_);
+	return *this;
+}
+
+
+PacketBuffer::~PacketBuffer()
+{
+	Reset();
+}
+
+
+/// <summary>
+/// Let go of the buffer, returning it to its pool if this was the last reference to it.
+/// </summary>
+void PacketBuffer::Reset()
+{
+	if (entry_ == nullptr)
+	{
+		return;
+	}
+
+	// acq_rel, so that every other holder's writes are visible before the buffer is reused
+	if (entry_->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		entry_->pool->Release(entry_);
+	}
+	entry_ = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+//---------------------------------------------------------
+// file:	PacketBufferPool.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A fixed set of datagram-sized buffers, handed out as reference-counted PacketBuffers.
+//
+// remarks: All buffers are allocated when the pool is created, so queueing a send or holding on to a received datagram
+//          never touches the heap.  Buffers may be acquired and released from any thread.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Packet.h"
+
+
+class PacketBuffer;
+
+
+/// <summary>
+/// A fixed set of datagram-sized buffers, handed out as reference-counted PacketBuffers.
+/// </summary>
+/// <remarks>The pool must outlive every PacketBuffer acquired from it.</remarks>
+class PacketBufferPool
+{
+public:
+	PacketBufferPool(unsigned int buffer_count);
+	~PacketBufferPool();
+
+	PacketBufferPool(const PacketBufferPool&) = delete;
+	PacketBufferPool& operator=(const PacketBufferPool&) = delete;
+
+	PacketBuffer Acquire();
+
+	unsigned int GetBufferCount() const { return buffer_count_; }
+	unsigned int GetFreeCount() const;
+
+private:
+	friend class PacketBuffer;
+
+	struct Entry
+	{
+		PacketBufferPool* pool;
+		std::atomic<unsigned int> ref_count;
+		unsigned int size;
+		char data[kMaxDatagramSize];
+	};
+
+	void Release(Entry* entry);
+
+	std::unique_ptr<Entry[]> entries_;
+	unsigned int buffer_count_;
+	std::vector<Entry*> free_entries_;
+	mutable std::mutex mutex_;
+};
+
+
+/// <summary>
+/// A reference-counted handle to one buffer from a PacketBufferPool.
+/// </summary>
+/// <remarks>Copies share the same buffer, which returns to its pool when the last copy is destroyed or reset.</remarks>
+class PacketBuffer
+{
+public:
+	static const unsigned int kCapacity = kMaxDatagramSize;
+
+	PacketBuffer() : entry_(nullptr) { }
+	PacketBuffer(const PacketBuffer& other);
+	PacketBuffer(PacketBuffer&& other) noexcept;
+	PacketBuffer& operator=(PacketBuffer other) noexcept;
+	~PacketBuffer();
+
+	bool IsValid() const { return entry_ != nullptr; }
+	char* GetData() const { return entry_->data; }
+	unsigned int GetSize() const { return entry_->size; }
+	void SetSize(const unsigned int size) { entry_->size = size; }
+
+	void Reset();
+
+private:
+	friend class PacketBufferPool;
+
+	explicit PacketBuffer(PacketBufferPool::Entry* entry) : entry_(entry) { }
+
+	PacketBufferPool::Entry* entry_;
+};
\ No newline at end of file
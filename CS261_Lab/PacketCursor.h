@@ -0,0 +1,133 @@
+//---------------------------------------------------------
+// file:	PacketCursor.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Reads or writes a run of values in a packet, checking the packet's space only once for the whole run.
+//
+// remarks: PacketSerializer::ReadValue/WriteValue check and advance the packet for every value.
+//          A cursor reserves (or validates) the space for a whole message up front, copies each value in its
+//          wire type and byte order (see PacketSerializer::StoreWire), and then commits the bytes it used.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include "Packet.h"
+#include "PacketSerializer.h"
+
+
+/// <summary>
+/// Writes values into space reserved once in a packet, with no per-value checks.
+/// </summary>
+/// <remarks>Writing more than the reserved size is a programming error, not a runtime condition.</remarks>
+class PacketWriteCursor
+{
+public:
+	PacketWriteCursor(Packet& packet, const unsigned int reserved_size)
+		: packet_(packet),
+		start_(packet.GetTarget()),
+		target_(packet.GetTarget()),
+		reserved_size_(reserved_size),
+		is_valid_(packet.GetRemainingSpace() >= reserved_size)
+	{ }
+
+	/// <summary>
+	/// If false, the packet did not have room for the reservation, and nothing may be written.
+	/// </summary>
+	bool IsValid() const { return is_valid_; }
+
+	template <typename T>
+	void Write(const T value)
+	{
+		PacketSerializer::StoreWire<T>(target_, value);
+		target_ += PacketSerializer::kWireSize<T>;
+	}
+
+	void WriteBytes(const char* source, const unsigned int size)
+	{
+		memcpy(target_, source, size);
+		target_ += size;
+	}
+
+	unsigned int GetBytesWritten() const { return static_cast<unsigned int>(target_ - start_); }
+
+	/// <summary>
+	/// Advance the packet past the bytes that were written.
+	/// </summary>
+	/// <returns>If true, the reservation was valid and the written bytes are now part of the packet.</returns>
+	bool Commit()
+	{
+		if (!is_valid_ || (GetBytesWritten() > reserved_size_))
+		{
+			return false;
+		}
+		packet_.AdvanceUnchecked(GetBytesWritten());
+		return true;
+	}
+
+private:
+	Packet& packet_;
+	char* start_;
+	char* target_;
+	unsigned int reserved_size_;
+	bool is_valid_;
+};
+
+
+/// <summary>
+/// Reads values out of a packet whose length was validated once, with no per-value checks.
+/// </summary>
+/// <remarks>Variable-length sections are validated once each, with Require, before they are read.</remarks>
+class PacketReadCursor
+{
+public:
+	PacketReadCursor(Packet& packet, const unsigned int required_size)
+		: packet_(packet),
+		start_(packet.GetTarget()),
+		target_(packet.GetTarget()),
+		end_(packet.GetTarget() + packet.GetRemainingSpace()),
+		is_valid_(packet.GetRemainingSpace() >= required_size)
+	{ }
+
+	/// <summary>
+	/// If false, the packet is too short for the required size, and nothing may be read.
+	/// </summary>
+	bool IsValid() const { return is_valid_; }
+
+	/// <summary>
+	/// Check that the next section of the message is fully present in the packet.
+	/// </summary>
+	/// <returns>If true, size more bytes may be read.</returns>
+	bool Require(const unsigned int size) const { return is_valid_ && (static_cast<unsigned int>(end_ - target_) >= size); }
+
+	template <typename T>
+	void Read(T& value)
+	{
+		PacketSerializer::LoadWire<T>(target_, value);
+		target_ += PacketSerializer::kWireSize<T>;
+	}
+
+	void ReadBytes(char* destination, const unsigned int size)
+	{
+		memcpy(destination, target_, size);
+		target_ += size;
+	}
+
+	unsigned int GetBytesRead() const { return static_cast<unsigned int>(target_ - start_); }
+
+	/// <summary>
+	/// Advance the packet past the bytes that were read.
+	/// </summary>
+	void Commit()
+	{
+		packet_.AdvanceUnchecked(GetBytesRead());
+	}
+
+private:
+	Packet& packet_;
+	const char* start_;
+	const char* target_;
+	const char* end_;
+	bool is_valid_;
+};
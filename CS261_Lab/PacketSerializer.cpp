@@ -5,49 +5,176 @@
 //
 // brief:	Provides support for reading and writing a few specific value types into a packet.
 //
-// remarks: This could be optimized in a variety of ways, including bit-packing, etc.
+// remarks: Bit-packing is provided separately, by BitWriter and BitReader.
 //
 // Copyright  2021 DigiPen, All rights reserved.
 //---------------------------------------------------------
 #include "pch.h"
 #include "PacketSerializer.h"
 
+// a LEB128 varint carries 7 bits in each byte, with the high bit set on every byte but the last
+const unsigned int kVarIntBitsPerByte = 7;
+const unsigned int kMaxVarIntBytes = 5;
+
+
+namespace
+{
+	unsigned int GetVarUIntSize(uint32_t value)
+	{
+		auto byte_count = 1u;
+		while (value >= (1u << kVarIntBitsPerByte))
+		{
+			value >>= kVarIntBitsPerByte;
+			++byte_count;
+		}
+		return byte_count;
+	}
+
+
+	/// <summary>
+	/// Write the value as a varint of exactly byte_count bytes, padding with zero groups if needed.
+	/// </summary>
+	bool WriteVarUIntBytes(Packet& packet, uint32_t value, const unsigned int byte_count)
+	{
+		if (packet.GetRemainingSpace() < byte_count)
+		{
+			return false;
+		}
+
+		auto* target = reinterpret_cast<uint8_t*>(packet.GetTarget());
+		for (auto i = 0u; i < byte_count; ++i)
+		{
+			const auto is_last = (i + 1 == byte_count);
+			target[i] = static_cast<uint8_t>((value & 0x7F) | (is_last ? 0x00 : 0x80));
+			value >>= kVarIntBitsPerByte;
+		}
+		packet.AdvanceUnchecked(byte_count);
+
+		return true;
+	}
+
+
+	/// <summary>
+	/// Read a varint, reporting how many bytes it used (which may include padding).
+	/// </summary>
+	bool ReadVarUIntBytes(Packet& packet, uint32_t& value, unsigned int& byte_count)
+	{
+		const auto* source = reinterpret_cast<const uint8_t*>(packet.GetTarget());
+		const auto available = packet.GetRemainingSpace();
+
+		value = 0;
+		for (byte_count = 0; byte_count < kMaxVarIntBytes; ++byte_count)
+		{
+			if (byte_count >= available)
+			{
+				return false;
+			}
+
+			const auto group = source[byte_count];
+			// the fifth byte may only carry the top 4 bits of a 32-bit value
+			if ((byte_count == kMaxVarIntBytes - 1) && (group > 0x0F))
+			{
+				return false;
+			}
+			value |= static_cast<uint32_t>(group & 0x7F) << (kVarIntBitsPerByte * byte_count);
+
+			if ((group & 0x80) == 0)
+			{
+				++byte_count;
+				packet.AdvanceUnchecked(byte_count);
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
 
 /// <summary>
-/// Read a string from the provided packet
+/// Read a run of bytes from the provided packet, without copying them.
 /// </summary>
+/// <remarks>The bytes point into the packet's buffer, and are only valid for as long as that buffer is.</remarks>
 /// <returns>If true, the data was successfully read out of the packet.</returns>
-bool PacketSerializer::ReadString(Packet& packet, std::string& text)
+bool PacketSerializer::ReadBytes(Packet& packet, const char*& bytes, const uint32_t size)
 {
-	auto text_size_size = sizeof(uint32_t);
+	// are the bytes beyond the end of the safe read zone?
+	if (packet.GetRemainingSpace() < size)
+	{
+		return false;
+	}
+
+	bytes = packet.GetTarget();
+	packet.AdvanceUnchecked(size);
 
-	// is the string *size* beyond the end of the safe read zone?
-	if (packet.GetRemainingSpace() < text_size_size)
+	return true;
+}
+
+
+/// <summary>
+/// Write a run of bytes into the provided packet.
+/// </summary>
+/// <returns>If true, the data was successfully written into the packet.</returns>
+bool PacketSerializer::WriteBytes(Packet& packet, const char* bytes, const uint32_t size)
+{
+	// are the bytes beyond the end of the safe writing zone?
+	if (packet.GetRemainingSpace() < size)
 	{
 		return false;
 	}
 
-	// read the string size
-	const auto* size_reader = reinterpret_cast<const uint32_t*>(packet.GetTarget());
-	const auto text_size = *size_reader;
+	memcpy(packet.GetTarget(), bytes, size);
+	packet.AdvanceUnchecked(size);
+
+	return true;
+}
+
 
-	// is the string beyond the end of the safe read zone?
-	const auto string_size = text_size * sizeof(char);
-	if (packet.GetRemainingSpace() < string_size)
+/// <summary>
+/// Read a string from the provided packet, without copying it.
+/// </summary>
+/// <remarks>The text points into the packet's buffer, and is only valid for as long as that buffer is.</remarks>
+/// <returns>If true, the data was successfully read out of the packet.</returns>
+bool PacketSerializer::ReadStringView(Packet& packet, std::string_view& text)
+{
+	// read the string size, which is only consumed if the whole string is present
+	Packet size_reader(packet.GetTarget(), packet.GetRemainingSpace());
+	uint32_t text_size;
+	if (!ReadVarUInt(size_reader, text_size))
+	{
+		return false;
+	}
+
+	// is the string beyond the end of the safe read zone (after the size value itself)?
+	if (size_reader.GetRemainingSpace() < text_size)
 	{
 		return false;
 	}
 
 	// advance the packet, now that we know we are really reading a valid string...
-	packet.Advance(text_size_size);
+	packet.AdvanceUnchecked(size_reader.GetUsedSpace());
 
-	// read in the text parameter
-	const auto* read_text = reinterpret_cast<const char*>(packet.GetTarget());
-	text = std::string(read_text, text_size);
+	// the text is left in place in the packet
+	text = std::string_view(packet.GetTarget(), text_size);
+	packet.AdvanceUnchecked(text_size);
+
+	return true;
+}
 
-	// advance the packet
-	packet.Advance(string_size);
 
+/// <summary>
+/// Read a string from the provided packet
+/// </summary>
+/// <returns>If true, the data was successfully read out of the packet.</returns>
+bool PacketSerializer::ReadString(Packet& packet, std::string& text)
+{
+	std::string_view text_view;
+	if (!ReadStringView(packet, text_view))
+	{
+		return false;
+	}
+
+	text.assign(text_view.data(), text_view.size());
 	return true;
 }
 
@@ -56,35 +183,240 @@ bool PacketSerializer::ReadString(Packet& packet, std::string& text)
 /// Write a string int the provided packet
 /// </summary>
 /// <returns>If true, the data was successfully written into the packet.</returns>
-bool PacketSerializer::WriteString(Packet& packet, const std::string& text)
+bool PacketSerializer::WriteString(Packet& packet, const std::string_view text)
 {
-	const auto text_size_size = sizeof(uint32_t);
-	const auto text_size = sizeof(char) * static_cast<uint32_t>(text.size());
-	const auto write_size = text_size_size + text_size;
+	const auto text_size = static_cast<uint32_t>(text.size());
+	const auto text_size_size = GetVarUIntSize(text_size);
 
 	// is the string size beyond the end of the safe writing zone (including the size value itself)?
-	if (packet.GetRemainingSpace() < write_size)
+	if ((packet.GetRemainingSpace() < text_size_size) || (packet.GetRemainingSpace() - text_size_size < text_size))
+	{
+		return false;
+	}
+
+	// write the string length, then the string itself
+	WriteVarUIntBytes(packet, text_size, text_size_size);
+	memcpy(packet.GetTarget(), text.data(), text_size);
+	packet.AdvanceUnchecked(text_size);
+
+	return true;
+}
+
+
+/// <summary>
+/// Read an unsigned varint from the provided packet.
+/// </summary>
+/// <returns>If true, the data was successfully read out of the packet.</returns>
+bool PacketSerializer::ReadVarUInt(Packet& packet, uint32_t& value)
+{
+	unsigned int byte_count;
+	return ReadVarUIntBytes(packet, value, byte_count);
+}
+
+
+/// <summary>
+/// Write an unsigned value into the provided packet as a varint, using 1 byte for values below 128, up to 5 bytes.
+/// </summary>
+/// <returns>If true, the data was successfully written into the packet.</returns>
+bool PacketSerializer::WriteVarUInt(Packet& packet, const uint32_t value)
+{
+	return WriteVarUIntBytes(packet, value, GetVarUIntSize(value));
+}
+
+
+/// <summary>
+/// Read a zig-zag encoded signed varint from the provided packet.
+/// </summary>
+/// <returns>If true, the data was successfully read out of the packet.</returns>
+bool PacketSerializer::ReadVarInt(Packet& packet, int32_t& value)
+{
+	uint32_t encoded;
+	if (!ReadVarUInt(packet, encoded))
 	{
 		return false;
 	}
+	value = ZigZagDecode(encoded);
+	return true;
+}
+
+
+/// <summary>
+/// Write a signed value into the provided packet as a zig-zag encoded varint, using 1 byte for values in [-64, 63].
+/// </summary>
+/// <returns>If true, the data was successfully written into the packet.</returns>
+bool PacketSerializer::WriteVarInt(Packet& packet, const int32_t value)
+{
+	return WriteVarUInt(packet, ZigZagEncode(value));
+}
 
-	// write the string length
-	auto* size_writer = reinterpret_cast<uint32_t*>(packet.GetTarget());
-	*size_writer = text_size;
-	
-	// advance the packet
-	packet.Advance(text_size_size);
 
-	// write the string itself
-	auto* text_writer = reinterpret_cast<char*>(packet.GetTarget());
-	for (const auto element : text)
+/// <summary>
+/// Read a frame number written by WriteFrame, rebuilding it from the newest frame received from the same sender.
+/// </summary>
+/// <remarks>The frame is taken to be the candidate nearest to the frame after newest_received_frame, so the counter may wrap.</remarks>
+/// <returns>If true, the data was successfully read out of the packet.</returns>
+bool PacketSerializer::ReadFrame(Packet& packet, u_long& frame, const u_long newest_received_frame)
+{
+	uint32_t truncated;
+	unsigned int byte_count;
+	if (!ReadVarUIntBytes(packet, truncated, byte_count))
 	{
-		*text_writer = element;
-		++text_writer;
+		return false;
 	}
 
-	// advance the packet
-	packet.Advance(text_size);
+	// a full-width varint carries the whole frame number
+	if (byte_count == kMaxVarIntBytes)
+	{
+		frame = truncated;
+		return true;
+	}
+
+	const auto window = 1u << (kVarIntBitsPerByte * byte_count);
+	const auto half_window = static_cast<int32_t>(window / 2);
+	const auto expected = static_cast<uint32_t>(newest_received_frame) + 1;
+	auto candidate = (expected & ~(window - 1)) | truncated;
+	const auto distance = static_cast<int32_t>(candidate - expected);
+	if (distance <= -half_window)
+	{
+		candidate += window;
+	}
+	else if (distance > half_window)
+	{
+		candidate -= window;
+	}
+	frame = candidate;
 
 	return true;
+}
+
+
+/// <summary>
+/// Write only as many low bits of the frame number as the receiver needs to rebuild it.
+/// </summary>
+/// <remarks>acked_frame must be a frame the receiver is known to have received (or 0, which it starts with).</remarks>
+/// <returns>If true, the data was successfully written into the packet.</returns>
+bool PacketSerializer::WriteFrame(Packet& packet, const u_long frame, const u_long acked_frame)
+{
+	// the receiver rebuilds the frame from its newest frame, so the window must cover twice the distance from the ack
+	const auto distance = static_cast<uint32_t>(frame) - static_cast<uint32_t>(acked_frame);
+	auto byte_count = 1u;
+	while ((byte_count < kMaxVarIntBytes) && (distance >= (1u << (kVarIntBitsPerByte * byte_count - 1))))
+	{
+		++byte_count;
+	}
+
+	const auto mask = (byte_count < kMaxVarIntBytes) ? (1u << (kVarIntBitsPerByte * byte_count)) - 1 : 0xFFFFFFFFu;
+	return WriteVarUIntBytes(packet, static_cast<uint32_t>(frame) & mask, byte_count);
+}
+
+
+/// <summary>
+/// Write the frame number for a receiver that does not acknowledge frames.
+/// </summary>
+/// <remarks>The receiver rebuilds it correctly as long as it has not lost half of the kUnackedFrameBytes window in a row.</remarks>
+/// <returns>If true, the data was successfully written into the packet.</returns>
+bool PacketSerializer::WriteFrame(Packet& packet, const u_long frame)
+{
+	return WriteVarUIntBytes(packet, static_cast<uint32_t>(frame) & ((1u << (kVarIntBitsPerByte * kUnackedFrameBytes)) - 1), kUnackedFrameBytes);
+}
+
+
+/// <summary>
+/// Map a value within [min, max] onto an integer of the given number of bits.
+/// </summary>
+/// <remarks>Values outside of the range are clamped to it.</remarks>
+uint32_t PacketSerializer::Quantize(const float value, const float min, const float max, const unsigned int bits)
+{
+	const auto max_quantized = GetMaxQuantized(bits);
+	const auto clamped = std::max(min, std::min(max, value));
+	const auto normalized = (clamped - min) / (max - min);
+	return static_cast<uint32_t>(static_cast<double>(normalized) * max_quantized + 0.5);
+}
+
+
+/// <summary>
+/// Map an integer produced by Quantize back onto the [min, max] range.
+/// </summary>
+float PacketSerializer::Dequantize(const uint32_t quantized, const float min, const float max, const unsigned int bits)
+{
+	const auto max_quantized = GetMaxQuantized(bits);
+	const auto normalized = static_cast<double>(quantized) / max_quantized;
+	return min + static_cast<float>(normalized * (max - min));
+}
+
+
+/// <summary>
+/// The largest difference between a value within [min, max] and its quantized reconstruction.
+/// </summary>
+float PacketSerializer::GetQuantizationError(const float min, const float max, const unsigned int bits)
+{
+	const auto max_quantized = GetMaxQuantized(bits);
+	return (max - min) / static_cast<float>(max_quantized) / 2.0f;
+}
+
+
+/// <summary>
+/// Read a quantized value from the provided packet
+/// </summary>
+/// <remarks>A byte, short, or int is read whole, so a value past the field's bits is rejected, rather than leave [min, max].</remarks>
+/// <returns>If true, the data was successfully read out of the packet, and was within the field's bits.</returns>
+bool PacketSerializer::ReadQuantized(Packet& packet, float& value, const float min, const float max, const unsigned int bits)
+{
+	uint32_t quantized;
+	switch (GetQuantizedSize(bits))
+	{
+	case sizeof(uint8_t):
+	{
+		uint8_t small_value;
+		if (!ReadValue<uint8_t>(packet, small_value))
+		{
+			return false;
+		}
+		quantized = small_value;
+		break;
+	}
+	case sizeof(uint16_t):
+	{
+		uint16_t medium_value;
+		if (!ReadValue<uint16_t>(packet, medium_value))
+		{
+			return false;
+		}
+		quantized = medium_value;
+		break;
+	}
+	default:
+		if (!ReadValue<uint32_t>(packet, quantized))
+		{
+			return false;
+		}
+		break;
+	}
+
+	if (quantized > GetMaxQuantized(bits))
+	{
+		return false;
+	}
+	value = Dequantize(quantized, min, max, bits);
+	return true;
+}
+
+
+/// <summary>
+/// Write a value into the provided packet, quantized to the given number of bits within [min, max].
+/// </summary>
+/// <remarks>The value is written in the smallest whole number of bytes that holds those bits.  Use BitWriter to avoid the padding.</remarks>
+/// <returns>If true, the data was successfully written into the packet.</returns>
+bool PacketSerializer::WriteQuantized(Packet& packet, const float value, const float min, const float max, const unsigned int bits)
+{
+	const auto quantized = Quantize(value, min, max, bits);
+	switch (GetQuantizedSize(bits))
+	{
+	case sizeof(uint8_t):
+		return WriteValue<uint8_t>(packet, static_cast<uint8_t>(quantized));
+	case sizeof(uint16_t):
+		return WriteValue<uint16_t>(packet, static_cast<uint16_t>(quantized));
+	default:
+		return WriteValue<uint32_t>(packet, quantized);
+	}
 }
\ No newline at end of file
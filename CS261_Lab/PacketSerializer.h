@@ -5,19 +5,217 @@
 //
 // brief:	Provides support for reading and writing a few specific value types into a packet.
 //
-// remarks: This could be optimized in a variety of ways, including bit-packing, etc.
+// remarks: Values are copied (never dereferenced in place), so they may sit at any alignment in the packet,
+//          and are always little-endian on the wire, whatever the host's byte order.
+//          Bit-packing is provided separately, by BitWriter and BitReader.
 //
 // Copyright  2021 DigiPen, All rights reserved.
 //---------------------------------------------------------
 #pragma once
 #include "pch.h"
+#include <string_view>
+#include <type_traits>
 #include "Packet.h"
 
 
 namespace PacketSerializer
 {
+	/// <summary>
+	/// The encoding used for the body of a packet, written as its first byte.
+	/// </summary>
+	enum class Format : uint8_t
+	{
+		Bytes = 0, // every value is written whole, with ReadValue/WriteValue
+		Bits = 1, // values are packed with BitReader/BitWriter
+	};
+
+	/// <summary>
+	/// The range and precision used to put a float on the wire.
+	/// </summary>
+	struct QuantizedField
+	{
+		const char* name;
+		float min, max;
+		unsigned int bits;
+	};
+
+	bool ReadBytes(Packet& packet, const char*& bytes, uint32_t size);
+	bool WriteBytes(Packet& packet, const char* bytes, uint32_t size);
+
+	bool ReadStringView(Packet& packet, std::string_view& text);
 	bool ReadString(Packet& packet, std::string& text);
-	bool WriteString(Packet& packet, const std::string& text);
+	bool WriteString(Packet& packet, std::string_view text);
+
+	/// <summary>
+	/// Map a signed value onto an unsigned one, so that values near zero (of either sign) are small.
+	/// </summary>
+	constexpr uint32_t ZigZagEncode(const int32_t value)
+	{
+		return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+	}
+
+	constexpr int32_t ZigZagDecode(const uint32_t encoded)
+	{
+		return static_cast<int32_t>(encoded >> 1) ^ -static_cast<int32_t>(encoded & 1);
+	}
+
+	bool ReadVarUInt(Packet& packet, uint32_t& value);
+	bool WriteVarUInt(Packet& packet, uint32_t value);
+	bool ReadVarInt(Packet& packet, int32_t& value);
+	bool WriteVarInt(Packet& packet, int32_t value);
+
+	// frame numbers written without an ack are sent in this many bytes (14 bits), which survives 8191 lost frames in a row
+	const unsigned int kUnackedFrameBytes = 2;
+
+	/// <summary>
+	/// Is frame newer than than_frame, allowing for the frame counter wrapping around?
+	/// </summary>
+	constexpr bool IsFrameNewer(const u_long frame, const u_long than_frame)
+	{
+		return static_cast<int32_t>(static_cast<uint32_t>(frame) - static_cast<uint32_t>(than_frame)) > 0;
+	}
+
+	bool ReadFrame(Packet& packet, u_long& frame, u_long newest_received_frame);
+	bool WriteFrame(Packet& packet, u_long frame, u_long acked_frame);
+	bool WriteFrame(Packet& packet, u_long frame);
+
+	uint32_t Quantize(float value, float min, float max, unsigned int bits);
+	float Dequantize(uint32_t quantized, float min, float max, unsigned int bits);
+	float GetQuantizationError(float min, float max, unsigned int bits);
+
+	/// <summary>
+	/// The number of bytes WriteQuantized uses for a value of the given number of bits.
+	/// </summary>
+	constexpr unsigned int GetQuantizedSize(const unsigned int bits)
+	{
+		if (bits <= 8)
+		{
+			return sizeof(uint8_t);
+		}
+		return (bits <= 16) ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	/// <summary>
+	/// The largest value Quantize produces for the given number of bits, beyond which a read value is corrupt.
+	/// </summary>
+	constexpr uint32_t GetMaxQuantized(const unsigned int bits)
+	{
+		return (bits < 32) ? (1u << bits) - 1u : 0xFFFFFFFFu;
+	}
+
+	bool ReadQuantized(Packet& packet, float& value, float min, float max, unsigned int bits);
+	bool WriteQuantized(Packet& packet, float value, float min, float max, unsigned int bits);
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	const bool kIsBigEndianHost = true;
+#else
+	const bool kIsBigEndianHost = false;
+#endif
+
+	/// <summary>
+	/// The type a value is carried as on the wire, which is the same size on every platform.
+	/// </summary>
+	template <typename T, typename Enable = void>
+	struct WireType
+	{
+		using Type = T;
+	};
+
+	template <typename T>
+	struct WireType<T, std::enable_if_t<std::is_enum_v<T>>>
+	{
+		using Type = std::underlying_type_t<T>;
+	};
+
+	template <>
+	struct WireType<bool>
+	{
+		using Type = uint8_t;
+	};
+
+	template <>
+	struct WireType<float>
+	{
+		using Type = uint32_t;
+	};
+
+	// u_long is 4 bytes on Windows but 8 on Linux, and frame numbers are 32 bits everywhere
+	// -- a 64-bit wire value must be declared as unsigned long long, since uint64_t is unsigned long on Linux
+	template <>
+	struct WireType<unsigned long>
+	{
+		using Type = uint32_t;
+	};
+
+	template <>
+	struct WireType<long>
+	{
+		using Type = int32_t;
+	};
+
+	template <typename T>
+	constexpr unsigned int kWireSize = sizeof(typename WireType<T>::Type);
+
+	/// <summary>
+	/// Reverse the byte order of an unsigned integer.
+	/// </summary>
+	template <typename T>
+	constexpr T ByteSwap(T value)
+	{
+		T swapped = 0;
+		for (auto i = 0u; i < sizeof(T); ++i)
+		{
+			swapped = static_cast<T>((swapped << 8) | (value & 0xFF));
+			value = static_cast<T>(value >> 8);
+		}
+		return swapped;
+	}
+
+	/// <summary>
+	/// Copy a value to the target in its wire type and byte order, without checking for space.
+	/// </summary>
+	template <typename T>
+	void StoreWire(char* target, const T value)
+	{
+		using Wire = std::make_unsigned_t<typename WireType<T>::Type>;
+		Wire wire;
+		if constexpr (std::is_same_v<T, float>)
+		{
+			memcpy(&wire, &value, sizeof(wire));
+		}
+		else
+		{
+			wire = static_cast<Wire>(value);
+		}
+		if constexpr (kIsBigEndianHost && (sizeof(Wire) > 1))
+		{
+			wire = ByteSwap(wire);
+		}
+		memcpy(target, &wire, sizeof(wire));
+	}
+
+	/// <summary>
+	/// Copy a value from the source out of its wire type and byte order, without checking the length.
+	/// </summary>
+	template <typename T>
+	void LoadWire(const char* source, T& value)
+	{
+		using Wire = std::make_unsigned_t<typename WireType<T>::Type>;
+		Wire wire;
+		memcpy(&wire, source, sizeof(wire));
+		if constexpr (kIsBigEndianHost && (sizeof(Wire) > 1))
+		{
+			wire = ByteSwap(wire);
+		}
+		if constexpr (std::is_same_v<T, float>)
+		{
+			memcpy(&value, &wire, sizeof(value));
+		}
+		else
+		{
+			value = static_cast<T>(static_cast<typename WireType<T>::Type>(wire));
+		}
+	}
 
 	/// <summary>
 	/// Read a value from the provided packet
@@ -26,7 +224,7 @@ namespace PacketSerializer
 	template <typename T>
 	bool ReadValue(Packet& packet, T& value)
 	{
-		const auto read_size = sizeof(T);
+		const auto read_size = kWireSize<T>;
 
 		// is the value size beyond the end of the safe read zone?
 		if (packet.GetRemainingSpace() < read_size)
@@ -35,11 +233,10 @@ namespace PacketSerializer
 		}
 
 		// read the value
-		const auto* reader = reinterpret_cast<const T*>(packet.GetTarget());
-		value = *reader;
-		
-		// advance the packet
-		packet.Advance(read_size);
+		LoadWire<T>(packet.GetTarget(), value);
+
+		// advance the packet, which we already know has the space
+		packet.AdvanceUnchecked(read_size);
 
 		return true;
 	}
@@ -51,7 +248,7 @@ namespace PacketSerializer
 	template <typename T>
 	bool WriteValue(Packet& packet, const T value)
 	{
-		const auto write_size = sizeof(T);
+		const auto write_size = kWireSize<T>;
 
 		// is the value size beyond the end of the safe read zone?
 		if (packet.GetRemainingSpace() < write_size)
@@ -60,11 +257,10 @@ namespace PacketSerializer
 		}
 
 		// write the value
-		auto* writer = reinterpret_cast<T*>(packet.GetTarget());
-		*writer = value;
+		StoreWire<T>(packet.GetTarget(), value);
 
-		// advance the packet
-		packet.Advance(write_size);
+		// advance the packet, which we already know has the space
+		packet.AdvanceUnchecked(write_size);
 
 		return true;
 	}
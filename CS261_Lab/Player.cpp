@@ -10,8 +10,6 @@
 #include "pch.h"
 #include "Player.h"
 
-const int kPlayerTrailLength = 15;
-
 
 void Player::SetPosition(float x, float y)
 {
@@ -23,13 +21,9 @@ void Player::SetPosition(float x, float y)
 		return;
 	}
 
-	if (previous_x.size() > kPlayerTrailLength)
-	{
-		previous_x.pop_back();
-		previous_y.pop_back();
-	}
-	previous_x.push_front(current_x);
-	previous_y.push_front(current_y);
+	// the oldest position drops off the end of a full trail
+	previous_x.Push(current_x);
+	previous_y.Push(current_y);
 	current_x = x;
 	current_y = y;
 }
@@ -47,11 +41,13 @@ void Player::Draw() const
 	auto draw_size = size;
 	CP_Settings_Fill(draw_color);
 	CP_Graphics_DrawCircle(current_x, current_y, draw_size);
-	for (size_t i = 0; i < previous_x.size(); ++i)
+	// newest first, so the trail shrinks and fades away from the player
+	for (unsigned int i = 0; i < previous_x.GetSize(); ++i)
 	{
-		alpha -= 255 / kPlayerTrailLength;
+		alpha -= 255 / kTrailLength;
 		draw_color = CP_Color_Create(color.r, color.g, color.b, alpha);
 		CP_Settings_Fill(draw_color);
-		CP_Graphics_DrawCircle(previous_x[i], previous_y[i], draw_size - i);
+		const auto newest_index = previous_x.GetSize() - 1 - i;
+		CP_Graphics_DrawCircle(previous_x[newest_index], previous_y[newest_index], draw_size - i);
 	}
 }
\ No newline at end of file
@@ -9,7 +9,7 @@
 //---------------------------------------------------------
 #pragma once
 #include "pch.h"
-#include <deque>
+#include "RingBuffer.h"
 
 
 /// <summary>
@@ -21,6 +21,8 @@ struct Player
 	CP_Color color = CP_Color_Create(0, 0, 255, 255);
 
 	void SetPosition(float x, float y);
+	float GetX() const { return current_x; }
+	float GetY() const { return current_y; }
 
 	/// <summary>
 	/// Draw the player object at its current location.
@@ -28,9 +30,12 @@ struct Player
 	void Draw() const;
 
 private:
+	// the previous positions drawn behind the player, fading out
+	static const unsigned int kTrailLength = 15;
+
 	float current_x = 0.0f;
 	float current_y = 0.0f;
 
-	std::deque<float> previous_x;
-	std::deque<float> previous_y;
+	RingBuffer<float, kTrailLength + 1> previous_x;
+	RingBuffer<float, kTrailLength + 1> previous_y;
 };
\ No newline at end of file
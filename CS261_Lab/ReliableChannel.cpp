@@ -0,0 +1,289 @@
+//---------------------------------------------------------
+// file:	ReliableChannel.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Numbers every datagram, acknowledges the peer's, and resends the messages marked reliable until they arrive.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "ReliableChannel.h"
+#include <algorithm>
+#include "PacketSerializer.h"
+
+const uint16_t kLossThreshold = 3; // a datagram is lost once the peer has acknowledged this many newer ones without it
+const float kResendTimeout_Secs = 0.3f; // resend anyway if no ack has said either way, in case every datagram since was lost
+
+
+ReliableChannel::ReliableChannel(MessageDispatcher& dispatcher)
+	: dispatcher_(dispatcher),
+	time_secs_(0.0f),
+	next_sequence_(1), // the peer acks 0 until it has received something, which must not ack a real datagram
+	current_sequence_(0),
+	next_message_id_(0),
+	sent_datagrams_(),
+	has_ack_(false),
+	newest_ack_(0),
+	oldest_unchecked_sequence_(1),
+	has_received_(false),
+	remote_sequence_(0),
+	remote_ack_bits_(0),
+	received_message_ids_(),
+	is_received_message_id_valid_(),
+	stats_()
+{
+	pending_messages_.reserve(kMaxPendingMessages);
+	dispatcher_.Register(kReliableMessageType, [this](Packet& payload) { return ReceiveReliable(payload); });
+}
+
+
+/// <summary>
+/// Advance the clock used to resend reliable messages that have gone unacknowledged for too long.
+/// </summary>
+void ReliableChannel::Update(const float dt)
+{
+	time_secs_ += dt;
+}
+
+
+/// <summary>
+/// Start a new datagram: number it, and acknowledge everything received from the peer so far.
+/// </summary>
+/// <remarks>Call on an empty packet, before writing any messages, then call WriteReliable before sending it.</remarks>
+/// <returns>If false, the packet had no room for the header.</returns>
+bool ReliableChannel::WriteHeader(Packet& packet)
+{
+	if (packet.GetRemainingSpace() < kHeaderSize)
+	{
+		return false;
+	}
+
+	current_sequence_ = next_sequence_++;
+	auto& sent_datagram = sent_datagrams_[current_sequence_ & 0xFF];
+	sent_datagram.sequence = current_sequence_;
+	sent_datagram.is_valid = true;
+	sent_datagram.is_acked = false;
+	sent_datagram.message_count = 0;
+
+	return PacketSerializer::WriteValue<uint16_t>(packet, current_sequence_) &&
+		PacketSerializer::WriteValue<uint16_t>(packet, remote_sequence_) &&
+		PacketSerializer::WriteValue<uint32_t>(packet, remote_ack_bits_);
+}
+
+
+/// <summary>
+/// Write every reliable message that has not been sent, or whose last datagram was lost, into the datagram.
+/// </summary>
+/// <remarks>Messages that do not fit are left for the next datagram.</remarks>
+void ReliableChannel::WriteReliable(MessageWriter& writer)
+{
+	auto& sent_datagram = sent_datagrams_[current_sequence_ & 0xFF];
+	for (auto& pending_message : pending_messages_)
+	{
+		if (sent_datagram.message_count == kMaxReliablePerDatagram)
+		{
+			break;
+		}
+
+		const bool is_due = !pending_message.is_sent || pending_message.is_lost ||
+			(time_secs_ - pending_message.last_send_secs >= kResendTimeout_Secs);
+		if (!is_due)
+		{
+			continue;
+		}
+
+		const bool is_written = writer.Write(kReliableMessageType, [&](Packet& payload)
+			{
+				return PacketSerializer::WriteVarUInt(payload, pending_message.id) &&
+					PacketSerializer::WriteBytes(payload, pending_message.data, pending_message.size);
+			});
+		if (!is_written)
+		{
+			break;
+		}
+
+		if (pending_message.is_sent)
+		{
+			++stats_.reliable_resent;
+		}
+		pending_message.is_sent = true;
+		pending_message.is_lost = false;
+		pending_message.last_sequence = current_sequence_;
+		pending_message.last_send_secs = time_secs_;
+		sent_datagram.message_ids[sent_datagram.message_count++] = pending_message.id;
+	}
+}
+
+
+/// <summary>
+/// Read the header from the start of a received datagram, recording it and the acks it carries.
+/// </summary>
+/// <remarks>On success, the datagram is left at its first message, ready to be dispatched.</remarks>
+/// <returns>If false, the header was malformed, or the datagram was a duplicate, and it should be dropped.</returns>
+bool ReliableChannel::ReadHeader(Packet& datagram)
+{
+	uint16_t sequence, ack;
+	uint32_t ack_bits;
+	if (!PacketSerializer::ReadValue<uint16_t>(datagram, sequence) ||
+		!PacketSerializer::ReadValue<uint16_t>(datagram, ack) ||
+		!PacketSerializer::ReadValue<uint32_t>(datagram, ack_bits))
+	{
+		return false;
+	}
+
+	if (!has_received_)
+	{
+		has_received_ = true;
+		remote_sequence_ = sequence;
+		remote_ack_bits_ = 0;
+	}
+	else if (IsSequenceNewer(sequence, remote_sequence_))
+	{
+		// slide the bitfield along, and mark the previous newest as received
+		const uint16_t shift = sequence - remote_sequence_;
+		if (shift < 32)
+		{
+			remote_ack_bits_ = (remote_ack_bits_ << shift) | (1u << (shift - 1));
+		}
+		else
+		{
+			remote_ack_bits_ = (shift == 32) ? (1u << 31) : 0;
+		}
+		remote_sequence_ = sequence;
+	}
+	else
+	{
+		const uint16_t age = remote_sequence_ - sequence;
+		if (age == 0)
+		{
+			return false;
+		}
+		if (age <= 32)
+		{
+			const auto bit = 1u << (age - 1);
+			if ((remote_ack_bits_ & bit) != 0)
+			{
+				return false;
+			}
+			remote_ack_bits_ |= bit;
+		}
+		// older than the bitfield, so it cannot be acked, but its messages may still be of use
+	}
+
+	ReceiveAck(ack, ack_bits);
+	return true;
+}
+
+
+/// <summary>
+/// Is sequence newer than than_sequence, allowing for the 16-bit counter wrapping around?
+/// </summary>
+bool ReliableChannel::IsSequenceNewer(const uint16_t sequence, const uint16_t than_sequence)
+{
+	return static_cast<int16_t>(static_cast<uint16_t>(sequence - than_sequence)) > 0;
+}
+
+
+bool ReliableChannel::ReceiveReliable(Packet& payload)
+{
+	uint32_t id;
+	if (!PacketSerializer::ReadVarUInt(payload, id))
+	{
+		return false;
+	}
+
+	// we may receive a message again if only our ack of it was lost
+	const auto slot = id & 0xFF;
+	if (is_received_message_id_valid_[slot] && (received_message_ids_[slot] == id))
+	{
+		++stats_.reliable_duplicates;
+		return true;
+	}
+	is_received_message_id_valid_[slot] = true;
+	received_message_ids_[slot] = static_cast<uint16_t>(id);
+
+	// the rest of the payload is the message itself, framed as MessageWriter wrote it
+	++stats_.reliable_delivered;
+	dispatcher_.Dispatch(payload);
+	return true;
+}
+
+
+void ReliableChannel::ReceiveAck(const uint16_t ack, const uint32_t ack_bits)
+{
+	AckSequence(ack);
+	for (uint16_t i = 0; i < 32; ++i)
+	{
+		if ((ack_bits & (1u << i)) != 0)
+		{
+			stats_.reliable_acked_by_bits += AckSequence(static_cast<uint16_t>(ack - 1 - i));
+		}
+	}
+
+	// only a newer ack tells us anything more about what was lost
+	if (has_ack_ && !IsSequenceNewer(ack, newest_ack_))
+	{
+		return;
+	}
+	has_ack_ = true;
+	newest_ack_ = ack;
+
+	// anything the peer has moved far enough past without acking is lost
+	for (auto& pending_message : pending_messages_)
+	{
+		if (pending_message.is_sent && !pending_message.is_lost &&
+			IsSequenceNewer(ack, pending_message.last_sequence) &&
+			(static_cast<uint16_t>(ack - pending_message.last_sequence) >= kLossThreshold))
+		{
+			pending_message.is_lost = true;
+		}
+	}
+
+	// datagrams the peer has moved far enough past are counted lost, by the same rule as the messages in them
+	while (IsSequenceNewer(static_cast<uint16_t>(ack - kLossThreshold + 1), oldest_unchecked_sequence_))
+	{
+		const auto& sent_datagram = sent_datagrams_[oldest_unchecked_sequence_ & 0xFF];
+		if (sent_datagram.is_valid && (sent_datagram.sequence == oldest_unchecked_sequence_) && !sent_datagram.is_acked)
+		{
+			++stats_.datagrams_lost;
+		}
+		++oldest_unchecked_sequence_;
+	}
+}
+
+
+/// <summary>
+/// Record that the peer received one of our datagrams, and retire the reliable messages it carried.
+/// </summary>
+/// <returns>The number of reliable messages retired.</returns>
+unsigned int ReliableChannel::AckSequence(const uint16_t sequence)
+{
+	auto& sent_datagram = sent_datagrams_[sequence & 0xFF];
+	if (!sent_datagram.is_valid || (sent_datagram.sequence != sequence) || sent_datagram.is_acked)
+	{
+		return 0;
+	}
+	sent_datagram.is_acked = true;
+	// one acked after it was counted lost arrived too far out of order to count as delivered on time
+	if (!IsSequenceNewer(oldest_unchecked_sequence_, sequence))
+	{
+		++stats_.datagrams_acked;
+	}
+
+	// a message is delivered if any datagram that carried it was
+	unsigned int acked_count = 0;
+	for (unsigned int i = 0; i < sent_datagram.message_count; ++i)
+	{
+		const auto message_id = sent_datagram.message_ids[i];
+		const auto pending_iter = std::find_if(pending_messages_.begin(), pending_messages_.end(),
+			[=](const PendingMessage& pending_message) { return pending_message.id == message_id; });
+		if (pending_iter != pending_messages_.end())
+		{
+			pending_messages_.erase(pending_iter);
+			++stats_.reliable_acked;
+			++acked_count;
+		}
+	}
+	return acked_count;
+}
\ No newline at end of file
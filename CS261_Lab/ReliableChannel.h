@@ -0,0 +1,150 @@
+//---------------------------------------------------------
+// file:	ReliableChannel.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Numbers every datagram, acknowledges the peer's, and resends the messages marked reliable until they arrive.
+//
+// remarks: Each datagram starts with its sequence number, the newest sequence received from the peer, and a bitfield
+//          of the 32 sequences before that.  A reliable message rides in a wrapper message with its own id, and is
+//          written into the next datagram again if the one carrying it is lost.  Reliable messages are handled as
+//          soon as they arrive, in any order, so they never hold up the unreliable messages around them.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <array>
+#include <vector>
+#include "Packet.h"
+#include "MessageWriter.h"
+#include "MessageDispatcher.h"
+
+
+/// <summary>
+/// Numbers every datagram, acknowledges the peer's, and resends the messages marked reliable until they arrive.
+/// </summary>
+class ReliableChannel
+{
+public:
+	/// <summary>
+	/// Counters for the messages sent reliably, and the datagrams that carried them.
+	/// </summary>
+	struct Stats
+	{
+		unsigned int reliable_queued; // messages queued to be sent reliably
+		unsigned int reliable_resent; // times a reliable message was written again, after its datagram was lost
+		unsigned int reliable_acked; // reliable messages the peer has acknowledged
+		unsigned int reliable_acked_by_bits; // ... of which the ack came in the bitfield, as the ack naming its datagram was lost or overtaken
+		unsigned int reliable_delivered; // reliable messages received and dispatched, once each
+		unsigned int reliable_duplicates; // reliable messages received more than once, and dropped
+		unsigned int datagrams_acked; // our datagrams the peer acknowledged
+		unsigned int datagrams_lost; // our datagrams the peer did not acknowledge before three newer ones
+	};
+
+	// the wrapper type around reliable messages, which must not be used by any other message
+	static const MessageTypeId kReliableMessageType = 255;
+	// the largest reliable message, including its own header
+	static const unsigned int kMaxReliableMessageSize = 64;
+	// the most reliable messages that may be waiting for an ack at once
+	static const unsigned int kMaxPendingMessages = 32;
+	// the most reliable messages written into one datagram
+	static const unsigned int kMaxReliablePerDatagram = 8;
+	// the size of the header at the start of every datagram
+	static const unsigned int kHeaderSize = sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint32_t);
+
+	ReliableChannel(MessageDispatcher& dispatcher);
+
+	ReliableChannel(const ReliableChannel&) = delete;
+	ReliableChannel& operator=(const ReliableChannel&) = delete;
+
+	void Update(float dt);
+
+	bool WriteHeader(Packet& packet);
+	void WriteReliable(MessageWriter& writer);
+	bool ReadHeader(Packet& datagram);
+
+	/// <summary>
+	/// Queue a message to be sent reliably, with the next datagrams, as written by write_message(MessageWriter&).
+	/// </summary>
+	/// <returns>If false, the message was too large, or too many are already waiting, and it was dropped.</returns>
+	template <typename WriteMessage>
+	bool QueueReliable(WriteMessage&& write_message)
+	{
+		if (pending_messages_.size() >= kMaxPendingMessages)
+		{
+			return false;
+		}
+
+		PendingMessage pending_message{};
+		Packet packet(pending_message.data, kMaxReliableMessageSize);
+		MessageWriter writer(packet);
+		if (!write_message(writer) || (writer.GetMessageCount() == 0))
+		{
+			return false;
+		}
+		pending_message.id = next_message_id_++;
+		pending_message.size = packet.GetUsedSpace();
+		pending_messages_.push_back(pending_message);
+		++stats_.reliable_queued;
+		return true;
+	}
+
+	const Stats& GetStats() const { return stats_; }
+	unsigned int GetPendingCount() const { return static_cast<unsigned int>(pending_messages_.size()); }
+
+private:
+	/// <summary>
+	/// A reliable message the peer has not acknowledged yet.
+	/// </summary>
+	struct PendingMessage
+	{
+		uint16_t id;
+		unsigned int size;
+		char data[kMaxReliableMessageSize];
+		bool is_sent;
+		uint16_t last_sequence; // the datagram it was last written into
+		float last_send_secs;
+		bool is_lost; // the datagram it was last written into is known to be lost
+	};
+
+	/// <summary>
+	/// What we know about a datagram we sent.
+	/// </summary>
+	struct SentDatagram
+	{
+		uint16_t sequence;
+		bool is_valid;
+		bool is_acked;
+		unsigned int message_count;
+		uint16_t message_ids[kMaxReliablePerDatagram]; // the reliable messages it carried
+	};
+
+	static bool IsSequenceNewer(uint16_t sequence, uint16_t than_sequence);
+
+	bool ReceiveReliable(Packet& payload);
+	void ReceiveAck(uint16_t ack, uint32_t ack_bits);
+	unsigned int AckSequence(uint16_t sequence);
+
+	MessageDispatcher& dispatcher_;
+	float time_secs_;
+
+	// sending
+	uint16_t next_sequence_;
+	uint16_t current_sequence_; // the datagram being written, between WriteHeader and WriteReliable
+	uint16_t next_message_id_;
+	std::array<SentDatagram, 256> sent_datagrams_;
+	std::vector<PendingMessage> pending_messages_;
+	bool has_ack_;
+	uint16_t newest_ack_;
+	uint16_t oldest_unchecked_sequence_; // the oldest datagram not yet known to be acked or lost
+
+	// receiving
+	bool has_received_;
+	uint16_t remote_sequence_;
+	uint32_t remote_ack_bits_;
+	std::array<uint16_t, 256> received_message_ids_;
+	std::array<bool, 256> is_received_message_id_valid_;
+
+	Stats stats_;
+};
\ No newline at end of file
@@ -0,0 +1,84 @@
+//---------------------------------------------------------
+// file:	RingBuffer.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A fixed-capacity history that keeps the newest items, overwriting the oldest, and never allocates.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <array>
+
+
+/// <summary>
+/// A fixed-capacity history that keeps the newest items, overwriting the oldest, and never allocates.
+/// </summary>
+/// <remarks>For the histories the scenarios keep every frame, which a std::deque would allocate blocks for as it moves.</remarks>
+template <typename T, unsigned int Capacity>
+class RingBuffer
+{
+	static_assert(Capacity > 0, "RingBuffer capacity must be at least one");
+
+public:
+	static const unsigned int kCapacity = Capacity;
+
+	RingBuffer() : slots_(), oldest_(0), size_(0) { }
+
+	/// <summary>
+	/// Add an item as the newest, overwriting the oldest if the buffer is full.
+	/// </summary>
+	void Push(const T& item)
+	{
+		if (size_ < Capacity)
+		{
+			slots_[(oldest_ + size_) % Capacity] = item;
+			++size_;
+		}
+		else
+		{
+			slots_[oldest_] = item;
+			oldest_ = (oldest_ + 1) % Capacity;
+		}
+	}
+
+	void Clear()
+	{
+		oldest_ = 0;
+		size_ = 0;
+	}
+
+	unsigned int GetSize() const { return size_; }
+
+	/// <summary>
+	/// The item at the given index, where 0 is the oldest and GetSize() - 1 the newest.
+	/// </summary>
+	const T& operator[](const unsigned int index) const
+	{
+		return slots_[(oldest_ + index) % Capacity];
+	}
+
+	/// <summary>
+	/// The oldest item that matches the predicate.
+	/// </summary>
+	/// <returns>The item, or nullptr if none matched.</returns>
+	template <typename Predicate>
+	const T* Find(Predicate&& predicate) const
+	{
+		for (auto i = 0u; i < size_; ++i)
+		{
+			const auto& item = (*this)[i];
+			if (predicate(item))
+			{
+				return &item;
+			}
+		}
+		return nullptr;
+	}
+
+private:
+	std::array<T, Capacity> slots_;
+	unsigned int oldest_;
+	unsigned int size_;
+};
\ No newline at end of file
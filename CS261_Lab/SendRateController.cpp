@@ -0,0 +1,163 @@
+//---------------------------------------------------------
+// file:	SendRateController.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Picks how often to send state to one peer, and how tightly to pack it, from what the link reports.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "SendRateController.h"
+
+const float kEvaluate_Secs = 0.5f; // how often the signals are weighed, so each decision sees several datagrams
+const float kStartRate_PerSec = 10.0f; // a moderate start, which a clear link raises within a few seconds
+const float kRateIncrease_PerSec = 2.0f; // added to the rate at each clear evaluation
+const float kRateCutback = 0.7f; // the rate is multiplied by this on congestion
+const float kLossRatioThreshold = 0.02f; // the share of datagrams lost, beyond the usual, that counts as congestion
+const float kMinQueueingDelay_Secs = 0.025f; // queueing delay below this is treated as ordinary variation
+const float kQueueingDelayRatio = 0.5f; // ... as is queueing delay below this share of the best round trip
+const float kJitterThreshold_Secs = 0.02f; // the jitter the peer can report, beyond the usual, before it counts as congestion
+const float kUsualSmoothing = 1.0f / 16.0f; // the weight of each evaluation in the usual loss and jitter, about 8 seconds
+const float kUdpIpHeaderBytes = 28.0f; // counted against the budget along with each datagram's payload
+const float kDatagramSizeSmoothing = 0.125f; // the weight of each datagram in the average size
+
+
+SendRateController::SendRateController(const float budget_bytes_per_sec)
+	: budget_bytes_per_sec_(budget_bytes_per_sec),
+	rate_per_sec_(kStartRate_PerSec),
+	is_bit_packing_(false),
+	reason_(Reason::Startup),
+	metrics_(),
+	evaluate_timer_secs_(kEvaluate_Secs),
+	has_usual_(false),
+	best_rtt_secs_(0.0f),
+	average_datagram_bytes_(0.0f),
+	last_datagrams_acked_(0),
+	last_datagrams_lost_(0)
+{ }
+
+
+/// <summary>
+/// Weigh the signals every so often, and raise the rate or cut it back.
+/// </summary>
+void SendRateController::Update(const float dt, const Signals& signals)
+{
+	evaluate_timer_secs_ -= dt;
+	if (evaluate_timer_secs_ > 0.0f)
+	{
+		return;
+	}
+	evaluate_timer_secs_ = kEvaluate_Secs;
+
+	// the loss since the last evaluation
+	const auto acked = signals.datagrams_acked - last_datagrams_acked_;
+	const auto lost = signals.datagrams_lost - last_datagrams_lost_;
+	last_datagrams_acked_ = signals.datagrams_acked;
+	last_datagrams_lost_ = signals.datagrams_lost;
+	metrics_.loss_ratio = ((acked + lost) > 0) ? static_cast<float>(lost) / (acked + lost) : 0.0f;
+
+	// the queue building on the path, measured against the best round trip ever seen
+	if ((signals.min_rtt_secs > 0.0f) && ((best_rtt_secs_ <= 0.0f) || (signals.min_rtt_secs < best_rtt_secs_)))
+	{
+		best_rtt_secs_ = signals.min_rtt_secs;
+	}
+	metrics_.queueing_delay_secs = std::max(signals.rtt_secs - best_rtt_secs_, 0.0f);
+	metrics_.remote_jitter_secs = signals.remote_jitter_secs;
+	const auto queueing_threshold_secs = std::max(kMinQueueingDelay_Secs, best_rtt_secs_ * kQueueingDelayRatio);
+
+	// the link as first seen is taken as usual, and the usual follows whatever persists
+	if (!has_usual_)
+	{
+		metrics_.usual_loss_ratio = metrics_.loss_ratio;
+		metrics_.usual_remote_jitter_secs = metrics_.remote_jitter_secs;
+		has_usual_ = (acked + lost) > 0;
+	}
+	const auto is_loss_rising = (lost > 0) && (metrics_.loss_ratio > metrics_.usual_loss_ratio + kLossRatioThreshold);
+	const auto is_jitter_rising = (metrics_.remote_jitter_secs > metrics_.usual_remote_jitter_secs + kJitterThreshold_Secs);
+	metrics_.usual_loss_ratio += kUsualSmoothing * (metrics_.loss_ratio - metrics_.usual_loss_ratio);
+	metrics_.usual_remote_jitter_secs += kUsualSmoothing * (metrics_.remote_jitter_secs - metrics_.usual_remote_jitter_secs);
+
+	if (is_loss_rising)
+	{
+		reason_ = Reason::Loss;
+	}
+	else if ((best_rtt_secs_ > 0.0f) && (metrics_.queueing_delay_secs > queueing_threshold_secs))
+	{
+		reason_ = Reason::Latency;
+	}
+	else if (is_jitter_rising)
+	{
+		reason_ = Reason::Jitter;
+	}
+	else
+	{
+		reason_ = Reason::Clear;
+	}
+
+	if (reason_ == Reason::Clear)
+	{
+		rate_per_sec_ += kRateIncrease_PerSec;
+	}
+	else
+	{
+		rate_per_sec_ *= kRateCutback;
+		++metrics_.cutback_count;
+	}
+	rate_per_sec_ = std::min(std::max(rate_per_sec_, 1.0f / kMaxInterval_Secs), 1.0f / kMinInterval_Secs);
+	if ((reason_ == Reason::Clear) && (rate_per_sec_ >= 1.0f / kMinInterval_Secs))
+	{
+		reason_ = Reason::Maximum;
+	}
+
+	// the budget caps whatever the link would allow, and bits are packed once it is the limit
+	if (average_datagram_bytes_ > 0.0f)
+	{
+		const auto budget_rate_per_sec = budget_bytes_per_sec_ / (average_datagram_bytes_ + kUdpIpHeaderBytes);
+		if (rate_per_sec_ > budget_rate_per_sec)
+		{
+			rate_per_sec_ = std::max(budget_rate_per_sec, 1.0f / kMaxInterval_Secs);
+			is_bit_packing_ = true;
+			reason_ = Reason::Bandwidth;
+		}
+		else if (is_bit_packing_ && (rate_per_sec_ < 0.5f * budget_rate_per_sec))
+		{
+			// well clear of the budget, so the bytes format's cheaper encoding is affordable again
+			is_bit_packing_ = false;
+		}
+	}
+	metrics_.bytes_per_sec = rate_per_sec_ * (average_datagram_bytes_ + kUdpIpHeaderBytes);
+}
+
+
+/// <summary>
+/// Count a datagram sent at the chosen rate toward the average size the budget is checked against.
+/// </summary>
+void SendRateController::OnSend(const unsigned int datagram_bytes)
+{
+	const auto bytes = static_cast<float>(datagram_bytes);
+	average_datagram_bytes_ = (average_datagram_bytes_ <= 0.0f) ? bytes : average_datagram_bytes_ + kDatagramSizeSmoothing * (bytes - average_datagram_bytes_);
+}
+
+
+const char* SendRateController::GetReasonName(const Reason reason)
+{
+	switch (reason)
+	{
+	case Reason::Startup:
+		return "Startup";
+	case Reason::Clear:
+		return "Clear";
+	case Reason::Maximum:
+		return "Maximum";
+	case Reason::Loss:
+		return "Loss";
+	case Reason::Latency:
+		return "Latency";
+	case Reason::Jitter:
+		return "Jitter";
+	case Reason::Bandwidth:
+		return "Bandwidth";
+	}
+	return "Unknown";
+}
\ No newline at end of file
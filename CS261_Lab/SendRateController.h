@@ -0,0 +1,95 @@
+//---------------------------------------------------------
+// file:	SendRateController.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Picks how often to send state to one peer, and how tightly to pack it, from what the link reports.
+//
+// remarks: The rate rises steadily while the link is clear, and is cut back sharply on a sign of congestion:
+//          more datagrams lost than usual, the round trip growing past its best, or the peer seeing our datagrams
+//          arrive more unevenly than usual.  "Usual" is a slow average, so loss and jitter the link always has
+//          (which sending less would not fix) stop counting against the rate after a few seconds.  It never
+//          exceeds the bandwidth budget, and packs bits once the budget is what holds it back.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+
+
+/// <summary>
+/// Picks how often to send state to one peer, and how tightly to pack it, from what the link reports.
+/// </summary>
+class SendRateController
+{
+public:
+	/// <summary>
+	/// Why the rate is what it is, as of the last evaluation.
+	/// </summary>
+	enum class Reason
+	{
+		Startup, // not evaluated yet
+		Clear, // nothing is holding the rate back, so it is rising
+		Maximum, // the rate is as high as it goes
+		Loss, // more datagrams were lost than usual
+		Latency, // the round trip has grown well past its best, so a queue is building
+		Jitter, // the peer reports our datagrams arriving more unevenly than usual
+		Bandwidth, // the budget would be exceeded at a higher rate
+	};
+
+	/// <summary>
+	/// What the link has reported: the round trip, the peer's view of our jitter, and running datagram counts.
+	/// </summary>
+	struct Signals
+	{
+		float rtt_secs;
+		float min_rtt_secs;
+		float remote_jitter_secs;
+		unsigned int datagrams_acked;
+		unsigned int datagrams_lost;
+	};
+
+	/// <summary>
+	/// What the controller is seeing, as of the last evaluation.
+	/// </summary>
+	struct Metrics
+	{
+		float loss_ratio; // of the datagrams judged since the last evaluation
+		float usual_loss_ratio;
+		float queueing_delay_secs; // the round trip, less the best seen
+		float remote_jitter_secs;
+		float usual_remote_jitter_secs;
+		float bytes_per_sec; // at the chosen rate and the recent datagram size, with UDP/IP headers
+		unsigned int cutback_count; // times the rate was cut
+	};
+
+	// the fastest and slowest rates, which match the host's tick and the manual send targets
+	static constexpr float kMinInterval_Secs = 1.0f / 30.0f;
+	static constexpr float kMaxInterval_Secs = 0.5f;
+
+	SendRateController(float budget_bytes_per_sec);
+
+	void Update(float dt, const Signals& signals);
+	void OnSend(unsigned int datagram_bytes);
+
+	float GetInterval() const { return 1.0f / rate_per_sec_; }
+	bool IsBitPacking() const { return is_bit_packing_; }
+	Reason GetReason() const { return reason_; }
+	const Metrics& GetMetrics() const { return metrics_; }
+
+	static const char* GetReasonName(Reason reason);
+
+private:
+	float budget_bytes_per_sec_;
+	float rate_per_sec_;
+	bool is_bit_packing_;
+	Reason reason_;
+	Metrics metrics_;
+
+	float evaluate_timer_secs_;
+	bool has_usual_;
+	float best_rtt_secs_;
+	float average_datagram_bytes_;
+	unsigned int last_datagrams_acked_;
+	unsigned int last_datagrams_lost_;
+};
\ No newline at end of file
@@ -0,0 +1,310 @@
+//---------------------------------------------------------
+// file:	SessionHost.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A thread that owns one bound socket, and demultiplexes it into a session for every peer address.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "SessionHost.h"
+
+const long kWaitForData_Usecs = 1000; // the longest the thread waits for datagrams before checking the outgoing queue
+
+
+/// <summary>
+/// One peer's view of the shared socket.  Datagrams are delivered to it by the host's thread.
+/// </summary>
+class SessionHost::Session :
+	public DatagramTransport
+{
+public:
+	Session(SessionHost& host, const SOCKADDR_IN& address)
+		: host_(host), address_(address), overflow_count_(0), is_open_(true)
+	{ }
+
+	~Session() override
+	{
+		Stop();
+	}
+
+	// Inherited via DatagramTransport
+	bool Send(const Packet& packet) override
+	{
+		return is_open_ && host_.SendTo(packet, address_);
+	}
+
+	bool Receive(ReceivedDatagram& datagram) override
+	{
+		return received_.Pop(datagram);
+	}
+
+	void Stop() override
+	{
+		// once this returns, the host's thread no longer delivers to this session
+		if (is_open_)
+		{
+			host_.CloseSession(GetPeerKey(address_));
+			is_open_ = false;
+		}
+	}
+
+	unsigned int GetOverflowCount() const override { return overflow_count_.load(std::memory_order_relaxed); }
+
+	/// <summary>
+	/// Queue a datagram for the simulation.  Host thread only, with the sessions locked.
+	/// </summary>
+	void Deliver(ReceivedDatagram&& datagram)
+	{
+		if (!received_.Push(std::move(datagram)))
+		{
+			overflow_count_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void CountOverflow()
+	{
+		overflow_count_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+private:
+	SessionHost& host_;
+	SOCKADDR_IN address_;
+	SpscQueue<ReceivedDatagram, kSessionQueueCapacity> received_;
+	std::atomic<unsigned int> overflow_count_;
+	bool is_open_;
+};
+
+
+SessionHost::SessionHost(const SOCKET socket, const DatagramReceiver::Backend receive_backend, UnmatchedFilter unmatched_filter)
+	: socket_(socket),
+	unmatched_filter_(std::move(unmatched_filter)),
+	pool_(kPoolSize),
+	receiver_(socket, receive_backend),
+	overflow_count_(0),
+	is_running_(true),
+	thread_(&SessionHost::Run, this) // last, so everything the thread touches is constructed
+{ }
+
+
+SessionHost::~SessionHost()
+{
+	Stop();
+
+	std::lock_guard<std::mutex> lock(sessions_mutex_);
+	if (!sessions_.empty())
+	{
+		std::cerr << "SessionHost destroyed with " << sessions_.size() << " sessions still open" << std::endl;
+	}
+}
+
+
+/// <summary>
+/// Start delivering the datagrams from the given address to a new session.  Simulation thread only.
+/// </summary>
+/// <returns>The session, or nullptr if the address already has one.</returns>
+std::unique_ptr<DatagramTransport> SessionHost::OpenSession(const SOCKADDR_IN& address)
+{
+	const auto peer_key = GetPeerKey(address);
+
+	std::lock_guard<std::mutex> lock(sessions_mutex_);
+	if (sessions_.count(peer_key) > 0)
+	{
+		return nullptr;
+	}
+	std::unique_ptr<Session> session(new Session(*this, address));
+	sessions_.emplace(peer_key, session.get());
+	return session;
+}
+
+
+/// <summary>
+/// Take the oldest datagram from a peer that had no session when it arrived.  Simulation thread only.
+/// </summary>
+/// <returns>If false, there were no datagrams waiting.</returns>
+bool SessionHost::ReceiveUnmatched(UnmatchedDatagram& datagram)
+{
+	return unmatched_.Pop(datagram);
+}
+
+
+/// <summary>
+/// Queue a copy of the packet's used space to be sent to the given address.  Simulation thread only.
+/// </summary>
+/// <returns>If false, the thread has fallen too far behind, and the datagram was dropped.</returns>
+bool SessionHost::SendTo(const Packet& packet, const SOCKADDR_IN& address)
+{
+	OutgoingDatagram outgoing = { pool_.Acquire(), address };
+	if (!outgoing.buffer.IsValid())
+	{
+		return false;
+	}
+
+	memcpy(outgoing.buffer.GetData(), packet.GetRoot(), packet.GetUsedSpace());
+	outgoing.buffer.SetSize(packet.GetUsedSpace());
+	return outgoing_.Push(std::move(outgoing));
+}
+
+
+/// <summary>
+/// Stop the thread and close the socket.  Anything still queued is dropped.
+/// </summary>
+void SessionHost::Stop()
+{
+	is_running_.store(false, std::memory_order_release);
+	if (thread_.joinable())
+	{
+		thread_.join();
+	}
+
+	if (socket_ != INVALID_SOCKET)
+	{
+		receiver_.Stop();
+		closesocket(socket_);
+		socket_ = INVALID_SOCKET;
+	}
+}
+
+
+unsigned int SessionHost::GetSessionCount() const
+{
+	std::lock_guard<std::mutex> lock(sessions_mutex_);
+	return static_cast<unsigned int>(sessions_.size());
+}
+
+
+/// <summary>
+/// Pack an IPv4 address and port into one key, both in network byte order.
+/// </summary>
+uint64_t SessionHost::GetPeerKey(const SOCKADDR_IN& address)
+{
+	return (static_cast<uint64_t>(address.sin_addr.s_addr) << 16) | address.sin_port;
+}
+
+
+void SessionHost::CloseSession(const uint64_t peer_key)
+{
+	std::lock_guard<std::mutex> lock(sessions_mutex_);
+	sessions_.erase(peer_key);
+}
+
+
+void SessionHost::Run()
+{
+	while (is_running_.load(std::memory_order_acquire))
+	{
+		SendQueued();
+
+		// sleep until a datagram arrives, or it is time to check the outgoing queue again
+		ReceiveWaiting(kWaitForData_Usecs);
+	}
+}
+
+
+void SessionHost::SendQueued()
+{
+	// the queue holds datagrams for many peers, so batch them into as few system calls as possible
+	OutgoingDatagram outgoing;
+	while (outgoing_.Pop(outgoing))
+	{
+		memcpy(send_batch_.GetNextBuffer(), outgoing.buffer.GetData(), outgoing.buffer.GetSize());
+		send_batch_.Push(outgoing.buffer.GetSize(), &outgoing.address);
+		outgoing.buffer.Reset();
+		if (send_batch_.IsFull())
+		{
+			// UDP may drop any datagram, so a failed send is treated the same way
+			send_batch_.Send(socket_);
+		}
+	}
+	if (send_batch_.GetCount() > 0)
+	{
+		send_batch_.Send(socket_);
+	}
+}
+
+
+void SessionHost::ReceiveWaiting(const long timeout_usecs)
+{
+	// only the first receive waits; the rest drain what is already there
+	int received;
+	auto timeout = timeout_usecs;
+	while ((received = receiver_.Receive(timeout)) > 0)
+	{
+		timeout = 0;
+		const auto arrival_time = DatagramTransport::Clock::now();
+
+		// one lock per batch, held while delivering, so no session can close while a datagram is on its way to it
+		std::lock_guard<std::mutex> lock(sessions_mutex_);
+		for (int i = 0; i < received; ++i)
+		{
+			const auto& address = receiver_.GetAddress(i);
+			const auto session_iter = sessions_.find(GetPeerKey(address));
+			if ((session_iter == sessions_.end()) && !IsUnmatchedQueued(address, i))
+			{
+				continue;
+			}
+			DatagramTransport::ReceivedDatagram received_datagram = { pool_.Acquire(), arrival_time };
+			if (!received_datagram.buffer.IsValid())
+			{
+				if (session_iter != sessions_.end())
+				{
+					session_iter->second->CountOverflow();
+				}
+				overflow_count_.fetch_add(1, std::memory_order_relaxed);
+				continue;
+			}
+
+			const auto datagram = receiver_.GetDatagram(i);
+			memcpy(received_datagram.buffer.GetData(), datagram.GetRoot(), datagram.GetRemainingSpace());
+			received_datagram.buffer.SetSize(datagram.GetRemainingSpace());
+			if (session_iter != sessions_.end())
+			{
+				session_iter->second->Deliver(std::move(received_datagram));
+			}
+			else if (!unmatched_.Push({ std::move(received_datagram), address }))
+			{
+				overflow_count_.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// a partial batch means the socket is already empty
+		if (received < static_cast<int>(DatagramReceiver::kMaxDatagrams))
+		{
+			break;
+		}
+	}
+
+	// the filter's responses go out now, rather than after the next wait
+	if (send_batch_.GetCount() > 0)
+	{
+		send_batch_.Send(socket_);
+	}
+}
+
+
+/// <summary>
+/// Run the filter on a datagram from a peer with no session, and send any response it writes.
+/// </summary>
+/// <returns>If true, the datagram is to be queued for the simulation.</returns>
+bool SessionHost::IsUnmatchedQueued(const SOCKADDR_IN& address, const unsigned int index)
+{
+	if (!unmatched_filter_)
+	{
+		return true;
+	}
+
+	// the response is written straight into the send batch, which is only sent from this thread
+	auto datagram = receiver_.GetDatagram(index);
+	Packet response(send_batch_.GetNextBuffer(), kMaxDatagramSize);
+	const auto is_queued = unmatched_filter_(datagram, address, response);
+	if (response.GetUsedSpace() > 0)
+	{
+		send_batch_.Push(response.GetUsedSpace(), &address);
+		if (send_batch_.IsFull())
+		{
+			send_batch_.Send(socket_);
+		}
+	}
+	return is_queued;
+}
\ No newline at end of file
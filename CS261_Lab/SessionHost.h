@@ -0,0 +1,108 @@
+//---------------------------------------------------------
+// file:	SessionHost.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A thread that owns one bound socket, and demultiplexes it into a session for every peer address.
+//
+// remarks: Each session is a DatagramTransport, so any networked scenario can run over it unchanged.
+//          Datagrams from peers with no session yet (usually connection requests) are queued separately,
+//          for the simulation to accept or reject.  The simulation must run every session on the same thread,
+//          and must stop or destroy every session before the host.
+//          The thread wakes when datagrams arrive, through DatagramReceiver, or every millisecond to send.
+//          An UnmatchedFilter lets the thread answer or drop datagrams from unknown peers before they are queued,
+//          so a flood of them never reaches the simulation.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "Packet.h"
+#include "PacketBufferPool.h"
+#include "DatagramBatch.h"
+#include "DatagramReceiver.h"
+#include "DatagramTransport.h"
+#include "SpscQueue.h"
+
+
+/// <summary>
+/// A thread that owns one bound socket, and demultiplexes it into a session for every peer address.
+/// </summary>
+class SessionHost
+{
+public:
+	/// <summary>
+	/// A datagram from a peer that has no session.
+	/// </summary>
+	struct UnmatchedDatagram
+	{
+		DatagramTransport::ReceivedDatagram datagram;
+		SOCKADDR_IN address;
+	};
+
+	/// <summary>
+	/// Decides, on the host's thread, if a datagram from a peer with no session is queued for the simulation.
+	/// </summary>
+	/// <remarks>Anything written into the response is sent back to the peer, whatever is decided.
+	/// Called with the sessions locked, so it must be quick, and must not call back into the host.</remarks>
+	using UnmatchedFilter = std::function<bool(Packet& datagram, const SOCKADDR_IN& address, Packet& response)>;
+
+	static const unsigned int kQueueCapacity = 1024;
+	static const unsigned int kSessionQueueCapacity = 64;
+	static const unsigned int kPoolSize = 4096;
+
+	SessionHost(SOCKET socket, DatagramReceiver::Backend receive_backend, UnmatchedFilter unmatched_filter);
+	~SessionHost();
+
+	SessionHost(const SessionHost&) = delete;
+	SessionHost& operator=(const SessionHost&) = delete;
+
+	std::unique_ptr<DatagramTransport> OpenSession(const SOCKADDR_IN& address);
+	bool ReceiveUnmatched(UnmatchedDatagram& datagram);
+	bool SendTo(const Packet& packet, const SOCKADDR_IN& address);
+	void Stop();
+
+	bool IsRunning() const { return is_running_.load(std::memory_order_acquire); }
+	unsigned int GetSessionCount() const;
+	unsigned int GetOverflowCount() const { return overflow_count_.load(std::memory_order_relaxed); }
+
+private:
+	class Session;
+
+	/// <summary>
+	/// A datagram queued by the simulation, with the peer it is for.
+	/// </summary>
+	struct OutgoingDatagram
+	{
+		PacketBuffer buffer;
+		SOCKADDR_IN address;
+	};
+
+	static uint64_t GetPeerKey(const SOCKADDR_IN& address);
+
+	void CloseSession(uint64_t peer_key);
+	void Run();
+	void SendQueued();
+	void ReceiveWaiting(long timeout_usecs);
+	bool IsUnmatchedQueued(const SOCKADDR_IN& address, unsigned int index);
+
+	SOCKET socket_;
+	UnmatchedFilter unmatched_filter_; // or empty, to queue every datagram from an unknown peer
+	PacketBufferPool pool_;
+	SpscQueue<OutgoingDatagram, kQueueCapacity> outgoing_;
+	SpscQueue<UnmatchedDatagram, kQueueCapacity> unmatched_;
+	// sessions are added and removed by the simulation, but looked up for every datagram by the thread
+	std::unordered_map<uint64_t, Session*> sessions_;
+	mutable std::mutex sessions_mutex_;
+	DatagramReceiver receiver_;
+	DatagramBatch send_batch_;
+	std::atomic<unsigned int> overflow_count_;
+	std::atomic<bool> is_running_;
+	std::thread thread_;
+};
\ No newline at end of file
@@ -0,0 +1,444 @@
+//---------------------------------------------------------
+// file:	SharedMemoryTransport.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Exchanges datagrams with a peer on the same machine through a shared memory region, instead of sockets.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "SharedMemoryTransport.h"
+#include <atomic>
+#include <cctype>
+#include <new>
+#include <random>
+#include <thread>
+#include "PacketSerializer.h"
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+const char* kNamePrefix = "cs261-"; // every region's name starts with this, so a request cannot name anything else
+const unsigned int kMaxNameLength = 48;
+const uint32_t kRegionMagic = 0x31363243; // "C261", written last by the client, once the region is ready
+const uint32_t kRegionVersion = 1;
+// received datagrams may be held a while (as NetworkConditionTransport does), so the pool outlasts a full ring
+const unsigned int kPoolSize = 2 * SharedMemoryTransport::kRingCapacity;
+
+
+/// <summary>
+/// A lock-free queue of datagrams from one peer to the other, which lives in the shared region.
+/// </summary>
+/// <remarks>Only the sending peer writes the tail, and only the receiving peer writes the head, as in SpscQueue.</remarks>
+struct SharedMemoryTransport::Ring
+{
+	struct Slot
+	{
+		uint32_t size;
+		Clock::rep send_time; // the steady clock is the same in every process on a machine
+		char data[kMaxDatagramSize];
+	};
+
+	// the indices are on separate cache lines, so the two peers do not contend over one line
+	alignas(64) std::atomic<uint32_t> head;
+	alignas(64) std::atomic<uint32_t> tail; // also what a waiting receiver sleeps on
+	std::atomic<uint32_t> is_receiver_waiting;
+	std::atomic<uint32_t> overflow_count; // datagrams the sender dropped, because the ring was full
+	Slot slots[kRingCapacity];
+};
+
+
+/// <summary>
+/// The whole shared region: a ring in each direction.
+/// </summary>
+struct SharedMemoryTransport::Region
+{
+	std::atomic<uint32_t> magic;
+	uint32_t version;
+	std::atomic<uint32_t> is_host_attached; // so a repeated request cannot open a second host on the region
+	Ring rings[2]; // client to host, then host to client
+};
+
+static_assert((SharedMemoryTransport::kRingCapacity & (SharedMemoryTransport::kRingCapacity - 1)) == 0, "the ring capacity must be a power of two");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the ring indices must be lock-free to be shared between processes");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "a ring's tail is waited on as a plain 32-bit word");
+
+
+namespace
+{
+	bool IsValidName(const std::string_view name)
+	{
+		const auto prefix_length = strlen(kNamePrefix);
+		if ((name.size() <= prefix_length) || (name.size() > kMaxNameLength) || (name.substr(0, prefix_length) != kNamePrefix))
+		{
+			return false;
+		}
+		return std::all_of(name.begin() + prefix_length, name.end(), [](const char c) { return isxdigit(static_cast<unsigned char>(c)) || (c == '-'); });
+	}
+}
+
+
+/// <summary>
+/// Create a region for a client to offer the host in its connection request.
+/// </summary>
+/// <returns>The transport, or nullptr if the region could not be created, in which case the client uses UDP.</returns>
+std::unique_ptr<SharedMemoryTransport> SharedMemoryTransport::Create()
+{
+	// the name is unguessable, so only the host we send it to can find the region
+	std::random_device random;
+	char name[kMaxNameLength + 1];
+	snprintf(name, sizeof(name), "%s%08x%08x", kNamePrefix, random(), random());
+
+	auto transport = std::unique_ptr<SharedMemoryTransport>(new SharedMemoryTransport(name, false));
+	if (!transport->Map())
+	{
+		std::cerr << "Could not create shared memory '" << name << "', so connecting over UDP" << std::endl;
+		return nullptr;
+	}
+	return transport;
+}
+
+
+/// <summary>
+/// Open the region named in a client's connection request, after its game type, if there is one.
+/// </summary>
+/// <returns>The transport, or nullptr if the request named no region, or it could not be opened, in which case the host uses UDP.</returns>
+std::unique_ptr<SharedMemoryTransport> SharedMemoryTransport::OpenRequested(Packet& request)
+{
+	std::string_view name;
+	if ((request.GetRemainingSpace() == 0) || !PacketSerializer::ReadStringView(request, name) || !IsValidName(name))
+	{
+		return nullptr;
+	}
+
+	auto transport = std::unique_ptr<SharedMemoryTransport>(new SharedMemoryTransport(std::string(name), true));
+	if (!transport->Map())
+	{
+		std::cout << "Could not open shared memory '" << name << "', as the client is on another machine, or already attached; continuing over UDP" << std::endl;
+		return nullptr;
+	}
+	return transport;
+}
+
+
+/// <summary>
+/// Is shared memory allowed by the command line?  It is, unless kDisableArgument is given.
+/// </summary>
+bool SharedMemoryTransport::IsAllowedByArguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], kDisableArgument) == 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+SharedMemoryTransport::SharedMemoryTransport(std::string name, const bool is_host)
+	: name_(std::move(name)),
+	is_host_(is_host),
+	is_stopped_(false),
+	region_(nullptr),
+	sending_(nullptr),
+	receiving_(nullptr),
+	pool_(kPoolSize)
+#if defined(_WIN32)
+	, mapping_(nullptr),
+	send_event_(nullptr),
+	receive_event_(nullptr)
+#endif
+{ }
+
+
+SharedMemoryTransport::~SharedMemoryTransport()
+{
+	Stop();
+	Unmap();
+}
+
+
+/// <summary>
+/// Copy the packet's used space into the next slot of the ring to the peer, and wake the peer if it is waiting.
+/// </summary>
+/// <returns>If false, the peer has fallen too far behind, and the datagram was dropped.</returns>
+bool SharedMemoryTransport::Send(const Packet& packet)
+{
+	if (is_stopped_)
+	{
+		return false;
+	}
+
+	auto& ring = *sending_;
+	const auto tail = ring.tail.load(std::memory_order_relaxed);
+	if (tail - ring.head.load(std::memory_order_acquire) == kRingCapacity)
+	{
+		ring.overflow_count.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	auto& slot = ring.slots[tail & (kRingCapacity - 1)];
+	memcpy(slot.data, packet.GetRoot(), packet.GetUsedSpace());
+	slot.size = packet.GetUsedSpace();
+	slot.send_time = Clock::now().time_since_epoch().count();
+	// sequentially consistent, along with the receiver's flag, so either it sees the new tail or we see it waiting
+	ring.tail.store(tail + 1, std::memory_order_seq_cst);
+	if (ring.is_receiver_waiting.load(std::memory_order_seq_cst) != 0)
+	{
+		WakePeer();
+	}
+	return true;
+}
+
+
+/// <summary>
+/// Copy the oldest datagram out of the ring from the peer.
+/// </summary>
+/// <returns>If false, there were no datagrams waiting.</returns>
+bool SharedMemoryTransport::Receive(ReceivedDatagram& datagram)
+{
+	if (is_stopped_)
+	{
+		return false;
+	}
+
+	auto& ring = *receiving_;
+	const auto head = ring.head.load(std::memory_order_relaxed);
+	if (head == ring.tail.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+	// with every buffer held, the datagram waits in the ring, which drops the peer's sends once it is full
+	auto buffer = pool_.Acquire();
+	if (!buffer.IsValid())
+	{
+		return false;
+	}
+
+	// the size is checked as any datagram's would be, since the region is writable by the peer
+	const auto& slot = ring.slots[head & (kRingCapacity - 1)];
+	const auto size = std::min<uint32_t>(slot.size, kMaxDatagramSize);
+	memcpy(buffer.GetData(), slot.data, size);
+	buffer.SetSize(size);
+	datagram.buffer = std::move(buffer);
+	// the datagram was ready for us the moment it was sent
+	datagram.arrival_time = Clock::time_point(Clock::duration(slot.send_time));
+	// release, so the peer only reuses the slot after it has been copied out
+	ring.head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+
+/// <summary>
+/// Stop exchanging datagrams.  The region stays mapped until the transport is destroyed.
+/// </summary>
+void SharedMemoryTransport::Stop()
+{
+	is_stopped_ = true;
+}
+
+
+/// <summary>
+/// The datagrams the peer dropped because we were not keeping up, and the ring to us was full.
+/// </summary>
+unsigned int SharedMemoryTransport::GetOverflowCount() const
+{
+	return receiving_->overflow_count.load(std::memory_order_relaxed);
+}
+
+
+/// <summary>
+/// Sleep until the peer sends a datagram, or the timeout passes.  The peer only makes a system call to wake us.
+/// </summary>
+/// <remarks>May return early, so check the result, or just call Receive.</remarks>
+/// <returns>If true, a datagram is waiting.</returns>
+bool SharedMemoryTransport::WaitForDatagram(const float timeout_secs)
+{
+	if (is_stopped_)
+	{
+		return false;
+	}
+
+	auto& ring = *receiving_;
+	const auto head = ring.head.load(std::memory_order_relaxed);
+	if (head != ring.tail.load(std::memory_order_acquire))
+	{
+		return true;
+	}
+
+	// say we are waiting, then look again, so a send between the two is never missed
+	ring.is_receiver_waiting.store(1, std::memory_order_seq_cst);
+	const auto tail = ring.tail.load(std::memory_order_seq_cst);
+	if (tail == head)
+	{
+		SleepUntilSent(tail, timeout_secs);
+	}
+	ring.is_receiver_waiting.store(0, std::memory_order_relaxed);
+	return head != ring.tail.load(std::memory_order_acquire);
+}
+
+
+/// <summary>
+/// Name the region in the client's connection request, after the game type, for the host to open.
+/// </summary>
+/// <returns>If true, the name was successfully written.</returns>
+bool SharedMemoryTransport::WriteRequest(Packet& request) const
+{
+	return PacketSerializer::WriteString(request, name_);
+}
+
+
+/// <summary>
+/// Create the region (the client) or open it (the host), and find the rings to send into and receive from.
+/// </summary>
+/// <returns>If false, the region could not be created or opened, and nothing is left behind.</returns>
+bool SharedMemoryTransport::Map()
+{
+	void* view = nullptr;
+#if defined(_WIN32)
+	const auto mapping_name = "Local\\" + name_;
+	mapping_ = is_host_ ?
+		OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mapping_name.c_str()) :
+		CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(Region), mapping_name.c_str());
+	if (mapping_ == nullptr)
+	{
+		return false;
+	}
+	view = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Region));
+	if (view == nullptr)
+	{
+		Unmap();
+		return false;
+	}
+	region_ = static_cast<Region*>(view);
+
+	// one auto-reset event per ring, which either peer creates or opens by name
+	const auto client_event_name = mapping_name + "-0";
+	const auto host_event_name = mapping_name + "-1";
+	send_event_ = CreateEventA(nullptr, FALSE, FALSE, is_host_ ? host_event_name.c_str() : client_event_name.c_str());
+	receive_event_ = CreateEventA(nullptr, FALSE, FALSE, is_host_ ? client_event_name.c_str() : host_event_name.c_str());
+	if ((send_event_ == nullptr) || (receive_event_ == nullptr))
+	{
+		Unmap();
+		return false;
+	}
+#else
+	const auto path = "/" + name_;
+	const int fd = shm_open(path.c_str(), is_host_ ? O_RDWR : (O_RDWR | O_CREAT | O_EXCL), 0600);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat status;
+	const bool is_sized = is_host_ ?
+		((fstat(fd, &status) == 0) && (static_cast<size_t>(status.st_size) >= sizeof(Region))) :
+		(ftruncate(fd, sizeof(Region)) == 0);
+	view = is_sized ? mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	// once the host has it mapped, the name has done its job
+	if (is_host_ || (view == MAP_FAILED))
+	{
+		shm_unlink(path.c_str());
+	}
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+	region_ = static_cast<Region*>(view);
+#endif
+
+	if (!is_host_)
+	{
+		region_ = new (view) Region();
+		region_->version = kRegionVersion;
+		region_->magic.store(kRegionMagic, std::memory_order_release);
+	}
+	else if ((region_->magic.load(std::memory_order_acquire) != kRegionMagic) || (region_->version != kRegionVersion) ||
+		(region_->is_host_attached.exchange(1, std::memory_order_acq_rel) != 0))
+	{
+		Unmap();
+		return false;
+	}
+
+	sending_ = &region_->rings[is_host_ ? 1 : 0];
+	receiving_ = &region_->rings[is_host_ ? 0 : 1];
+	return true;
+}
+
+
+void SharedMemoryTransport::Unmap()
+{
+#if defined(_WIN32)
+	if (region_ != nullptr)
+	{
+		UnmapViewOfFile(region_);
+	}
+	for (HANDLE* handle : { &mapping_, &send_event_, &receive_event_ })
+	{
+		if (*handle != nullptr)
+		{
+			CloseHandle(*handle);
+			*handle = nullptr;
+		}
+	}
+#else
+	if (region_ != nullptr)
+	{
+		munmap(region_, sizeof(Region));
+		// the client removes the name, in case the host never opened it
+		if (!is_host_)
+		{
+			shm_unlink(("/" + name_).c_str());
+		}
+	}
+#endif
+	region_ = nullptr;
+	sending_ = nullptr;
+	receiving_ = nullptr;
+}
+
+
+/// <summary>
+/// Wake the peer, which is waiting on the ring we send into.
+/// </summary>
+void SharedMemoryTransport::WakePeer()
+{
+#if defined(_WIN32)
+	SetEvent(send_event_);
+#elif defined(__linux__)
+	// not FUTEX_PRIVATE_FLAG, as the waiter is in another process
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sending_->tail), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+
+/// <summary>
+/// Sleep until the ring's tail moves on from the given value, or the timeout passes.
+/// </summary>
+void SharedMemoryTransport::SleepUntilSent(const uint32_t tail, const float timeout_secs)
+{
+#if defined(_WIN32)
+	(void)tail;
+	WaitForSingleObject(receive_event_, static_cast<DWORD>(timeout_secs * 1000.0f));
+#elif defined(__linux__)
+	// the kernel only sleeps if the tail still holds the value we saw, so a send just before is never missed
+	timespec timeout;
+	timeout.tv_sec = static_cast<time_t>(timeout_secs);
+	timeout.tv_nsec = static_cast<long>((timeout_secs - timeout.tv_sec) * 1000000000.0f);
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&receiving_->tail), FUTEX_WAIT, tail, &timeout, nullptr, 0);
+#else
+	// no portable way to sleep on a word, so poll briefly instead
+	(void)tail;
+	std::this_thread::sleep_for(std::chrono::duration<float>(std::min(timeout_secs, 0.001f)));
+#endif
+}
\ No newline at end of file
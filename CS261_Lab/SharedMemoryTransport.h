@@ -0,0 +1,81 @@
+//---------------------------------------------------------
+// file:	SharedMemoryTransport.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Exchanges datagrams with a peer on the same machine through a shared memory region, instead of sockets.
+//
+// remarks: The client creates the region, and names it in its connection request.  If the host can open it,
+//          the two are on one machine, and the host says so in its response; otherwise both carry on over UDP.
+//          The region holds one lock-free ring of datagram slots in each direction, so a send or receive is
+//          a copy into or out of a slot, with no system call.  A peer that waits for a datagram sleeps on the
+//          ring's tail (a futex on Linux, a named event on Windows), which the sender only wakes if it is asleep.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <memory>
+#include <string_view>
+#include "Packet.h"
+#include "PacketBufferPool.h"
+#include "DatagramTransport.h"
+
+
+/// <summary>
+/// Exchanges datagrams with a peer on the same machine through a shared memory region, instead of sockets.
+/// </summary>
+class SharedMemoryTransport :
+	public DatagramTransport
+{
+public:
+	// the datagrams that may be waiting in each direction, beyond which sends are dropped
+	static const unsigned int kRingCapacity = 256;
+	// the host's response carries this after "LetUsBegin" when it has opened the region
+	static constexpr const char* kAcceptResponse = "SharedMemory";
+	// keeps peers on one machine on UDP, to compare the two
+	static constexpr const char* kDisableArgument = "--udp";
+
+	static std::unique_ptr<SharedMemoryTransport> Create();
+	static std::unique_ptr<SharedMemoryTransport> OpenRequested(Packet& request);
+	static bool IsAllowedByArguments(int argc, char** argv);
+
+	~SharedMemoryTransport() override;
+
+	SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+	SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+	// Inherited via DatagramTransport
+	bool Send(const Packet& packet) override;
+	bool Receive(ReceivedDatagram& datagram) override;
+	void Stop() override;
+	unsigned int GetOverflowCount() const override;
+
+	bool WaitForDatagram(float timeout_secs);
+	bool WriteRequest(Packet& request) const;
+
+private:
+	struct Ring;
+	struct Region;
+
+	SharedMemoryTransport(std::string name, bool is_host);
+
+	bool Map();
+	void Unmap();
+	void WakePeer();
+	void SleepUntilSent(uint32_t tail, float timeout_secs);
+
+	std::string name_;
+	bool is_host_; // the host opened the region, and the client created it
+	bool is_stopped_;
+	Region* region_;
+	Ring* sending_;
+	Ring* receiving_;
+	PacketBufferPool pool_;
+
+#if defined(_WIN32)
+	HANDLE mapping_;
+	HANDLE send_event_; // set to wake the peer when it is waiting on the ring we send into
+	HANDLE receive_event_;
+#endif
+};
\ No newline at end of file
@@ -15,7 +15,8 @@ void SnapshotControl::AddSnapshot(const State& new_state, const u_long remote_fr
 {
 	sync_ratio_.base_frame = sync_ratio_.target_frame;
 	sync_ratio_.target_frame = remote_frame;
-	sync_ratio_.t = 0.0f;
+	// the snapshot is already age_secs old, so start the interpolation that far along
+	sync_ratio_.t = (new_state.time_since_last_update_secs > 0.0f) ? new_state.age_secs / new_state.time_since_last_update_secs : 0.0f;
 
 	previous_state_ = latest_state_;
 	latest_state_ = new_state;
@@ -24,6 +24,7 @@ public:
 		float x = 0.0f;
 		float y = 0.0f;
 		float time_since_last_update_secs = 0.0f;
+		float age_secs = 0.0f; // how long ago the peer sent it, on the peer's clock
 	};
 
 	void AddSnapshot(const State& new_state, u_long remote_frame);
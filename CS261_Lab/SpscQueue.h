@@ -0,0 +1,83 @@
+//---------------------------------------------------------
+// file:	SpscQueue.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A fixed-capacity, lock-free queue for exactly one producer thread and one consumer thread.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <array>
+#include <atomic>
+
+
+/// <summary>
+/// A fixed-capacity, lock-free queue for exactly one producer thread and one consumer thread.
+/// </summary>
+/// <remarks>
+/// Only the producer may call Push, and only the consumer may call Pop.
+/// The indices only ever increase, and wrap through the power-of-two capacity with a mask.
+/// </remarks>
+template <typename T, unsigned int Capacity>
+class SpscQueue
+{
+	static_assert((Capacity > 0) && ((Capacity & (Capacity - 1)) == 0), "SpscQueue capacity must be a power of two");
+
+public:
+	SpscQueue() : head_(0), tail_(0) { }
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	/// <summary>
+	/// Add an item to the back of the queue.  Producer only.
+	/// </summary>
+	/// <returns>If false, the queue was full, and the item was not moved from.</returns>
+	bool Push(T&& item)
+	{
+		const auto tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+
+		slots_[tail & (Capacity - 1)] = std::move(item);
+		// release, so the consumer sees the item before it sees the new tail
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// Take the item at the front of the queue.  Consumer only.
+	/// </summary>
+	/// <returns>If false, the queue was empty.</returns>
+	bool Pop(T& item)
+	{
+		const auto head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		item = std::move(slots_[head & (Capacity - 1)]);
+		// release, so the producer only reuses the slot after the item has been moved out
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// The number of items in the queue, which may already be stale when read from the other thread.
+	/// </summary>
+	unsigned int GetSize() const
+	{
+		return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+	}
+
+private:
+	// the indices are on separate cache lines, so the two threads do not contend over one line
+	alignas(64) std::atomic<unsigned int> head_;
+	alignas(64) std::atomic<unsigned int> tail_;
+	std::array<T, Capacity> slots_;
+};
\ No newline at end of file
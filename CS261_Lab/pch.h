@@ -10,11 +10,16 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+#if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 // Windows Header Files
 #include <windows.h>
 #include "WinSock2.h"
 #include <WS2tcpip.h>
+#else
+// BSD sockets, under the WinSock names
+#include "BsdSockets.h"
+#endif
 
 // C RunTime Header Files
 #include <iostream>
@@ -22,10 +27,19 @@
 #include <deque>
 #include <algorithm>
 
+#if defined(_WIN32)
 #include <malloc.h>
 #include <memory.h>
 #include <tchar.h>
+#else
+#include <string.h>
+#endif
 
+// headless builds (such as CS261_Lab_Headless) have no window, so they stub out CProcessing
+#if defined(CS261_HEADLESS)
+#include "HeadlessProcessing.h"
+#else
 #include "cprocessing.h"
+#endif
 
 #endif //PCH_H
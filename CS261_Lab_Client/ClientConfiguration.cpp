@@ -8,6 +8,7 @@
 // Copyright  2021 DigiPen, All rights reserved.
 //---------------------------------------------------------
 #include "ClientConfiguration.h"
+#include "SharedMemoryTransport.h"
 
 
 ClientConfiguration ClientConfiguration::BuildConfigurationFromArguments(int argc, char** argv)
@@ -16,6 +17,8 @@ ClientConfiguration ClientConfiguration::BuildConfigurationFromArguments(int arg
 
     //NOTE: in Assignment 4, there are configuration values for the user service login process here...
     configuration.game_port = 4200;
+    configuration.network_conditions = NetworkConditions::FromArguments(argc, argv);
+    configuration.is_shared_memory_allowed = SharedMemoryTransport::IsAllowedByArguments(argc, argv);
 
     return configuration;
 }
\ No newline at end of file
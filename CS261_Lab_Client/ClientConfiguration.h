@@ -9,6 +9,7 @@
 //---------------------------------------------------------
 #pragma once
 #include "framework.h"
+#include "NetworkConditions.h"
 
 
 /// <summary>
@@ -17,6 +18,10 @@
 struct ClientConfiguration
 {
 	int game_port = 4200;
+	// simulated on the scenario's datagrams, from a --net= argument
+	NetworkConditions network_conditions;
+	// offer the host shared memory, which it uses if it is on this machine, unless there is a --udp argument
+	bool is_shared_memory_allowed = true;
 
 	static ClientConfiguration BuildConfigurationFromArguments(int argc, char** argv);
 };
@@ -55,27 +55,27 @@ void ClientMainMenuState::Update()
 	else if (CP_Input_KeyTriggered(KEY_2) || CP_Input_KeyTriggered(KEY_KP_2))
 	{
 		auto* game_state = new ConnectingMenuState(
-			[](const SOCKET socket, const bool is_host) -> NetworkedScenarioState*
+			[](std::unique_ptr<DatagramTransport> transport, const bool is_host) -> NetworkedScenarioState*
 			{ 
-				return new LockstepScenarioState(socket, is_host); 
+				return new LockstepScenarioState(std::move(transport), is_host); 
 			}, "Lockstep", configuration_);
 		GameStateManager::ApplyState(game_state);
 	}
 	else if (CP_Input_KeyTriggered(KEY_3) || CP_Input_KeyTriggered(KEY_KP_3))
 	{
 		auto* game_state = new ConnectingMenuState(
-			[](const SOCKET socket, const bool is_host) -> NetworkedScenarioState*
+			[](std::unique_ptr<DatagramTransport> transport, const bool is_host) -> NetworkedScenarioState*
 			{
-				return new DumbClientScenarioState(socket, is_host);
+				return new DumbClientScenarioState(std::move(transport), is_host);
 			}, "DumbClient", configuration_);
 		GameStateManager::ApplyState(game_state);
 	}
 	else if (CP_Input_KeyTriggered(KEY_4) || CP_Input_KeyTriggered(KEY_KP_4))
 	{
 		auto* game_state = new ConnectingMenuState(
-			[](const SOCKET socket, const bool is_host) -> NetworkedScenarioState*
+			[](std::unique_ptr<DatagramTransport> transport, const bool is_host) -> NetworkedScenarioState*
 			{
-				return new OptimisticClientScenarioState(socket);
+				return new OptimisticClientScenarioState(std::move(transport));
 			}, "Optimistic", configuration_);
 		GameStateManager::ApplyState(game_state);
 	}
@@ -10,9 +10,11 @@
 #include "ConnectingMenuState.h"
 #include "GameStateManager.h"
 #include "PacketSerializer.h"
+#include "NetworkThread.h"
+#include "NetworkConditionTransport.h"
 
-const int kNetwork_Buffer_Size = 1024;
-const float kConnecting_Timeout_Secs = 3.0f;
+const float kFirstRetry_Secs = 0.04f; // a lost datagram is the likeliest reason for no response, so the first retry is soon
+const float kLongestRetry_Secs = 3.0f; // retries back off to this, so a host that is not up yet is not flooded
 
 
 ConnectingMenuState::ConnectingMenuState(NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator, std::string game_type, ClientConfiguration configuration)
@@ -20,14 +22,14 @@ ConnectingMenuState::ConnectingMenuState(NetworkedScenarioState::NetworkedScenar
 	  game_type_(game_type),
 	  configuration_(configuration),
 	  connecting_socket_(INVALID_SOCKET),
-	  connecting_timer_secs_(kConnecting_Timeout_Secs)
+	  connecting_timer_secs_(kFirstRetry_Secs),
+	  retry_interval_secs_(kFirstRetry_Secs),
+	  cookie_()
 {
 	operation_description_ = "Connecting to ";
 	operation_description_ += std::to_string(configuration_.game_port);
 	operation_description_ += ", waiting for response from host...  ";
 
-	network_buffer_ = new char[kNetwork_Buffer_Size];
-
 	// create a UDP socket for connecting to a scenario host
 	connecting_socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	if ((connecting_socket_ == INVALID_SOCKET) &&
@@ -63,15 +65,18 @@ ConnectingMenuState::ConnectingMenuState(NetworkedScenarioState::NetworkedScenar
 		return;
 	}
 
+	// a host on this machine can skip the socket entirely
+	if (configuration_.is_shared_memory_allowed)
+	{
+		shared_memory_ = SharedMemoryTransport::Create();
+	}
+
 	// send the initial connection request
 	SendConnectionRequest();
 }
 
 
-ConnectingMenuState::~ConnectingMenuState()
-{
-	delete[] network_buffer_;
-}
+ConnectingMenuState::~ConnectingMenuState() = default;
 
 
 void ConnectingMenuState::Update()
@@ -90,17 +95,18 @@ void ConnectingMenuState::Update()
 		return;
 	}
 
-	// reduce the timer by CP_System_GetDt(), and if expired, give up and move on to Hosting
+	// reduce the timer by CP_System_GetDt(), and if expired, try again, waiting twice as long for a response
 	connecting_timer_secs_ -= CP_System_GetDt();
 	if (connecting_timer_secs_ <= 0.0f)
 	{		
 		std::cout << "Timeout waiting for a response from a server on port " << configuration_.game_port << ", attempting to connect again..." << std::endl;
 		SendConnectionRequest();
-		connecting_timer_secs_ = kConnecting_Timeout_Secs;
+		retry_interval_secs_ = std::min(2.0f * retry_interval_secs_, kLongestRetry_Secs);
+		connecting_timer_secs_ = retry_interval_secs_;
 	}
 
 	// attempt to receive a response from a hosting server
-	const auto res = recv(connecting_socket_, network_buffer_, kNetwork_Buffer_Size, 0);
+	const auto res = recv(connecting_socket_, network_buffer_, kMaxDatagramSize, 0);
 	if ((res == SOCKET_ERROR) &&
 		HandleSocketError("Error receiving on connection socket: "))
 	{
@@ -110,16 +116,45 @@ void ConnectingMenuState::Update()
 	// if any bytes are received, then check the response, and determine if we are accepted
 	if (res > 0)
 	{
-		std::string server_response;
+		std::string_view server_response;
 		Packet packet = Packet(network_buffer_, res);
-		PacketSerializer::ReadString(packet, server_response);
-		std::cout << "Received a response from a server on port " << configuration_.game_port << ", which was: " << server_response.c_str() << std::endl;
+		PacketSerializer::ReadStringView(packet, server_response);
+		std::cout << "Received a response from a server on port " << configuration_.game_port << ", which was: " << server_response << std::endl;
 
+		// if the host wants proof that we are at this address, send the request again with its cookie, right away
+		if (server_response == ConnectionCookie::kChallengeResponse)
+		{
+			if (cookie_.Read(packet))
+			{
+				std::cout << "The host sent a cookie, so sending it back..." << std::endl;
+				SendConnectionRequest();
+				retry_interval_secs_ = kFirstRetry_Secs;
+				connecting_timer_secs_ = retry_interval_secs_;
+			}
+		}
 		// if it's the magic string, move on to the scenario
-		if (server_response == "LetUsBegin")
+		else if (server_response == "LetUsBegin")
 		{
 			std::cout << "Successfully connected, moving on to the " << game_type_.c_str() << " scenario..." << std::endl;
-			auto* game_state = scenario_state_creator_(connecting_socket_, false);
+			// the host says so if it opened our shared memory, in which case the socket is no longer needed
+			std::string_view transport_response;
+			std::unique_ptr<DatagramTransport> transport;
+			if ((shared_memory_ != nullptr) && PacketSerializer::ReadStringView(packet, transport_response) &&
+				(transport_response == SharedMemoryTransport::kAcceptResponse))
+			{
+				std::cout << "The host is on this machine, so the scenario uses shared memory rather than UDP" << std::endl;
+				closesocket(connecting_socket_);
+				connecting_socket_ = INVALID_SOCKET;
+				transport = std::move(shared_memory_);
+			}
+			else
+			{
+				// the scenario's network thread owns the socket from here on
+				transport = std::make_unique<NetworkThread>(connecting_socket_);
+			}
+			// -- either way, seen through any simulated conditions
+			transport = NetworkConditionTransport::Wrap(std::move(transport), configuration_.network_conditions);
+			auto* game_state = scenario_state_creator_(std::move(transport), false);
 			GameStateManager::ApplyState(game_state);
 		}
 		else
@@ -149,8 +184,15 @@ void ConnectingMenuState::Draw()
 void ConnectingMenuState::SendConnectionRequest()
 {
 	//NOTE: in Assignment 4, we send more values here...
-	Packet packet = Packet(network_buffer_, kNetwork_Buffer_Size);
+	Packet packet = Packet(network_buffer_, kMaxDatagramSize);
 	PacketSerializer::WriteString(packet, game_type_);
+	cookie_.Write(packet);
+	if (shared_memory_ != nullptr)
+	{
+		shared_memory_->WriteRequest(packet);
+	}
+	// -- the host only answers a request at least as large as its challenge
+	ConnectionCookie::PadRequest(packet);
 	
 	// send the scenario-specific challenge message to the server, hoping for a response
 	const auto res = send(connecting_socket_, packet.GetRoot(), packet.GetUsedSpace(), 0);
@@ -10,7 +10,10 @@
 #pragma once
 #include "GameState.h"
 #include "NetworkedScenarioState.h"
+#include "Packet.h"
 #include "ClientConfiguration.h"
+#include "ConnectionCookie.h"
+#include "SharedMemoryTransport.h"
 
 
 /// <summary>
@@ -36,8 +39,14 @@ private:
     ClientConfiguration configuration_;
 
     SOCKET connecting_socket_;
+    // offered to the host in every connection request, and used instead of the socket if the host accepts it
+    std::unique_ptr<SharedMemoryTransport> shared_memory_;
     float connecting_timer_secs_;
-    char* network_buffer_;
+    // doubles with every retry that goes unanswered
+    float retry_interval_secs_;
+    // empty until the host challenges us, then sent back in every request
+    ConnectionCookie cookie_;
+    char network_buffer_[kMaxDatagramSize];
 
     std::string operation_description_;
 };
\ No newline at end of file
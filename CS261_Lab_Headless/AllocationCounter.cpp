@@ -0,0 +1,75 @@
+//---------------------------------------------------------
+// file:	AllocationCounter.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Counts every heap allocation made through operator new, for checks that a code path makes none.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+namespace
+{
+	std::atomic<unsigned long long> allocation_count(0);
+}
+
+
+unsigned long long AllocationCounter::GetCount()
+{
+	return allocation_count.load(std::memory_order_relaxed);
+}
+
+
+// the array and nothrow forms all allocate through these two
+void* operator new(const std::size_t size)
+{
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (auto* memory = malloc((size != 0) ? size : 1))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	// aligned_alloc needs the size to be a multiple of the alignment
+	const auto align = static_cast<std::size_t>(alignment);
+	if (auto* memory = aligned_alloc(align, (size + align - 1) / align * align))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	free(memory);
+}
+
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	free(memory);
+}
+
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+	free(memory);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+//---------------------------------------------------------
+// file:	AllocationCounter.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Counts every heap allocation made through operator new, for checks that a code path makes none.
+//
+// remarks: The headless build replaces the global operator new with one that counts, then allocates as usual,
+//          so the count covers the standard library containers as well as the lab's own news.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+
+
+namespace AllocationCounter
+{
+	// the allocations made so far, on any thread
+	unsigned long long GetCount();
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+//---------------------------------------------------------
+// file:	BatchBench.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Times sending and receiving datagrams over loopback UDP, one system call each and batched with DatagramBatch.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "Bench.h"
+#include <fcntl.h>
+#include <iomanip>
+#include <unistd.h>
+#include "DatagramBatch.h"
+
+const unsigned int kDatagramSize = 48; // about the size of an optimistic state datagram
+const unsigned int kBurstSize = 2048; // datagrams sent, then drained, per round
+const unsigned int kRoundCount = 200; // rounds per variant; the rates are the median round's
+const int kSocketBufferSize = 16 << 20; // large enough to hold a whole burst, so none are dropped
+
+
+namespace
+{
+	/// <summary>
+	/// A receiving socket bound to an ephemeral loopback port, and a sending socket connected to it.
+	/// </summary>
+	struct SocketPair
+	{
+		SocketPair()
+		{
+			receiver = socket(AF_INET, SOCK_DGRAM, 0);
+			sender = socket(AF_INET, SOCK_DGRAM, 0);
+			setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &kSocketBufferSize, sizeof(kSocketBufferSize));
+			setsockopt(sender, SOL_SOCKET, SO_SNDBUF, &kSocketBufferSize, sizeof(kSocketBufferSize));
+			SOCKADDR_IN address = {};
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			socklen_t address_size = sizeof(address);
+			is_valid = (receiver >= 0) && (sender >= 0) &&
+				(bind(receiver, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) &&
+				(getsockname(receiver, reinterpret_cast<sockaddr*>(&address), &address_size) == 0) &&
+				(connect(sender, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) &&
+				(fcntl(receiver, F_SETFL, O_NONBLOCK) == 0);
+		}
+
+		~SocketPair()
+		{
+			close(receiver);
+			close(sender);
+		}
+
+		int receiver;
+		int sender;
+		bool is_valid;
+	};
+
+
+	/// <summary>
+	/// Send bursts of datagrams, then drain them, timing each side in CPU time.
+	/// </summary>
+	/// <returns>If false, the sockets could not be set up, or datagrams went missing.</returns>
+	bool TimeBursts(const char* name, const bool is_batched)
+	{
+		SocketPair sockets;
+		if (!sockets.is_valid)
+		{
+			std::cerr << "Could not set up a loopback socket pair" << std::endl;
+			return false;
+		}
+
+		DatagramBatch batch;
+		char buffer[kMaxDatagramSize] = { 1 };
+		unsigned long long sent_count = 0, received_count = 0;
+		std::vector<double> send_rates, receive_rates;
+		for (auto round = 0u; round < kRoundCount; ++round)
+		{
+			unsigned int round_sent = 0, round_received = 0;
+			const auto send_start = Bench::GetThreadCpuSecs();
+			if (is_batched)
+			{
+				while (round_sent < kBurstSize)
+				{
+					while (!batch.IsFull())
+					{
+						memcpy(batch.GetNextBuffer(), buffer, kDatagramSize);
+						batch.Push(kDatagramSize);
+					}
+					const auto result = batch.Send(sockets.sender);
+					round_sent += DatagramBatch::kMaxDatagrams;
+					sent_count += (result > 0) ? result : 0;
+				}
+			}
+			else
+			{
+				for (; round_sent < kBurstSize; ++round_sent)
+				{
+					sent_count += (send(sockets.sender, buffer, kDatagramSize, 0) > 0) ? 1 : 0;
+				}
+			}
+
+			const auto receive_start = Bench::GetThreadCpuSecs();
+			if (is_batched)
+			{
+				int result;
+				while ((result = batch.Receive(sockets.receiver)) > 0)
+				{
+					round_received += result;
+				}
+			}
+			else
+			{
+				while (recv(sockets.receiver, buffer, sizeof(buffer), 0) > 0)
+				{
+					++round_received;
+				}
+			}
+			const auto receive_end = Bench::GetThreadCpuSecs();
+			received_count += round_received;
+			send_rates.push_back(round_sent / (receive_start - send_start));
+			receive_rates.push_back(round_received / (receive_end - receive_start));
+		}
+
+		std::cout << "  " << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(0) <<
+			"send " << std::setw(6) << Bench::GetMedian(send_rates) / 1e3 << "k/core-s   receive " << std::setw(6) << Bench::GetMedian(receive_rates) / 1e3 << "k/core-s   (" <<
+			received_count << "/" << sent_count << " received)" << std::endl;
+		if (received_count != sent_count)
+		{
+			std::cerr << name << ": " << (sent_count - received_count) << " datagrams were lost on loopback" << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
+
+
+/// <summary>
+/// Compare sending and receiving one datagram per system call against batches of DatagramBatch::kMaxDatagrams.
+/// </summary>
+bool Bench::RunBatch(int, char**)
+{
+	std::cout << "Loopback UDP, " << kDatagramSize << "-byte datagrams in bursts of " << kBurstSize << ", median of " << kRoundCount << " rounds, thousands of datagrams per core-second:" << std::endl;
+	const auto is_unbatched_passed = TimeBursts("unbatched", false);
+	const auto is_batched_passed = TimeBursts("batched", true);
+	return is_unbatched_passed && is_batched_passed;
+}
\ No newline at end of file
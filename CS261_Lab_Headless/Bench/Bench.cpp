@@ -0,0 +1,114 @@
+//---------------------------------------------------------
+// file:	Bench.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Entry point for the benchmarks, and the measurements they share.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "Bench.h"
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+
+namespace
+{
+	/// <summary>
+	/// A benchmark, as named on the command line.
+	/// </summary>
+	struct Benchmark
+	{
+		const char* name;
+		bool (*run)(int argc, char** argv);
+		const char* usage;
+	};
+
+	const Benchmark kBenchmarks[] = {
+		{ "serialize", Bench::RunSerialize, "serialize                  encode and decode messages, per field, with a schema cursor, and with reinterpret_cast" },
+		{ "batch", Bench::RunBatch, "batch                      send and receive datagrams over loopback UDP, one system call each and with recvmmsg/sendmmsg" },
+		{ "load", Bench::RunLoad, "load [client count...]     run optimistic clients against a headless server, 1/100/500 by default, and time its CPU" },
+		{ "workers", Bench::RunWorkers, "workers [client count]     run optimistic clients, 500 by default, against a headless server with 1, 2, and 4 workers" },
+		{ "transports", Bench::RunTransports, "transports [client count]  run optimistic clients, 100 by default, against a headless server over UDP, then over shared memory" },
+		{ "handshake", Bench::RunHandshake, "handshake [client count]   connect optimistic clients, 200 by default, and time each to its first state, under no flood, junk, and forged cookies" },
+		{ "shm", Bench::RunSharedMemory, "shm                        bounce a datagram between two processes over shared memory and loopback UDP, and time it" },
+		{ "recv", Bench::RunReceive, "recv [--recv=backend]      receive a flood and a trickle of datagrams with each receive backend and with polling recv" },
+	};
+}
+
+
+/// <summary>
+/// The CPU time this thread has used, so that a benchmark is not charged for time it spent descheduled.
+/// </summary>
+double Bench::GetThreadCpuSecs()
+{
+	timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+
+/// <summary>
+/// The CPU time another process has used, in user and kernel mode, read from /proc.
+/// </summary>
+/// <returns>The seconds used, or 0 if the process could not be read.</returns>
+double Bench::GetProcessCpuSecs(const int pid)
+{
+	std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+	std::string line;
+	if (!std::getline(stat, line) || (line.rfind(')') == std::string::npos))
+	{
+		return 0.0;
+	}
+
+	// the fields after the command name, which may itself contain spaces, start with the state (field 3)
+	std::istringstream fields(line.substr(line.rfind(')') + 2));
+	std::vector<std::string> values;
+	std::string value;
+	while (fields >> value)
+	{
+		values.push_back(value);
+	}
+	// utime and stime are fields 14 and 15
+	if (values.size() < 13)
+	{
+		return 0.0;
+	}
+	return (std::stod(values[11]) + std::stod(values[12])) / sysconf(_SC_CLK_TCK);
+}
+
+
+double Bench::GetMedian(std::vector<double> samples)
+{
+	if (samples.empty())
+	{
+		return 0.0;
+	}
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+
+int main(const int argc, char** argv)
+{
+	if (argc > 1)
+	{
+		for (const auto& benchmark : kBenchmarks)
+		{
+			if (strcmp(argv[1], benchmark.name) == 0)
+			{
+				return benchmark.run(argc, argv) ? 0 : 1;
+			}
+		}
+	}
+
+	std::cerr << "Usage: CS261_Lab_Bench <benchmark> [arguments], where the benchmark is one of:" << std::endl;
+	for (const auto& benchmark : kBenchmarks)
+	{
+		std::cerr << "  " << benchmark.usage << std::endl;
+	}
+	return 1;
+}
\ No newline at end of file
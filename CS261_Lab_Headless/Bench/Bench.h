@@ -0,0 +1,59 @@
+//---------------------------------------------------------
+// file:	Bench.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Benchmarks for the lab's networking code, built and run by "make bench" in CS261_Lab_Headless.
+//
+// remarks: Usage: CS261_Lab_Bench <benchmark> [arguments]; run it with no arguments for the list.
+//          Each benchmark prints a line per variant it compares.  Timings are the median of kRepeats runs,
+//          so they are steadiest on an otherwise idle machine, and are only comparable within one run.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+
+namespace Bench
+{
+	using Clock = std::chrono::steady_clock;
+
+	// each timing is the median of this many runs
+	const unsigned int kRepeats = 5;
+
+	double GetThreadCpuSecs();
+	double GetProcessCpuSecs(int pid);
+	double GetMedian(std::vector<double> samples);
+
+	/// <summary>
+	/// Call run(i) for i in [0, count), kRepeats times over, and return the median nanoseconds per call.
+	/// </summary>
+	template <typename Run>
+	double TimePerCall(const unsigned int count, Run&& run)
+	{
+		std::vector<double> samples;
+		for (auto repeat = 0u; repeat < kRepeats; ++repeat)
+		{
+			const auto start = Clock::now();
+			for (auto i = 0u; i < count; ++i)
+			{
+				run(i);
+			}
+			samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count);
+		}
+		return GetMedian(std::move(samples));
+	}
+
+	bool RunSerialize(int argc, char** argv);
+	bool RunBatch(int argc, char** argv);
+	bool RunLoad(int argc, char** argv);
+	bool RunWorkers(int argc, char** argv);
+	bool RunTransports(int argc, char** argv);
+	bool RunHandshake(int argc, char** argv);
+	bool RunSharedMemory(int argc, char** argv);
+	bool RunReceive(int argc, char** argv);
+}
\ No newline at end of file
@@ -0,0 +1,710 @@
+//---------------------------------------------------------
+// file:	LoadBench.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Runs many optimistic clients against a headless server, and times the server's CPU per session.
+//
+// remarks: Usage: CS261_Lab_Bench load [client count...]
+//                 CS261_Lab_Bench workers [client count]
+//                 CS261_Lab_Bench transports [client count]
+//                 CS261_Lab_Bench handshake [client count]
+//          For each run, the headless server built alongside the bench is started on a port of its own,
+//          from kFirstServerPort, and every client connects to it, cookie and all, then runs a real OptimisticClientScenarioState
+//          at 30 ticks per second.  The server's CPU time is read from /proc, so the clients' own time is not counted.
+//          "load" varies the client count against one worker; "workers" varies the workers under one client count;
+//          "transports" runs one client count over UDP, then with each client offering the server shared memory.
+//          "handshake" connects clients at once, retrying as ConnectingMenuState does, and times each to its first state,
+//          with no flood, then under a flood of junk datagrams, then of requests with forged cookies.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "Bench.h"
+#include <atomic>
+#include <csignal>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ConnectionCookie.h"
+#include "OptimisticClientScenarioState.h"
+#include "PacketSerializer.h"
+#include "SharedMemoryTransport.h"
+
+// away from the lab's default port, so a server left running there is not measured
+// -- each run takes the next port, as the last server's socket may outlive it briefly, while the kernel tears down its ring
+const unsigned short kFirstServerPort = 4261;
+const unsigned int kDefaultClientCounts[] = { 1, 100, 500 }; // the client counts "load" runs when none are given
+const unsigned int kWorkerCounts[] = { 1, 2, 4 }; // the worker counts "workers" runs
+const unsigned int kDefaultWorkerClientCount = 500; // the client count "workers" runs when none is given
+const unsigned int kDefaultTransportClientCount = 100; // the client count "transports" runs when none is given
+const auto kTick = std::chrono::microseconds(33333); // the clients run at the lab's 30 ticks per second
+const auto kRetry = std::chrono::seconds(1); // how often a client without an answer asks again
+const auto kConnectTimeout = std::chrono::seconds(10); // clients still unanswered by then are left out
+const auto kWarmUp = std::chrono::seconds(2); // run before measuring, so every session is past its first states
+const auto kMeasure = std::chrono::seconds(10); // the measured run
+const unsigned int kPoolSize = 4096; // the buffers shared by every client's received datagrams
+const unsigned int kDefaultHandshakeClientCount = 200; // the client count "handshake" runs when none is given
+const auto kFirstRetry = std::chrono::milliseconds(40); // "handshake" clients retry after this, doubling, as ConnectingMenuState does
+const auto kLongestRetry = std::chrono::seconds(3);
+const auto kHandshakePoll = std::chrono::milliseconds(1); // how often "handshake" clients look for answers
+const auto kHeadStart = std::chrono::milliseconds(500); // the server and the flood start this long before the clients
+const unsigned int kFloodSocketCount = 64; // the flood is spread over this many ports, as from many peers
+const unsigned int kFloodBatchSize = 32; // datagrams per sendmmsg in the flood
+const unsigned int kFloodBatchesPerPause = 8; // the flood pauses after this many batches, so it does not starve the clients of the core
+const auto kFloodPause = std::chrono::microseconds(100);
+
+
+namespace
+{
+	/// <summary>
+	/// A connected socket read and written on the caller's thread, so hundreds of clients need no threads of their own.
+	/// </summary>
+	class DirectTransport : public DatagramTransport
+	{
+	public:
+		DirectTransport(const SOCKET socket, PacketBufferPool& pool) : socket_(socket), pool_(pool) {}
+		~DirectTransport() override { Stop(); }
+
+		bool Send(const Packet& packet) override
+		{
+			return send(socket_, packet.GetRoot(), packet.GetUsedSpace(), 0) != SOCKET_ERROR;
+		}
+
+		bool Receive(ReceivedDatagram& datagram) override
+		{
+			datagram.buffer = pool_.Acquire();
+			if (!datagram.buffer.IsValid())
+			{
+				return false;
+			}
+			const auto res = recv(socket_, datagram.buffer.GetData(), kMaxDatagramSize, 0);
+			if (res <= 0)
+			{
+				datagram.buffer.Reset();
+				return false;
+			}
+			datagram.buffer.SetSize(res);
+			datagram.arrival_time = Clock::now();
+			return true;
+		}
+
+		void Stop() override
+		{
+			if (socket_ != INVALID_SOCKET)
+			{
+				closesocket(socket_);
+				socket_ = INVALID_SOCKET;
+			}
+		}
+
+		unsigned int GetOverflowCount() const override { return 0; }
+
+	private:
+		SOCKET socket_;
+		PacketBufferPool& pool_;
+	};
+
+
+	/// <summary>
+	/// A client connecting to the server, then running its scenario.
+	/// </summary>
+	struct LoadClient
+	{
+		SOCKET socket = INVALID_SOCKET;
+		ConnectionCookie cookie = {};
+		std::unique_ptr<SharedMemoryTransport> shared_memory; // offered to the server, if the run offers it
+		bool is_shared_memory_accepted = false;
+		std::unique_ptr<OptimisticClientScenarioState> scenario;
+	};
+
+
+	/// <summary>
+	/// Send the connection request, with the cookie the server gave, if it has given one yet, and any shared memory offered.
+	/// </summary>
+	void SendConnectionRequest(const LoadClient& client)
+	{
+		char buffer[kMaxDatagramSize];
+		Packet packet(buffer, sizeof(buffer));
+		PacketSerializer::WriteString(packet, "Optimistic");
+		client.cookie.Write(packet);
+		if (client.shared_memory != nullptr)
+		{
+			client.shared_memory->WriteRequest(packet);
+		}
+		ConnectionCookie::PadRequest(packet);
+		send(client.socket, packet.GetRoot(), packet.GetUsedSpace(), 0);
+	}
+
+
+	/// <summary>
+	/// Take the server's answer, if any: send the request again with a cookie, or start the scenario.
+	/// </summary>
+	/// <returns>If true, the client was accepted, and its scenario has started.</returns>
+	bool ReceiveConnectionResponse(LoadClient& client, PacketBufferPool& pool)
+	{
+		char buffer[kMaxDatagramSize];
+		const auto res = recv(client.socket, buffer, sizeof(buffer), 0);
+		if (res <= 0)
+		{
+			return false;
+		}
+
+		Packet packet(buffer, res);
+		std::string_view response;
+		if (!PacketSerializer::ReadStringView(packet, response))
+		{
+			return false;
+		}
+		if (response == ConnectionCookie::kChallengeResponse)
+		{
+			if (client.cookie.Read(packet))
+			{
+				SendConnectionRequest(client);
+			}
+			return false;
+		}
+		if (response != "LetUsBegin")
+		{
+			return false;
+		}
+
+		// as in ConnectingMenuState, the socket is closed if the server opened the shared memory
+		std::string_view transport_response;
+		std::unique_ptr<DatagramTransport> transport;
+		if ((client.shared_memory != nullptr) && PacketSerializer::ReadStringView(packet, transport_response) &&
+			(transport_response == SharedMemoryTransport::kAcceptResponse))
+		{
+			closesocket(client.socket);
+			client.socket = INVALID_SOCKET;
+			client.is_shared_memory_accepted = true;
+			transport = std::move(client.shared_memory);
+		}
+		else
+		{
+			transport = std::make_unique<DirectTransport>(client.socket, pool);
+		}
+		client.scenario = std::make_unique<OptimisticClientScenarioState>(std::move(transport));
+		return true;
+	}
+
+
+	/// <summary>
+	/// How to start the headless server for one run.
+	/// </summary>
+	struct ServerRun
+	{
+		std::string path; // the server built alongside the bench
+		unsigned short port;
+		unsigned int worker_count;
+		std::string output_path; // where the server's output goes, or empty to discard it
+	};
+
+
+	/// <summary>
+	/// Start the headless server, with its output written to the run's output path, or discarded.
+	/// </summary>
+	/// <returns>The server's process ID, or -1 if it could not be started.</returns>
+	int StartServer(const ServerRun& server)
+	{
+		const auto pid = fork();
+		if (pid == 0)
+		{
+			const auto output = open(server.output_path.empty() ? "/dev/null" : server.output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+			dup2(output, STDOUT_FILENO);
+			const auto port = std::to_string(server.port);
+			const auto worker_count = std::to_string(server.worker_count);
+			execl(server.path.c_str(), server.path.c_str(), port.c_str(), "Optimistic", worker_count.c_str(), static_cast<char*>(nullptr));
+			_exit(127);
+		}
+		return pid;
+	}
+
+
+	/// <summary>
+	/// Update every client's scenario once per tick, until the given time has passed.
+	/// </summary>
+	void RunClients(std::vector<LoadClient>& clients, const Bench::Clock::duration duration)
+	{
+		auto next_tick = Bench::Clock::now();
+		const auto end = next_tick + duration;
+		while (next_tick < end)
+		{
+			for (auto& client : clients)
+			{
+				if (client.scenario != nullptr)
+				{
+					client.scenario->Update();
+				}
+			}
+			next_tick += kTick;
+			std::this_thread::sleep_until(next_tick);
+		}
+	}
+
+
+	/// <summary>
+	/// Connect the given number of clients to a fresh server, run them, and report what the server spent on them.
+	/// </summary>
+	/// <returns>If false, the server could not be started, or no client was accepted.</returns>
+	bool TimeLoad(const char* name, const ServerRun& server, const unsigned int client_count, const bool is_shared_memory_offered = false)
+	{
+		const auto server_pid = StartServer(server);
+		if (server_pid < 0)
+		{
+			std::cerr << "Could not start " << server.path << std::endl;
+			return false;
+		}
+
+		SOCKADDR_IN server_address = {};
+		server_address.sin_family = AF_INET;
+		server_address.sin_port = htons(server.port);
+		server_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		PacketBufferPool pool(kPoolSize);
+		std::vector<LoadClient> clients(client_count);
+		for (auto& client : clients)
+		{
+			client.socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+			u_long nonblocking = 1;
+			ioctlsocket(client.socket, FIONBIO, &nonblocking);
+			connect(client.socket, reinterpret_cast<SOCKADDR*>(&server_address), sizeof(server_address));
+			if (is_shared_memory_offered)
+			{
+				client.shared_memory = SharedMemoryTransport::Create();
+			}
+		}
+
+		// the server may not be up yet, so every client asks again until it is answered
+		unsigned int accepted_count = 0;
+		const auto connect_deadline = Bench::Clock::now() + kConnectTimeout;
+		auto next_retry = Bench::Clock::now();
+		while ((accepted_count < client_count) && (Bench::Clock::now() < connect_deadline))
+		{
+			const auto is_retrying = Bench::Clock::now() >= next_retry;
+			if (is_retrying)
+			{
+				next_retry += kRetry;
+			}
+			for (auto& client : clients)
+			{
+				if (client.scenario != nullptr)
+				{
+					client.scenario->Update();
+					continue;
+				}
+				if (is_retrying)
+				{
+					SendConnectionRequest(client);
+				}
+				if (ReceiveConnectionResponse(client, pool))
+				{
+					++accepted_count;
+				}
+			}
+			std::this_thread::sleep_for(kTick);
+		}
+
+		RunClients(clients, kWarmUp);
+		std::vector<unsigned int> drained_before;
+		for (const auto& client : clients)
+		{
+			drained_before.push_back((client.scenario != nullptr) ? client.scenario->GetReceiveStats().datagrams_drained : 0);
+		}
+		const auto cpu_before = Bench::GetProcessCpuSecs(server_pid);
+		const auto start = Bench::Clock::now();
+		RunClients(clients, kMeasure);
+		const auto wall_secs = std::chrono::duration<double>(Bench::Clock::now() - start).count();
+		const auto cpu_secs = Bench::GetProcessCpuSecs(server_pid) - cpu_before;
+
+		kill(server_pid, SIGTERM);
+		waitpid(server_pid, nullptr, 0);
+
+		// the states each accepted client received per second, on average and at the least
+		double total_states = 0.0;
+		auto min_states = std::numeric_limits<unsigned int>::max();
+		unsigned int shared_memory_count = 0;
+		for (unsigned int i = 0; i < client_count; ++i)
+		{
+			if (clients[i].scenario != nullptr)
+			{
+				shared_memory_count += clients[i].is_shared_memory_accepted ? 1 : 0;
+				const auto states = clients[i].scenario->GetReceiveStats().datagrams_drained - drained_before[i];
+				total_states += states;
+				min_states = std::min(min_states, states);
+			}
+		}
+		if (accepted_count == 0)
+		{
+			std::cerr << "No client was accepted by the server on port " << server.port << std::endl;
+			return false;
+		}
+
+		std::cout << "  " << std::left << std::setw(12) << name << std::right << std::setw(4) << accepted_count << "/" << std::left << std::setw(4) << client_count << std::right << std::fixed <<
+			std::setprecision(1) << std::setw(6) << 100.0 * cpu_secs / wall_secs << "% of a core" <<
+			std::setprecision(3) << std::setw(9) << 1000.0 * cpu_secs / wall_secs / accepted_count << " ms/s per session" <<
+			std::setprecision(1) << std::setw(7) << total_states / accepted_count / wall_secs << " states/s per client (min " <<
+			min_states / wall_secs << ")" << std::endl;
+		if (is_shared_memory_offered)
+		{
+			std::cout << "      " << shared_memory_count << " of them over shared memory" << std::endl;
+		}
+		return true;
+	}
+
+
+	/// <summary>
+	/// What floods the server while "handshake" clients connect.
+	/// </summary>
+	enum class Flood
+	{
+		None,
+		Junk, // random bytes
+		Forged, // connection requests, with random cookies
+	};
+
+
+	/// <summary>
+	/// Flood the server from a child process, counting what was sent, until it is killed.
+	/// </summary>
+	/// <remarks>A flood from forged source addresses needs raw sockets, so this one comes from real ports.</remarks>
+	/// <returns>The flood's process ID, or 0 if there is no flood.</returns>
+	int StartFlood(const SOCKADDR_IN& server_address, const Flood flood, std::atomic<unsigned long long>& sent_count)
+	{
+		if (flood == Flood::None)
+		{
+			return 0;
+		}
+		const auto pid = fork();
+		if (pid != 0)
+		{
+			return pid;
+		}
+
+		SOCKET sockets[kFloodSocketCount];
+		for (auto& flood_socket : sockets)
+		{
+			flood_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+			connect(flood_socket, reinterpret_cast<const SOCKADDR*>(&server_address), sizeof(server_address));
+		}
+		std::mt19937 random;
+		char datagrams[kFloodBatchSize][64];
+		mmsghdr headers[kFloodBatchSize] = {};
+		iovec vectors[kFloodBatchSize];
+		for (auto batch = 0u; ; ++batch)
+		{
+			for (auto i = 0u; i < kFloodBatchSize; ++i)
+			{
+				Packet packet(datagrams[i], sizeof(datagrams[i]));
+				if (flood == Flood::Junk)
+				{
+					const auto size = 8 + random() % (sizeof(datagrams[i]) - 8);
+					for (auto j = 0u; j < size; ++j)
+					{
+						datagrams[i][j] = static_cast<char>(random());
+					}
+					packet.Advance(size);
+				}
+				else
+				{
+					const ConnectionCookie cookie = { static_cast<uint32_t>(random()), (static_cast<unsigned long long>(random()) << 32) | random() };
+					PacketSerializer::WriteString(packet, "Optimistic");
+					cookie.Write(packet);
+					ConnectionCookie::PadRequest(packet);
+				}
+				vectors[i] = { datagrams[i], packet.GetUsedSpace() };
+				headers[i].msg_hdr.msg_iov = &vectors[i];
+				headers[i].msg_hdr.msg_iovlen = 1;
+			}
+			const auto sent = sendmmsg(sockets[batch % kFloodSocketCount], headers, kFloodBatchSize, 0);
+			sent_count += (sent > 0) ? sent : 0;
+			if ((batch % kFloodBatchesPerPause) == 0)
+			{
+				std::this_thread::sleep_for(kFloodPause);
+			}
+		}
+	}
+
+
+	/// <summary>
+	/// A client connecting with backoff, as ConnectingMenuState does, timed until its scenario receives a state.
+	/// </summary>
+	struct HandshakeClient
+	{
+		LoadClient load;
+		Bench::Clock::time_point start;
+		Bench::Clock::time_point next_retry;
+		Bench::Clock::duration retry_interval = kFirstRetry;
+		unsigned int request_count = 0;
+		bool has_first_state = false;
+		double first_state_msecs = 0.0;
+	};
+
+
+	/// <summary>
+	/// Start a fresh server, under the flood, connect the clients, and report how long each took to its first state.
+	/// </summary>
+	/// <returns>If false, the server could not be started, or no client received a state.</returns>
+	bool TimeHandshake(const char* name, const ServerRun& server, const unsigned int client_count, const Flood flood)
+	{
+		const auto server_pid = StartServer(server);
+		if (server_pid < 0)
+		{
+			std::cerr << "Could not start " << server.path << std::endl;
+			return false;
+		}
+
+		SOCKADDR_IN server_address = {};
+		server_address.sin_family = AF_INET;
+		server_address.sin_port = htons(server.port);
+		server_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		// the flood's count is shared with it, so it lives in memory both processes map
+		auto* flood_sent_count = static_cast<std::atomic<unsigned long long>*>(
+			mmap(nullptr, sizeof(std::atomic<unsigned long long>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+		new (flood_sent_count) std::atomic<unsigned long long>(0);
+		const auto flood_pid = StartFlood(server_address, flood, *flood_sent_count);
+		std::this_thread::sleep_for(kHeadStart);
+
+		PacketBufferPool pool(kPoolSize);
+		std::vector<HandshakeClient> clients(client_count);
+		const auto flood_before = flood_sent_count->load();
+		const auto cpu_before = Bench::GetProcessCpuSecs(server_pid);
+		const auto start = Bench::Clock::now();
+		for (auto& client : clients)
+		{
+			client.load.socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+			u_long nonblocking = 1;
+			ioctlsocket(client.load.socket, FIONBIO, &nonblocking);
+			connect(client.load.socket, reinterpret_cast<SOCKADDR*>(&server_address), sizeof(server_address));
+			client.start = Bench::Clock::now();
+			client.next_retry = client.start;
+		}
+
+		unsigned int first_state_count = 0;
+		while ((first_state_count < client_count) && (Bench::Clock::now() - start < kConnectTimeout))
+		{
+			for (auto& client : clients)
+			{
+				const auto now = Bench::Clock::now();
+				if (client.has_first_state)
+				{
+					continue;
+				}
+				if (client.load.scenario != nullptr)
+				{
+					client.load.scenario->Update();
+					if (client.load.scenario->GetReceiveStats().datagrams_drained > 0)
+					{
+						client.has_first_state = true;
+						client.first_state_msecs = std::chrono::duration<double, std::milli>(now - client.start).count();
+						++first_state_count;
+					}
+					continue;
+				}
+				if (now >= client.next_retry)
+				{
+					SendConnectionRequest(client.load);
+					++client.request_count;
+					client.next_retry = now + client.retry_interval;
+					client.retry_interval = std::min<Bench::Clock::duration>(2 * client.retry_interval, kLongestRetry);
+				}
+
+				// a cookie is sent straight back, and the backoff starts over, as in ConnectingMenuState
+				const auto cookie = client.load.cookie;
+				ReceiveConnectionResponse(client.load, pool);
+				if ((client.load.cookie.period != cookie.period) || (client.load.cookie.signature != cookie.signature))
+				{
+					++client.request_count;
+					client.retry_interval = kFirstRetry;
+					client.next_retry = now + client.retry_interval;
+				}
+			}
+			std::this_thread::sleep_for(kHandshakePoll);
+		}
+		const auto wall_secs = std::chrono::duration<double>(Bench::Clock::now() - start).count();
+		const auto cpu_secs = Bench::GetProcessCpuSecs(server_pid) - cpu_before;
+		const auto flood_count = flood_sent_count->load() - flood_before;
+
+		if (flood_pid > 0)
+		{
+			kill(flood_pid, SIGKILL);
+			waitpid(flood_pid, nullptr, 0);
+		}
+		munmap(flood_sent_count, sizeof(std::atomic<unsigned long long>));
+		kill(server_pid, SIGTERM);
+		waitpid(server_pid, nullptr, 0);
+
+		std::vector<double> first_state_msecs;
+		unsigned long long request_count = 0;
+		for (const auto& client : clients)
+		{
+			request_count += client.request_count;
+			if (client.has_first_state)
+			{
+				first_state_msecs.push_back(client.first_state_msecs);
+			}
+		}
+		if (first_state_msecs.empty())
+		{
+			std::cerr << "No client received a state from the server on port " << server.port << std::endl;
+			return false;
+		}
+		std::sort(first_state_msecs.begin(), first_state_msecs.end());
+		const auto percentile = [&](const double fraction)
+			{
+				return first_state_msecs[static_cast<size_t>(fraction * (first_state_msecs.size() - 1))];
+			};
+
+		std::cout << "  " << std::left << std::setw(8) << name << std::right << std::setw(4) << first_state_msecs.size() << "/" << std::left << std::setw(4) << client_count << std::right << std::fixed <<
+			std::setprecision(1) << std::setw(8) << percentile(0.5) << std::setw(8) << percentile(0.9) << std::setw(8) << percentile(1.0) << " ms" <<
+			std::setw(6) << static_cast<double>(request_count) / client_count << " requests each" <<
+			std::setprecision(0) << std::setw(9) << flood_count / wall_secs << " flood/s" <<
+			std::setprecision(1) << std::setw(6) << 100.0 * cpu_secs / wall_secs << "% of a core" << std::endl;
+		return true;
+	}
+
+
+	/// <summary>
+	/// Find the server that was built into the same directory as the bench.
+	/// </summary>
+	std::string GetServerPath(const char* bench_path)
+	{
+		const std::string path(bench_path);
+		return path.substr(0, path.find_last_of('/') + 1) + "CS261_Lab_Headless";
+	}
+}
+
+
+/// <summary>
+/// Time the headless server's CPU per session, at each client count given, or at 1, 100, and 500 clients.
+/// </summary>
+bool Bench::RunLoad(const int argc, char** argv)
+{
+	std::vector<unsigned int> client_counts;
+	for (auto i = 2; i < argc; ++i)
+	{
+		client_counts.push_back(static_cast<unsigned int>(atoi(argv[i])));
+	}
+	if (client_counts.empty())
+	{
+		client_counts.assign(std::begin(kDefaultClientCounts), std::end(kDefaultClientCounts));
+	}
+
+	std::cout << "Optimistic clients against a headless server with 1 worker, " << kMeasure.count() << "s per client count:" << std::endl;
+	std::cout << "  clients     accepted   server CPU     per session" << std::endl;
+	for (unsigned int i = 0; i < client_counts.size(); ++i)
+	{
+		const ServerRun server = { GetServerPath(argv[0]), static_cast<unsigned short>(kFirstServerPort + i), 1, "" };
+		const auto name = std::to_string(client_counts[i]);
+		if ((client_counts[i] == 0) || !TimeLoad(name.c_str(), server, client_counts[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/// <summary>
+/// Time the headless server under one client count, given or 500, with 1, 2, and 4 workers, and show each worker's tick report.
+/// </summary>
+/// <remarks>The workers share the machine's cores, so on a machine with fewer cores than workers, this measures what sharding costs, not what it gains.</remarks>
+bool Bench::RunWorkers(const int argc, char** argv)
+{
+	const auto client_count = (argc > 2) ? static_cast<unsigned int>(atoi(argv[2])) : kDefaultWorkerClientCount;
+	if (client_count == 0)
+	{
+		return false;
+	}
+
+	// the server's output is kept, for the tick report each worker logs
+	char output_path[] = "/tmp/CS261_Lab_Bench_XXXXXX";
+	const auto output = mkstemp(output_path);
+	if (output < 0)
+	{
+		std::cerr << "Could not create a file for the server's output" << std::endl;
+		return false;
+	}
+	close(output);
+
+	std::cout << client_count << " optimistic clients against a headless server, " << kMeasure.count() << "s per worker count, on " <<
+		std::thread::hardware_concurrency() << " cores:" << std::endl;
+	std::cout << "  workers     accepted   server CPU     per session" << std::endl;
+	auto is_timed = true;
+	for (unsigned int i = 0; is_timed && (i < std::size(kWorkerCounts)); ++i)
+	{
+		const ServerRun server = { GetServerPath(argv[0]), static_cast<unsigned short>(kFirstServerPort + i), kWorkerCounts[i], output_path };
+		const auto name = std::to_string(kWorkerCounts[i]);
+		is_timed = TimeLoad(name.c_str(), server, client_count);
+
+		// each worker's sessions and tick timing, as it last logged them
+		std::ifstream server_output(output_path);
+		std::vector<std::string> report(kWorkerCounts[i]);
+		std::string line;
+		while (std::getline(server_output, line))
+		{
+			unsigned int worker = 0;
+			if ((sscanf(line.c_str(), "Worker %u:", &worker) == 1) && (worker < report.size()))
+			{
+				report[worker] = line;
+			}
+		}
+		for (const auto& worker_line : report)
+		{
+			std::cout << "      " << worker_line << std::endl;
+		}
+	}
+	unlink(output_path);
+	return is_timed;
+}
+
+
+/// <summary>
+/// Time the headless server under one client count, given or 100, with every client on UDP, then with every client offering shared memory.
+/// </summary>
+bool Bench::RunTransports(const int argc, char** argv)
+{
+	const auto client_count = (argc > 2) ? static_cast<unsigned int>(atoi(argv[2])) : kDefaultTransportClientCount;
+	if (client_count == 0)
+	{
+		return false;
+	}
+
+	std::cout << client_count << " optimistic clients against a headless server with 1 worker, " << kMeasure.count() << "s per transport:" << std::endl;
+	std::cout << "  transport   accepted   server CPU     per session" << std::endl;
+	const ServerRun udp_server = { GetServerPath(argv[0]), kFirstServerPort, 1, "" };
+	const ServerRun shared_memory_server = { GetServerPath(argv[0]), static_cast<unsigned short>(kFirstServerPort + 1), 1, "" };
+	return TimeLoad("UDP", udp_server, client_count) &&
+		TimeLoad("shm", shared_memory_server, client_count, true);
+}
+
+
+/// <summary>
+/// Time how long clients, given or 200, take from their first request to their first state, with no flood and under each flood.
+/// </summary>
+bool Bench::RunHandshake(const int argc, char** argv)
+{
+	const auto client_count = (argc > 2) ? static_cast<unsigned int>(atoi(argv[2])) : kDefaultHandshakeClientCount;
+	if (client_count == 0)
+	{
+		return false;
+	}
+
+	std::cout << client_count << " optimistic clients connecting at once to a headless server with 1 worker:" << std::endl;
+	std::cout << "  flood   first state    p50     p90     max        requests          flood     server CPU" << std::endl;
+	const std::pair<const char*, Flood> floods[] = { { "none", Flood::None }, { "junk", Flood::Junk }, { "forged", Flood::Forged } };
+	for (unsigned int i = 0; i < std::size(floods); ++i)
+	{
+		const ServerRun server = { GetServerPath(argv[0]), static_cast<unsigned short>(kFirstServerPort + i), 1, "" };
+		if (!TimeHandshake(floods[i].first, server, client_count, floods[i].second))
+		{
+			return false;
+		}
+	}
+	return true;
+}
\ No newline at end of file
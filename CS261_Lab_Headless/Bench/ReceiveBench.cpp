@@ -0,0 +1,267 @@
+//---------------------------------------------------------
+// file:	ReceiveBench.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Times the receiving side of a loopback socket with each DatagramReceiver backend, and with polling recv.
+//
+// remarks: Usage: CS261_Lab_Bench recv [--recv=uring|epoll|select]
+//          A child process sends to the socket, as a flood of batches and then as a trickle of single datagrams,
+//          and the receiver's own CPU time per datagram is reported, with the mean time from send to receive,
+//          how many datagrams each wake found, and how many calls came back empty.  "poll" calls recv every
+//          kPollInterval until it would block, as each scenario did in its Update before the server waited on a receiver.
+//          The receiver stops after kIdleTimeout with nothing received, which is not counted as work.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "Bench.h"
+#include <fcntl.h>
+#include <iomanip>
+#include <memory>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "DatagramReceiver.h"
+
+const unsigned int kDatagramSize = 48; // about the size of an optimistic state datagram
+const unsigned int kFloodCount = 200000; // datagrams sent in the flood
+const unsigned int kFloodBatchSize = 32; // datagrams per sendmmsg in the flood
+const unsigned int kFloodPauseEvery = 1024; // the flood pauses briefly after this many datagrams, so the receiver is not simply overrun
+const auto kFloodPause = std::chrono::microseconds(50);
+const unsigned int kTrickleCount = 5000; // datagrams sent in the trickle, one at a time
+const auto kTrickleInterval = std::chrono::microseconds(100);
+const long kWait_Usecs = 1000; // the longest one Receive waits, as the server's thread does
+const auto kPollInterval = std::chrono::milliseconds(1); // how often "poll" drains the socket
+const auto kIdleTimeout = std::chrono::milliseconds(200); // the receiver stops after this long with nothing received
+const int kSocketBufferSize = 8 << 20; // large enough that the flood's pauses keep it from overflowing
+
+
+namespace
+{
+	/// <summary>
+	/// What one receiver saw of one workload.
+	/// </summary>
+	struct ReceiveCounts
+	{
+		unsigned long long datagram_count = 0;
+		unsigned long long wake_count = 0; // waits or polls that found at least one datagram
+		unsigned long long empty_count = 0; // calls that found none
+		double cpu_secs = 0.0;
+		double delay_secs = 0.0; // summed over every datagram, from the time its sender stamped on it
+
+		/// <summary>
+		/// Count a received datagram, and the time since it was sent.
+		/// </summary>
+		void Add(const char* datagram, const Bench::Clock::time_point now)
+		{
+			Bench::Clock::rep sent_ticks;
+			memcpy(&sent_ticks, datagram, sizeof(sent_ticks));
+			delay_secs += std::chrono::duration<double>(now - Bench::Clock::time_point(Bench::Clock::duration(sent_ticks))).count();
+			++datagram_count;
+		}
+	};
+
+
+	/// <summary>
+	/// Stamp the datagram with the time it is sent; the steady clock is the same in every process on the machine.
+	/// </summary>
+	void Stamp(char* datagram)
+	{
+		const auto sent_ticks = Bench::Clock::now().time_since_epoch().count();
+		memcpy(datagram, &sent_ticks, sizeof(sent_ticks));
+	}
+
+
+	/// <summary>
+	/// Send the workload to the address, from a child process, and return its process ID.
+	/// </summary>
+	int StartSender(const SOCKADDR_IN& address, const bool is_flood)
+	{
+		const auto pid = fork();
+		if (pid != 0)
+		{
+			return pid;
+		}
+
+		const auto sender = socket(AF_INET, SOCK_DGRAM, 0);
+		connect(sender, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+		char buffer[kDatagramSize] = { 1 };
+		if (!is_flood)
+		{
+			for (auto i = 0u; i < kTrickleCount; ++i)
+			{
+				Stamp(buffer);
+				send(sender, buffer, sizeof(buffer), 0);
+				std::this_thread::sleep_for(kTrickleInterval);
+			}
+			_exit(0);
+		}
+
+		mmsghdr headers[kFloodBatchSize] = {};
+		iovec vectors[kFloodBatchSize];
+		for (auto i = 0u; i < kFloodBatchSize; ++i)
+		{
+			vectors[i] = { buffer, sizeof(buffer) };
+			headers[i].msg_hdr.msg_iov = &vectors[i];
+			headers[i].msg_hdr.msg_iovlen = 1;
+		}
+		for (auto i = 0u; i < kFloodCount; i += kFloodBatchSize)
+		{
+			// each batch shares one stamp
+			Stamp(buffer);
+			sendmmsg(sender, headers, kFloodBatchSize, 0);
+			if ((i % kFloodPauseEvery) == 0)
+			{
+				std::this_thread::sleep_for(kFloodPause);
+			}
+		}
+		_exit(0);
+	}
+
+
+	/// <summary>
+	/// Receive with the backend until nothing has arrived for kIdleTimeout.
+	/// </summary>
+	ReceiveCounts ReceiveWithBackend(DatagramReceiver& receiver)
+	{
+		ReceiveCounts counts;
+		auto last_received = Bench::Clock::now();
+		while (Bench::Clock::now() - last_received < kIdleTimeout)
+		{
+			auto received = receiver.Receive(kWait_Usecs);
+			if (received <= 0)
+			{
+				++counts.empty_count;
+				continue;
+			}
+			// a full batch may mean more are waiting, so take them without waiting
+			++counts.wake_count;
+			while (received > 0)
+			{
+				const auto now = Bench::Clock::now();
+				for (auto i = 0; i < received; ++i)
+				{
+					counts.Add(receiver.GetDatagram(i).GetRoot(), now);
+				}
+				received = receiver.Receive(0);
+			}
+			last_received = Bench::Clock::now();
+		}
+		return counts;
+	}
+
+
+	/// <summary>
+	/// Receive with recv until it would block, every kPollInterval, until nothing has arrived for kIdleTimeout.
+	/// </summary>
+	ReceiveCounts ReceiveByPolling(const SOCKET socket)
+	{
+		ReceiveCounts counts;
+		char buffer[kMaxDatagramSize];
+		auto last_received = Bench::Clock::now();
+		while (Bench::Clock::now() - last_received < kIdleTimeout)
+		{
+			auto is_woken = false;
+			while (recv(socket, buffer, sizeof(buffer), 0) > 0)
+			{
+				counts.Add(buffer, Bench::Clock::now());
+				is_woken = true;
+			}
+			++counts.empty_count;
+			if (is_woken)
+			{
+				++counts.wake_count;
+				last_received = Bench::Clock::now();
+			}
+			std::this_thread::sleep_for(kPollInterval);
+		}
+		return counts;
+	}
+
+
+	/// <summary>
+	/// Run one workload against a fresh socket, received with the backend, or by polling if there is none.
+	/// </summary>
+	/// <returns>If false, the socket could not be set up.</returns>
+	bool TimeWorkload(const bool is_flood, const DatagramReceiver::Backend* backend)
+	{
+		const auto receiving_socket = socket(AF_INET, SOCK_DGRAM, 0);
+		setsockopt(receiving_socket, SOL_SOCKET, SO_RCVBUF, &kSocketBufferSize, sizeof(kSocketBufferSize));
+		SOCKADDR_IN address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t address_size = sizeof(address);
+		if ((receiving_socket < 0) ||
+			(bind(receiving_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) ||
+			(getsockname(receiving_socket, reinterpret_cast<sockaddr*>(&address), &address_size) != 0) ||
+			(fcntl(receiving_socket, F_SETFL, O_NONBLOCK) != 0))
+		{
+			std::cerr << "Could not set up a loopback socket" << std::endl;
+			return false;
+		}
+
+		// the receiver is set up before the sender starts, as the server's is before any client connects
+		std::unique_ptr<DatagramReceiver> receiver;
+		if (backend != nullptr)
+		{
+			receiver = std::make_unique<DatagramReceiver>(receiving_socket, *backend);
+		}
+		const auto sender_pid = StartSender(address, is_flood);
+		const auto cpu_before = Bench::GetThreadCpuSecs();
+		auto counts = (receiver != nullptr) ? ReceiveWithBackend(*receiver) : ReceiveByPolling(receiving_socket);
+		counts.cpu_secs = Bench::GetThreadCpuSecs() - cpu_before;
+		waitpid(sender_pid, nullptr, 0);
+
+		// a backend the kernel refused has fallen back, and is named for what it fell back to
+		const auto* name = (receiver != nullptr) ? DatagramReceiver::GetBackendName(receiver->GetBackend()) : "poll";
+		if (receiver != nullptr)
+		{
+			receiver->Stop();
+		}
+		close(receiving_socket);
+
+		const auto sent_count = is_flood ? kFloodCount : kTrickleCount;
+		std::cout << "  " << std::left << std::setw(8) << (is_flood ? "flood" : "trickle") << std::setw(8) << name << std::right <<
+			std::setw(7) << counts.datagram_count << "/" << std::left << std::setw(7) << sent_count << std::right << std::fixed <<
+			std::setprecision(0) << std::setw(7) << (counts.datagram_count > 0 ? counts.cpu_secs * 1e9 / counts.datagram_count : 0.0) << " ns/datagram" <<
+			std::setprecision(1) << std::setw(8) << (counts.datagram_count > 0 ? counts.delay_secs * 1e6 / counts.datagram_count : 0.0) << " us delay" <<
+			std::setw(8) << (counts.wake_count > 0 ? static_cast<double>(counts.datagram_count) / counts.wake_count : 0.0) << " per wake" <<
+			std::setw(8) << counts.empty_count << " empty calls" << std::endl;
+		return true;
+	}
+}
+
+
+/// <summary>
+/// Time each receive backend, or only the one given, against polling recv, under a flood and a trickle.
+/// </summary>
+bool Bench::RunReceive(const int argc, char** argv)
+{
+	std::vector<DatagramReceiver::Backend> backends = { DatagramReceiver::Backend::Uring, DatagramReceiver::Backend::Epoll, DatagramReceiver::Backend::Select };
+	for (auto i = 2; i < argc; ++i)
+	{
+		if (strncmp(argv[i], DatagramReceiver::kArgumentPrefix, strlen(DatagramReceiver::kArgumentPrefix)) == 0)
+		{
+			backends = { DatagramReceiver::FromArguments(argc, argv) };
+		}
+	}
+
+	std::cout << "Receiving " << kDatagramSize << "-byte datagrams sent by another process, in the receiver's CPU time:" << std::endl;
+	std::cout << "  workload backend  received        per datagram" << std::endl;
+	for (const auto is_flood : { true, false })
+	{
+		for (const auto& backend : backends)
+		{
+			if (!TimeWorkload(is_flood, &backend))
+			{
+				return false;
+			}
+		}
+		if (!TimeWorkload(is_flood, nullptr))
+		{
+			return false;
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,230 @@
+//---------------------------------------------------------
+// file:	SerializeBench.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Times encoding and decoding messages in the Bytes format, one checked value at a time and with schema cursors,
+//          and against the reinterpret_cast values the memcpy wire values replaced.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "Bench.h"
+#include <iomanip>
+#include "MessageSchema.h"
+#include "OptimisticMessages.h"
+
+const unsigned int kStateCount = 5000000; // state messages encoded, then decoded, per run
+const unsigned int kRoundTripCount = 10000000; // whole values encoded and decoded, per run
+
+
+namespace
+{
+	using namespace OptimisticMessages;
+	using PacketSerializer::ReadQuantized;
+	using PacketSerializer::WriteQuantized;
+
+	// the host state's player values, as OptimisticMessages writes them in the Bytes format
+	using StateSchema = MessageSchema::Schema<StateMessage,
+		MessageSchema::Value<&StateMessage::frame>,
+		MessageSchema::Quantized<&StateMessage::host_x, kPositionX>,
+		MessageSchema::Quantized<&StateMessage::host_y, kPositionY>,
+		MessageSchema::Quantized<&StateMessage::host_velocity_x, kVelocity>,
+		MessageSchema::Quantized<&StateMessage::host_velocity_y, kVelocity>,
+		MessageSchema::Quantized<&StateMessage::non_host_x, kPositionX>,
+		MessageSchema::Quantized<&StateMessage::non_host_y, kPositionY>,
+		MessageSchema::Quantized<&StateMessage::non_host_velocity_x, kVelocity>,
+		MessageSchema::Quantized<&StateMessage::non_host_velocity_y, kVelocity>>;
+
+
+	/// <summary>
+	/// The same message, one checked value at a time, as every message was written before the schema cursors.
+	/// </summary>
+	bool WriteStatePerField(Packet& packet, const StateMessage& message)
+	{
+		return PacketSerializer::WriteValue(packet, message.frame) &&
+			WriteQuantized(packet, message.host_x, kPositionX.min, kPositionX.max, kPositionX.bits) &&
+			WriteQuantized(packet, message.host_y, kPositionY.min, kPositionY.max, kPositionY.bits) &&
+			WriteQuantized(packet, message.host_velocity_x, kVelocity.min, kVelocity.max, kVelocity.bits) &&
+			WriteQuantized(packet, message.host_velocity_y, kVelocity.min, kVelocity.max, kVelocity.bits) &&
+			WriteQuantized(packet, message.non_host_x, kPositionX.min, kPositionX.max, kPositionX.bits) &&
+			WriteQuantized(packet, message.non_host_y, kPositionY.min, kPositionY.max, kPositionY.bits) &&
+			WriteQuantized(packet, message.non_host_velocity_x, kVelocity.min, kVelocity.max, kVelocity.bits) &&
+			WriteQuantized(packet, message.non_host_velocity_y, kVelocity.min, kVelocity.max, kVelocity.bits);
+	}
+
+
+	bool ReadStatePerField(Packet& packet, StateMessage& message)
+	{
+		return PacketSerializer::ReadValue(packet, message.frame) &&
+			ReadQuantized(packet, message.host_x, kPositionX.min, kPositionX.max, kPositionX.bits) &&
+			ReadQuantized(packet, message.host_y, kPositionY.min, kPositionY.max, kPositionY.bits) &&
+			ReadQuantized(packet, message.host_velocity_x, kVelocity.min, kVelocity.max, kVelocity.bits) &&
+			ReadQuantized(packet, message.host_velocity_y, kVelocity.min, kVelocity.max, kVelocity.bits) &&
+			ReadQuantized(packet, message.non_host_x, kPositionX.min, kPositionX.max, kPositionX.bits) &&
+			ReadQuantized(packet, message.non_host_y, kPositionY.min, kPositionY.max, kPositionY.bits) &&
+			ReadQuantized(packet, message.non_host_velocity_x, kVelocity.min, kVelocity.max, kVelocity.bits) &&
+			ReadQuantized(packet, message.non_host_velocity_y, kVelocity.min, kVelocity.max, kVelocity.bits);
+	}
+
+
+	/// <summary>
+	/// Time encoding kStateCount state messages with write, then decoding them with read.
+	/// </summary>
+	template <typename Write, typename Read>
+	void TimeState(const char* name, Write&& write, Read&& read)
+	{
+		StateMessage message;
+		message.host_x = 300.0f;
+		message.host_y = 200.0f;
+		message.host_velocity_x = 10.0f;
+		FixedPacket<kMaxDatagramSize> packet;
+		const auto encode_nsecs = Bench::TimePerCall(kStateCount, [&](const unsigned int i)
+		{
+			message.frame = i;
+			packet.Reset();
+			write(packet, message);
+		});
+
+		// the sum keeps the decoded values live, so the reads are not optimized away
+		volatile float sink = 0.0f;
+		const auto decode_nsecs = Bench::TimePerCall(kStateCount, [&](unsigned int)
+		{
+			Packet reader(packet.GetRoot(), packet.GetUsedSpace());
+			StateMessage decoded;
+			read(reader, decoded);
+			sink = sink + decoded.host_x;
+		});
+
+		std::cout << "  " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1) <<
+			std::setw(6) << encode_nsecs << " ns encode" << std::setw(8) << decode_nsecs << " ns decode  (" << packet.GetUsedSpace() << " bytes)" << std::endl;
+	}
+
+
+	/// <summary>
+	/// A frame, a flag, and four floats, as in every scenario packet: the float after the bool is never aligned.
+	/// </summary>
+	struct RoundTripMessage
+	{
+		u_long frame;
+		bool is_paused;
+		float x, y, velocity_x, velocity_y;
+	};
+
+	using RoundTripSchema = MessageSchema::Schema<RoundTripMessage,
+		MessageSchema::Value<&RoundTripMessage::frame>,
+		MessageSchema::Value<&RoundTripMessage::is_paused>,
+		MessageSchema::Value<&RoundTripMessage::x>,
+		MessageSchema::Value<&RoundTripMessage::y>,
+		MessageSchema::Value<&RoundTripMessage::velocity_x>,
+		MessageSchema::Value<&RoundTripMessage::velocity_y>>;
+
+
+	/// <summary>
+	/// ReadValue/WriteValue as they were before StoreWire/LoadWire: a dereference of the packet as a T*, in host byte order.
+	/// </summary>
+	template <typename T>
+	bool WriteCast(Packet& packet, const T value)
+	{
+		if (packet.GetRemainingSpace() < sizeof(T))
+		{
+			return false;
+		}
+		*reinterpret_cast<T*>(packet.GetTarget()) = value;
+		packet.AdvanceUnchecked(sizeof(T));
+		return true;
+	}
+
+
+	template <typename T>
+	bool ReadCast(Packet& packet, T& value)
+	{
+		if (packet.GetRemainingSpace() < sizeof(T))
+		{
+			return false;
+		}
+		value = *reinterpret_cast<const T*>(packet.GetTarget());
+		packet.AdvanceUnchecked(sizeof(T));
+		return true;
+	}
+
+
+	bool WriteRoundTripCast(Packet& packet, const RoundTripMessage& message)
+	{
+		return WriteCast(packet, static_cast<uint32_t>(message.frame)) && WriteCast(packet, message.is_paused) &&
+			WriteCast(packet, message.x) && WriteCast(packet, message.y) && WriteCast(packet, message.velocity_x) && WriteCast(packet, message.velocity_y);
+	}
+
+
+	bool ReadRoundTripCast(Packet& packet, RoundTripMessage& message)
+	{
+		uint32_t frame = 0;
+		const auto is_read = ReadCast(packet, frame) && ReadCast(packet, message.is_paused) &&
+			ReadCast(packet, message.x) && ReadCast(packet, message.y) && ReadCast(packet, message.velocity_x) && ReadCast(packet, message.velocity_y);
+		message.frame = frame;
+		return is_read;
+	}
+
+
+	bool WriteRoundTripValues(Packet& packet, const RoundTripMessage& message)
+	{
+		using PacketSerializer::WriteValue;
+		return WriteValue(packet, message.frame) && WriteValue(packet, message.is_paused) &&
+			WriteValue(packet, message.x) && WriteValue(packet, message.y) && WriteValue(packet, message.velocity_x) && WriteValue(packet, message.velocity_y);
+	}
+
+
+	bool ReadRoundTripValues(Packet& packet, RoundTripMessage& message)
+	{
+		using PacketSerializer::ReadValue;
+		return ReadValue(packet, message.frame) && ReadValue(packet, message.is_paused) &&
+			ReadValue(packet, message.x) && ReadValue(packet, message.y) && ReadValue(packet, message.velocity_x) && ReadValue(packet, message.velocity_y);
+	}
+
+
+	/// <summary>
+	/// Time kRoundTripCount round trips, each encoding a message with write and decoding it again with read.
+	/// </summary>
+	template <typename Write, typename Read>
+	void TimeRoundTrip(const char* name, Write&& write, Read&& read)
+	{
+		RoundTripMessage message = { 0, true, 1.0f, 2.0f, 3.0f, 4.0f };
+		FixedPacket<64> packet;
+		volatile float sink = 0.0f;
+		const auto nsecs = Bench::TimePerCall(kRoundTripCount, [&](const unsigned int i)
+		{
+			message.frame = i;
+			message.x = static_cast<float>(i);
+			packet.Reset();
+			write(packet, message);
+			Packet reader(packet.GetRoot(), packet.GetUsedSpace());
+			RoundTripMessage decoded = {};
+			read(reader, decoded);
+			sink = sink + decoded.x + decoded.frame;
+		});
+
+		std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1) <<
+			std::setw(6) << nsecs << " ns per round trip  (" << packet.GetUsedSpace() << " bytes)" << std::endl;
+	}
+}
+
+
+/// <summary>
+/// Compare the per-field and schema cursor encodings of the state message, and the ways of copying whole values.
+/// </summary>
+bool Bench::RunSerialize(int, char**)
+{
+	std::cout << "Host state message, Bytes format, " << kStateCount << " each way, median of " << kRepeats << " runs:" << std::endl;
+	TimeState("per-field ReadValue/WriteValue", WriteStatePerField, ReadStatePerField);
+	TimeState("schema cursor",
+		[](Packet& packet, const StateMessage& message) { return StateSchema::Write(packet, message); },
+		[](Packet& packet, StateMessage& message) { return StateSchema::Read(packet, message); });
+
+	std::cout << "Frame, flag, and 4 floats, " << kRoundTripCount << " round trips, median of " << kRepeats << " runs:" << std::endl;
+	TimeRoundTrip("reinterpret_cast ReadValue/WriteValue", WriteRoundTripCast, ReadRoundTripCast);
+	TimeRoundTrip("memcpy ReadValue/WriteValue", WriteRoundTripValues, ReadRoundTripValues);
+	TimeRoundTrip("memcpy schema cursor",
+		[](Packet& packet, const RoundTripMessage& message) { return RoundTripSchema::Write(packet, message); },
+		[](Packet& packet, RoundTripMessage& message) { return RoundTripSchema::Read(packet, message); });
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,249 @@
+//---------------------------------------------------------
+// file:	SharedMemoryBench.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Times a datagram's trip between two processes, over shared memory and over loopback UDP.
+//
+// remarks: Two processes bounce one small datagram back and forth, and each round trip is timed; the one-way
+//          time is half of it.  The child echoes until it is killed.  Shared memory is timed sleeping on the ring
+//          and polling it, and UDP through the NetworkThread the scenarios use, and with a bare blocking socket,
+//          as the floor for the kernel's path.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "Bench.h"
+#include <iomanip>
+#include <memory>
+#include <thread>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "NetworkThread.h"
+#include "PacketSerializer.h"
+#include "SharedMemoryTransport.h"
+
+const unsigned int kPingCount = 5000; // round trips timed per variant
+const unsigned int kWarmUpPingCount = 200; // round trips made first, and not timed
+const float kWaitTimeout_Secs = 1.0f; // the longest one wait on the ring sleeps, before checking again
+
+
+namespace
+{
+	/// <summary>
+	/// The one-way times, from the round trips, at the median, the 90th and 99th percentiles, and the worst.
+	/// </summary>
+	void Report(const char* name, std::vector<double> round_trip_secs)
+	{
+		std::sort(round_trip_secs.begin(), round_trip_secs.end());
+		const auto one_way_usecs = [&](const double fraction)
+			{
+				return round_trip_secs[static_cast<size_t>(fraction * (round_trip_secs.size() - 1))] / 2.0 * 1e6;
+			};
+		std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1) <<
+			" p50 " << std::setw(6) << one_way_usecs(0.5) << "  p90 " << std::setw(6) << one_way_usecs(0.9) <<
+			"  p99 " << std::setw(6) << one_way_usecs(0.99) << "  max " << std::setw(8) << one_way_usecs(1.0) << " us" << std::endl;
+	}
+
+
+	/// <summary>
+	/// Send a datagram over the transport and time each reply, calling wait() while nothing has arrived.
+	/// </summary>
+	template <typename Wait>
+	std::vector<double> Ping(DatagramTransport& transport, Wait&& wait)
+	{
+		std::vector<double> round_trip_secs;
+		FixedPacket<64> packet;
+		DatagramTransport::ReceivedDatagram datagram;
+		for (auto i = 0u; i < kWarmUpPingCount + kPingCount; ++i)
+		{
+			packet.Reset();
+			PacketSerializer::WriteValue<uint32_t>(packet, i);
+			const auto start = Bench::Clock::now();
+			transport.Send(packet);
+			while (!transport.Receive(datagram))
+			{
+				wait();
+			}
+			datagram.buffer.Reset();
+			if (i >= kWarmUpPingCount)
+			{
+				round_trip_secs.push_back(std::chrono::duration<double>(Bench::Clock::now() - start).count());
+			}
+		}
+		return round_trip_secs;
+	}
+
+
+	/// <summary>
+	/// Send each datagram back over the transport, until the process is killed.
+	/// </summary>
+	template <typename Wait>
+	[[noreturn]] void Echo(DatagramTransport& transport, Wait&& wait)
+	{
+		DatagramTransport::ReceivedDatagram datagram;
+		while (true)
+		{
+			while (!transport.Receive(datagram))
+			{
+				wait();
+			}
+			Packet packet(datagram.buffer.GetData(), datagram.buffer.GetSize());
+			packet.Advance(datagram.buffer.GetSize());
+			transport.Send(packet);
+			datagram.buffer.Reset();
+		}
+	}
+
+
+	/// <summary>
+	/// Stop the echoing child, and report the round trips timed against it.
+	/// </summary>
+	void Finish(const int pid, const char* name, std::vector<double> round_trip_secs)
+	{
+		kill(pid, SIGKILL);
+		waitpid(pid, nullptr, 0);
+		Report(name, std::move(round_trip_secs));
+	}
+
+
+	/// <summary>
+	/// Wait for the ring by sleeping on it, or by yielding, so a peer sharing the core can run.
+	/// </summary>
+	auto MakeRingWait(SharedMemoryTransport& transport, const bool is_polling)
+	{
+		return [&transport, is_polling]
+			{
+				if (is_polling)
+				{
+					std::this_thread::yield();
+				}
+				else
+				{
+					transport.WaitForDatagram(kWaitTimeout_Secs);
+				}
+			};
+	}
+
+
+	/// <summary>
+	/// Time the round trips between this process and a child, over a shared memory region the child opens.
+	/// </summary>
+	/// <returns>If false, the region could not be created.</returns>
+	bool TimeSharedMemory(const char* name, const bool is_polling)
+	{
+		auto client = SharedMemoryTransport::Create();
+		char request_data[kMaxDatagramSize];
+		Packet request(request_data, kMaxDatagramSize);
+		if ((client == nullptr) || !client->WriteRequest(request))
+		{
+			std::cerr << "Could not create a shared memory region" << std::endl;
+			return false;
+		}
+
+		const auto pid = fork();
+		if (pid == 0)
+		{
+			// the child is the host, and leaves the client's mapping to the parent
+			client.release();
+			Packet requested(request_data, request.GetUsedSpace());
+			auto host = SharedMemoryTransport::OpenRequested(requested);
+			if (host == nullptr)
+			{
+				_exit(1);
+			}
+			Echo(*host, MakeRingWait(*host, is_polling));
+		}
+
+		Finish(pid, name, Ping(*client, MakeRingWait(*client, is_polling)));
+		return true;
+	}
+
+
+	/// <summary>
+	/// Time the round trips between this process and a child, over a pair of connected loopback UDP sockets.
+	/// </summary>
+	/// <returns>If false, the sockets could not be set up.</returns>
+	bool TimeUdp(const char* name, const bool is_threaded)
+	{
+		SOCKET sockets[2] = { socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP), socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP) };
+		SOCKADDR_IN addresses[2] = {};
+		auto is_valid = true;
+		for (auto& address : addresses)
+		{
+			const auto i = &address - addresses;
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			socklen_t address_size = sizeof(address);
+			is_valid = is_valid && (sockets[i] != INVALID_SOCKET) &&
+				(bind(sockets[i], reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) == 0) &&
+				(getsockname(sockets[i], reinterpret_cast<SOCKADDR*>(&address), &address_size) == 0);
+		}
+		is_valid = is_valid &&
+			(connect(sockets[0], reinterpret_cast<SOCKADDR*>(&addresses[1]), sizeof(addresses[1])) == 0) &&
+			(connect(sockets[1], reinterpret_cast<SOCKADDR*>(&addresses[0]), sizeof(addresses[0])) == 0);
+		if (!is_valid)
+		{
+			std::cerr << "Could not set up a loopback socket pair" << std::endl;
+			return false;
+		}
+
+		const auto pid = fork();
+		const auto is_pinger = (pid != 0);
+		const auto own_socket = sockets[is_pinger ? 0 : 1];
+		closesocket(sockets[is_pinger ? 1 : 0]);
+		if (is_threaded)
+		{
+			// the network thread expects a non-blocking socket, as the menus hand it one
+			u_long nonblocking = 1;
+			ioctlsocket(own_socket, FIONBIO, &nonblocking);
+			NetworkThread transport(own_socket);
+			const auto wait = [] { std::this_thread::yield(); };
+			if (!is_pinger)
+			{
+				Echo(transport, wait);
+			}
+			Finish(pid, name, Ping(transport, wait));
+			transport.Stop();
+			return true;
+		}
+
+		char buffer[64] = {};
+		if (!is_pinger)
+		{
+			while (true)
+			{
+				const auto received = recv(own_socket, buffer, sizeof(buffer), 0);
+				send(own_socket, buffer, (received > 0) ? received : 0, 0);
+			}
+		}
+		std::vector<double> round_trip_secs;
+		for (auto i = 0u; i < kWarmUpPingCount + kPingCount; ++i)
+		{
+			const auto start = Bench::Clock::now();
+			send(own_socket, buffer, sizeof(uint32_t), 0);
+			recv(own_socket, buffer, sizeof(buffer), 0);
+			if (i >= kWarmUpPingCount)
+			{
+				round_trip_secs.push_back(std::chrono::duration<double>(Bench::Clock::now() - start).count());
+			}
+		}
+		Finish(pid, name, std::move(round_trip_secs));
+		closesocket(own_socket);
+		return true;
+	}
+}
+
+
+/// <summary>
+/// Compare the one-way time of a small datagram between two processes, over shared memory and loopback UDP.
+/// </summary>
+bool Bench::RunSharedMemory(int, char**)
+{
+	std::cout << "One-way time of a 4-byte datagram between two processes, from " << kPingCount << " round trips:" << std::endl;
+	return TimeSharedMemory("shared memory, sleeping on the ring", false) &&
+		TimeSharedMemory("shared memory, polling the ring", true) &&
+		TimeUdp("UDP through NetworkThread, polled", true) &&
+		TimeUdp("UDP, blocking recv", false);
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+//---------------------------------------------------------
+// file:	CS261_Lab_Headless.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Entry point for the headless server, which hosts one scenario type for many clients, with no window.
+//
+// remarks: Usage: CS261_Lab_Headless [port] [Lockstep|DumbClient|Optimistic] [worker threads] [--net=conditions] [--udp]
+//                 [--recv=uring|epoll|select]
+//          Or: CS261_Lab_Headless --loopback [Lockstep|DumbClient|Optimistic|Flood|Reliable|Fragments|All] [ticks] [--net=conditions]
+//          Or: CS261_Lab_Headless --wire
+//          The worker threads default to one per core, each with its own socket on the port, if the count is
+//          left out, is not a number from 1 to kMaxWorkerCount, or is replaced by a -- option.
+//          The --net= conditions are simulated on every session; see NetworkConditions::Parse.
+//          Clients on this machine are served through shared memory, unless --udp is given; see SharedMemoryTransport.
+//          Datagrams are received with io_uring where the kernel allows it, unless --recv= says otherwise; see DatagramReceiver.
+//          The simulation is the same CS261_Lab code the windowed server runs, with CProcessing stubbed out.
+//          The --loopback form runs a host and client in this process instead of serving; see LoopbackCheck.
+//          The --wire form round-trips every wire encoding instead of serving; see WireFormatCheck.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include <csignal>
+#include <thread>
+#include "GameStateManager.h"
+#include "HeadlessServerState.h"
+#include "ServerConfiguration.h"
+#include "LockstepScenarioState.h"
+#include "DumbClientScenarioState.h"
+#include "OptimisticHostScenarioState.h"
+#include "LoopbackCheck.h"
+#include "WireFormatCheck.h"
+
+const long kMaxWorkerCount = 1024; // far more than any machine's cores, to catch a mistyped count
+
+
+/// <summary>
+/// Find the host-side creator for a game type, matching the names the clients send.
+/// </summary>
+/// <returns>The creator, or nullptr if the game type is unknown.</returns>
+NetworkedScenarioState::NetworkedScenarioStateCreator FindScenarioStateCreator(const std::string& game_type)
+{
+	if (game_type == "Lockstep")
+	{
+		return [](std::unique_ptr<DatagramTransport> transport, const bool is_host) -> NetworkedScenarioState*
+		{
+			return new LockstepScenarioState(std::move(transport), is_host);
+		};
+	}
+	if (game_type == "DumbClient")
+	{
+		return [](std::unique_ptr<DatagramTransport> transport, const bool is_host) -> NetworkedScenarioState*
+		{
+			return new DumbClientScenarioState(std::move(transport), is_host);
+		};
+	}
+	if (game_type == "Optimistic")
+	{
+		return [](std::unique_ptr<DatagramTransport> transport, bool /*is_host*/) -> NetworkedScenarioState*
+		{
+			return new OptimisticHostScenarioState(std::move(transport));
+		};
+	}
+	return nullptr;
+}
+
+
+/// <summary>
+/// Parse the worker thread count, or default to one per core.
+/// </summary>
+/// <remarks>A count that is not a number from 1 to kMaxWorkerCount is reported and replaced by the default.</remarks>
+unsigned int ParseWorkerCount(const int argc, char** argv)
+{
+	const auto default_count = std::max(std::thread::hardware_concurrency(), 1u);
+	if ((argc <= 3) || (strncmp(argv[3], "--", 2) == 0))
+	{
+		return default_count;
+	}
+
+	char* end = nullptr;
+	errno = 0;
+	const auto count = strtol(argv[3], &end, 10);
+	if ((end == argv[3]) || (*end != '\0') || (errno != 0) || (count < 1) || (count > kMaxWorkerCount))
+	{
+		std::cerr << "Worker thread count '" << argv[3] << "' is not a number from 1 to " << kMaxWorkerCount << ", using " << default_count << std::endl;
+		return default_count;
+	}
+	return static_cast<unsigned int>(count);
+}
+
+
+void HandleTerminationSignal(int)
+{
+	CP_Engine_Terminate();
+}
+
+
+int main(const int argc, char** argv)
+{
+	// check the scenarios against themselves, with no sockets, rather than serve
+	if ((argc > 1) && (strcmp(argv[1], LoopbackCheck::kArgument) == 0))
+	{
+		return LoopbackCheck::Run(argc, argv) ? 0 : 1;
+	}
+	if ((argc > 1) && (strcmp(argv[1], WireFormatCheck::kArgument) == 0))
+	{
+		return WireFormatCheck::Run() ? 0 : 1;
+	}
+
+	auto configuration = ServerConfiguration::BuildConfigurationFromArguments(argc, argv);
+	const std::string game_type = (argc > 2) ? argv[2] : "Optimistic";
+	configuration.worker_count = ParseWorkerCount(argc, argv);
+	const auto scenario_state_creator = FindScenarioStateCreator(game_type);
+	if (scenario_state_creator == nullptr)
+	{
+		std::cerr << "Unknown game type '" << game_type << "', expected Lockstep, DumbClient, or Optimistic" << std::endl;
+		return 1;
+	}
+
+	// initialize WinSock (a no-op for BSD sockets)
+	WSADATA wsa_data;
+	const auto res = WSAStartup(MAKEWORD(2, 2), &wsa_data);
+	if (res != 0)
+	{
+		std::cerr << "Error in WSAStartup: " << WSAGetLastError() << std::endl;
+		return 1;
+	}
+
+	// stop cleanly on Ctrl+C or a service manager's stop request
+	std::signal(SIGINT, HandleTerminationSignal);
+	std::signal(SIGTERM, HandleTerminationSignal);
+
+	std::cout << "Headless server hosting " << game_type << " on port " << configuration.port << " with " << configuration.worker_count << " workers" << std::endl;
+	GameStateManager::Establish(new HeadlessServerState(scenario_state_creator, game_type, configuration), nullptr);
+	CP_Engine_Run();
+
+	// clean up WinSock
+	WSACleanup();
+
+	return 0;
+}
\ No newline at end of file
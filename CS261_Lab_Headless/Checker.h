@@ -0,0 +1,57 @@
+//---------------------------------------------------------
+// file:	Checker.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Counts the checks of a headless check run that failed, and reports the first few.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+
+
+/// <summary>
+/// Counts the checks that failed, and reports the first few.
+/// </summary>
+class Checker
+{
+public:
+	// per checker, so a badly broken build does not flood the output
+	static const unsigned int kMaxReportedFailures = 10;
+
+	/// <summary>
+	/// Report failures as "name, step_label step: what", where the step is the tick, value, or case that failed.
+	/// </summary>
+	Checker(const std::string& name, const char* step_label = "tick") : name_(name), step_label_(step_label), failure_count_(0) { }
+
+	bool Check(const bool is_passed, const unsigned long long step, const char* what)
+	{
+		if (!is_passed)
+		{
+			if (failure_count_ < kMaxReportedFailures)
+			{
+				std::cerr << name_ << ", " << step_label_ << " " << step << ": " << what << std::endl;
+			}
+			++failure_count_;
+		}
+		return is_passed;
+	}
+
+	unsigned int GetFailureCount() const { return failure_count_; }
+
+	/// <summary>
+	/// Print the outcome, after whatever the caller has already printed on the line.
+	/// </summary>
+	/// <returns>If true, every check passed.</returns>
+	bool Report() const
+	{
+		std::cout << ", " << failure_count_ << " failures" << std::endl;
+		return failure_count_ == 0;
+	}
+
+private:
+	std::string name_;
+	const char* step_label_;
+	unsigned int failure_count_;
+};
\ No newline at end of file
@@ -0,0 +1,112 @@
+//---------------------------------------------------------
+// file:	HeadlessProcessing.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Stands in for cprocessing.h in headless builds, which have no window, keyboard, or renderer.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+	FunctionPtr next_init = nullptr;
+	FunctionPtr next_update = nullptr;
+	FunctionPtr next_exit = nullptr;
+	bool is_next_pending = false;
+
+	// set from signal handlers, so it must be lock-free
+	std::atomic<bool> is_terminating(false);
+
+	// zero when no key is pressed, which is always, outside of a scripted run
+	int pressed_key = 0;
+}
+
+
+void CP_Engine_SetNextGameStateForced(FunctionPtr init, FunctionPtr update, FunctionPtr exit)
+{
+	next_init = init;
+	next_update = update;
+	next_exit = exit;
+	is_next_pending = true;
+}
+
+
+/// <summary>
+/// Run the current update function once per tick, on a fixed schedule, until CP_Engine_Terminate is called.
+/// </summary>
+/// <remarks>A tick that runs long is followed immediately by the next, rather than drifting the schedule.</remarks>
+void CP_Engine_Run(void)
+{
+	using Clock = std::chrono::steady_clock;
+	const auto tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(HeadlessProcessing::kTick_Secs));
+
+	FunctionPtr update = nullptr;
+	FunctionPtr exit = nullptr;
+	auto next_tick = Clock::now();
+	while (!is_terminating.load())
+	{
+		if (is_next_pending)
+		{
+			if (exit != nullptr)
+			{
+				exit();
+			}
+			update = next_update;
+			exit = next_exit;
+			is_next_pending = false;
+			if (next_init != nullptr)
+			{
+				next_init();
+			}
+		}
+
+		if (update != nullptr)
+		{
+			update();
+		}
+
+		next_tick += tick;
+		std::this_thread::sleep_until(next_tick);
+	}
+
+	if (exit != nullptr)
+	{
+		exit();
+	}
+}
+
+
+/// <summary>
+/// Stop CP_Engine_Run after the current tick.  Safe to call from a signal handler.
+/// </summary>
+void CP_Engine_Terminate(void)
+{
+	is_terminating.store(true);
+}
+
+
+/// <summary>
+/// Hold the key down until ReleaseKey.  Only one key is pressed at a time, so this releases any other.
+/// </summary>
+/// <remarks>The key reads as triggered for as long as it is held, so press it around a single Update.</remarks>
+void HeadlessProcessing::PressKey(const CP_KEY key)
+{
+	pressed_key = key;
+}
+
+
+void HeadlessProcessing::ReleaseKey()
+{
+	pressed_key = 0;
+}
+
+
+bool HeadlessProcessing::IsKeyPressed(const CP_KEY key)
+{
+	return pressed_key == key;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+//---------------------------------------------------------
+// file:	HeadlessProcessing.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Stands in for cprocessing.h in headless builds, which have no window, keyboard, or renderer.
+//
+// remarks: Only the parts of CProcessing that the lab uses are provided.  Drawing does nothing, no key is
+//          pressed unless a scripted run presses it, and CP_Engine_Run drives the game state on a fixed tick
+//          until CP_Engine_Terminate.
+//          The math is real, as the simulation depends on it.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include <math.h>
+
+
+typedef void(*FunctionPtr)(void);
+
+typedef union CP_Color
+{
+	int rgba[4];
+	struct { int r, g, b, a; };
+} CP_Color;
+
+typedef enum CP_TEXT_ALIGN_HORIZONTAL
+{
+	CP_TEXT_ALIGN_H_LEFT = 1 << 0,
+	CP_TEXT_ALIGN_H_CENTER = 1 << 1,
+	CP_TEXT_ALIGN_H_RIGHT = 1 << 2
+} CP_TEXT_ALIGN_HORIZONTAL;
+
+typedef enum CP_TEXT_ALIGN_VERTICAL
+{
+	CP_TEXT_ALIGN_V_TOP = 1 << 3,
+	CP_TEXT_ALIGN_V_MIDDLE = 1 << 4,
+	CP_TEXT_ALIGN_V_BOTTOM = 1 << 5,
+	CP_TEXT_ALIGN_V_BASELINE = 1 << 6
+} CP_TEXT_ALIGN_VERTICAL;
+
+// the values match cprocessing_common.h, though only a scripted run ever presses one
+typedef enum CP_KEY
+{
+	KEY_SPACE = 32,
+	KEY_A = 65,
+	KEY_B = 66,
+	KEY_D = 68,
+	KEY_F = 70,
+	KEY_W = 87,
+	KEY_ESCAPE = 256
+} CP_KEY;
+
+
+namespace HeadlessProcessing
+{
+	// the scenarios simulate with a fixed 30 Hz step, so the loop ticks at the same rate
+	const float kTick_Secs = 1.0f / 30.0f;
+
+	// hold a key down, as a scripted run does around one state's Update, until it is released
+	void PressKey(CP_KEY key);
+	void ReleaseKey();
+	bool IsKeyPressed(CP_KEY key);
+}
+
+
+// engine
+void CP_Engine_SetNextGameStateForced(FunctionPtr init, FunctionPtr update, FunctionPtr exit);
+void CP_Engine_Run(void);
+void CP_Engine_Terminate(void);
+
+// system
+inline float CP_System_GetDt(void) { return HeadlessProcessing::kTick_Secs; }
+
+// input
+inline int CP_Input_KeyTriggered(CP_KEY key) { return HeadlessProcessing::IsKeyPressed(key); }
+inline int CP_Input_KeyReleased(CP_KEY) { return 0; }
+inline int CP_Input_KeyDown(CP_KEY key) { return HeadlessProcessing::IsKeyPressed(key); }
+
+// color and math
+inline CP_Color CP_Color_Create(const int r, const int g, const int b, const int a)
+{
+	CP_Color color;
+	color.r = r;
+	color.g = g;
+	color.b = b;
+	color.a = a;
+	return color;
+}
+inline float CP_Math_Distance(const float x1, const float y1, const float x2, const float y2)
+{
+	return sqrtf((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+}
+
+// settings and drawing
+inline void CP_Settings_Background(CP_Color) { }
+inline void CP_Settings_Fill(CP_Color) { }
+inline void CP_Settings_Stroke(CP_Color) { }
+inline void CP_Settings_NoStroke(void) { }
+inline void CP_Settings_TextSize(float) { }
+inline void CP_Settings_TextAlignment(CP_TEXT_ALIGN_HORIZONTAL, CP_TEXT_ALIGN_VERTICAL) { }
+inline void CP_Graphics_DrawCircle(float, float, float) { }
+inline void CP_Graphics_DrawLine(float, float, float, float) { }
+inline void CP_Font_DrawText(const char*, float, float) { }
\ No newline at end of file
@@ -0,0 +1,44 @@
+//---------------------------------------------------------
+// file:	HeadlessServerState.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	The base state for the headless server, which hosts a session for every client, and hosts again if that ends.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "HeadlessServerState.h"
+#include "GameStateManager.h"
+#include "SessionHostingState.h"
+
+const float kRehostDelay_Secs = 1.0f; // wait between hosting attempts, so a port that will not bind does not spin
+
+
+HeadlessServerState::HeadlessServerState(NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator, std::string game_type, ServerConfiguration configuration)
+	: scenario_state_creator_(scenario_state_creator),
+	game_type_(game_type),
+	configuration_(configuration),
+	rehost_timer_secs_(0.0f) // host right away
+{ }
+
+
+HeadlessServerState::~HeadlessServerState() = default;
+
+
+void HeadlessServerState::Update()
+{
+	rehost_timer_secs_ -= CP_System_GetDt();
+	if (rehost_timer_secs_ > 0.0f)
+	{
+		return;
+	}
+
+	// we only come back here if hosting fails, so just host again
+	rehost_timer_secs_ = kRehostDelay_Secs;
+	GameStateManager::ApplyState(new SessionHostingState(scenario_state_creator_, game_type_, configuration_));
+}
+
+
+void HeadlessServerState::Draw()
+{ }
\ No newline at end of file
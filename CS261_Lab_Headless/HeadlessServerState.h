@@ -0,0 +1,35 @@
+//---------------------------------------------------------
+// file:	HeadlessServerState.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	The base state for the headless server, which hosts a session for every client, and hosts again if that ends.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+#include "GameState.h"
+#include "NetworkedScenarioState.h"
+#include "ServerConfiguration.h"
+
+
+/// <summary>
+/// The base state for the headless server, which hosts a session for every client, and hosts again if that ends.
+/// </summary>
+class HeadlessServerState :
+    public GameState
+{
+public:
+	HeadlessServerState(NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator, std::string game_type, ServerConfiguration configuration);
+	~HeadlessServerState() override;
+
+	void Update() override;
+	void Draw() override;
+
+private:
+	NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator_;
+	std::string game_type_;
+	ServerConfiguration configuration_;
+	float rehost_timer_secs_;
+};
\ No newline at end of file
@@ -0,0 +1,692 @@
+//---------------------------------------------------------
+// file:	LoopbackCheck.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Runs a host and a client of each scenario in this process, joined by a LoopbackTransport, and checks they agree.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "LoopbackCheck.h"
+#include "Checker.h"
+#include "AllocationCounter.h"
+#include <map>
+#include <memory>
+#include <vector>
+#include "FragmentChannel.h"
+#include "LabClock.h"
+#include "LoopbackTransport.h"
+#include "NetworkConditionTransport.h"
+#include "LockstepScenarioState.h"
+#include "DumbClientScenarioState.h"
+#include "OptimisticHostScenarioState.h"
+#include "OptimisticClientScenarioState.h"
+
+const unsigned int kDefaultTickCount = 900; // thirty seconds of simulation
+const unsigned int kPauseStartTick = 320; // the client holds SPACE from here...
+const unsigned int kPauseEndTick = 400; // ... to here, between two attacks
+const unsigned int kPauseSettle_Ticks = 45; // how long the pause may take to reach the host, after which its view must hold still
+const unsigned int kAttackInterval_Ticks = 90; // the client presses F this often, and each attack must be confirmed before the next
+const unsigned int kHostHistory_Frames = 300; // the host's views kept, for the client's to be compared against
+const unsigned int kSteadyStateTick = 30; // from here on, after the first second, the scenarios must not allocate
+const unsigned int kFloodFactor = 10; // in the flood case, the host runs and sends this many times per client tick
+const unsigned int kReliableAttackInterval_Ticks = 5; // in the reliable case, the client presses F this often...
+const unsigned int kReliableSettle_Ticks = 90; // ... until this long before the end, which leaves every message time to be acked
+const char* kLossyLink = "loss=0.1,burst_start=0.02,burst_end=0.3,reorder=0.05,duplicate=0.05"; // layered over a link that loses nothing, for the reliable case
+const char* kReorderingLink = "reorder=0.2,duplicate=0.1"; // layered over the given link, without its loss, for the fragment case
+const MessageTypeId kFragmentedMessageType = 1; // the large messages the fragment case sends
+const unsigned int kFragmentsPerTick = 2; // the fragment case sends this many datagrams a tick, each with one fragment...
+const unsigned int kFragmentSettle_Ticks = 60; // ... and stops queueing messages this long before the end, so every one finishes or times out
+const float kPositionTolerance = 0.1f; // covers the optimistic quantization (1/16) and the moves Player skips (0.01)
+
+
+namespace
+{
+	/// <summary>
+	/// The two sides of one scenario, joined in memory.
+	/// </summary>
+	struct ScenarioPair
+	{
+		std::unique_ptr<NetworkedScenarioState> host;
+		std::unique_ptr<NetworkedScenarioState> client;
+	};
+
+
+	/// <summary>
+	/// Create the host and client of a game type, with the conditions simulated at the client's end, as the windowed client does.
+	/// </summary>
+	/// <returns>If false, the game type is unknown.</returns>
+	bool CreatePair(const std::string& game_type, const NetworkConditions& conditions, ScenarioPair& pair)
+	{
+		auto transports = LoopbackTransport::CreatePair();
+		auto client_transport = NetworkConditionTransport::Wrap(std::move(transports.second), conditions);
+		if (game_type == "Lockstep")
+		{
+			pair.host.reset(new LockstepScenarioState(std::move(transports.first), true));
+			pair.client.reset(new LockstepScenarioState(std::move(client_transport), false));
+		}
+		else if (game_type == "DumbClient")
+		{
+			pair.host.reset(new DumbClientScenarioState(std::move(transports.first), true));
+			pair.client.reset(new DumbClientScenarioState(std::move(client_transport), false));
+		}
+		else if (game_type == "Optimistic")
+		{
+			pair.host.reset(new OptimisticHostScenarioState(std::move(transports.first)));
+			pair.client.reset(new OptimisticClientScenarioState(std::move(client_transport)));
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+
+
+	bool IsNear(const float value, const float expected)
+	{
+		return fabsf(value - expected) <= kPositionTolerance;
+	}
+
+
+	/// <summary>
+	/// Run one game type for the given ticks, checking the two sides against each other after every tick.
+	/// </summary>
+	/// <returns>If false, a check failed, or the game type is unknown.</returns>
+	bool RunScenario(const std::string& game_type, const unsigned int tick_count, const NetworkConditions& conditions)
+	{
+		ScenarioPair pair;
+		if (!CreatePair(game_type, conditions, pair))
+		{
+			std::cerr << "Unknown game type '" << game_type << "', expected Lockstep, DumbClient, Optimistic, Flood, Reliable, Fragments, or All" << std::endl;
+			return false;
+		}
+		const auto is_lockstep = (game_type == "Lockstep");
+		const auto is_optimistic = (game_type == "Optimistic");
+		const auto* optimistic_host = is_optimistic ? static_cast<const OptimisticHostScenarioState*>(pair.host.get()) : nullptr;
+		const auto* optimistic_client = is_optimistic ? static_cast<const OptimisticClientScenarioState*>(pair.client.get()) : nullptr;
+		const auto tick = std::chrono::duration_cast<LabClock::duration>(std::chrono::duration<float>(HeadlessProcessing::kTick_Secs));
+
+		Checker checker(game_type);
+		// the host's view on each of its recent frames, which the client's view of that frame must match
+		std::map<u_long, NetworkedScenarioState::View> host_history;
+		u_long last_client_remote_frame = 0;
+		NetworkedScenarioState::View paused_host_view{};
+		// the attack waiting to be confirmed, if any
+		bool is_attack_pending = false;
+		unsigned int attack_tick = 0;
+		Attack pending_attack;
+		unsigned int attack_count = 0;
+		unsigned int confirmed_count = 0;
+		unsigned int agreed_count = 0;
+		unsigned int steady_allocation_count = 0;
+
+		for (unsigned int i = 0; i < tick_count; ++i)
+		{
+			LabClock::Advance(tick);
+			const auto allocations = AllocationCounter::GetCount();
+			pair.host->Update();
+
+			const auto is_attacking = is_optimistic && (i % kAttackInterval_Ticks == kAttackInterval_Ticks / 2) && (i + kAttackInterval_Ticks < tick_count);
+			if (is_attacking)
+			{
+				checker.Check(!is_attack_pending, attack_tick, "the attack was never confirmed");
+				HeadlessProcessing::PressKey(KEY_F);
+			}
+			else if ((i >= kPauseStartTick) && (i < kPauseEndTick))
+			{
+				HeadlessProcessing::PressKey(KEY_SPACE);
+			}
+			pair.client->Update();
+			HeadlessProcessing::ReleaseKey();
+			// once the scenario is under way, nothing it does each tick may touch the heap
+			if (i >= kSteadyStateTick)
+			{
+				steady_allocation_count += static_cast<unsigned int>(AllocationCounter::GetCount() - allocations);
+				checker.Check(AllocationCounter::GetCount() == allocations, i, "the tick allocated memory");
+			}
+
+			const auto host = pair.host->GetView();
+			const auto client = pair.client->GetView();
+			// the host sends a frame on the tick it simulates it, so the first view of each frame is the one sent
+			host_history.emplace(host.local_frame, host);
+			while (PacketSerializer::IsFrameNewer(host.local_frame, host_history.begin()->first + kHostHistory_Frames))
+			{
+				host_history.erase(host_history.begin());
+			}
+
+			checker.Check(!PacketSerializer::IsFrameNewer(client.remote_frame, host.local_frame), i, "the client has seen a frame the host has not simulated");
+			if (is_lockstep)
+			{
+				// neither side may run more than a frame ahead, and on the same frame, both must be in the same place
+				checker.Check(!PacketSerializer::IsFrameNewer(host.local_frame, client.local_frame + 1) && !PacketSerializer::IsFrameNewer(client.local_frame, host.local_frame + 1),
+					i, "the local frames are more than one apart");
+				if (host.local_frame == client.local_frame)
+				{
+					checker.Check((host.local_x == client.remote_x) && (host.local_y == client.remote_y) && (host.remote_x == client.local_x) && (host.remote_y == client.local_y),
+						i, "the players differ on the same frame");
+				}
+			}
+			else
+			{
+				// the client shows the newest state it has, though the optimistic client shows it on the next tick
+				const auto shown_frame = is_optimistic ? last_client_remote_frame : client.remote_frame;
+				const auto record = host_history.find(shown_frame);
+				if ((shown_frame != 0) && checker.Check(record != host_history.end(), i, "the client shows a frame the host no longer remembers"))
+				{
+					const auto& shown = record->second;
+					checker.Check(IsNear(client.remote_x, shown.local_x) && IsNear(client.remote_y, shown.local_y) &&
+						IsNear(client.local_x, shown.remote_x) && IsNear(client.local_y, shown.remote_y),
+						i, "the client does not show the host's positions for its frame");
+				}
+			}
+			last_client_remote_frame = client.remote_frame;
+
+			// once the client's pause has had time to arrive, the host must hold the client's player still
+			if (i == kPauseStartTick + kPauseSettle_Ticks)
+			{
+				paused_host_view = host;
+			}
+			else if (i == kPauseEndTick - 1)
+			{
+				checker.Check((host.remote_x == paused_host_view.remote_x) && (host.remote_y == paused_host_view.remote_y), i, "the client's pause never reached the host");
+			}
+
+			// every attack must come back confirmed, at the place it was made, though the host may judge the hit differently
+			if (is_attacking)
+			{
+				is_attack_pending = true;
+				attack_tick = i;
+				pending_attack = optimistic_client->GetLocalAttack();
+				++attack_count;
+			}
+			else if (is_attack_pending)
+			{
+				const auto& confirmed = optimistic_client->GetRemoteConfirmedAttack();
+				const auto& resolved = optimistic_host->GetClientAttack();
+				if (IsNear(confirmed.GetAttackX(), pending_attack.GetAttackX()) && IsNear(confirmed.GetAttackY(), pending_attack.GetAttackY()))
+				{
+					checker.Check(IsNear(resolved.GetAttackX(), pending_attack.GetAttackX()) && IsNear(resolved.GetAttackY(), pending_attack.GetAttackY()) &&
+						IsNear(confirmed.GetTargetX(), resolved.GetTargetX()) && IsNear(confirmed.GetTargetY(), resolved.GetTargetY()),
+						i, "the confirmed attack does not match the one the host resolved");
+					is_attack_pending = false;
+					++confirmed_count;
+					if (confirmed.IsTargetHit() == pending_attack.IsTargetHit())
+					{
+						++agreed_count;
+					}
+				}
+			}
+		}
+
+		const auto host = pair.host->GetView();
+		const auto client = pair.client->GetView();
+		checker.Check((host.local_frame != 0) && (client.remote_frame != 0), tick_count, "the scenario never advanced");
+		checker.Check(!is_attack_pending, attack_tick, "the attack was never confirmed");
+		for (const auto* side : { pair.host.get(), pair.client.get() })
+		{
+			checker.Check((side->GetReceiveStats().datagrams_malformed == 0) && (side->GetReceiveStats().messages_unreadable == 0), tick_count, "a side could not read what the other sent");
+		}
+		std::cout << game_type << ": " << tick_count << " ticks, host frame " << host.local_frame << ", client frame " << client.local_frame <<
+			", client has host frame " << client.remote_frame << ", " << steady_allocation_count << " allocations after the first second";
+		if (is_optimistic)
+		{
+			// the host's side of the hit is the lab's to get right, so disagreement is reported, not failed
+			std::cout << ", attacks confirmed " << confirmed_count << "/" << attack_count << ", hits agreed " << agreed_count << "/" << confirmed_count;
+		}
+		return checker.Report();
+	}
+
+	/// <summary>
+	/// Run the optimistic host at kFloodFactor times the tick rate, sending a state on every one of its Updates,
+	/// and check that the client drains the flood each tick, rather than falling further and further behind.
+	/// </summary>
+	/// <returns>If false, a check failed.</returns>
+	bool RunFlood(const unsigned int tick_count, const NetworkConditions& conditions)
+	{
+		ScenarioPair pair;
+		CreatePair("Optimistic", conditions, pair);
+		const auto tick = std::chrono::duration_cast<LabClock::duration>(std::chrono::duration<float>(HeadlessProcessing::kTick_Secs));
+		// the newest state may still be crossing the link, for as many ticks as the latency (and most of the jitter) lasts
+		const auto link_ticks = 1 + static_cast<unsigned int>(ceilf((conditions.latency_secs + 3.0f * conditions.jitter_secs) / HeadlessProcessing::kTick_Secs));
+		const auto max_lag_frames = kFloodFactor * link_ticks;
+		// every datagram is then either the next frame, or a duplicate of one already seen
+		const auto is_in_order = (conditions.loss_chance == 0.0f) && (conditions.burst_start_chance == 0.0f) && (conditions.reorder_chance == 0.0f) && (conditions.jitter_secs == 0.0f);
+
+		Checker checker("Flood");
+		unsigned int max_lag = 0;
+		for (unsigned int i = 0; i < tick_count; ++i)
+		{
+			// W switches the host from the automatic send rate to sending on every Update
+			for (auto update = 0u; update < kFloodFactor; ++update)
+			{
+				LabClock::Advance(tick / kFloodFactor);
+				if ((i == 0) && (update == 0))
+				{
+					HeadlessProcessing::PressKey(KEY_W);
+				}
+				pair.host->Update();
+				HeadlessProcessing::ReleaseKey();
+			}
+			pair.client->Update();
+
+			const auto& stats = pair.client->GetReceiveStats();
+			const auto host = pair.host->GetView();
+			const auto client = pair.client->GetView();
+			const auto lag = host.local_frame - client.remote_frame;
+			max_lag = std::max(max_lag, static_cast<unsigned int>(lag));
+			if (i >= link_ticks)
+			{
+				// the client keeps up: the oldest datagram waited at most a tick, and the newest state is no further behind than the link
+				checker.Check(stats.queue_delay_secs <= HeadlessProcessing::kTick_Secs + 0.001f, i, "a datagram waited longer than a tick to be drained");
+				checker.Check((stats.queue_depth > 0) && (stats.queue_depth <= 2 * kFloodFactor), i, "the drain did not take about a tick's worth of datagrams");
+				checker.Check(lag <= max_lag_frames, i, "the client fell behind the host's newest state");
+			}
+		}
+
+		const auto& stats = pair.client->GetReceiveStats();
+		const auto host = pair.host->GetView();
+		const auto client = pair.client->GetView();
+		checker.Check(host.local_frame >= kFloodFactor * (tick_count - 1), tick_count, "the host did not send on every Update");
+		checker.Check((stats.datagrams_drained + max_lag_frames >= host.local_frame) && (stats.max_queue_depth <= 2 * kFloodFactor) && (stats.datagrams_overflowed == 0),
+			tick_count, "the datagrams were not all drained as they arrived");
+		// each datagram that was not stale moved the client on at least one frame
+		checker.Check(stats.datagrams_drained - stats.datagrams_stale <= client.remote_frame, tick_count, "a stale datagram was not counted as stale");
+		if (is_in_order)
+		{
+			checker.Check(stats.datagrams_drained - stats.datagrams_stale == client.remote_frame, tick_count, "an in-order datagram was counted as stale");
+		}
+		std::cout << "Flood: " << tick_count << " ticks, host frame " << host.local_frame << " at " << kFloodFactor << "x the tick rate, client has host frame " << client.remote_frame <<
+			", drained " << stats.datagrams_drained << ", stale " << stats.datagrams_stale << ", max queue depth " << stats.max_queue_depth <<
+			", max lag " << max_lag << " frames";
+		return checker.Report();
+	}
+
+	/// <summary>
+	/// Run the optimistic scenarios over a lossy link, with the client attacking every few ticks, and check that
+	/// every attack reaches the host exactly once, and every confirmation reaches the client exactly once.
+	/// </summary>
+	/// <remarks>If the conditions lose nothing, kLossyLink is layered over them, and the channel must then also
+	/// have resent, recovered an ack from the bitfield, and dropped a repeated message id along the way.</remarks>
+	/// <returns>If false, a check failed.</returns>
+	bool RunReliable(const unsigned int tick_count, const NetworkConditions& conditions)
+	{
+		auto lossy_conditions = conditions;
+		const auto is_layered = (conditions.loss_chance == 0.0f) && (conditions.burst_start_chance == 0.0f);
+		if (is_layered)
+		{
+			NetworkConditions::Parse(kLossyLink, lossy_conditions);
+		}
+		ScenarioPair pair;
+		CreatePair("Optimistic", lossy_conditions, pair);
+		const auto* host = static_cast<const OptimisticHostScenarioState*>(pair.host.get());
+		const auto* client = static_cast<const OptimisticClientScenarioState*>(pair.client.get());
+		const auto tick = std::chrono::duration_cast<LabClock::duration>(std::chrono::duration<float>(HeadlessProcessing::kTick_Secs));
+
+		Checker checker("Reliable");
+		unsigned int attack_count = 0;
+		for (unsigned int i = 0; i < tick_count; ++i)
+		{
+			LabClock::Advance(tick);
+			pair.host->Update();
+			// the host can only resolve an attack made against a state it sent
+			if ((client->GetView().remote_frame != 0) && (i % kReliableAttackInterval_Ticks == 0) && (i + kReliableSettle_Ticks < tick_count))
+			{
+				HeadlessProcessing::PressKey(KEY_F);
+				++attack_count;
+			}
+			pair.client->Update();
+			HeadlessProcessing::ReleaseKey();
+
+			// a message id repeated, or a datagram dispatched twice, shows up as more delivered than sent
+			checker.Check(host->GetReliableStats().reliable_delivered <= client->GetReliableStats().reliable_queued, i, "an attack reached the host more than once");
+			checker.Check(client->GetReliableStats().reliable_delivered <= host->GetReliableStats().reliable_queued, i, "a confirmation reached the client more than once");
+		}
+
+		const auto& host_stats = host->GetReliableStats();
+		const auto& client_stats = client->GetReliableStats();
+		checker.Check(client_stats.reliable_queued == attack_count, tick_count, "an attack was not queued");
+		checker.Check(host_stats.reliable_delivered == client_stats.reliable_queued, tick_count, "an attack never reached the host");
+		// the host confirms each attack it receives, once
+		checker.Check(host_stats.reliable_queued == host_stats.reliable_delivered, tick_count, "an attack was not confirmed");
+		checker.Check(client_stats.reliable_delivered == host_stats.reliable_queued, tick_count, "a confirmation never reached the client");
+		checker.Check((client_stats.reliable_acked == client_stats.reliable_queued) && (host_stats.reliable_acked == host_stats.reliable_queued),
+			tick_count, "a delivered message was never acked");
+		if (is_layered)
+		{
+			checker.Check((client_stats.reliable_resent > 0) && (host_stats.reliable_resent > 0), tick_count, "the lossy link never made a side resend");
+			checker.Check(client_stats.reliable_acked_by_bits + host_stats.reliable_acked_by_bits > 0, tick_count, "no message was acked by the bitfield alone");
+			checker.Check(client_stats.reliable_duplicates + host_stats.reliable_duplicates > 0, tick_count, "no repeated message id was dropped");
+		}
+		std::cout << "Reliable: " << tick_count << " ticks, attacks sent " << client_stats.reliable_queued << ", received " << host_stats.reliable_delivered <<
+			", confirmations received " << client_stats.reliable_delivered << ", resent " << client_stats.reliable_resent + host_stats.reliable_resent <<
+			", acked by the bitfield " << client_stats.reliable_acked_by_bits + host_stats.reliable_acked_by_bits <<
+			", repeats dropped " << client_stats.reliable_duplicates + host_stats.reliable_duplicates;
+		return checker.Report();
+	}
+
+	/// <summary>
+	/// Write a message of kFragmentedMessageType, numbered, whose size and bytes follow from its number.
+	/// </summary>
+	bool WriteFragmentedMessage(MessageWriter& writer, const uint32_t number)
+	{
+		const auto max_size = FragmentChannel::kMaxMessageSize - MessageWriter::kMaxHeaderSize - sizeof(uint32_t);
+		// steps that do not divide the fragment size, so the last fragment's size varies from message to message
+		const auto size = 1 + (number * 997) % max_size;
+		return writer.Write(kFragmentedMessageType, [&](Packet& payload)
+			{
+				if (!PacketSerializer::WriteValue(payload, number) || (payload.GetRemainingSpace() < size))
+				{
+					return false;
+				}
+				for (unsigned int i = 0; i < size; ++i)
+				{
+					payload.GetTarget()[i] = static_cast<char>(number + i);
+				}
+				payload.AdvanceUnchecked(size);
+				return true;
+			});
+	}
+
+
+	/// <summary>
+	/// Read a message written by WriteFragmentedMessage.
+	/// </summary>
+	/// <returns>If false, the message is not the size, or does not hold the bytes, that its number calls for.</returns>
+	bool ReadFragmentedMessage(Packet& payload, uint32_t& number)
+	{
+		if (!PacketSerializer::ReadValue(payload, number))
+		{
+			return false;
+		}
+		const auto max_size = FragmentChannel::kMaxMessageSize - MessageWriter::kMaxHeaderSize - sizeof(uint32_t);
+		const auto size = 1 + (number * 997) % max_size;
+		if (payload.GetRemainingSpace() != size)
+		{
+			return false;
+		}
+		for (unsigned int i = 0; i < size; ++i)
+		{
+			if (payload.GetTarget()[i] != static_cast<char>(number + i))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	/// <summary>
+	/// Send numbered messages through a FragmentChannel over the given link, one after another, and check what is reassembled.
+	/// </summary>
+	/// <remarks>Every message reassembled must be intact, and reassembled once.  Over a link that loses nothing, every
+	/// message must be; over one that loses fragments, some messages must still be, and some must time out.</remarks>
+	void RunFragmentLink(const char* name, const NetworkConditions& conditions, const unsigned int tick_count, Checker& checker)
+	{
+		auto transports = LoopbackTransport::CreatePair();
+		auto sender = std::move(transports.first);
+		auto receiver = NetworkConditionTransport::Wrap(std::move(transports.second), conditions);
+		MessageDispatcher sending_dispatcher;
+		MessageDispatcher receiving_dispatcher;
+		FragmentChannel sending(sending_dispatcher);
+		FragmentChannel receiving(receiving_dispatcher);
+		const auto is_lossy = (conditions.loss_chance > 0.0f) || (conditions.burst_start_chance > 0.0f);
+		const auto tick = std::chrono::duration_cast<LabClock::duration>(std::chrono::duration<float>(HeadlessProcessing::kTick_Secs));
+
+		// how many times each message was reassembled
+		std::vector<unsigned int> received_counts;
+		receiving_dispatcher.Register(kFragmentedMessageType, [&](Packet& payload)
+			{
+				uint32_t number;
+				if (!ReadFragmentedMessage(payload, number) || (number >= received_counts.size()))
+				{
+					return false;
+				}
+				++received_counts[number];
+				return true;
+			});
+
+		char buffer[kMaxDatagramSize];
+		for (unsigned int i = 0; i < tick_count; ++i)
+		{
+			LabClock::Advance(tick);
+			if (!sending.HasPendingFragments() && (i + kFragmentSettle_Ticks < tick_count))
+			{
+				const auto number = static_cast<uint32_t>(received_counts.size());
+				checker.Check(sending.Queue([=](MessageWriter& writer) { return WriteFragmentedMessage(writer, number); }), i, "a message could not be queued");
+				received_counts.push_back(0);
+			}
+			for (unsigned int fragment = 0; fragment < kFragmentsPerTick; ++fragment)
+			{
+				Packet packet(buffer, kMaxDatagramSize);
+				MessageWriter writer(packet);
+				if (!sending.WriteFragment(writer))
+				{
+					break;
+				}
+				sender->Send(packet);
+			}
+
+			receiving.Update(HeadlessProcessing::kTick_Secs);
+			DatagramTransport::ReceivedDatagram datagram;
+			while (receiver->Receive(datagram))
+			{
+				Packet packet(datagram.buffer.GetData(), datagram.buffer.GetSize());
+				receiving_dispatcher.Dispatch(packet);
+				datagram.buffer.Reset();
+			}
+		}
+
+		const auto& stats = receiving.GetStats();
+		unsigned int reassembled_count = 0;
+		for (const auto received_count : received_counts)
+		{
+			checker.Check(received_count <= 1, tick_count, "a message was reassembled more than once");
+			checker.Check(is_lossy || (received_count == 1), tick_count, "a message was never reassembled over a link that loses nothing");
+			reassembled_count += (received_count > 0) ? 1 : 0;
+		}
+		checker.Check((receiving_dispatcher.GetStats().datagrams_malformed == 0) && (receiving_dispatcher.GetStats().messages_unreadable == 0),
+			tick_count, "a message was not reassembled as it was sent");
+		checker.Check(stats.messages_received == reassembled_count, tick_count, "a reassembled message was not dispatched");
+		checker.Check(stats.messages_received + stats.messages_timed_out + stats.messages_displaced <= sending.GetStats().messages_sent,
+			tick_count, "more messages finished than were sent");
+		if (is_lossy)
+		{
+			checker.Check(stats.messages_received > 0, tick_count, "no message was reassembled over the lossy link");
+			checker.Check(stats.messages_timed_out > 0, tick_count, "no message missing a fragment timed out");
+		}
+		else
+		{
+			checker.Check((stats.messages_timed_out == 0) && (stats.messages_displaced == 0), tick_count, "a message was dropped over a link that loses nothing");
+		}
+		std::cout << "Fragments, " << name << ": " << sending.GetStats().messages_sent << " messages in " << sending.GetStats().fragments_sent <<
+			" fragments, reassembled " << stats.messages_received << ", timed out " << stats.messages_timed_out << ", displaced " << stats.messages_displaced <<
+			", duplicate fragments " << stats.fragments_duplicate << ", stale fragments " << stats.fragments_stale << std::endl;
+	}
+
+
+	/// <summary>
+	/// Hand a FragmentChannel fragments made up to be malformed, out of range, stale, or late, and check what it makes of each.
+	/// </summary>
+	void CheckFragmentEdges(Checker& checker)
+	{
+		MessageDispatcher dispatcher;
+		FragmentChannel channel(dispatcher);
+		unsigned int dispatched_count = 0;
+		dispatcher.Register(kFragmentedMessageType, [&](Packet&) { ++dispatched_count; return true; });
+
+		// deliver one datagram holding one fragment, with the given header and bytes, as a peer might send it
+		char buffer[kMaxDatagramSize];
+		char data[kMaxDatagramSize] = {};
+		const auto deliver = [&](const uint32_t id, const uint8_t index, const uint8_t fragment_count, const unsigned int size, const char* bytes)
+			{
+				Packet packet(buffer, kMaxDatagramSize);
+				MessageWriter writer(packet);
+				writer.Write(FragmentChannel::kFragmentMessageType, [&](Packet& payload)
+					{
+						return PacketSerializer::WriteVarUInt(payload, id) && PacketSerializer::WriteValue(payload, index) &&
+							PacketSerializer::WriteValue(payload, fragment_count) && PacketSerializer::WriteBytes(payload, bytes, size);
+					});
+				Packet datagram(buffer, packet.GetUsedSpace());
+				dispatcher.Dispatch(datagram);
+			};
+		const auto full = FragmentChannel::kFragmentSize;
+		const auto& stats = channel.GetStats();
+
+		// each of these is refused outright, and the channel takes nothing from it
+		struct Malformed
+		{
+			const char* failure;
+			uint32_t id;
+			uint8_t index;
+			uint8_t fragment_count;
+			unsigned int size;
+		};
+		const Malformed malformed[] = {
+			{ "a fragment whose index is past its count was accepted", 1, 2, 2, full },
+			{ "a fragment of a message with no fragments was accepted", 1, 0, 0, 10 },
+			{ "a fragment of a message with too many fragments was accepted", 1, 0, FragmentChannel::kMaxFragmentCount + 1, full },
+			{ "a fragment whose id is past 16 bits was accepted", 0x10000, 0, 1, 10 },
+			{ "a short fragment before the last was accepted", 1, 0, 2, 10 },
+			{ "a fragment larger than kFragmentSize was accepted", 1, 0, 1, full + 1 },
+			{ "an empty fragment was accepted", 1, 0, 1, 0 },
+		};
+		for (const auto& fragment : malformed)
+		{
+			const auto unreadable_count = dispatcher.GetStats().messages_unreadable;
+			deliver(fragment.id, fragment.index, fragment.fragment_count, fragment.size, data);
+			checker.Check((dispatcher.GetStats().messages_unreadable == unreadable_count + 1) && (stats.fragments_received == 0), 0, fragment.failure);
+		}
+		{
+			// a header cut short, which no length can make up for
+			Packet packet(buffer, kMaxDatagramSize);
+			MessageWriter writer(packet);
+			writer.Write(FragmentChannel::kFragmentMessageType, [](Packet& payload) { return PacketSerializer::WriteVarUInt(payload, 1); });
+			Packet datagram(buffer, packet.GetUsedSpace());
+			const auto unreadable_count = dispatcher.GetStats().messages_unreadable;
+			dispatcher.Dispatch(datagram);
+			checker.Check((dispatcher.GetStats().messages_unreadable == unreadable_count + 1) && (stats.fragments_received == 0), 0, "a fragment with a truncated header was accepted");
+		}
+
+		// a message arriving out of order and duplicated is reassembled once, and its late fragments are dropped as duplicates
+		Packet message(data, kMaxDatagramSize);
+		MessageWriter message_writer(message);
+		message_writer.Write(kFragmentedMessageType, [&](Packet& payload) { return PacketSerializer::WriteBytes(payload, data + kMaxDatagramSize / 2, full); });
+		deliver(2, 1, 2, message.GetUsedSpace() - full, data + full);
+		deliver(2, 1, 2, message.GetUsedSpace() - full, data + full);
+		deliver(2, 0, 2, full, data);
+		deliver(2, 1, 2, message.GetUsedSpace() - full, data + full);
+		checker.Check((dispatched_count == 1) && (stats.messages_received == 1) && (stats.fragments_duplicate == 2), 1, "an out of order, duplicated message was not reassembled once");
+
+		// a fragment whose count disagrees with the message's earlier fragments is refused
+		deliver(3, 0, 3, full, data);
+		auto unreadable_count = dispatcher.GetStats().messages_unreadable;
+		deliver(3, 1, 2, full, data);
+		checker.Check(dispatcher.GetStats().messages_unreadable == unreadable_count + 1, 2, "a fragment whose count disagreed with its message was accepted");
+
+		// a reassembled message may not carry a fragment of its own
+		Packet nested(data, kMaxDatagramSize);
+		MessageWriter nested_writer(nested);
+		nested_writer.Write(FragmentChannel::kFragmentMessageType, [](Packet& payload)
+			{
+				return PacketSerializer::WriteVarUInt(payload, 4) && PacketSerializer::WriteValue<uint8_t>(payload, 0) &&
+					PacketSerializer::WriteValue<uint8_t>(payload, 1) && PacketSerializer::WriteValue<uint8_t>(payload, 0);
+			});
+		unreadable_count = dispatcher.GetStats().messages_unreadable;
+		deliver(5, 0, 1, nested.GetUsedSpace(), data);
+		checker.Check((stats.messages_received == 2) && (dispatcher.GetStats().messages_unreadable == unreadable_count + 1), 3, "a fragment nested in a reassembled message was accepted");
+
+		// a message still missing fragments a second after it started is dropped, and its last fragment starts over
+		channel.Update(0.75f);
+		deliver(6, 0, 2, full, data);
+		channel.Update(0.5f);
+		checker.Check(stats.messages_timed_out == 1, 4, "an incomplete message did not time out, or timed out early"); // 3, but not 6
+		channel.Update(0.75f);
+		checker.Check(stats.messages_timed_out == 2, 4, "an incomplete message did not time out");
+		deliver(6, 1, 2, 1, data);
+		checker.Check(stats.messages_received == 2, 4, "a message was reassembled from fragments either side of its timeout");
+
+		// once every reassembly holds a newer message, a fragment of an older one is stale, and pushes out nothing
+		for (uint32_t id = 10; id < 10 + FragmentChannel::kMaxReassemblies; ++id)
+		{
+			deliver(id, 0, 2, full, data);
+		}
+		const auto displaced_count = stats.messages_displaced;
+		deliver(9, 0, 2, full, data);
+		checker.Check((stats.fragments_stale == 1) && (stats.messages_displaced == displaced_count), 5, "a fragment older than every message in progress was not stale");
+		deliver(10 + FragmentChannel::kMaxReassemblies, 0, 2, full, data);
+		checker.Check(stats.messages_displaced == displaced_count + 1, 5, "a newer message did not push out the oldest in progress");
+	}
+
+
+	/// <summary>
+	/// Send messages too large for a datagram through a FragmentChannel, over a link that reorders and duplicates, then one
+	/// that also loses, and hand it malformed and out of range fragments, checking that it reassembles, times out, and refuses as it should.
+	/// </summary>
+	/// <returns>If false, a check failed.</returns>
+	bool RunFragments(const unsigned int tick_count, const NetworkConditions& conditions)
+	{
+		Checker checker("Fragments");
+
+		auto reordering_conditions = conditions;
+		NetworkConditions::Parse(kReorderingLink, reordering_conditions);
+		reordering_conditions.loss_chance = 0.0f;
+		reordering_conditions.burst_start_chance = 0.0f;
+		RunFragmentLink("reordering link", reordering_conditions, tick_count, checker);
+
+		auto lossy_conditions = conditions;
+		if ((conditions.loss_chance == 0.0f) && (conditions.burst_start_chance == 0.0f))
+		{
+			NetworkConditions::Parse(kLossyLink, lossy_conditions);
+		}
+		RunFragmentLink("lossy link", lossy_conditions, tick_count, checker);
+
+		CheckFragmentEdges(checker);
+		std::cout << "Fragments: malformed, out of range, stale, and late fragments";
+		return checker.Report();
+	}
+}
+
+
+/// <summary>
+/// Run the check on the game type given after kArgument, or on all of them, for the given ticks.
+/// </summary>
+/// <returns>If false, a check failed.</returns>
+bool LoopbackCheck::Run(const int argc, char** argv)
+{
+	const std::string game_type = (argc > 2) ? argv[2] : "All";
+	const auto tick_count = (argc > 3) ? static_cast<unsigned int>(std::max(atoi(argv[3]), 1)) : kDefaultTickCount;
+	const auto conditions = NetworkConditions::FromArguments(argc, argv);
+	const auto game_types = (game_type == "All") ? std::vector<std::string>{ "Lockstep", "DumbClient", "Optimistic", "Flood", "Reliable", "Fragments" } : std::vector<std::string>{ game_type };
+
+	// every timestamp now follows the ticks, rather than how long each one took to run
+	LabClock::SetManual(true);
+	auto is_passed = true;
+	for (const auto& type : game_types)
+	{
+		auto is_type_passed = false;
+		if (type == "Flood")
+		{
+			is_type_passed = RunFlood(tick_count, conditions);
+		}
+		else if (type == "Reliable")
+		{
+			is_type_passed = RunReliable(tick_count, conditions);
+		}
+		else if (type == "Fragments")
+		{
+			is_type_passed = RunFragments(tick_count, conditions);
+		}
+		else
+		{
+			is_type_passed = RunScenario(type, tick_count, conditions);
+		}
+		if (!is_type_passed)
+		{
+			is_passed = false;
+		}
+	}
+	LabClock::SetManual(false);
+	return is_passed;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+//---------------------------------------------------------
+// file:	LoopbackCheck.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Runs a host and a client of each scenario in this process, joined by a LoopbackTransport, and checks they agree.
+//
+// remarks: Usage: CS261_Lab_Headless --loopback [Lockstep|DumbClient|Optimistic|Flood|Reliable|Fragments|All] [ticks] [--net=conditions]
+//          LabClock is advanced by hand, one fixed tick at a time, and the --net= conditions are seeded,
+//          so every run with the same arguments is the same.  The client holds SPACE for a while, and in
+//          the optimistic scenario presses F every few seconds.  Each tick, the frame counters and player
+//          positions on the two sides are compared, and every attack must come back confirmed.  After the
+//          first second, a tick that allocates from the heap fails, as counted by AllocationCounter.
+//          Flood runs the optimistic host at ten times the tick rate, sending on every Update, and checks
+//          that the client drains each tick's datagrams on that tick, so the state it shows never falls behind.
+//          Reliable presses F every few ticks over a lossy link, and checks that every attack reaches the host, and
+//          every confirmation the client, exactly once.  Fragments sends messages too large for a datagram through
+//          a FragmentChannel over reordering and lossy links, and hands it malformed and out of range fragments.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+
+
+namespace LoopbackCheck
+{
+	// given first on the command line, in place of the port, to run the check instead of a server
+	constexpr const char* kArgument = "--loopback";
+
+	bool Run(int argc, char** argv);
+}
\ No newline at end of file
@@ -0,0 +1,727 @@
+//---------------------------------------------------------
+// file:	WireFormatCheck.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Round-trips every wire encoding the lab uses, at its edges, and checks what comes back.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "pch.h"
+#include "WireFormatCheck.h"
+#include <cfloat>
+#include <limits>
+#include <tuple>
+#include <vector>
+#include "Checker.h"
+#include "BitWriter.h"
+#include "BitReader.h"
+#include "LabMath.h"
+#include "PacketSerializer.h"
+#include "MessageDispatcher.h"
+#include "MessageSchema.h"
+#include "OptimisticMessages.h"
+
+using PacketSerializer::Format;
+
+
+namespace
+{
+	/// <summary>
+	/// A packet over the bytes another packet has written, less the last trimmed_bytes, for reading them back.
+	/// </summary>
+	Packet GetWritten(const Packet& packet, const unsigned int trimmed_bytes = 0)
+	{
+		return Packet(packet.GetRoot(), packet.GetUsedSpace() - trimmed_bytes);
+	}
+
+
+	bool IsSameBits(const float value, const float expected)
+	{
+		return memcmp(&value, &expected, sizeof(value)) == 0;
+	}
+
+
+	bool IsWithinQuantization(const float value, const float expected, const PacketSerializer::QuantizedField& field)
+	{
+		// the reconstruction itself is done in float, which may add a rounding step of its own
+		return fabsf(value - expected) <= PacketSerializer::GetQuantizationError(field.min, field.max, field.bits) * 1.001f;
+	}
+
+
+	/// <summary>
+	/// Every width from 1 to 32 bits, at the edges of its range, never starting on a byte boundary.
+	/// </summary>
+	bool CheckBits()
+	{
+		Checker checker("BitWriter/BitReader", "bits");
+		const uint32_t kMarker = 5;
+		const unsigned int kMarkerBits = 3;
+		for (auto bit_count = 1u; bit_count <= 32; ++bit_count)
+		{
+			const auto max = (bit_count < 32) ? (1u << bit_count) - 1u : 0xFFFFFFFFu;
+			const uint32_t values[] = { 0u, 1u, max, max >> 1, 0xA5A5A5A5u & max };
+
+			// the bits above the width are set, and must be dropped
+			FixedPacket<64> packet;
+			BitWriter writer(packet);
+			auto is_written = true;
+			for (const auto value : values)
+			{
+				is_written = writer.WriteBits(kMarker, kMarkerBits) && writer.WriteBits(value | ~max, bit_count) && is_written;
+			}
+			is_written = writer.Flush() && is_written;
+			checker.Check(is_written, bit_count, "the values could not be written");
+			checker.Check(writer.GetBitsWritten() == std::size(values) * (kMarkerBits + bit_count), bit_count, "the wrong number of bits were written");
+			checker.Check(packet.GetUsedSpace() == (writer.GetBitsWritten() + 7) / 8, bit_count, "the wrong number of bytes were flushed");
+
+			auto written = GetWritten(packet);
+			BitReader reader(written);
+			for (const auto value : values)
+			{
+				uint32_t marker = 0, read = 0;
+				checker.Check(reader.ReadBits(marker, kMarkerBits) && reader.ReadBits(read, bit_count) && (marker == kMarker) && (read == value),
+					bit_count, "a value read back differently");
+			}
+			// all that is left is the padding of the last byte
+			uint32_t padding;
+			checker.Check(!reader.ReadBits(padding, 8), bit_count, "a value was read out of the padding");
+			checker.Check(reader.GetBitsRead() == writer.GetBitsWritten(), bit_count, "the wrong number of bits were read");
+		}
+
+		// widths outside of [1, 32] are refused by both sides, and change nothing
+		{
+			FixedPacket<8> packet;
+			BitWriter writer(packet);
+			checker.Check(!writer.WriteBits(1, 0) && !writer.WriteBits(1, 33) && (writer.GetBitsWritten() == 0), 33, "a width outside of [1, 32] was written");
+			packet.GetRoot()[0] = 1;
+			Packet full(packet.GetRoot(), packet.kCapacity);
+			BitReader reader(full);
+			uint32_t value;
+			checker.Check(!reader.ReadBits(value, 0) && !reader.ReadBits(value, 33) && (full.GetUsedSpace() == 0), 33, "a width outside of [1, 32] was read");
+		}
+
+		// a partial byte is only written by Flush, padded with zeroes, and only once
+		{
+			FixedPacket<8> packet;
+			BitWriter writer(packet);
+			writer.WriteBits(7, 3);
+			checker.Check(packet.GetUsedSpace() == 0, 3, "a partial byte was written before Flush");
+			checker.Check(writer.Flush() && writer.Flush() && (packet.GetUsedSpace() == 1) && (static_cast<uint8_t>(packet.GetRoot()[0]) == 0x07),
+				3, "Flush did not write exactly one zero-padded byte");
+		}
+
+		// a full packet refuses the bits, and truncated input refuses to read them
+		{
+			char buffer[2];
+			Packet small(buffer, sizeof(buffer));
+			BitWriter small_writer(small);
+			checker.Check(!small_writer.WriteBits(0xFFFFFF, 24), 24, "24 bits were written into 2 bytes");
+
+			FixedPacket<8> packet;
+			BitWriter writer(packet);
+			writer.WriteBits(0xABCDE, 20);
+			writer.Flush();
+			auto truncated = GetWritten(packet, 1);
+			BitReader truncated_reader(truncated);
+			uint32_t value;
+			checker.Check(!truncated_reader.ReadBits(value, 20), 20, "20 bits were read out of 2 bytes");
+			auto written = GetWritten(packet);
+			BitReader reader(written);
+			checker.Check(reader.ReadBits(value, 20) && (value == 0xABCDE), 20, "20 bits did not read back from 3 bytes");
+		}
+
+		std::cout << "BitWriter/BitReader: widths 1 to 32";
+		return checker.Report();
+	}
+
+
+	/// <summary>
+	/// Ranged ints use just the bits of their range, reject values outside of it, and sign-extend correctly.
+	/// </summary>
+	bool CheckRangedInts()
+	{
+		Checker checker("BitWriter/BitReader ranged int", "range");
+		const int32_t kMin = std::numeric_limits<int32_t>::min();
+		const int32_t kMax = std::numeric_limits<int32_t>::max();
+		const std::pair<int32_t, int32_t> ranges[] = { { -10, 10 }, { 0, 1 }, { -1, 0 }, { 1000, 1003 }, { kMin, kMax }, { kMin, kMin + 1 }, { kMax - 1, kMax } };
+		for (auto i = 0u; i < std::size(ranges); ++i)
+		{
+			const auto min = ranges[i].first;
+			const auto max = ranges[i].second;
+			const int32_t values[] = { min, max, static_cast<int32_t>((static_cast<int64_t>(min) + max) / 2) };
+			const auto range_bits = LabMath::BitsRequired(static_cast<uint32_t>(static_cast<int64_t>(max) - min));
+
+			FixedPacket<32> packet;
+			BitWriter writer(packet);
+			auto is_written = true;
+			for (const auto value : values)
+			{
+				is_written = writer.WriteRangedInt(value, min, max) && is_written;
+			}
+			checker.Check(is_written && (writer.GetBitsWritten() == std::size(values) * range_bits), i, "the values did not take just the bits of the range");
+			checker.Check(((min == kMin) || !writer.WriteRangedInt(min - 1, min, max)) && ((max == kMax) || !writer.WriteRangedInt(max + 1, min, max)) &&
+				(writer.GetBitsWritten() == std::size(values) * range_bits), i, "a value outside of the range was written");
+			writer.Flush();
+
+			auto written = GetWritten(packet);
+			BitReader reader(written);
+			for (const auto value : values)
+			{
+				int32_t read = 0;
+				checker.Check(reader.ReadRangedInt(read, min, max) && (read == value), i, "a value read back differently");
+			}
+		}
+
+		// an empty range is refused, and a reader refuses an offset past the end of its range
+		FixedPacket<8> packet;
+		BitWriter writer(packet);
+		checker.Check(!writer.WriteRangedInt(3, 3, 3) && !writer.WriteRangedInt(3, 4, 3), std::size(ranges), "an empty range was written");
+		writer.WriteBits(7, 3);
+		writer.Flush();
+		auto written = GetWritten(packet);
+		BitReader reader(written);
+		int32_t value;
+		checker.Check(!reader.ReadRangedInt(value, 0, 4), std::size(ranges), "an offset past the end of the range was read");
+
+		std::cout << "BitWriter/BitReader ranged ints: " << std::size(ranges) << " ranges";
+		return checker.Report();
+	}
+
+
+	/// <summary>
+	/// Floats go through bits unchanged, and quantized floats come back within their error, and clamped to their range.
+	/// </summary>
+	bool CheckFloats()
+	{
+		Checker checker("BitWriter/BitReader floats", "case");
+		const float values[] = { 0.0f, -0.0f, 1.5f, -1.0e-40f, FLT_MAX, -FLT_MIN, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN() };
+		{
+			FixedPacket<64> packet;
+			BitWriter writer(packet);
+			for (const auto value : values)
+			{
+				writer.WriteBool(true);
+				writer.WriteFloat(value);
+			}
+			checker.Check(writer.Flush(), 0, "the floats could not be written");
+			auto written = GetWritten(packet);
+			BitReader reader(written);
+			for (auto i = 0u; i < std::size(values); ++i)
+			{
+				bool flag = false;
+				float read = 0.0f;
+				checker.Check(reader.ReadBool(flag) && reader.ReadFloat(read) && flag && IsSameBits(read, values[i]), i, "a float did not read back bit for bit");
+			}
+		}
+
+		const PacketSerializer::QuantizedField fields[] = { OptimisticMessages::kPositionX, OptimisticMessages::kPositionY, OptimisticMessages::kVelocity,
+			{ "Full", -1.0f, 1.0f, 32 }, { "Coarse", 0.0f, 10.0f, 3 } };
+		const unsigned int kSteps = 64;
+		for (auto i = 0u; i < std::size(fields); ++i)
+		{
+			const auto& field = fields[i];
+			FixedPacket<1024> bit_packet, byte_packet;
+			BitWriter writer(bit_packet);
+			for (auto step = 0u; step <= kSteps; ++step)
+			{
+				const auto value = field.min + (field.max - field.min) * step / kSteps;
+				writer.WriteQuantized(value, field.min, field.max, field.bits);
+				PacketSerializer::WriteQuantized(byte_packet, value, field.min, field.max, field.bits);
+			}
+			// values outside of the range are clamped to it
+			writer.WriteQuantized(field.min - 100.0f, field.min, field.max, field.bits);
+			writer.WriteQuantized(field.max + 100.0f, field.min, field.max, field.bits);
+			checker.Check(writer.Flush() && (writer.GetBitsWritten() == (kSteps + 3) * field.bits), i, "the quantized values did not take just their bits");
+			checker.Check(byte_packet.GetUsedSpace() == (kSteps + 1) * PacketSerializer::GetQuantizedSize(field.bits), i, "the quantized values did not take just their bytes");
+
+			auto bit_written = GetWritten(bit_packet);
+			auto byte_written = GetWritten(byte_packet);
+			BitReader reader(bit_written);
+			for (auto step = 0u; step <= kSteps; ++step)
+			{
+				const auto value = field.min + (field.max - field.min) * step / kSteps;
+				float bit_read = 0.0f, byte_read = 0.0f;
+				checker.Check(reader.ReadQuantized(bit_read, field.min, field.max, field.bits) && IsWithinQuantization(bit_read, value, field), i, "a bit-packed value was not within the error");
+				checker.Check(PacketSerializer::ReadQuantized(byte_written, byte_read, field.min, field.max, field.bits) && (byte_read == bit_read), i, "a byte value did not match its bit-packed twin");
+			}
+			float low = 0.0f, high = 0.0f;
+			checker.Check(reader.ReadQuantized(low, field.min, field.max, field.bits) && (low == field.min), i, "a value below the range was not clamped");
+			checker.Check(reader.ReadQuantized(high, field.min, field.max, field.bits) && IsWithinQuantization(high, field.max, field), i, "a value above the range was not clamped");
+			checker.Check(!PacketSerializer::ReadQuantized(byte_written, low, field.min, field.max, field.bits), i, "a quantized value was read past the end");
+
+			// a corrupt value past the field's bits, in the bytes read whole, must not leave [min, max]
+			if (field.bits < PacketSerializer::GetQuantizedSize(field.bits) * 8)
+			{
+				FixedPacket<8> corrupt_packet;
+				const auto corrupt = PacketSerializer::GetMaxQuantized(field.bits) + 1;
+				switch (PacketSerializer::GetQuantizedSize(field.bits))
+				{
+				case sizeof(uint8_t):
+					PacketSerializer::WriteValue<uint8_t>(corrupt_packet, static_cast<uint8_t>(corrupt));
+					break;
+				case sizeof(uint16_t):
+					PacketSerializer::WriteValue<uint16_t>(corrupt_packet, static_cast<uint16_t>(corrupt));
+					break;
+				default:
+					PacketSerializer::WriteValue<uint32_t>(corrupt_packet, corrupt);
+					break;
+				}
+				auto corrupt_written = GetWritten(corrupt_packet);
+				float corrupt_read = 0.0f;
+				checker.Check(!PacketSerializer::ReadQuantized(corrupt_written, corrupt_read, field.min, field.max, field.bits), i, "a byte value past the field's bits was read");
+			}
+		}
+
+		std::cout << "BitWriter/BitReader floats: " << std::size(values) << " floats, " << std::size(fields) << " quantized fields";
+		return checker.Report();
+	}
+
+
+	/// <summary>
+	/// Write a value, and read it back out of just the bytes it took.
+	/// </summary>
+	template <typename T>
+	bool RoundTripValue(const T value, T& read)
+	{
+		FixedPacket<16> packet;
+		if (!PacketSerializer::WriteValue<T>(packet, value) || (packet.GetUsedSpace() != PacketSerializer::kWireSize<T>))
+		{
+			return false;
+		}
+		auto written = GetWritten(packet);
+		return PacketSerializer::ReadValue<T>(written, read) && (written.GetRemainingSpace() == 0);
+	}
+
+
+	template <typename T>
+	bool IsRoundTripped(const T value)
+	{
+		T read{};
+		return RoundTripValue(value, read) && (read == value);
+	}
+
+
+	/// <summary>
+	/// Whole values keep their sign and their width on the wire, and are refused when the packet is too short.
+	/// </summary>
+	bool CheckValues()
+	{
+		Checker checker("PacketSerializer values", "case");
+		checker.Check(IsRoundTripped<int8_t>(-128) && IsRoundTripped<uint8_t>(255), 0, "an 8-bit value read back differently");
+		checker.Check(IsRoundTripped<int16_t>(-2) && IsRoundTripped<uint16_t>(0xFFFE), 1, "a 16-bit value read back differently");
+		checker.Check(IsRoundTripped<int32_t>(std::numeric_limits<int32_t>::min()) && IsRoundTripped<uint32_t>(0xFFFFFFFFu), 2, "a 32-bit value read back differently");
+		checker.Check(IsRoundTripped<unsigned long long>(std::numeric_limits<unsigned long long>::max()), 3, "a 64-bit value read back differently");
+		// long and u_long are 32 bits on the wire, whatever their size here, so a negative long must be sign-extended
+		checker.Check(IsRoundTripped<long>(-5) && IsRoundTripped<long>(std::numeric_limits<int32_t>::min()) && (PacketSerializer::kWireSize<long> == 4),
+			4, "a long did not keep its sign in 4 bytes");
+		checker.Check(IsRoundTripped<u_long>(0xFFFFFFFFu) && IsRoundTripped<u_long>(0) && (PacketSerializer::kWireSize<u_long> == 4), 5, "a u_long did not read back from 4 bytes");
+		checker.Check(IsRoundTripped(true) && IsRoundTripped(false) && IsRoundTripped(Format::Bits) && (PacketSerializer::kWireSize<bool> == 1), 6, "a bool or enum read back differently");
+		checker.Check(IsRoundTripped(-1.25f) && IsRoundTripped(FLT_MAX), 7, "a float read back differently");
+
+		// a value that does not fit is neither written nor read, and the packet does not move
+		char buffer[sizeof(uint32_t)] = {};
+		Packet short_packet(buffer, sizeof(buffer) - 1);
+		uint32_t value = 0;
+		checker.Check(!PacketSerializer::WriteValue<uint32_t>(short_packet, 1) && (short_packet.GetUsedSpace() == 0), 8, "a value was written past the end");
+		checker.Check(!PacketSerializer::ReadValue<uint32_t>(short_packet, value) && (short_packet.GetUsedSpace() == 0), 9, "a value was read past the end");
+
+		std::cout << "PacketSerializer values: signed, unsigned, and truncated";
+		return checker.Report();
+	}
+
+
+	/// <summary>
+	/// Write a value at an odd offset, so that it is never aligned, and compare its bytes with the expected wire bytes.
+	/// </summary>
+	template <typename T>
+	bool IsStoredAs(const T value, const std::vector<uint8_t>& expected)
+	{
+		char buffer[1 + sizeof(unsigned long long)] = {};
+		PacketSerializer::StoreWire<T>(buffer + 1, value);
+		T loaded{};
+		PacketSerializer::LoadWire<T>(buffer + 1, loaded);
+		return (expected.size() == PacketSerializer::kWireSize<T>) && (memcmp(buffer + 1, expected.data(), expected.size()) == 0) && (loaded == value);
+	}
+
+
+	/// <summary>
+	/// Values are little-endian on the wire, in their wire size, at any alignment, whatever the host's byte order.
+	/// </summary>
+	bool CheckByteOrder()
+	{
+		static_assert(PacketSerializer::ByteSwap<uint16_t>(0x0102) == 0x0201, "ByteSwap reversed a uint16_t wrongly");
+		static_assert(PacketSerializer::ByteSwap<uint32_t>(0x01020304u) == 0x04030201u, "ByteSwap reversed a uint32_t wrongly");
+		static_assert(PacketSerializer::ByteSwap<unsigned long long>(0x0102030405060708ull) == 0x0807060504030201ull, "ByteSwap reversed a 64-bit value wrongly");
+
+		Checker checker("PacketSerializer byte order", "case");
+		checker.Check(IsStoredAs<uint16_t>(0x0102, { 0x02, 0x01 }), 0, "a uint16_t was not stored little-endian");
+		checker.Check(IsStoredAs<uint32_t>(0x01020304u, { 0x04, 0x03, 0x02, 0x01 }), 1, "a uint32_t was not stored little-endian");
+		checker.Check(IsStoredAs<unsigned long long>(0x0102030405060708ull, { 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01 }), 2, "an unsigned long long was not stored little-endian");
+		checker.Check(IsStoredAs<int16_t>(-2, { 0xFE, 0xFF }), 3, "an int16_t was not stored in two's complement");
+		checker.Check(IsStoredAs(1.0f, { 0x00, 0x00, 0x80, 0x3F }) && IsStoredAs(-2.5f, { 0x00, 0x00, 0x20, 0xC0 }), 4, "a float was not stored as its little-endian bits");
+		checker.Check(IsStoredAs(true, { 0x01 }) && IsStoredAs(false, { 0x00 }), 5, "a bool did not take one byte");
+		checker.Check(IsStoredAs(Format::Bits, { 0x01 }), 6, "an enum did not take the size of its underlying type");
+		// long and u_long are 32 bits on the wire, even where they are 64 here, and a negative long loads back sign-extended
+		checker.Check(IsStoredAs<long>(-2, { 0xFE, 0xFF, 0xFF, 0xFF }), 7, "a long was not stored in 4 bytes, or did not load back negative");
+		checker.Check(IsStoredAs<u_long>(0x01020304u, { 0x04, 0x03, 0x02, 0x01 }), 8, "a u_long was not stored in 4 bytes");
+
+		// the same bytes come back through ReadValue at every offset
+		FixedPacket<64> packet;
+		for (auto offset = 0u; offset < 8; ++offset)
+		{
+			packet.Reset();
+			PacketSerializer::WriteBytes(packet, "\x00\x00\x00\x00\x00\x00\x00", offset);
+			PacketSerializer::WriteValue(packet, true);
+			PacketSerializer::WriteValue(packet, 1.0f);
+			PacketSerializer::WriteValue<u_long>(packet, 0xA1B2C3D4u);
+			auto written = GetWritten(packet);
+			const char* skipped;
+			bool flag = false;
+			float value = 0.0f;
+			u_long frame = 0;
+			checker.Check(PacketSerializer::ReadBytes(written, skipped, offset) && PacketSerializer::ReadValue(written, flag) && PacketSerializer::ReadValue(written, value) &&
+				PacketSerializer::ReadValue(written, frame) && flag && (value == 1.0f) && (frame == 0xA1B2C3D4u) && (written.GetUsedSpace() == offset + 9),
+				9 + offset, "a value read back differently at an unaligned offset");
+		}
+
+		std::cout << "PacketSerializer byte order: little-endian at every alignment";
+		return checker.Report();
+	}
+
+
+	/// <summary>
+	/// Varints take a byte per 7 bits, zig-zag keeps small values of either sign small, and neither is read from truncated or overlong input.
+	/// </summary>
+	bool CheckVarInts()
+	{
+		Checker checker("PacketSerializer varints", "value");
+		const std::pair<uint32_t, unsigned int> sizes[] = { { 0u, 1 }, { 127u, 1 }, { 128u, 2 }, { 16383u, 2 }, { 16384u, 3 },
+			{ (1u << 21) - 1, 3 }, { 1u << 21, 4 }, { (1u << 28) - 1, 4 }, { 1u << 28, 5 }, { 0xFFFFFFFFu, 5 } };
+		for (const auto& [value, size] : sizes)
+		{
+			FixedPacket<8> packet;
+			checker.Check(PacketSerializer::WriteVarUInt(packet, value) && (packet.GetUsedSpace() == size), value, "the varint took the wrong number of bytes");
+			auto written = GetWritten(packet);
+			uint32_t read = 0;
+			checker.Check(PacketSerializer::ReadVarUInt(written, read) && (read == value) && (written.GetRemainingSpace() == 0), value, "the varint read back differently");
+
+			// every prefix of it is refused, and does not move the packet
+			for (auto trimmed = 1u; trimmed <= size; ++trimmed)
+			{
+				auto truncated = GetWritten(packet, trimmed);
+				checker.Check(!PacketSerializer::ReadVarUInt(truncated, read) && (truncated.GetUsedSpace() == 0), value, "a truncated varint was read");
+			}
+			char buffer[8];
+			Packet short_packet(buffer, size - 1);
+			checker.Check(!PacketSerializer::WriteVarUInt(short_packet, value) && (short_packet.GetUsedSpace() == 0), value, "a varint was written past the end");
+		}
+
+		// the fifth byte carries only the top 4 bits, and there is never a sixth
+		const std::vector<std::vector<uint8_t>> overlong = { { 0xFF, 0xFF, 0xFF, 0xFF, 0x10 }, { 0x80, 0x80, 0x80, 0x80, 0x80, 0x00 } };
+		for (auto bytes : overlong)
+		{
+			Packet packet(reinterpret_cast<char*>(bytes.data()), static_cast<unsigned int>(bytes.size()));
+			uint32_t read = 0;
+			checker.Check(!PacketSerializer::ReadVarUInt(packet, read) && (packet.GetUsedSpace() == 0), bytes.size(), "an overlong varint was read");
+		}
+
+		// small values of either sign take a single byte
+		const int32_t kMin = std::numeric_limits<int32_t>::min();
+		const int32_t kMax = std::numeric_limits<int32_t>::max();
+		const std::tuple<int32_t, uint32_t, unsigned int> zig_zags[] = { { 0, 0u, 1 }, { -1, 1u, 1 }, { 1, 2u, 1 }, { -64, 127u, 1 }, { 63, 126u, 1 },
+			{ -65, 129u, 2 }, { 64, 128u, 2 }, { kMin, 0xFFFFFFFFu, 5 }, { kMax, 0xFFFFFFFEu, 5 } };
+		for (const auto& [value, encoded, size] : zig_zags)
+		{
+			checker.Check((PacketSerializer::ZigZagEncode(value) == encoded) && (PacketSerializer::ZigZagDecode(encoded) == value), encoded, "a value zig-zagged differently");
+			FixedPacket<8> packet;
+			checker.Check(PacketSerializer::WriteVarInt(packet, value) && (packet.GetUsedSpace() == size), encoded, "the signed varint took the wrong number of bytes");
+			auto written = GetWritten(packet);
+			int32_t read = 0;
+			checker.Check(PacketSerializer::ReadVarInt(written, read) && (read == value), encoded, "the signed varint read back differently");
+		}
+
+		std::cout << "PacketSerializer varints: " << std::size(sizes) << " sizes, " << std::size(zig_zags) << " signed values";
+		return checker.Report();
+	}
+
+
+	/// <summary>
+	/// Strings are prefixed with a varint length, and one that is cut short is not read at all, not even its length.
+	/// </summary>
+	bool CheckStrings()
+	{
+		Checker checker("PacketSerializer strings", "length");
+		for (const auto length : { 0u, 1u, 127u, 128u, 300u })
+		{
+			const std::string text(length, 'x');
+			const auto size = length + ((length < 128) ? 1 : 2);
+			FixedPacket<512> packet;
+			checker.Check(PacketSerializer::WriteString(packet, text) && (packet.GetUsedSpace() == size), length, "the string took the wrong number of bytes");
+			auto written = GetWritten(packet);
+			std::string read;
+			checker.Check(PacketSerializer::ReadString(written, read) && (read == text) && (written.GetRemainingSpace() == 0), length, "the string read back differently");
+			auto truncated = GetWritten(packet, 1);
+			checker.Check(!PacketSerializer::ReadString(truncated, read) && (truncated.GetUsedSpace() == 0), length, "a truncated string was read");
+
+			char buffer[512];
+			Packet short_packet(buffer, size - 1);
+			checker.Check(!PacketSerializer::WriteString(short_packet, text) && (short_packet.GetUsedSpace() == 0), length, "a string was written past the end");
+		}
+
+		std::cout << "PacketSerializer strings: lengths 0 to 300";
+		return checker.Report();
+	}
+
+
+	/// <summary>
+	/// Write a frame against acked_frame, then rebuild it from newest_received_frame.
+	/// </summary>
+	bool RoundTripFrame(const u_long frame, const u_long acked_frame, const u_long newest_received_frame, unsigned int& size)
+	{
+		FixedPacket<8> packet;
+		if (!PacketSerializer::WriteFrame(packet, frame, acked_frame))
+		{
+			return false;
+		}
+		size = packet.GetUsedSpace();
+		auto written = GetWritten(packet);
+		u_long read = 0;
+		return PacketSerializer::ReadFrame(written, read, newest_received_frame) && (read == frame);
+	}
+
+
+	/// <summary>
+	/// Frame numbers take only the bytes their distance from the ack needs, and are rebuilt across the wrap at 2^32.
+	/// </summary>
+	bool CheckFrames()
+	{
+		Checker checker("PacketSerializer frames", "distance");
+		const std::pair<uint32_t, unsigned int> distances[] = { { 0u, 1 }, { 1u, 1 }, { 63u, 1 }, { 64u, 2 }, { 8191u, 2 }, { 8192u, 3 },
+			{ (1u << 20) - 1, 3 }, { 1u << 20, 4 }, { (1u << 27) - 1, 4 }, { 1u << 27, 5 }, { 0x80000000u, 5 } };
+		for (const uint32_t acked_frame : { 0u, 123456u, 0xFFFFFFF0u, 0x7FFFFFF8u })
+		{
+			for (const auto& [distance, size] : distances)
+			{
+				const u_long frame = static_cast<uint32_t>(acked_frame + distance);
+				// the receiver has anything from the ack up to the frame before, or a few frames after it when this one was reordered
+				const uint32_t newest_frames[] = { acked_frame, static_cast<uint32_t>(frame - 1), static_cast<uint32_t>(acked_frame + distance / 2), static_cast<uint32_t>(frame + 3) };
+				for (const auto newest_received_frame : newest_frames)
+				{
+					// the receiver always has the ack itself
+					if (PacketSerializer::IsFrameNewer(acked_frame, newest_received_frame))
+					{
+						continue;
+					}
+					unsigned int written_size = 0;
+					checker.Check(RoundTripFrame(frame, acked_frame, newest_received_frame, written_size), distance, "the frame was rebuilt differently");
+					checker.Check(written_size == size, distance, "the frame took the wrong number of bytes");
+				}
+			}
+		}
+
+		// a frame written without an ack takes 2 bytes, and survives 8191 frames lost in a row, including across the wrap
+		for (const uint32_t frame : { 5u, 0x12345u, 0xFFFFFFFFu, 0x1000u })
+		{
+			for (const auto lost_frames : { 0u, 1u, 8191u })
+			{
+				FixedPacket<8> packet;
+				PacketSerializer::WriteFrame(packet, frame);
+				auto written = GetWritten(packet);
+				u_long read = 0;
+				checker.Check((packet.GetUsedSpace() == PacketSerializer::kUnackedFrameBytes) && PacketSerializer::ReadFrame(written, read, static_cast<uint32_t>(frame - 1 - lost_frames)) &&
+					(read == frame), lost_frames, "an unacked frame was rebuilt differently");
+			}
+		}
+
+		// a truncated frame is not read, and the packet does not move
+		{
+			FixedPacket<8> packet;
+			PacketSerializer::WriteFrame(packet, 1u << 20, 0);
+			auto truncated = GetWritten(packet, 1);
+			u_long read = 0;
+			checker.Check(!PacketSerializer::ReadFrame(truncated, read, 0) && (truncated.GetUsedSpace() == 0), 1u << 20, "a truncated frame was read");
+		}
+
+		checker.Check(PacketSerializer::IsFrameNewer(0, 0xFFFFFFFFu) && !PacketSerializer::IsFrameNewer(0xFFFFFFFFu, 0) && !PacketSerializer::IsFrameNewer(7, 7) &&
+			PacketSerializer::IsFrameNewer(0x7FFFFFFFu, 0) && !PacketSerializer::IsFrameNewer(0x80000000u, 0), 0, "IsFrameNewer did not allow for the wrap");
+
+		std::cout << "PacketSerializer frames: " << std::size(distances) << " distances from the ack, across the wrap";
+		return checker.Report();
+	}
+
+
+	/// <summary>
+	/// A message of one quantized field, whose 14 bits take a whole uint16_t in the Bytes format, leaving 2 bits a corrupt datagram can set.
+	/// </summary>
+	struct QuantizedMessage
+	{
+		float value;
+	};
+	using QuantizedSchema = MessageSchema::Schema<QuantizedMessage, MessageSchema::Quantized<&QuantizedMessage::value, OptimisticMessages::kPositionX>>;
+	static_assert(PacketSerializer::GetQuantizedSize(OptimisticMessages::kPositionX.bits) == sizeof(uint16_t), "the check needs spare bits in the Bytes format");
+
+
+	/// <summary>
+	/// A schema's quantized field rejects a value past its bits, read whole or rebuilt from a delta, rather than leave the range.
+	/// </summary>
+	bool CheckQuantizedRange()
+	{
+		const auto& field = OptimisticMessages::kPositionX;
+		const auto max_quantized = PacketSerializer::GetMaxQuantized(field.bits);
+		Checker checker("MessageSchema quantized range", "value");
+
+		// the Bytes format reads the whole uint16_t
+		for (const uint32_t quantized : { 0u, max_quantized, max_quantized + 1, 0xFFFFu })
+		{
+			FixedPacket<sizeof(uint16_t)> packet;
+			PacketSerializer::WriteValue(packet, static_cast<uint16_t>(quantized));
+			auto written = GetWritten(packet);
+			QuantizedMessage read = { -1.0f };
+			const auto is_read = QuantizedSchema::Read(written, read);
+			checker.Check(is_read == (quantized <= max_quantized), quantized, "a Bytes value was read past the field's bits, or not read within them");
+			checker.Check(!is_read || ((read.value >= field.min) && (read.value <= field.max)), quantized, "a Bytes value was read outside the range");
+		}
+
+		// a small delta from a baseline at either end of the range may step past it
+		const std::tuple<float, int32_t, bool> deltas[] = { { field.max, -1, true }, { field.max, 1, false }, { field.min, 1, true }, { field.min, -1, false } };
+		for (const auto& [baseline_value, delta, is_valid] : deltas)
+		{
+			FixedPacket<8> packet;
+			BitWriter writer(packet);
+			writer.WriteBool(true);
+			writer.WriteBool(true);
+			writer.WriteBits(PacketSerializer::ZigZagEncode(delta), MessageSchema::kDeltaBits);
+			writer.Flush();
+			auto written = GetWritten(packet);
+			BitReader reader(written);
+			const QuantizedMessage baseline = { baseline_value };
+			QuantizedMessage read = { -1.0f };
+			const auto step = PacketSerializer::Quantize(baseline_value, field.min, field.max, field.bits) + delta;
+			const auto is_read = QuantizedSchema::ReadDelta(reader, read, baseline);
+			checker.Check(is_read == is_valid, step, "a delta was read past the field's bits, or not read within them");
+			checker.Check(!is_read || ((read.value >= field.min) && (read.value <= field.max)), step, "a delta was read outside the range");
+		}
+
+		std::cout << "MessageSchema quantized range: Bytes values and deltas at the edges of " << field.bits << " bits";
+		return checker.Report();
+	}
+
+
+	/// <summary>
+	/// Read the only message in the packet with read_payload, through a MessageDispatcher, as the scenarios do.
+	/// </summary>
+	template <typename ReadPayload>
+	bool ReadMessage(const Packet& packet, const OptimisticMessages::MessageType type, ReadPayload&& read_payload)
+	{
+		MessageDispatcher dispatcher;
+		auto is_read = false;
+		OptimisticMessages::Register(dispatcher, type, [&](Packet& payload)
+		{
+			is_read = read_payload(payload);
+			return is_read;
+		});
+		auto written = GetWritten(packet);
+		return dispatcher.Dispatch(written) && is_read;
+	}
+
+
+	bool IsSameState(const OptimisticMessages::StateMessage& read, const OptimisticMessages::StateMessage& written)
+	{
+		using namespace OptimisticMessages;
+		return (read.frame == written.frame) &&
+			IsWithinQuantization(read.host_x, written.host_x, kPositionX) && IsWithinQuantization(read.host_y, written.host_y, kPositionY) &&
+			IsWithinQuantization(read.host_velocity_x, written.host_velocity_x, kVelocity) && IsWithinQuantization(read.host_velocity_y, written.host_velocity_y, kVelocity) &&
+			IsWithinQuantization(read.non_host_x, written.non_host_x, kPositionX) && IsWithinQuantization(read.non_host_y, written.non_host_y, kPositionY) &&
+			IsWithinQuantization(read.non_host_velocity_x, written.non_host_velocity_x, kVelocity) && IsWithinQuantization(read.non_host_velocity_y, written.non_host_velocity_y, kVelocity);
+	}
+
+
+	/// <summary>
+	/// The optimistic messages read back the same in either format, with and without a delta baseline.
+	/// </summary>
+	bool CheckOptimisticMessages()
+	{
+		using namespace OptimisticMessages;
+		Checker checker("OptimisticMessages", "format");
+		for (const auto format : { Format::Bytes, Format::Bits })
+		{
+			const auto step = static_cast<unsigned int>(format);
+
+			StateMessage baseline;
+			baseline.frame = 123440;
+			baseline.host_x = 300.5f;
+			baseline.host_y = 250.25f;
+			baseline.host_velocity_x = -100.0f;
+			baseline.non_host_x = 1024.0f;
+			baseline.non_host_velocity_y = 77.7f;
+			auto state = baseline;
+			state.frame = 123456;
+			state.host_y = 0.0f;
+			state.non_host_velocity_x = -512.0f;
+			StateHistory baselines;
+			baselines.Push(baseline);
+
+			// a full snapshot, then a delta against the baseline, and then a delta against a baseline that was never received
+			for (const auto* reference : std::initializer_list<const StateMessage*>{ nullptr, &baseline })
+			{
+				FixedPacket<kMaxDatagramSize> packet;
+				MessageWriter writer(packet);
+				checker.Check(WriteState(writer, format, state, reference, baseline.frame), step, "the state could not be written");
+				StateMessage read;
+				checker.Check(ReadMessage(packet, MessageType::State, [&](Packet& payload) { return ReadState(payload, read, baseline.frame, baselines); }) &&
+					IsSameState(read, state), step, "the state read back differently");
+				const auto expected_baseline = ((reference != nullptr) && (format == Format::Bits)) ? baseline.frame : 0;
+				checker.Check(read.baseline_frame == expected_baseline, step, "the state read back against the wrong baseline");
+				if (expected_baseline != 0)
+				{
+					checker.Check(!ReadMessage(packet, MessageType::State, [&](Packet& payload) { return ReadState(payload, read, baseline.frame, {}); }) &&
+						(read.baseline_frame == baseline.frame), step, "a delta was read without its baseline, or the baseline was not reported");
+				}
+			}
+
+			ControlMessage control;
+			control.frame = 99;
+			control.is_paused = true;
+			AttackMessage attack;
+			attack.attack_x = 512.0f;
+			attack.attack_y = 384.0f;
+			attack.attack_sync = { 95, 96, 0.5f };
+			FixedPacket<kMaxDatagramSize> packet;
+			MessageWriter writer(packet);
+			checker.Check(WriteControl(writer, format, control) && WriteAttack(writer, format, attack) && (writer.GetMessageCount() == 2), step, "the client messages could not be written");
+			ControlMessage read_control;
+			AttackMessage read_attack;
+			MessageDispatcher dispatcher;
+			Register(dispatcher, MessageType::Control, [&](Packet& payload) { return ReadControl(payload, read_control, 98); });
+			Register(dispatcher, MessageType::Attack, [&](Packet& payload) { return ReadAttack(payload, read_attack); });
+			auto written = GetWritten(packet);
+			checker.Check(dispatcher.Dispatch(written), step, "the client messages could not be dispatched");
+			checker.Check((read_control.frame == control.frame) && read_control.is_paused, step, "the control message read back differently");
+			checker.Check(IsWithinQuantization(read_attack.attack_x, attack.attack_x, kPositionX) && IsWithinQuantization(read_attack.attack_y, attack.attack_y, kPositionY) &&
+				(read_attack.attack_sync.base_frame == 95) && (read_attack.attack_sync.target_frame == 96) && (read_attack.attack_sync.t == 0.5f),
+				step, "the attack message read back differently");
+		}
+
+		std::cout << "OptimisticMessages: Bytes and Bits formats";
+		return checker.Report();
+	}
+}
+
+
+/// <summary>
+/// Run every round trip, reporting a line for each encoding.
+/// </summary>
+/// <returns>If false, a check failed.</returns>
+bool WireFormatCheck::Run()
+{
+	auto is_passed = true;
+	for (const auto check : { CheckBits, CheckRangedInts, CheckFloats, CheckValues, CheckByteOrder, CheckVarInts, CheckStrings, CheckFrames, CheckQuantizedRange, CheckOptimisticMessages })
+	{
+		if (!check())
+		{
+			is_passed = false;
+		}
+	}
+	return is_passed;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+//---------------------------------------------------------
+// file:	WireFormatCheck.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Round-trips every wire encoding the lab uses, at its edges, and checks what comes back.
+//
+// remarks: Usage: CS261_Lab_Headless --wire
+//          Each encoding is written and read back at the boundaries of its ranges, and read back from
+//          truncated input, which must fail without reading past the end.  A change to the wire format that
+//          breaks a peer built from the previous one shows up here first.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "pch.h"
+
+
+namespace WireFormatCheck
+{
+	// given first on the command line, in place of the port, to run the check instead of a server
+	constexpr const char* kArgument = "--wire";
+
+	bool Run();
+}
\ No newline at end of file
@@ -10,8 +10,11 @@
 #include "HostingMenuState.h"
 #include "GameStateManager.h"
 #include "PacketSerializer.h"
+#include "NetworkThread.h"
+#include "NetworkConditionTransport.h"
+#include "SharedMemoryTransport.h"
 
-const int kNetwork_Buffer_Size = 1024;
+const unsigned int kMaxRequestsPerUpdate = 1024; // a flood of junk is drained this fast, so a real request behind it is not kept waiting
 
 
 HostingMenuState::HostingMenuState(NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator, std::string game_type, ServerConfiguration configuration)
@@ -23,8 +26,6 @@ HostingMenuState::HostingMenuState(NetworkedScenarioState::NetworkedScenarioStat
 	operation_description_ += std::to_string(configuration_.port);
 	operation_description_ += ", waiting for connection...  ";
 
-	network_buffer_ = new char[kNetwork_Buffer_Size];
-
 	// create a UDP socket for connecting to a scenario host
 	hosting_socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	if ((hosting_socket_ == INVALID_SOCKET) &&
@@ -64,10 +65,7 @@ HostingMenuState::HostingMenuState(NetworkedScenarioState::NetworkedScenarioStat
 }
 
 
-HostingMenuState::~HostingMenuState()
-{
-	delete[] network_buffer_;
-}
+HostingMenuState::~HostingMenuState() = default;
 
 
 void HostingMenuState::Update()
@@ -86,38 +84,23 @@ void HostingMenuState::Update()
 		return;
 	}
 
-	// attempt to receive a message from a connecting client
-	SOCKADDR_IN other_address;
-	int other_address_size = sizeof(other_address);
-	auto res = recvfrom(hosting_socket_, network_buffer_, kNetwork_Buffer_Size, 0, reinterpret_cast<SOCKADDR*>(&other_address),
-		&other_address_size);
-	if ((res == SOCKET_ERROR) &&
-		HandleSocketError("Error receiving on hosting socket: "))
-	{
-		return;
-	}
-
-	// if any data is received:
-	if (res > 0)
+	// attempt to receive messages from connecting clients, until one is accepted
+	for (unsigned int i = 0; i < kMaxRequestsPerUpdate; ++i)
 	{
-		std::cout << "Received a message from a potential connection, accepting to the game..." << std::endl;
-
-		//NOTE: in Assignment 4, there's actual token-validation logic here...
-
-		// read the client data out of the packet
-		Packet packet = Packet(network_buffer_, res);
-		std::string client_game_type;
-		PacketSerializer::ReadString(packet, client_game_type);
-
-		if (game_type_ == client_game_type)
-	{
-			std::cout << "Game-type matched!  Continuing to game..." << std::endl;
-			SendConnectionSuccess(other_address);
+		SOCKADDR_IN other_address;
+		socklen_t other_address_size = sizeof(other_address);
+		auto res = recvfrom(hosting_socket_, network_buffer_, kMaxDatagramSize, 0, reinterpret_cast<SOCKADDR*>(&other_address),
+			&other_address_size);
+		if (res == SOCKET_ERROR)
+		{
+			HandleSocketError("Error receiving on hosting socket: ");
+			return;
 		}
-		else
+
+		// once a client is accepted, the game has moved on to the scenario
+		if ((res > 0) && HandleConnectionRequest(other_address, static_cast<unsigned int>(res)))
 		{
-			std::cout << "Game type mismatch: expected '" << game_type_ << "', received '" << client_game_type << "'.  Rejecting..." << std::endl;
-			SendConnectionFailure(other_address, "BadGameType");
+			return;
 		}
 	}
 }
@@ -143,6 +126,12 @@ bool HostingMenuState::HandleSocketError(const char* error_text)
 		return false;
 	}
 
+	// a cookie sent to an address with nobody listening can come back as WSAECONNRESET, which is no reason to stop hosting
+	if (wsa_error == WSAECONNRESET)
+	{
+		return false;
+	}
+
 	// log unexpected errors and return to the default game mode
 	std::cerr << "Hosting Winsock Error: " << error_text << wsa_error << std::endl;
 
@@ -155,7 +144,63 @@ bool HostingMenuState::HandleSocketError(const char* error_text)
 }
 
 
-void HostingMenuState::SendConnectionSuccess(SOCKADDR_IN other_address)
+/// <summary>
+/// Challenge a connection request, reject it, or accept it and move on to the scenario.
+/// </summary>
+/// <returns>If true, the client was accepted.</returns>
+bool HostingMenuState::HandleConnectionRequest(SOCKADDR_IN other_address, const unsigned int request_size)
+{
+	// read the client data out of the packet
+	// -- anything else is dropped without a response, as it may be one of a flood
+	Packet packet = Packet(network_buffer_, request_size);
+	std::string_view client_game_type;
+	ConnectionCookie cookie;
+	if (!PacketSerializer::ReadStringView(packet, client_game_type) || !cookie.Read(packet))
+	{
+		return false;
+	}
+
+	// a client that has not proven it is at this address gets a cookie to prove it with, and nothing more
+	if (!cookies_.IsValid(cookie, other_address))
+	{
+		SendChallenge(other_address, request_size);
+		return false;
+	}
+
+	std::cout << "Received a connection request with a valid cookie, accepting to the game..." << std::endl;
+
+	//NOTE: in Assignment 4, there's actual token-validation logic here...
+
+	if (client_game_type != game_type_)
+	{
+		std::cout << "Game type mismatch: expected '" << game_type_ << "', received '" << client_game_type << "'.  Rejecting..." << std::endl;
+		SendConnectionFailure(other_address, "BadGameType");
+		return false;
+	}
+
+	std::cout << "Game-type matched!  Continuing to game..." << std::endl;
+	// a client on this machine names shared memory for us to open, which bypasses the socket
+	SendConnectionSuccess(other_address, configuration_.is_shared_memory_allowed ? SharedMemoryTransport::OpenRequested(packet) : nullptr);
+	return true;
+}
+
+
+void HostingMenuState::SendChallenge(SOCKADDR_IN other_address, const unsigned int request_size)
+{
+	Packet packet = Packet(network_buffer_, kMaxDatagramSize);
+	if (!cookies_.WriteChallenge(packet, other_address, request_size))
+	{
+		return;
+	}
+	auto res = sendto(hosting_socket_, packet.GetRoot(), packet.GetUsedSpace(), 0, (SOCKADDR*)&other_address, sizeof(other_address));
+	if (res == SOCKET_ERROR)
+	{
+		HandleSocketError("Error sending a cookie from hosting socket: ");
+	}
+}
+
+
+void HostingMenuState::SendConnectionSuccess(SOCKADDR_IN other_address, std::unique_ptr<SharedMemoryTransport> shared_memory)
 {
 	// set the hosting socket to reference the address the message was received from
 	auto res = connect(hosting_socket_, reinterpret_cast<SOCKADDR*>(&other_address), sizeof(other_address));
@@ -166,8 +211,12 @@ void HostingMenuState::SendConnectionSuccess(SOCKADDR_IN other_address)
 	}
 
 	// send the magic success string to the client
-	Packet packet = Packet(network_buffer_, kNetwork_Buffer_Size);
+	Packet packet = Packet(network_buffer_, kMaxDatagramSize);
 	PacketSerializer::WriteString(packet, "LetUsBegin");
+	if (shared_memory != nullptr)
+	{
+		PacketSerializer::WriteString(packet, SharedMemoryTransport::kAcceptResponse);
+	}
 	res = send(hosting_socket_, packet.GetRoot(), packet.GetUsedSpace(), 0);
 	if ((res == SOCKET_ERROR) &&
 		HandleSocketError("Error sending 'LetUsBegin' from hosting socket: "))
@@ -177,14 +226,29 @@ void HostingMenuState::SendConnectionSuccess(SOCKADDR_IN other_address)
 
 	// move on to the scenario, using the hosting socket, in host mode
 	std::cout << "Successfully hosting a scenario on port " << configuration_.port << ", moving on to the scenario..." << std::endl;
-	auto game_state = scenario_state_creator_(hosting_socket_, true);
+	// -- the scenario's network thread owns the socket from here on, unless the client is on this machine
+	std::unique_ptr<DatagramTransport> transport;
+	if (shared_memory != nullptr)
+	{
+		std::cout << "The client is on this machine, so the scenario uses shared memory rather than UDP" << std::endl;
+		closesocket(hosting_socket_);
+		hosting_socket_ = INVALID_SOCKET;
+		transport = std::move(shared_memory);
+	}
+	else
+	{
+		transport = std::make_unique<NetworkThread>(hosting_socket_);
+	}
+	// -- either way, seen through any simulated conditions
+	transport = NetworkConditionTransport::Wrap(std::move(transport), configuration_.network_conditions);
+	auto game_state = scenario_state_creator_(std::move(transport), true);
 	GameStateManager::ApplyState(game_state);
 }
 
 
 void HostingMenuState::SendConnectionFailure(SOCKADDR_IN other_address, const char* message)
 {
-	Packet packet = Packet(network_buffer_, kNetwork_Buffer_Size);
+	Packet packet = Packet(network_buffer_, kMaxDatagramSize);
 	PacketSerializer::WriteString(packet, message);
 	auto res = sendto(hosting_socket_, packet.GetRoot(), packet.GetUsedSpace(), 0, (SOCKADDR*)&other_address, sizeof(other_address));
 	if (res == SOCKET_ERROR)
@@ -11,7 +11,10 @@
 #include "framework.h"
 #include "GameState.h"
 #include "NetworkedScenarioState.h"
+#include "Packet.h"
 #include "ServerConfiguration.h"
+#include "ConnectionCookie.h"
+#include "SharedMemoryTransport.h"
 
 
 /// <summary>
@@ -31,7 +34,9 @@ public:
 private:
     bool HandleSocketError(const char* error_text);
 
-    void SendConnectionSuccess(SOCKADDR_IN other_address);
+    bool HandleConnectionRequest(SOCKADDR_IN other_address, unsigned int request_size);
+    void SendChallenge(SOCKADDR_IN other_address, unsigned int request_size);
+    void SendConnectionSuccess(SOCKADDR_IN other_address, std::unique_ptr<SharedMemoryTransport> shared_memory);
     void SendConnectionFailure(SOCKADDR_IN other_address, const char* message);
 
     NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator_;
@@ -39,7 +44,9 @@ private:
     ServerConfiguration configuration_;
 
     SOCKET hosting_socket_;
-    char* network_buffer_;
+    char network_buffer_[kMaxDatagramSize];
+    // nothing is kept about a client until it sends back the cookie issued to it
+    ConnectionCookie::Issuer cookies_;
 
     std::string operation_description_;
 };
\ No newline at end of file
@@ -8,6 +8,7 @@
 // Copyright  2021 DigiPen, All rights reserved.
 //---------------------------------------------------------
 #include "ServerConfiguration.h"
+#include "SharedMemoryTransport.h"
 
 
 ServerConfiguration ServerConfiguration::BuildConfigurationFromArguments(int argc, char** argv)
@@ -16,6 +17,10 @@ ServerConfiguration ServerConfiguration::BuildConfigurationFromArguments(int arg
 
     // argv[0] is the executable file name and path
     configuration.port = (argc > 1) ? atoi(argv[1]) : 4200;
+    configuration.worker_count = 0;
+    configuration.network_conditions = NetworkConditions::FromArguments(argc, argv);
+    configuration.is_shared_memory_allowed = SharedMemoryTransport::IsAllowedByArguments(argc, argv);
+    configuration.receive_backend = DatagramReceiver::FromArguments(argc, argv);
 
     return configuration;
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 //---------------------------------------------------------
 #pragma once
 #include "framework.h"
+#include "NetworkConditions.h"
+#include "DatagramReceiver.h"
 
 
 /// <summary>
@@ -17,6 +19,14 @@
 struct ServerConfiguration
 {
 	int port;
+	// the number of threads hosting sessions on the port, or zero to host them on the game thread
+	unsigned int worker_count;
+	// simulated on every session's datagrams, from a --net= argument
+	NetworkConditions network_conditions;
+	// accept a client's offer of shared memory, if it is on this machine, unless there is a --udp argument
+	bool is_shared_memory_allowed;
+	// how the port's datagrams are received, from a --recv= argument, falling back if the kernel refuses it
+	DatagramReceiver::Backend receive_backend;
 
 	static ServerConfiguration BuildConfigurationFromArguments(int argc, char** argv);
 };
@@ -11,6 +11,7 @@
 #include "GameStateManager.h"
 #include "ServerMainMenuState.h"
 #include "HostingMenuState.h"
+#include "SessionHostingState.h"
 #include "LockstepScenarioState.h"
 #include "DumbClientScenarioState.h"
 #include "OptimisticHostScenarioState.h"
@@ -49,27 +50,36 @@ void ServerMainMenuState::Update()
 	if (CP_Input_KeyTriggered(KEY_2) || CP_Input_KeyTriggered(KEY_KP_2))
 	{
 		auto* game_state = new HostingMenuState(
-			[](const SOCKET socket, const bool is_host) -> NetworkedScenarioState*
+			[](std::unique_ptr<DatagramTransport> transport, const bool is_host) -> NetworkedScenarioState*
 			{ 
-				return new LockstepScenarioState(socket, is_host); 
+				return new LockstepScenarioState(std::move(transport), is_host); 
 			}, "Lockstep", configuration_);
 		GameStateManager::ApplyState(game_state);
 	}
 	else if (CP_Input_KeyTriggered(KEY_3) || CP_Input_KeyTriggered(KEY_KP_3))
 	{
 		auto* game_state = new HostingMenuState(
-			[](const SOCKET socket, const bool is_host) -> NetworkedScenarioState*
+			[](std::unique_ptr<DatagramTransport> transport, const bool is_host) -> NetworkedScenarioState*
 			{
-				return new DumbClientScenarioState(socket, is_host);
+				return new DumbClientScenarioState(std::move(transport), is_host);
 			}, "DumbClient", configuration_);
 		GameStateManager::ApplyState(game_state);
 	}
 	else if (CP_Input_KeyTriggered(KEY_4) || CP_Input_KeyTriggered(KEY_KP_4))
 	{
 		auto* game_state = new HostingMenuState(
-			[](const SOCKET socket, const bool is_host) -> NetworkedScenarioState*
+			[](std::unique_ptr<DatagramTransport> transport, const bool is_host) -> NetworkedScenarioState*
 			{
-				return new OptimisticHostScenarioState(socket);
+				return new OptimisticHostScenarioState(std::move(transport));
+			}, "Optimistic", configuration_);
+		GameStateManager::ApplyState(game_state);
+	}
+	else if (CP_Input_KeyTriggered(KEY_5) || CP_Input_KeyTriggered(KEY_KP_5))
+	{
+		auto* game_state = new SessionHostingState(
+			[](std::unique_ptr<DatagramTransport> transport, bool /*is_host*/) -> NetworkedScenarioState*
+			{
+				return new OptimisticHostScenarioState(std::move(transport));
 			}, "Optimistic", configuration_);
 		GameStateManager::ApplyState(game_state);
 	}
@@ -86,6 +96,7 @@ void ServerMainMenuState::Draw()
 	CP_Font_DrawText("Press 2 for Lockstep (2 player)", 10.0f, 40.0f);
 	CP_Font_DrawText("Press 3 for Dumb Client (2 player)", 10.0f, 70.0f);
 	CP_Font_DrawText("Press 4 for Optimistic (2 player)", 10.0f, 100.0f);
+	CP_Font_DrawText("Press 5 for Optimistic (one session per client)", 10.0f, 130.0f);
 	CP_Settings_Stroke(kMenuOptionTextColor);
 	CP_Graphics_DrawLine(10.0f, 38.0f, 167.0f, 38.0f);
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+//---------------------------------------------------------
+// file:	SessionHostingState.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Hosts a separate scenario for every client that connects, all on one port.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "SessionHostingState.h"
+#include <algorithm>
+#include "GameStateManager.h"
+
+const float kTickStatsReport_Secs = 10.0f; // how often the worker threads' tick timing is logged
+
+
+SessionHostingState::SessionHostingState(NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator, std::string game_type, ServerConfiguration configuration)
+	: game_type_(game_type),
+	  configuration_(configuration),
+	  is_threaded_(configuration.worker_count > 0),
+	  report_timer_secs_(kTickStatsReport_Secs)
+{
+	auto worker_count = std::max(configuration_.worker_count, 1u);
+#if !defined(SO_REUSEPORT)
+	// without SO_REUSEPORT, only one socket can be bound to the port
+	if (worker_count > 1)
+	{
+		std::cout << "Sharing a port between workers is not supported on this platform, so only one worker will host" << std::endl;
+		worker_count = 1;
+	}
+#endif
+
+	operation_description_ = "Hosting ";
+	operation_description_ += game_type_;
+	operation_description_ += " sessions on ";
+	operation_description_ += std::to_string(configuration_.port);
+
+	// every worker binds the port before any starts, so the kernel's hash of clients to workers never changes
+	for (unsigned int i = 0; i < worker_count; ++i)
+	{
+		workers_.push_back(std::make_unique<SessionWorker>(scenario_state_creator, game_type_, configuration_, worker_count > 1));
+		if (!workers_.back()->IsHosting())
+		{
+			// if any worker cannot host, none do, and the next Update returns to the main menu
+			workers_.clear();
+			return;
+		}
+	}
+	if (is_threaded_)
+	{
+		for (auto& worker : workers_)
+		{
+			worker->Start();
+		}
+	}
+
+	std::cout << "Hosting " << game_type_ << " sessions on port " << configuration_.port << " with " << worker_count
+		<< (is_threaded_ ? " worker threads" : " worker on the game thread") << std::endl;
+}
+
+
+SessionHostingState::~SessionHostingState() = default;
+
+
+void SessionHostingState::Update()
+{
+	// if the user presses ESC, or hosting failed, return to the main menu, which ends every session
+	if (CP_Input_KeyTriggered(KEY_ESCAPE) || workers_.empty())
+	{
+		GameStateManager::ReturnToBaseState();
+		return;
+	}
+
+	if (!is_threaded_)
+	{
+		workers_.front()->Update(CP_System_GetDt());
+		return;
+	}
+
+	report_timer_secs_ -= CP_System_GetDt();
+	if (report_timer_secs_ <= 0.0f)
+	{
+		ReportTickStats();
+		report_timer_secs_ = kTickStatsReport_Secs;
+	}
+}
+
+
+void SessionHostingState::Draw()
+{
+	// the sessions are not drawn, as they would all overlap
+	std::string session_description("Sessions: ");
+	session_description += std::to_string(GetSessionCount());
+	unsigned int overflow_count = 0;
+	for (const auto& worker : workers_)
+	{
+		overflow_count += worker->GetOverflowCount();
+	}
+	session_description += ", Overflowed: ";
+	session_description += std::to_string(overflow_count);
+
+	// draw the descriptions
+	CP_Settings_TextSize(30);
+	CP_Settings_TextAlignment(CP_TEXT_ALIGN_H_LEFT, CP_TEXT_ALIGN_V_TOP);
+	CP_Settings_Fill(CP_Color_Create(255, 255, 255, 255));
+	CP_Font_DrawText(operation_description_.c_str(), 0.0f, 0.0f);
+	CP_Font_DrawText(session_description.c_str(), 0.0f, 35.0f);
+}
+
+
+unsigned int SessionHostingState::GetSessionCount() const
+{
+	unsigned int session_count = 0;
+	for (const auto& worker : workers_)
+	{
+		session_count += worker->GetSessionCount();
+	}
+	return session_count;
+}
+
+
+/// <summary>
+/// Log each worker's sessions and tick timing since the last report.
+/// </summary>
+void SessionHostingState::ReportTickStats()
+{
+	for (unsigned int i = 0; i < workers_.size(); ++i)
+	{
+		const auto tick_stats = workers_[i]->TakeTickStats();
+		const auto mean_lateness_secs = (tick_stats.tick_count > 0) ? tick_stats.total_lateness_secs / tick_stats.tick_count : 0.0f;
+		std::cout << "Worker " << i << ": " << workers_[i]->GetSessionCount() << " sessions, "
+			<< static_cast<unsigned int>(tick_stats.session_updates / kTickStatsReport_Secs) << " session updates/s, tick lateness mean "
+			<< mean_lateness_secs * 1000 << "ms max " << tick_stats.max_lateness_secs * 1000 << "ms, longest tick "
+			<< tick_stats.max_update_secs * 1000 << "ms" << std::endl;
+	}
+}
\ No newline at end of file
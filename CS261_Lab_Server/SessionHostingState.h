@@ -0,0 +1,51 @@
+//---------------------------------------------------------
+// file:	SessionHostingState.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	Hosts a separate scenario for every client that connects, all on one port.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "framework.h"
+#include <memory>
+#include <vector>
+#include "GameState.h"
+#include "NetworkedScenarioState.h"
+#include "ServerConfiguration.h"
+#include "SessionWorker.h"
+
+
+/// <summary>
+/// Hosts a separate scenario for every client that connects, all on one port.
+/// </summary>
+/// <remarks>
+/// With a worker_count of zero, one worker runs its sessions on the game thread.
+/// Otherwise, that many workers share the port, each running its sessions on its own thread.
+/// </remarks>
+class SessionHostingState :
+    public GameState
+{
+public:
+    SessionHostingState(NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator, std::string game_type, ServerConfiguration configuration);
+    ~SessionHostingState() override;
+
+    // Inherited via GameState
+    virtual void Update() override;
+    virtual void Draw() override;
+
+    unsigned int GetSessionCount() const;
+
+private:
+    void ReportTickStats();
+
+    std::string game_type_;
+    ServerConfiguration configuration_;
+
+    std::vector<std::unique_ptr<SessionWorker>> workers_;
+    bool is_threaded_;
+    float report_timer_secs_;
+
+    std::string operation_description_;
+};
\ No newline at end of file
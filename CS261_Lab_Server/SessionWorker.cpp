@@ -0,0 +1,334 @@
+//---------------------------------------------------------
+// file:	SessionWorker.cpp
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A socket on the hosting port, and the scenario sessions for every client that connects to it.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#include "SessionWorker.h"
+#include <algorithm>
+#include <chrono>
+#include "PacketSerializer.h"
+#include "NetworkConditionTransport.h"
+#include "SharedMemoryTransport.h"
+
+const float kSessionTimeout_Secs = 5.0f; // a session that receives nothing for this long is assumed to be gone
+const float kTick_Secs = 1.0f / 30.0f; // the scenarios simulate with a fixed 30 Hz step, so worker threads tick at the same rate
+
+
+SessionWorker::SessionWorker(NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator, std::string game_type, ServerConfiguration configuration, const bool is_port_shared)
+	: scenario_state_creator_(scenario_state_creator),
+	  game_type_(game_type),
+	  configuration_(configuration),
+	  session_count_(0),
+	  accepted_count_(0),
+	  tick_stats_(),
+	  is_running_(false)
+{
+	// create a UDP socket for all of this worker's sessions to share
+	hosting_socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if ((hosting_socket_ == INVALID_SOCKET) &&
+		HandleSocketError("Error creating socket: "))
+	{
+		return;
+	}
+
+	// make the socket non-blocking
+	u_long nonblocking = 1;
+	auto res = ioctlsocket(hosting_socket_, FIONBIO, &nonblocking);
+	if ((res == SOCKET_ERROR) &&
+		HandleSocketError("Error setting non-blocking state on socket: "))
+	{
+		return;
+	}
+
+#if defined(SO_REUSEPORT)
+	// let the other workers bind the same port, so the kernel spreads the clients across all of us
+	if (is_port_shared)
+	{
+		int is_reused = 1;
+		res = setsockopt(hosting_socket_, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&is_reused), sizeof(is_reused));
+		if ((res == SOCKET_ERROR) &&
+			HandleSocketError("Error sharing the hosting port: "))
+		{
+			return;
+		}
+	}
+#endif
+
+	// bind the hosting socket to the specified port on the local machine (127.0.0.1)
+	SOCKADDR_IN hosting_address;
+	memset(&hosting_address, 0, sizeof(hosting_address));
+	hosting_address.sin_family = AF_INET;
+	hosting_address.sin_port = htons(configuration_.port);
+	res = inet_pton(AF_INET, "127.0.0.1", &hosting_address.sin_addr);
+	if ((res == SOCKET_ERROR) &&
+		HandleSocketError("Error creating a localhost address for the socket to host on: "))
+	{
+		return;
+	}
+	res = bind(hosting_socket_, reinterpret_cast<SOCKADDR*>(&hosting_address), sizeof(hosting_address));
+	if ((res == SOCKET_ERROR) &&
+		HandleSocketError("Error binding hosting socket: "))
+	{
+		return;
+	}
+
+	// the socket is never connected, as every client shares it
+	// -- the session host owns it from here on, and only passes on connection requests with a valid cookie
+	session_host_ = std::make_unique<SessionHost>(hosting_socket_, configuration_.receive_backend,
+		[this](Packet& request, const SOCKADDR_IN& address, Packet& response) { return IsProvenRequest(request, address, response); });
+	hosting_socket_ = INVALID_SOCKET;
+}
+
+
+SessionWorker::~SessionWorker()
+{
+	Stop();
+}
+
+
+/// <summary>
+/// Accept new clients, update every session, and drop the sessions that have gone quiet.
+/// </summary>
+/// <remarks>Called by the game state on the game thread, unless the worker was started on its own thread.</remarks>
+void SessionWorker::Update(const float dt)
+{
+	if (session_host_ == nullptr)
+	{
+		return;
+	}
+
+	AcceptWaiting();
+
+	for (auto& session : sessions_)
+	{
+		session.scenario->Update();
+
+		const auto datagrams_drained = session.scenario->GetReceiveStats().datagrams_drained;
+		session.idle_secs = (datagrams_drained != session.last_datagrams_drained) ? 0.0f : session.idle_secs + dt;
+		session.last_datagrams_drained = datagrams_drained;
+	}
+
+	// there is no disconnect message, so drop the sessions that have gone quiet
+	const auto sessions_end = std::remove_if(sessions_.begin(), sessions_.end(),
+		[](const Session& session) { return session.idle_secs > kSessionTimeout_Secs; });
+	if (sessions_end != sessions_.end())
+	{
+		std::cout << "Ending " << (sessions_.end() - sessions_end) << " idle sessions on port " << configuration_.port << std::endl;
+		sessions_.erase(sessions_end, sessions_.end());
+	}
+	session_count_.store(static_cast<unsigned int>(sessions_.size()), std::memory_order_relaxed);
+}
+
+
+/// <summary>
+/// Run Update on a thread of the worker's own, on a fixed tick, until Stop.
+/// </summary>
+void SessionWorker::Start()
+{
+	if ((session_host_ == nullptr) || thread_.joinable())
+	{
+		return;
+	}
+
+	is_running_.store(true, std::memory_order_release);
+	thread_ = std::thread(&SessionWorker::Run, this);
+}
+
+
+/// <summary>
+/// Stop the worker's thread, if it was started.  The sessions are kept until the worker is destroyed.
+/// </summary>
+void SessionWorker::Stop()
+{
+	is_running_.store(false, std::memory_order_release);
+	if (thread_.joinable())
+	{
+		thread_.join();
+	}
+}
+
+
+/// <summary>
+/// Return the tick timing since the last call, and start counting again.
+/// </summary>
+SessionWorker::TickStats SessionWorker::TakeTickStats()
+{
+	std::lock_guard<std::mutex> lock(tick_stats_mutex_);
+	const auto tick_stats = tick_stats_;
+	tick_stats_ = TickStats();
+	return tick_stats;
+}
+
+
+bool SessionWorker::HandleSocketError(const char* error_text)
+{
+	const auto wsa_error = WSAGetLastError();
+
+	// ignore WSAEWOULDBLOCK
+	if (wsa_error == WSAEWOULDBLOCK)
+	{
+		return false;
+	}
+
+	// log unexpected errors and give up on hosting
+	std::cerr << "Session Worker Winsock Error: " << error_text << wsa_error << std::endl;
+
+	// close the socket and clear it
+	// -- without a session host, the worker never hosts anything
+	closesocket(hosting_socket_);
+	hosting_socket_ = INVALID_SOCKET;
+
+	return true;
+}
+
+
+void SessionWorker::Run()
+{
+	using Clock = std::chrono::steady_clock;
+	const auto tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(kTick_Secs));
+
+	// a tick that runs long is followed immediately by the next, rather than drifting the schedule
+	auto next_tick = Clock::now();
+	while (is_running_.load(std::memory_order_acquire))
+	{
+		const auto tick_start = Clock::now();
+		Update(kTick_Secs);
+		const auto tick_end = Clock::now();
+
+		{
+			const auto lateness_secs = std::chrono::duration<float>(tick_start - next_tick).count();
+			const auto update_secs = std::chrono::duration<float>(tick_end - tick_start).count();
+			std::lock_guard<std::mutex> lock(tick_stats_mutex_);
+			++tick_stats_.tick_count;
+			tick_stats_.session_updates += static_cast<unsigned int>(sessions_.size());
+			tick_stats_.total_lateness_secs += lateness_secs;
+			tick_stats_.max_lateness_secs = std::max(tick_stats_.max_lateness_secs, lateness_secs);
+			tick_stats_.max_update_secs = std::max(tick_stats_.max_update_secs, update_secs);
+		}
+
+		next_tick += tick;
+		std::this_thread::sleep_until(next_tick);
+	}
+}
+
+
+/// <summary>
+/// Challenge, accept, or reject every datagram from a client without a session, which should be a connection request.
+/// </summary>
+void SessionWorker::AcceptWaiting()
+{
+	SessionHost::UnmatchedDatagram unmatched;
+	while (session_host_->ReceiveUnmatched(unmatched))
+	{
+		// read the client data out of the packet
+		// -- its cookie was already checked by IsProvenRequest
+		Packet packet(unmatched.datagram.buffer.GetData(), unmatched.datagram.buffer.GetSize());
+		std::string_view client_game_type;
+		ConnectionCookie cookie;
+		if (!PacketSerializer::ReadStringView(packet, client_game_type) || !cookie.Read(packet))
+		{
+			continue;
+		}
+
+		//NOTE: in Assignment 4, there's actual token-validation logic here...
+
+		if (client_game_type != game_type_)
+		{
+			std::cout << "Game type mismatch: expected '" << game_type_ << "', received '" << client_game_type << "'.  Rejecting..." << std::endl;
+			SendResponse(unmatched.address, "BadGameType", nullptr);
+			continue;
+		}
+
+		// a repeat of a request accepted over shared memory finds the memory already attached, so it is only answered again
+		// -- opening a UDP session for it would stream states to a socket the client has closed
+		if (IsAcceptedOverSharedMemory(unmatched.address))
+		{
+			SendResponse(unmatched.address, "LetUsBegin", SharedMemoryTransport::kAcceptResponse);
+			continue;
+		}
+
+		// a client on this machine names shared memory for us to open, which bypasses the socket
+		std::unique_ptr<DatagramTransport> transport;
+		if (configuration_.is_shared_memory_allowed)
+		{
+			transport = SharedMemoryTransport::OpenRequested(packet);
+		}
+		const bool is_shared_memory = (transport != nullptr);
+
+		// a repeated request that arrived before the session was opened has nothing left to do
+		if (!is_shared_memory)
+		{
+			transport = session_host_->OpenSession(unmatched.address);
+			if (transport == nullptr)
+			{
+				continue;
+			}
+		}
+
+		// each session draws its own simulated conditions, so they do not all lose the same datagrams
+		auto conditions = configuration_.network_conditions;
+		conditions.seed += accepted_count_++;
+		transport = NetworkConditionTransport::Wrap(std::move(transport), conditions);
+
+		// the response is queued ahead of anything the scenario sends
+		SendResponse(unmatched.address, "LetUsBegin", is_shared_memory ? SharedMemoryTransport::kAcceptResponse : nullptr);
+		Session session = { std::unique_ptr<NetworkedScenarioState>(scenario_state_creator_(std::move(transport), true)), 0, 0.0f, is_shared_memory, unmatched.address };
+		sessions_.push_back(std::move(session));
+	}
+}
+
+
+/// <summary>
+/// Is there a session with a client at this address, accepted over shared memory?
+/// </summary>
+/// <remarks>UDP sessions never see their clients' requests here, as the session host hands those to the session.</remarks>
+bool SessionWorker::IsAcceptedOverSharedMemory(const SOCKADDR_IN& address) const
+{
+	return std::any_of(sessions_.begin(), sessions_.end(), [&](const Session& session)
+		{
+			return session.is_shared_memory &&
+				(session.address.sin_addr.s_addr == address.sin_addr.s_addr) && (session.address.sin_port == address.sin_port);
+		});
+}
+
+
+/// <summary>
+/// Is this a connection request with a valid cookie?  If it is a request without one, write a challenge.
+/// </summary>
+/// <remarks>The session host's filter, so it runs on the host's thread, for every datagram from a client without a session.
+/// Nothing is kept about the client, so a flood of requests, spoofed or not, costs nothing but the challenges.</remarks>
+bool SessionWorker::IsProvenRequest(Packet& request, const SOCKADDR_IN& address, Packet& response) const
+{
+	// anything that is not a request is dropped without a response, as it may be one of a flood
+	const auto request_size = request.GetRemainingSpace();
+	std::string_view client_game_type;
+	ConnectionCookie cookie;
+	if (!PacketSerializer::ReadStringView(request, client_game_type) || !cookie.Read(request))
+	{
+		return false;
+	}
+
+	// a client that has not proven it is at its address gets a cookie to prove it with, and nothing more
+	if (!cookies_.IsValid(cookie, address))
+	{
+		cookies_.WriteChallenge(response, address, request_size);
+		return false;
+	}
+	return true;
+}
+
+
+void SessionWorker::SendResponse(const SOCKADDR_IN& address, const char* message, const char* transport_message)
+{
+	Packet packet = Packet(network_buffer_, kMaxDatagramSize);
+	PacketSerializer::WriteString(packet, message);
+	if (transport_message != nullptr)
+	{
+		PacketSerializer::WriteString(packet, transport_message);
+	}
+	session_host_->SendTo(packet, address);
+}
\ No newline at end of file
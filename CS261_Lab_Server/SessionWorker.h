@@ -0,0 +1,101 @@
+//---------------------------------------------------------
+// file:	SessionWorker.h
+// author:	Matthew Picioccio
+// email:	matthew.picioccio@digipen.edu
+//
+// brief:	A socket on the hosting port, and the scenario sessions for every client that connects to it.
+//
+// remarks: Several workers can share a port with SO_REUSEPORT, in which case the kernel hashes each client
+//          to one of them, and each runs its sessions on its own thread.  Workers share no mutable state,
+//          so none waits on another.
+//
+// Copyright  2021 DigiPen, All rights reserved.
+//---------------------------------------------------------
+#pragma once
+#include "framework.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "NetworkedScenarioState.h"
+#include "Packet.h"
+#include "ServerConfiguration.h"
+#include "ConnectionCookie.h"
+#include "SessionHost.h"
+
+
+/// <summary>
+/// A socket on the hosting port, and the scenario sessions for every client that connects to it.
+/// </summary>
+class SessionWorker
+{
+public:
+    /// <summary>
+    /// Timing of the ticks a worker thread has run since the stats were last taken.
+    /// </summary>
+    struct TickStats
+    {
+        unsigned int tick_count; // ticks run
+        unsigned int session_updates; // scenario updates across all ticks
+        float total_lateness_secs; // how far behind schedule the ticks started, in total
+        float max_lateness_secs; // the furthest behind schedule any tick started
+        float max_update_secs; // the longest any tick took to run
+    };
+
+    SessionWorker(NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator, std::string game_type, ServerConfiguration configuration, bool is_port_shared);
+    ~SessionWorker();
+
+    SessionWorker(const SessionWorker&) = delete;
+    SessionWorker& operator=(const SessionWorker&) = delete;
+
+    void Update(float dt);
+    void Start();
+    void Stop();
+
+    bool IsHosting() const { return session_host_ != nullptr; }
+    unsigned int GetSessionCount() const { return session_count_.load(std::memory_order_relaxed); }
+    unsigned int GetOverflowCount() const { return (session_host_ != nullptr) ? session_host_->GetOverflowCount() : 0; }
+    TickStats TakeTickStats();
+
+private:
+    /// <summary>
+    /// One connected client, and the scenario being played with it.
+    /// </summary>
+    struct Session
+    {
+        std::unique_ptr<NetworkedScenarioState> scenario;
+        unsigned int last_datagrams_drained;
+        float idle_secs;
+        bool is_shared_memory; // the client was accepted over shared memory, so its requests still come here
+        SOCKADDR_IN address; // where the client's requests came from
+    };
+
+    bool HandleSocketError(const char* error_text);
+
+    void Run();
+    void AcceptWaiting();
+    bool IsAcceptedOverSharedMemory(const SOCKADDR_IN& address) const;
+    bool IsProvenRequest(Packet& request, const SOCKADDR_IN& address, Packet& response) const;
+    void SendResponse(const SOCKADDR_IN& address, const char* message, const char* transport_message);
+
+    NetworkedScenarioState::NetworkedScenarioStateCreator scenario_state_creator_;
+    std::string game_type_;
+    ServerConfiguration configuration_;
+
+    SOCKET hosting_socket_;
+    // declared before the sessions, so it outlives them
+    std::unique_ptr<SessionHost> session_host_;
+    std::vector<Session> sessions_;
+    char network_buffer_[kMaxDatagramSize];
+    // each worker has its own key, as the kernel hashes a client to the same worker every time
+    // -- only read once constructed, so the session host's thread checks cookies with it too
+    ConnectionCookie::Issuer cookies_;
+    std::atomic<unsigned int> session_count_;
+    unsigned int accepted_count_;
+
+    TickStats tick_stats_;
+    std::mutex tick_stats_mutex_;
+    std::atomic<bool> is_running_;
+    std::thread thread_;
+};
\ No newline at end of file